@@ -0,0 +1,95 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "baldr/cchoverlay.h"
+
+namespace valhalla {
+namespace baldr {
+
+constexpr uint32_t CCHOverlay::kNoVertex;
+constexpr uint32_t CCHOverlay::kNoArc;
+
+CCHOverlay::CCHOverlay(const std::string& file_name)
+    : header_(nullptr), edges_(nullptr), vertices_(nullptr), first_arcs_(nullptr), heads_(nullptr),
+      first_edges_(nullptr) {
+  struct stat s;
+  if (stat(file_name.c_str(), &s)) {
+    throw std::runtime_error("(stat): " + file_name + " " + strerror(errno));
+  }
+  if (static_cast<size_t>(s.st_size) < sizeof(CCHHeader)) {
+    throw std::runtime_error(file_name + " is not a contraction hierarchy overlay");
+  }
+  mm_.map(file_name, s.st_size);
+
+  // check the header and that the file holds everything it says it does
+  header_ = reinterpret_cast<const CCHHeader*>(mm_.get());
+  if (memcmp(header_->magic, kCCHMagic, sizeof(kCCHMagic)) != 0 ||
+      header_->version != kCCHVersion) {
+    throw std::runtime_error(file_name + " is not a version " + std::to_string(kCCHVersion) +
+                             " contraction hierarchy overlay");
+  }
+  size_t size = sizeof(CCHHeader) + header_->tile_count * sizeof(CCHTile) +
+                header_->edge_count * sizeof(CCHEdge) +
+                (header_->node_count + header_->vertex_count + 1 + 2 * header_->arc_count + 1) *
+                    sizeof(uint32_t);
+  if (size != mm_.size()) {
+    throw std::runtime_error(file_name + " is truncated, expected " + std::to_string(size) +
+                             " bytes");
+  }
+
+  // index the tiles
+  const auto* tile = reinterpret_cast<const CCHTile*>(header_ + 1);
+  tiles_.reserve(header_->tile_count);
+  for (uint32_t i = 0; i < header_->tile_count; ++i, ++tile) {
+    tiles_.emplace(static_cast<uint32_t>(tile->tile),
+                   std::make_pair(tile->first_row, tile->node_count));
+  }
+  edges_ = reinterpret_cast<const CCHEdge*>(tile);
+  vertices_ = reinterpret_cast<const uint32_t*>(edges_ + header_->edge_count);
+  first_arcs_ = vertices_ + header_->node_count;
+  heads_ = first_arcs_ + header_->vertex_count + 1;
+  first_edges_ = heads_ + header_->arc_count;
+}
+
+void CCHOverlay::Write(const std::string& file_name,
+                       const uint32_t access,
+                       const std::vector<CCHTile>& tiles,
+                       const std::vector<uint32_t>& vertices,
+                       const std::vector<uint32_t>& first_arcs,
+                       const std::vector<uint32_t>& heads,
+                       const std::vector<uint32_t>& first_edges,
+                       const std::vector<CCHEdge>& edges) {
+  if (first_arcs.empty() || first_arcs.back() != heads.size() ||
+      first_edges.size() != heads.size() + 1 || first_edges.back() != edges.size()) {
+    throw std::runtime_error("Inconsistent contraction hierarchy overlay for " + file_name);
+  }
+  CCHHeader header{};
+  memcpy(header.magic, kCCHMagic, sizeof(kCCHMagic));
+  header.version = kCCHVersion;
+  header.access = access;
+  header.tile_count = tiles.size();
+  header.vertex_count = first_arcs.size() - 1;
+  header.node_count = vertices.size();
+  header.arc_count = heads.size();
+  header.edge_count = edges.size();
+
+  std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open " + file_name);
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(tiles.data()), tiles.size() * sizeof(CCHTile));
+  file.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(CCHEdge));
+  for (const auto* values : {&vertices, &first_arcs, &heads, &first_edges}) {
+    file.write(reinterpret_cast<const char*>(values->data()), values->size() * sizeof(uint32_t));
+  }
+  if (!file) {
+    throw std::runtime_error("Failed to write " + file_name);
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
@@ -1,7 +1,9 @@
 #include "baldr/graphreader.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <sys/stat.h>
 
@@ -18,6 +20,16 @@ namespace {
 constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1073741824; // 1 gig
 constexpr size_t AVERAGE_TILE_SIZE = 2097152;         // 2 megs
 constexpr size_t AVERAGE_MM_TILE_SIZE = 1024;         // 1k
+constexpr size_t DEFAULT_CACHE_SHARDS = 64;
+constexpr size_t MIN_SHARD_CAPACITY = 16;
+
+size_t next_power_of_two(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
 } // namespace
 
 namespace valhalla {
@@ -25,6 +37,9 @@ namespace baldr {
 
 struct GraphReader::tile_extract_t {
   tile_extract_t(const boost::property_tree::ptree& pt) {
+    // live traffic goes first so the tiles can be given theirs as they are loaded
+    load_traffic(pt);
+
     // if you really meant to load it
     if (pt.get_optional<std::string>("tile_extract")) {
       try {
@@ -50,6 +65,10 @@ struct GraphReader::tile_extract_t {
             LOG_WARN("Tile extract had " + std::to_string(archive->corrupt_blocks) +
                      " corrupt blocks");
           }
+          // build a tile over each chunk of the mapping up front so readers can use them as is
+          if (pt.get<bool>("use_tile_extract_views", false)) {
+            build_views();
+          }
         }
       } catch (const std::exception& e) {
         LOG_ERROR(e.what());
@@ -57,9 +76,62 @@ struct GraphReader::tile_extract_t {
       }
     }
   }
+  void load_traffic(const boost::property_tree::ptree& pt) {
+    if (!pt.get_optional<std::string>("traffic_extract")) {
+      return;
+    }
+    try {
+      // the tar is mapped shared and writable so that changes made to it in place by the
+      // process keeping the speeds up to date are seen right away
+      traffic_archive.reset(new midgard::tar(pt.get<std::string>("traffic_extract")));
+      for (auto& c : traffic_archive->contents) {
+        try {
+          auto id = GraphTile::GetTileId(c.first);
+          auto* ptr = const_cast<char*>(c.second.first);
+          traffic_tiles.emplace(id, TrafficTile(ptr, c.second.second));
+        } catch (const std::exception& e) {
+          // skip files we dont understand
+          LOG_WARN("Skipping traffic tile " + c.first + ": " + e.what());
+        }
+      }
+      LOG_INFO("Traffic extract successfully loaded with tile count: " +
+               std::to_string(traffic_tiles.size()));
+    } catch (const std::exception& e) {
+      LOG_ERROR(e.what());
+      LOG_WARN("Traffic extract could not be loaded");
+    }
+  }
+  // live traffic of a tile, empty if there is none
+  TrafficTile traffic_tile(const GraphId& base) const {
+    auto t = traffic_tiles.find(base);
+    return t == traffic_tiles.cend() ? TrafficTile() : t->second;
+  }
+  void build_views() {
+    views.reserve(tiles.size());
+    for (const auto& t : tiles) {
+      try {
+        GraphTile tile(GraphId(t.first), t.second.first, t.second.second);
+        tile.set_traffic_tile(traffic_tile(GraphId(t.first)));
+        // the views live as long as the extract, so costings don't keep edge costs with them
+        tile.drop_edge_costs();
+        if (tile.header()) {
+          views.emplace(t.first, std::move(tile));
+        }
+      } catch (const std::exception& e) {
+        LOG_WARN("Skipping tile " + std::to_string(GraphId(t.first)) + ": " + e.what());
+      }
+    }
+    LOG_INFO("Tile extract views built for tile count: " + std::to_string(views.size()));
+  }
+
   // TODO: dont remove constness, and actually make graphtile read only?
   std::unordered_map<uint64_t, std::pair<char*, size_t>> tiles;
+  // Tiles pointing straight into the mapping, when populated these are the cache
+  std::unordered_map<uint64_t, GraphTile> views;
   std::shared_ptr<midgard::tar> archive;
+  // Live traffic of the tiles, pointing into the traffic archive
+  std::unordered_map<uint64_t, TrafficTile> traffic_tiles;
+  std::shared_ptr<midgard::tar> traffic_archive;
 };
 
 std::shared_ptr<const GraphReader::tile_extract_t>
@@ -274,6 +346,411 @@ SynchronizedTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t
   return cache_.Put(graphid, tile, size);
 }
 
+// ----------------------------------------------------------------------------
+// ShardedTileCache implementation
+// ----------------------------------------------------------------------------
+
+ShardedTileCache::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<Entry*>[capacity]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+// Constructor.
+ShardedTileCache::ShardedTileCache(size_t max_size,
+                                   MemoryLimitControl mem_control,
+                                   size_t shard_count)
+    : shard_capacity_(MIN_SHARD_CAPACITY), cache_size_(0), retired_size_(0),
+      max_cache_size_(max_size), mem_control_(mem_control), shard_hand_(0), epoch_(1) {
+  size_t shards = next_power_of_two(std::max<size_t>(shard_count, 1));
+  shards_.reset(new Shard[shards]);
+  shard_mask_ = shards - 1;
+}
+
+// Destructor, nobody can be reading anymore so everything goes
+ShardedTileCache::~ShardedTileCache() {
+  for (size_t i = 0; i <= shard_mask_; ++i) {
+    auto& shard = shards_[i];
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    if (table) {
+      for (size_t j = 0; j <= table->mask; ++j) {
+        Entry* entry = table->slots[j].load(std::memory_order_relaxed);
+        if (entry && entry != Tombstone()) {
+          delete entry;
+        }
+      }
+      delete table;
+    }
+    for (auto& retired : shard.retired_entries) {
+      delete retired.second;
+    }
+    for (auto& retired : shard.retired_tables) {
+      delete retired.second;
+    }
+  }
+}
+
+// Remembers how big the shard tables should be, they are allocated on first use
+void ShardedTileCache::Reserve(size_t tile_size) {
+  assert(tile_size != 0);
+  size_t per_shard = (max_cache_size_ / tile_size) / (shard_mask_ + 1);
+  size_t capacity = next_power_of_two(std::max(per_shard * 2, MIN_SHARD_CAPACITY));
+  size_t current = shard_capacity_.load(std::memory_order_relaxed);
+  while (capacity > current &&
+         !shard_capacity_.compare_exchange_weak(current, capacity, std::memory_order_relaxed)) {
+  }
+}
+
+const ShardedTileCache::Entry* ShardedTileCache::Find(const Shard& shard,
+                                                      const GraphId& graphid) const {
+  const Table* table = shard.table.load(std::memory_order_acquire);
+  if (!table) {
+    return nullptr;
+  }
+  // the low bits picked the shard so probe with the high ones
+  size_t slot = (Hash(graphid) >> 32) & table->mask;
+  for (size_t probes = 0; probes <= table->mask; ++probes) {
+    const Entry* entry = table->slots[slot].load(std::memory_order_acquire);
+    if (!entry) {
+      return nullptr;
+    }
+    if (entry != Tombstone() && entry->id == graphid) {
+      return entry;
+    }
+    slot = (slot + 1) & table->mask;
+  }
+  return nullptr;
+}
+
+bool ShardedTileCache::Contains(const GraphId& graphid) const {
+  return Find(shard(graphid), graphid) != nullptr;
+}
+
+// Lock free, a hit only flags the entry as recently used for the CLOCK hand
+const GraphTile* ShardedTileCache::Get(const GraphId& graphid) const {
+  const Entry* entry = Find(shard(graphid), graphid);
+  if (!entry) {
+    return nullptr;
+  }
+  // avoid dirtying the cache line when it is already flagged
+  if (!entry->referenced.load(std::memory_order_relaxed)) {
+    entry->referenced.store(true, std::memory_order_relaxed);
+  }
+  return &entry->tile;
+}
+
+const GraphTile*
+ShardedTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  if (size > max_cache_size_) {
+    throw std::runtime_error("ShardedTileCache: tile size is bigger than max cache size");
+  }
+
+  // make room first so that the tile we hand back can't be the one we evict. concurrent puts
+  // can still push the cache over its limit by the size of the tiles being inserted
+  if (mem_control_ == MemoryLimitControl::HARD) {
+    TrimToFit(size);
+  }
+
+  auto& shard = this->shard(graphid);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  // someone else may have loaded it in the meantime
+  if (const Entry* entry = Find(shard, graphid)) {
+    entry->referenced.store(true, std::memory_order_relaxed);
+    return &entry->tile;
+  }
+
+  // grow the table or get rid of the tombstones to keep the probe sequences short
+  Table* table = shard.table.load(std::memory_order_relaxed);
+  size_t capacity = table ? table->mask + 1 : 0;
+  if ((shard.live + shard.tombstones + 1) * 2 > capacity) {
+    capacity = std::max(capacity, shard_capacity_.load(std::memory_order_relaxed));
+    while ((shard.live + 1) * 2 > capacity) {
+      capacity *= 2;
+    }
+    Rebuild(shard, capacity);
+    table = shard.table.load(std::memory_order_relaxed);
+  }
+
+  // take the first free slot, we know the tile isnt in the table
+  auto* entry = new Entry(graphid, tile, size);
+  size_t slot = (Hash(graphid) >> 32) & table->mask;
+  while (true) {
+    Entry* current = table->slots[slot].load(std::memory_order_relaxed);
+    if (!current || current == Tombstone()) {
+      shard.tombstones -= current == Tombstone();
+      table->slots[slot].store(entry, std::memory_order_release);
+      break;
+    }
+    slot = (slot + 1) & table->mask;
+  }
+  ++shard.live;
+  cache_size_ += size;
+
+  // free whatever the readers are done with
+  Reclaim(shard);
+  return &entry->tile;
+}
+
+void ShardedTileCache::Rebuild(Shard& shard, size_t capacity) {
+  Table* old_table = shard.table.load(std::memory_order_relaxed);
+  auto* table = new Table(capacity);
+  if (old_table) {
+    for (size_t i = 0; i <= old_table->mask; ++i) {
+      Entry* entry = old_table->slots[i].load(std::memory_order_relaxed);
+      if (!entry || entry == Tombstone()) {
+        continue;
+      }
+      size_t slot = (Hash(entry->id) >> 32) & table->mask;
+      while (table->slots[slot].load(std::memory_order_relaxed)) {
+        slot = (slot + 1) & table->mask;
+      }
+      table->slots[slot].store(entry, std::memory_order_relaxed);
+    }
+  }
+  // publish the new table, readers still probing the old one can keep doing so
+  shard.table.store(table, std::memory_order_release);
+  shard.tombstones = 0;
+  shard.hand = 0;
+  if (old_table) {
+    shard.retired_tables.emplace_back(epoch_.fetch_add(1), old_table);
+  }
+}
+
+size_t ShardedTileCache::Evict(Shard& shard, size_t bytes) {
+  Table* table = shard.table.load(std::memory_order_relaxed);
+  if (!table) {
+    return 0;
+  }
+
+  // at most two sweeps, one to clear the referenced flags and one to evict
+  size_t freed = 0;
+  for (size_t steps = 0; steps < (table->mask + 1) * 2 && freed < bytes && shard.live; ++steps) {
+    auto& slot = table->slots[shard.hand];
+    shard.hand = (shard.hand + 1) & table->mask;
+    Entry* entry = slot.load(std::memory_order_relaxed);
+    if (!entry || entry == Tombstone() ||
+        entry->referenced.exchange(false, std::memory_order_relaxed)) {
+      continue;
+    }
+
+    // unlink it, it stays around until every reader has moved past it
+    slot.store(Tombstone(), std::memory_order_release);
+    --shard.live;
+    ++shard.tombstones;
+    freed += entry->size;
+    cache_size_ -= entry->size;
+    retired_size_ += entry->size;
+    shard.retired_entries.emplace_back(epoch_.fetch_add(1), entry);
+  }
+  return freed;
+}
+
+void ShardedTileCache::TrimToFit(size_t required_size) {
+  // spread the eviction over all the shards a bit at a time so they age evenly
+  size_t shard_count = shard_mask_ + 1;
+  bool evicted = true;
+  while (evicted) {
+    size_t size = cache_size_.load();
+    if (size + required_size <= max_cache_size_) {
+      break;
+    }
+    size_t excess = size + required_size - max_cache_size_;
+    size_t per_shard = (excess + shard_count - 1) / shard_count;
+
+    evicted = false;
+    size_t start = shard_hand_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < shard_count && excess > 0; ++i) {
+      auto& shard = shards_[(start + i) & shard_mask_];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      size_t freed = Evict(shard, std::min(per_shard, excess));
+      excess -= std::min(freed, excess);
+      evicted = evicted || freed > 0;
+      Reclaim(shard);
+    }
+  }
+}
+
+bool ShardedTileCache::OverCommitted() const {
+  return cache_size_.load() + retired_size_.load() > max_cache_size_;
+}
+
+void ShardedTileCache::Clear() {
+  for (size_t i = 0; i <= shard_mask_; ++i) {
+    auto& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    if (!table) {
+      continue;
+    }
+
+    // swap in an empty table and retire the old one along with all of its entries
+    shard.table.store(new Table(shard_capacity_.load(std::memory_order_relaxed)),
+                      std::memory_order_release);
+    uint64_t epoch = epoch_.fetch_add(1);
+    for (size_t j = 0; j <= table->mask; ++j) {
+      Entry* entry = table->slots[j].load(std::memory_order_relaxed);
+      if (entry && entry != Tombstone()) {
+        cache_size_ -= entry->size;
+        retired_size_ += entry->size;
+        shard.retired_entries.emplace_back(epoch, entry);
+      }
+    }
+    shard.retired_tables.emplace_back(epoch, table);
+    shard.live = 0;
+    shard.tombstones = 0;
+    shard.hand = 0;
+    Reclaim(shard);
+  }
+}
+
+void ShardedTileCache::Trim() {
+  TrimToFit(0);
+  // whatever was evicted before may be unused by now
+  for (size_t i = 0; i <= shard_mask_; ++i) {
+    auto& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Reclaim(shard);
+  }
+}
+
+void ShardedTileCache::Reclaim(Shard& shard) {
+  if (shard.retired_entries.empty() && shard.retired_tables.empty()) {
+    return;
+  }
+
+  // anything retired before the oldest quiescent point of all readers is unreachable
+  uint64_t min_epoch = MinReaderEpoch();
+  auto entries_end = std::remove_if(shard.retired_entries.begin(), shard.retired_entries.end(),
+                                    [this, min_epoch](const std::pair<uint64_t, Entry*>& retired) {
+                                      if (retired.first >= min_epoch) {
+                                        return false;
+                                      }
+                                      retired_size_ -= retired.second->size;
+                                      delete retired.second;
+                                      return true;
+                                    });
+  shard.retired_entries.erase(entries_end, shard.retired_entries.end());
+  auto tables_end = std::remove_if(shard.retired_tables.begin(), shard.retired_tables.end(),
+                                   [min_epoch](const std::pair<uint64_t, Table*>& retired) {
+                                     if (retired.first >= min_epoch) {
+                                       return false;
+                                     }
+                                     delete retired.second;
+                                     return true;
+                                   });
+  shard.retired_tables.erase(tables_end, shard.retired_tables.end());
+}
+
+constexpr uint64_t ShardedTileCache::kIdleReader;
+
+uint64_t ShardedTileCache::MinReaderEpoch() const {
+  std::lock_guard<std::mutex> lock(readers_mutex_);
+  uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+  // free slots are 0 and idle readers kIdleReader, which doesn't lower the minimum
+  for (const auto& reader : readers_) {
+    uint64_t epoch = reader.load();
+    if (epoch != 0) {
+      min_epoch = std::min(min_epoch, epoch);
+    }
+  }
+  return min_epoch;
+}
+
+size_t ShardedTileCache::RegisterReader() {
+  std::lock_guard<std::mutex> lock(readers_mutex_);
+  // reuse a slot of a reader that went away
+  for (size_t i = 0; i < readers_.size(); ++i) {
+    if (readers_[i].load() == 0) {
+      readers_[i].store(kIdleReader);
+      return i;
+    }
+  }
+  readers_.emplace_back(kIdleReader);
+  return readers_.size() - 1;
+}
+
+void ShardedTileCache::UnregisterReader(size_t reader) {
+  std::lock_guard<std::mutex> lock(readers_mutex_);
+  readers_[reader].store(0);
+}
+
+void ShardedTileCache::Quiesce(size_t reader) {
+  std::lock_guard<std::mutex> lock(readers_mutex_);
+  readers_[reader].store(epoch_.load());
+}
+
+void ShardedTileCache::Idle(size_t reader) {
+  std::lock_guard<std::mutex> lock(readers_mutex_);
+  readers_[reader].store(kIdleReader);
+}
+
+// ----------------------------------------------------------------------------
+// ShardedTileCacheReader implementation
+// ----------------------------------------------------------------------------
+
+// Constructor.
+ShardedTileCacheReader::ShardedTileCacheReader(const std::shared_ptr<ShardedTileCache>& cache)
+    : cache_(cache), reader_(cache->RegisterReader()), active_(false) {
+}
+
+// Destructor.
+ShardedTileCacheReader::~ShardedTileCacheReader() {
+  cache_->UnregisterReader(reader_);
+}
+
+void ShardedTileCacheReader::Reserve(size_t tile_size) {
+  cache_->Reserve(tile_size);
+}
+
+bool ShardedTileCacheReader::Contains(const GraphId& graphid) const {
+  return cache_->Contains(graphid);
+}
+
+bool ShardedTileCacheReader::OverCommitted() const {
+  return cache_->OverCommitted();
+}
+
+// Clearing or trimming invalidates the tiles we handed out so the owner holds none of them
+// before nor after the call. Being idle through it means what we evicted ourselves doesn't
+// have to wait on us to be reclaimed
+void ShardedTileCacheReader::Clear() {
+  Release();
+  cache_->Clear();
+}
+
+void ShardedTileCacheReader::Trim() {
+  Release();
+  cache_->Trim();
+}
+
+void ShardedTileCacheReader::Release() {
+  if (active_.exchange(false)) {
+    cache_->Idle(reader_);
+  }
+}
+
+// The quiescent point has to be marked before the lookup so nothing retired after it is freed
+// while we may be holding it
+void ShardedTileCacheReader::Activate() const {
+  if (!active_.load(std::memory_order_relaxed)) {
+    cache_->Quiesce(reader_);
+    active_.store(true, std::memory_order_relaxed);
+  }
+}
+
+const GraphTile* ShardedTileCacheReader::Get(const GraphId& graphid) const {
+  Activate();
+  return cache_->Get(graphid);
+}
+
+const GraphTile*
+ShardedTileCacheReader::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  Activate();
+  return cache_->Put(graphid, tile, size);
+}
+
 // Constructs tile cache.
 TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
   size_t max_cache_size = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
@@ -283,22 +760,22 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
                              ? TileCacheLRU::MemoryLimitControl::HARD
                              : TileCacheLRU::MemoryLimitControl::SOFT;
 
-  // wrap tile cache with thread-safe version
+  // share one thread-safe tile cache between all the readers
   if (pt.get<bool>("global_synchronized_cache", false)) {
-    // Handle synchronization of cache
-    static std::mutex globalCacheMutex_;
-    static std::shared_ptr<TileCache> globalTileCache_;
     // We need to lock the factory method itself to prevent races
+    static std::shared_ptr<ShardedTileCache> globalTileCache_;
     static std::mutex factoryMutex;
     std::lock_guard<std::mutex> lock(factoryMutex);
     if (!globalTileCache_) {
-      if (use_lru_cache) {
-        globalTileCache_.reset(new TileCacheLRU(max_cache_size, lru_mem_control));
-      } else {
-        globalTileCache_.reset(new SimpleTileCache(max_cache_size));
-      }
+      // hard memory control only ever applied to the lru cache
+      auto mem_control = use_lru_cache && lru_mem_control == TileCacheLRU::MemoryLimitControl::HARD
+                             ? ShardedTileCache::MemoryLimitControl::HARD
+                             : ShardedTileCache::MemoryLimitControl::SOFT;
+      globalTileCache_.reset(
+          new ShardedTileCache(max_cache_size, mem_control,
+                               pt.get<size_t>("global_cache_shards", DEFAULT_CACHE_SHARDS)));
     }
-    return new SynchronizedTileCache(*globalTileCache_, globalCacheMutex_);
+    return new ShardedTileCacheReader(globalTileCache_);
   }
 
   // Otherwise: No synchronization
@@ -320,8 +797,10 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt)
   if (!tile_url_.empty() && tile_url_.find(GraphTile::kTilePathPattern) == std::string::npos)
     throw std::runtime_error("Not found tilePath pattern in tile url");
   // Reserve cache (based on whether using individual tile files or shared,
-  // mmap'd file
-  cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+  // mmap'd file). The extract views don't go through the cache at all
+  if (tile_extract_->views.empty()) {
+    cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+  }
 }
 
 // Method to test if tile exists
@@ -374,8 +853,15 @@ const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
     return nullptr;
   }
 
-  // Check if the level/tileid combination is in the cache
+  // The extract views are read only and live as long as the extract so they need neither
+  // locking nor any accounting, the lookup is all there is to it
   auto base = graphid.Tile_Base();
+  if (!tile_extract_->views.empty()) {
+    auto view = tile_extract_->views.find(base);
+    return view == tile_extract_->views.cend() ? nullptr : &view->second;
+  }
+
+  // Check if the level/tileid combination is in the cache
   if (auto cached = cache_->Get(base)) {
     // LOG_DEBUG("Memory cache hit " + GraphTile::FileSuffix(base));
     return cached;
@@ -396,6 +882,7 @@ const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
       // LOG_DEBUG("Memory map cache miss " + GraphTile::FileSuffix(base));
       return nullptr;
     }
+    tile.set_traffic_tile(tile_extract_->traffic_tile(base));
     // LOG_DEBUG("Memory map cache hit " + GraphTile::FileSuffix(base));
 
     // Keep a copy in the cache and return it
@@ -432,6 +919,7 @@ const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
     } else {
       // LOG_DEBUG("Disk cache hit " + GraphTile::FileSuffix(base));
     }
+    tile.set_traffic_tile(tile_extract_->traffic_tile(base));
 
     // Keep a copy in the cache and return it
     size_t size = tile.header()->end_offset();
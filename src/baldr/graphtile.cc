@@ -327,6 +327,9 @@ void GraphTile::Initialize(const GraphId& graphid, char* tile_ptr, const size_t
   if (graphid.level() == 3) {
     AssociateOneStopIds(graphid);
   }
+
+  // No edge costs until a costing expands the tile
+  edge_costs_ = std::make_shared<EdgeCostTables>();
 }
 
 // For transit tiles we need to save off the pair<tileid,lineid> lookup via
@@ -0,0 +1,108 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "baldr/landmarks.h"
+#include "midgard/logging.h"
+
+namespace valhalla {
+namespace baldr {
+
+constexpr uint32_t LandmarkTable::kUnreached;
+
+LandmarkTable::LandmarkTable(const std::string& file_name) : header_(nullptr), rows_(nullptr) {
+  struct stat s;
+  if (stat(file_name.c_str(), &s)) {
+    throw std::runtime_error("(stat): " + file_name + " " + strerror(errno));
+  }
+  if (static_cast<size_t>(s.st_size) < sizeof(LandmarkHeader)) {
+    throw std::runtime_error(file_name + " is not a landmark table");
+  }
+  mm_.map(file_name, s.st_size);
+
+  // check the header and that the file holds everything it says it does
+  header_ = reinterpret_cast<const LandmarkHeader*>(mm_.get());
+  if (memcmp(header_->magic, kLandmarkMagic, sizeof(kLandmarkMagic)) != 0 ||
+      header_->version != kLandmarkVersion) {
+    throw std::runtime_error(file_name + " is not a version " + std::to_string(kLandmarkVersion) +
+                             " landmark table");
+  }
+  size_t size = sizeof(LandmarkHeader) + header_->tile_count * sizeof(LandmarkTile) +
+                header_->landmark_count * sizeof(uint64_t) +
+                header_->node_count * 2 * header_->landmark_count * sizeof(uint32_t);
+  if (size != mm_.size()) {
+    throw std::runtime_error(file_name + " is truncated, expected " + std::to_string(size) +
+                             " bytes");
+  }
+
+  // index the tiles
+  const auto* tile = reinterpret_cast<const LandmarkTile*>(header_ + 1);
+  tiles_.reserve(header_->tile_count);
+  for (uint32_t i = 0; i < header_->tile_count; ++i, ++tile) {
+    tiles_.emplace(static_cast<uint32_t>(tile->tile),
+                   std::make_pair(tile->first_row, tile->node_count));
+  }
+  rows_ = reinterpret_cast<const uint32_t*>(
+      reinterpret_cast<const uint64_t*>(tile) + header_->landmark_count);
+}
+
+void LandmarkTable::Write(const std::string& file_name,
+                          const uint32_t access,
+                          const std::vector<GraphId>& landmarks,
+                          const std::vector<LandmarkTile>& tiles,
+                          const std::vector<uint32_t>& rows) {
+  LandmarkHeader header{};
+  memcpy(header.magic, kLandmarkMagic, sizeof(kLandmarkMagic));
+  header.version = kLandmarkVersion;
+  header.access = access;
+  header.landmark_count = landmarks.size();
+  header.tile_count = tiles.size();
+  header.node_count = landmarks.empty() ? 0 : rows.size() / (2 * landmarks.size());
+
+  std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open " + file_name);
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(tiles.data()), tiles.size() * sizeof(LandmarkTile));
+  for (const auto& landmark : landmarks) {
+    file.write(reinterpret_cast<const char*>(&landmark.value), sizeof(uint64_t));
+  }
+  file.write(reinterpret_cast<const char*>(rows.data()), rows.size() * sizeof(uint32_t));
+  if (!file) {
+    throw std::runtime_error("Failed to write " + file_name);
+  }
+}
+
+std::vector<GraphId> LandmarkTable::landmarks() const {
+  const auto* values = reinterpret_cast<const uint64_t*>(
+      reinterpret_cast<const LandmarkTile*>(header_ + 1) + header_->tile_count);
+  std::vector<GraphId> landmarks;
+  for (uint32_t i = 0; i < header_->landmark_count; ++i) {
+    landmarks.emplace_back(values[i]);
+  }
+  return landmarks;
+}
+
+Landmarks::Landmarks(const std::string& dir) {
+  for (const auto& costing : kLandmarkCostings) {
+    auto file_name = dir + "/" + costing.first + ".landmarks";
+    struct stat s;
+    if (stat(file_name.c_str(), &s)) {
+      continue;
+    }
+    std::unique_ptr<LandmarkTable> table(new LandmarkTable(file_name));
+    if (table->access() != costing.second) {
+      LOG_WARN(file_name + " was built for another access mode, skipping it");
+      continue;
+    }
+    LOG_INFO("Loaded " + file_name + " with " + std::to_string(table->landmark_count()) +
+             " landmarks for " + std::to_string(table->node_count()) + " nodes");
+    tables_.emplace(costing.second, std::move(table));
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
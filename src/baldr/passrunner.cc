@@ -0,0 +1,82 @@
+#include "baldr/passrunner.h"
+
+namespace valhalla {
+namespace baldr {
+
+PassRunner::PassRunner(GraphReader& reader,
+                       const std::vector<std::shared_ptr<GraphReader>>& helper_readers)
+    : reader_(reader), task_(nullptr), count_(0), next_(0), running_(0), pass_(0), stop_(false) {
+  for (const auto& helper : helper_readers) {
+    threads_.emplace_back([this, helper]() { Help(*helper); });
+  }
+}
+
+PassRunner::~PassRunner() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void PassRunner::Run(const uint32_t count, const task_t& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    next_ = 0;
+    running_ = threads_.size();
+    ++pass_;
+  }
+  start_.notify_all();
+  Work(reader_);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return running_ == 0; });
+  task_ = nullptr;
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void PassRunner::Work(GraphReader& reader) {
+  try {
+    for (uint32_t i = next_++; i < count_; i = next_++) {
+      (*task_)(reader, i);
+    }
+  } catch (...) {
+    // Stop handing out tasks, the pass is failed
+    next_ = count_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_) {
+      error_ = std::current_exception();
+    }
+  }
+}
+
+void PassRunner::Help(GraphReader& reader) {
+  uint64_t pass = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [this, pass]() { return stop_ || pass_ != pass; });
+      if (stop_) {
+        return;
+      }
+      pass = pass_;
+    }
+    Work(reader);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--running_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+} // namespace baldr
+} // namespace valhalla
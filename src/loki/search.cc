@@ -1,4 +1,5 @@
 #include "loki/search.h"
+#include "baldr/passrunner.h"
 #include "baldr/tilehierarchy.h"
 #include "loki/reach.h"
 #include "midgard/distanceapproximator.h"
@@ -30,6 +31,22 @@ template <typename T> inline T square(T v) {
   return v * v;
 }
 
+// Bins shared by at least this many locations have their edges projected onto the locations
+// by several threads, when the search has helper threads
+constexpr size_t kMinParallelLocations = 16;
+// Number of locations each thread projects the edges of a bin onto at a time
+constexpr size_t kLocationsPerSlice = 8;
+// Number of edges of a bin projected in one go before the candidates are updated
+constexpr size_t kEdgesPerChunk = 64;
+
+// The reach of an edge is cached by its graph id rather than by the edge pointer so that threads
+// with their own graph readers find the reaches the others computed
+GraphId edge_id(const GraphTile* tile, const DirectedEdge* edge) {
+  GraphId id = tile->id();
+  id.set_id(tile->directededge_index(edge));
+  return id;
+}
+
 bool side_filter(const PathLocation::PathEdge& edge, const Location& location, GraphReader& reader) {
   // nothing to filter if you dont want to filter or if there is no side of street
   if (edge.sos == PathLocation::SideOfStreet::NONE ||
@@ -124,6 +141,24 @@ struct candidate_t {
   }
 };
 
+// The closest point of an edge to a location
+struct projection_t {
+  double sq_distance;
+  PointLL point;
+  size_t index;
+};
+
+// Reaches of edges by their graph id
+using reach_cache_t = std::unordered_map<uint64_t, directed_reach>;
+
+// An edge of a bin, ready to be projected onto the locations sharing the bin
+struct bin_edge_t {
+  GraphId id;
+  const GraphTile* tile;
+  const DirectedEdge* edge;
+  std::shared_ptr<const EdgeInfo> edge_info;
+};
+
 // This structure contains the context of the projection of a
 // Location.  At the creation, a bin is affected to the point.  The
 // test() method should be called to each valid segment of the bin.
@@ -209,15 +244,19 @@ struct bin_handler_t {
   const DynamicCost* costing;
   unsigned int max_reach_limit;
   std::vector<candidate_t> bin_candidates;
-  std::unordered_set<uint64_t> correlated_edges;
 
   // keep track of edges whose reachability we've already computed
-  // TODO: dont use pointers as keys, its safe for now but fancy caching one day could be bad
-  std::unordered_map<const DirectedEdge*, directed_reach> directed_reaches;
+  reach_cache_t directed_reaches;
+
+  // helper threads, if any, and the edges of a bin with their projections onto each location
+  std::unique_ptr<PassRunner> runner;
+  std::vector<bin_edge_t> bin_edges;
+  std::vector<projection_t> projections;
 
   bin_handler_t(const std::vector<valhalla::baldr::Location>& locations,
                 valhalla::baldr::GraphReader& reader,
-                const DynamicCost* costing)
+                const DynamicCost* costing,
+                const std::vector<std::shared_ptr<GraphReader>>& helper_readers)
       : reader(reader), costing(costing),
         edge_filter(costing ? costing->GetEdgeFilter() : PassThroughEdgeFilter),
         node_filter(costing ? costing->GetNodeFilter() : PassThroughNodeFilter) {
@@ -236,13 +275,20 @@ struct bin_handler_t {
     // TODO: make space for reach check in a more empirical way
     auto reservation = std::max(max_reach_limit, static_cast<decltype(max_reach_limit)>(1));
     directed_reaches.reserve(reservation * 1024);
+    // only worth starting threads when there is more than one location to share out
+    if (!helper_readers.empty() && pps.size() > 1) {
+      runner.reset(new PassRunner(reader, helper_readers));
+    }
   }
 
-  void correlate_node(const Location& location,
+  void correlate_node(GraphReader& reader,
+                      const Location& location,
                       const GraphId& found_node,
                       const candidate_t& candidate,
                       PathLocation& correlated,
-                      std::vector<PathLocation::PathEdge>& filtered) {
+                      std::vector<PathLocation::PathEdge>& filtered,
+                      std::unordered_set<uint64_t>& correlated_edges,
+                      reach_cache_t* new_reaches) {
     // the search cutoff is a hard filter so skip any outside of that
     if (candidate.point.Distance(location.latlng_) > location.search_cutoff_)
       return;
@@ -271,7 +317,7 @@ struct bin_handler_t {
 
         // do we want this edge
         if (edge_filter(edge) != 0.0f) {
-          auto reach = get_reach(edge);
+          auto reach = get_reach(reader, id, edge, new_reaches);
           PathLocation::PathEdge path_edge{std::move(id),
                                            0.f,
                                            node_ll,
@@ -295,7 +341,7 @@ struct bin_handler_t {
         }
         const auto* other_edge = other_tile->directededge(other_id);
         if (edge_filter(other_edge) != 0.0f) {
-          auto reach = get_reach(other_edge);
+          auto reach = get_reach(reader, other_id, other_edge, new_reaches);
           PathLocation::PathEdge path_edge{std::move(other_id),
                                            1.f,
                                            node_ll,
@@ -327,10 +373,13 @@ struct bin_handler_t {
     crawl(found_node, true);
   }
 
-  void correlate_edge(const Location& location,
+  void correlate_edge(GraphReader& reader,
+                      const Location& location,
                       const candidate_t& candidate,
                       PathLocation& correlated,
-                      std::vector<PathLocation::PathEdge>& filtered) {
+                      std::vector<PathLocation::PathEdge>& filtered,
+                      std::unordered_set<uint64_t>& correlated_edges,
+                      reach_cache_t* new_reaches) {
     // get the distance between the result
     auto distance = candidate.point.Distance(location.latlng_);
     // the search cutoff is a hard filter so skip any outside of that
@@ -354,7 +403,8 @@ struct bin_handler_t {
       // side of street
       auto sq_tolerance = square(double(location.street_side_tolerance_));
       auto side = candidate.get_side(location.latlng_, candidate.sq_distance, sq_tolerance);
-      auto reach = get_reach(candidate.edge);
+      auto reach =
+          get_reach(reader, edge_id(candidate.tile, candidate.edge), candidate.edge, new_reaches);
       PathLocation::PathEdge path_edge{candidate.edge_id, length_ratio, candidate.point,
                                        distance,          side,         reach.outbound,
                                        reach.inbound};
@@ -372,7 +422,7 @@ struct bin_handler_t {
       const DirectedEdge* other_edge;
       if (opposing_edge_id.Is_Valid() && (other_edge = other_tile->directededge(opposing_edge_id)) &&
           edge_filter(other_edge) != 0.0f) {
-        auto reach = get_reach(other_edge);
+        auto reach = get_reach(reader, opposing_edge_id, other_edge, new_reaches);
         PathLocation::PathEdge other_path_edge{opposing_edge_id, 1 - length_ratio, candidate.point,
                                                distance,         flip_side(side),  reach.outbound,
                                                reach.inbound};
@@ -387,16 +437,26 @@ struct bin_handler_t {
     }
   }
 
-  directed_reach get_reach(const DirectedEdge* edge) {
+  // new_reaches is where a thread other than the one that searched the bins keeps the reaches it
+  // computes, since the cache of the search is shared. null to add them to that cache
+  directed_reach get_reach(GraphReader& reader,
+                           const GraphId& id,
+                           const DirectedEdge* edge,
+                           reach_cache_t* new_reaches) {
     // if its in cache return it
-    auto itr = directed_reaches.find(edge);
+    auto itr = directed_reaches.find(id);
     if (itr != directed_reaches.cend())
       return itr->second;
+    if (new_reaches) {
+      itr = new_reaches->find(id);
+      if (itr != new_reaches->cend())
+        return itr->second;
+    }
 
     // notice we do both directions here because in the end we use this reach for all input locations
     auto reach =
         SimpleReach(edge, max_reach_limit, reader, edge_filter, node_filter, kInbound | kOutbound);
-    directed_reaches[edge] = reach;
+    (new_reaches ? *new_reaches : directed_reaches)[id] = reach;
     return reach;
   }
 
@@ -410,7 +470,8 @@ struct bin_handler_t {
       return {};
 
     // do we already know about this one?
-    auto found = directed_reaches.find(edge);
+    auto id = edge_id(tile, edge);
+    auto found = directed_reaches.find(id);
     if (found != directed_reaches.cend())
       return found->second;
 
@@ -430,157 +491,208 @@ struct bin_handler_t {
     // notice we do both directions here because in the end we use this reach for all input locations
     auto reach =
         SimpleReach(edge, max_reach_limit, reader, edge_filter, node_filter, kInbound | kOutbound);
-    directed_reaches[edge] = reach;
+    directed_reaches[id] = reach;
 
     // if the inbound reach is not 0 and the outbound reach is not 0 and the opposing edge is not
     // filtered then the reaches of both edges are the same
     const DirectedEdge* opp_edge = nullptr;
     if (reach.outbound > 0 && reach.inbound > 0 && (opp_edge = reader.GetOpposingEdge(edge, tile)) &&
         edge_filter(opp_edge) > 0.f)
-      directed_reaches[opp_edge] = reach;
+      directed_reaches[edge_id(tile, opp_edge)] = reach;
 
     return reach;
   }
 
+  // project the edges of the bin onto the range of candidates that share it. each location only
+  // reads the shape of the edges, so with helper threads large ranges are split between them
+  void project_bin_edges(std::vector<projector_wrapper>::iterator begin,
+                         std::vector<projector_wrapper>::iterator end) {
+    size_t count = end - begin;
+    projections.resize(bin_edges.size() * count);
+    auto project = [this, begin, count](size_t first, size_t last) {
+      for (size_t edge_index = 0; edge_index < bin_edges.size(); ++edge_index) {
+        auto* projection = &projections[edge_index * count];
+        // reset these so we know the best point along the edge
+        for (size_t p = first; p < last; ++p) {
+          projection[p].sq_distance = std::numeric_limits<float>::max();
+        }
+
+        // TODO: can we speed this up? the majority of edges will be short and far away enough
+        // such that the closest point on the edge will be one of the edges end points, we can get
+        // these coordinates them from the nodes in the graph. we can then find whichever end is
+        // closest to the input point p, call it n. we can then define an half plane h intersecting
+        // n so that its orthogonal to the ray from p to n. using h, we only need to test segments
+        // of the shape which are on the same side of h that p is. to make this fast we would need
+        // a a trivial half plane test as maybe a single dot product and comparison?
+
+        // get some shape of the edge
+        auto shape = bin_edges[edge_index].edge_info->lazy_shape();
+        PointLL v;
+        if (!shape.empty()) {
+          v = shape.pop();
+        }
+
+        // iterate along this edges segments projecting each of the points
+        for (size_t i = 0; !shape.empty(); ++i) {
+          auto u = v;
+          v = shape.pop();
+          // for each input point
+          for (size_t p = first; p < last; ++p) {
+            // how close is the input to this segment
+            const auto& pp = *(begin + p);
+            auto point = pp.project(u, v);
+            auto sq_distance = pp.project.approx.DistanceSquared(point);
+            // do we want to keep it
+            if (sq_distance < projection[p].sq_distance) {
+              projection[p].sq_distance = sq_distance;
+              projection[p].point = std::move(point);
+              projection[p].index = i;
+            }
+          }
+        }
+      }
+    };
+
+    if (!runner || count < kMinParallelLocations) {
+      project(0, count);
+      return;
+    }
+    uint32_t slices = (count + kLocationsPerSlice - 1) / kLocationsPerSlice;
+    runner->Run(slices, [&project, count](GraphReader&, const uint32_t slice) {
+      project(slice * kLocationsPerSlice, std::min(count, (slice + 1) * kLocationsPerSlice));
+    });
+  }
+
   // handle a bin for the range of candidates that share it
   void handle_bin(std::vector<projector_wrapper>::iterator begin,
                   std::vector<projector_wrapper>::iterator end) {
-    // iterate over the edges in the bin
+    // iterate over the edges in the bin, a chunk of them at a time
     auto tile = begin->cur_tile;
     auto edges = tile->GetBin(begin->bin_index);
-    for (auto e : edges) {
-      // get the tile and edge
-      if (!reader.GetGraphTile(e, tile)) {
-        continue;
-      }
+    for (auto e_itr = edges.begin(); e_itr != edges.end();) {
+      bin_edges.clear();
+      for (; e_itr != edges.end() && bin_edges.size() < kEdgesPerChunk; ++e_itr) {
+        // get the tile and edge
+        auto e = *e_itr;
+        if (!reader.GetGraphTile(e, tile)) {
+          continue;
+        }
 
-      // no thanks on this one or its evil twin
-      const auto* edge = tile->directededge(e);
-      if (edge_filter(edge) == 0.0f && (!(e = reader.GetOpposingEdgeId(e, tile)).Is_Valid() ||
-                                        edge_filter(edge = tile->directededge(e)) == 0.0f)) {
-        continue;
-      }
+        // no thanks on this one or its evil twin
+        const auto* edge = tile->directededge(e);
+        if (edge_filter(edge) == 0.0f && (!(e = reader.GetOpposingEdgeId(e, tile)).Is_Valid() ||
+                                          edge_filter(edge = tile->directededge(e)) == 0.0f)) {
+          continue;
+        }
 
-      // reset these so we know the best point along the edge
-      auto c_itr = bin_candidates.begin();
-      decltype(begin) p_itr;
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        c_itr->sq_distance = std::numeric_limits<float>::max();
+        // get some shape of the edge
+        auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge->edgeinfo_offset()));
+        bin_edges.push_back({e, tile, edge, std::move(edge_info)});
       }
 
-      // TODO: can we speed this up? the majority of edges will be short and far away enough
-      // such that the closest point on the edge will be one of the edges end points, we can get
-      // these coordinates them from the nodes in the graph. we can then find whichever end is
-      // closest to the input point p, call it n. we can then define an half plane h intersecting n
-      // so that its orthogonal to the ray from p to n. using h, we only need to test segments
-      // of the shape which are on the same side of h that p is. to make this fast we would need a
-      // a trivial half plane test as maybe a single dot product and comparison?
-
-      // get some shape of the edge
-      auto edge_info = std::make_shared<const EdgeInfo>(tile->edgeinfo(edge->edgeinfo_offset()));
-      auto shape = edge_info->lazy_shape();
-      PointLL v;
-      if (!shape.empty()) {
-        v = shape.pop();
-      }
+      // find the best point along each edge for each location
+      project_bin_edges(begin, end);
 
-      // iterate along this edges segments projecting each of the points
-      for (size_t i = 0; !shape.empty(); ++i) {
-        auto u = v;
-        v = shape.pop();
-        // for each input point
-        c_itr = bin_candidates.begin();
-        for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-          // how close is the input to this segment
-          auto point = p_itr->project(u, v);
-          auto sq_distance = p_itr->project.approx.DistanceSquared(point);
-          // do we want to keep it
-          if (sq_distance < c_itr->sq_distance) {
-            c_itr->sq_distance = sq_distance;
-            c_itr->point = std::move(point);
-            c_itr->index = i;
-          }
-        }
+      for (size_t edge_index = 0; edge_index < bin_edges.size(); ++edge_index) {
+        handle_edge(begin, end, bin_edges[edge_index], &projections[edge_index * (end - begin)]);
       }
+    }
 
-      // if we already have a better reachable candidate we can just assume this one is reachable
-      auto reach = check_reachability(begin, end, tile, edge);
-
-      // keep the best point along this edge if it makes sense
-      c_itr = bin_candidates.begin();
-      for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
-        // is this edge reachable in the right way
-        bool reachable = reach.outbound >= p_itr->location.min_outbound_reach_ &&
-                         reach.inbound >= p_itr->location.min_inbound_reach_;
-        // it's possible that it isnt reachable but the opposing is, switch to that if so
-        const GraphTile* opp_tile = tile;
-        const DirectedEdge* opp_edge = nullptr;
-        if (!reachable && (opp_edge = reader.GetOpposingEdge(edge, opp_tile)) &&
-            edge_filter(opp_edge) > 0.f) {
-          auto opp_reach = check_reachability(begin, end, opp_tile, opp_edge);
-          if (opp_reach.outbound >= p_itr->location.min_outbound_reach_ &&
-              opp_reach.inbound >= p_itr->location.min_inbound_reach_) {
-            tile = opp_tile;
-            edge = opp_edge;
-            reach = opp_reach;
-            reachable = true;
-          }
-        }
+    // bin is finished, advance the candidates to their respective next bins
+    for (auto p_itr = begin; p_itr != end; ++p_itr) {
+      p_itr->next_bin(reader);
+    }
+  }
 
-        // which batch of findings will this go into
-        auto* batch = reachable ? &p_itr->reachable : &p_itr->unreachable;
+  // keep the best point along the edge for each of the range of candidates if it makes sense
+  void handle_edge(std::vector<projector_wrapper>::iterator begin,
+                   std::vector<projector_wrapper>::iterator end,
+                   const bin_edge_t& bin_edge,
+                   const projection_t* projection) {
+    auto e = bin_edge.id;
+    auto tile = bin_edge.tile;
+    auto edge = bin_edge.edge;
+    const auto& edge_info = bin_edge.edge_info;
+    auto c_itr = bin_candidates.begin();
+    decltype(begin) p_itr;
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr, ++projection) {
+      c_itr->sq_distance = projection->sq_distance;
+      c_itr->point = projection->point;
+      c_itr->index = projection->index;
+    }
 
-        // if its empty append
-        if (batch->empty()) {
-          c_itr->edge = edge;
-          c_itr->edge_id = e;
-          c_itr->edge_info = edge_info;
-          c_itr->tile = tile;
-          batch->emplace_back(std::move(*c_itr));
-          continue;
+    // if we already have a better reachable candidate we can just assume this one is reachable
+    auto reach = check_reachability(begin, end, tile, edge);
+
+    // keep the best point along this edge if it makes sense
+    c_itr = bin_candidates.begin();
+    for (p_itr = begin; p_itr != end; ++p_itr, ++c_itr) {
+      // is this edge reachable in the right way
+      bool reachable = reach.outbound >= p_itr->location.min_outbound_reach_ &&
+                       reach.inbound >= p_itr->location.min_inbound_reach_;
+      // it's possible that it isnt reachable but the opposing is, switch to that if so
+      const GraphTile* opp_tile = tile;
+      const DirectedEdge* opp_edge = nullptr;
+      if (!reachable && (opp_edge = reader.GetOpposingEdge(edge, opp_tile)) &&
+          edge_filter(opp_edge) > 0.f) {
+        auto opp_reach = check_reachability(begin, end, opp_tile, opp_edge);
+        if (opp_reach.outbound >= p_itr->location.min_outbound_reach_ &&
+            opp_reach.inbound >= p_itr->location.min_inbound_reach_) {
+          tile = opp_tile;
+          edge = opp_edge;
+          reach = opp_reach;
+          reachable = true;
         }
+      }
 
-        // get some info about possibilities
-        bool in_radius = c_itr->sq_distance < p_itr->sq_radius;
-        bool better = c_itr->sq_distance < batch->back().sq_distance;
-        bool last_in_radius = batch->back().sq_distance < p_itr->sq_radius;
-        // TODO: this is a bit blunt in that any reachable edges between the best or ones within
-        // the radius will make unreachable edges that are even the tiniest bit further away unviable
-        // it seems like we should have a slightly looser radius to allow for unreachable edges but
-        // its unclear what that should be as in most cases we are working around not actually knowing
-        // the accuracy or even input modality of the incoming location
-        bool closer_external_reachable =
-            reachable && c_itr->sq_distance < p_itr->closest_external_reachable;
-
-        // it has to either be better or in the radius to move on
-        if (in_radius || better) {
-          c_itr->edge = edge;
-          c_itr->edge_id = e;
-          c_itr->edge_info = edge_info;
-          c_itr->tile = tile;
-          // the last one wasnt in the radius so replace it with this one because its better or is
-          // in the radius
-          if (!last_in_radius) {
-            if (closer_external_reachable)
-              p_itr->closest_external_reachable = batch->back().sq_distance;
-            batch->back() = std::move(*c_itr);
-            // last one is in the radius but this one is better so put it on the end
-          } else if (better) {
-            batch->emplace_back(std::move(*c_itr));
-            // last one and this one are both in the radius but this one is not as good
-          } else {
-            batch->emplace_back(std::move(*c_itr));
-            std::swap(*(batch->end() - 1), *(batch->end() - 2));
-          }
-        } // not in radius or better and reachable and closer than closest one outside of radius
-        else if (closer_external_reachable)
-          p_itr->closest_external_reachable = c_itr->sq_distance;
+      // which batch of findings will this go into
+      auto* batch = reachable ? &p_itr->reachable : &p_itr->unreachable;
+
+      // if its empty append
+      if (batch->empty()) {
+        c_itr->edge = edge;
+        c_itr->edge_id = e;
+        c_itr->edge_info = edge_info;
+        c_itr->tile = tile;
+        batch->emplace_back(std::move(*c_itr));
+        continue;
       }
-    }
 
-    // bin is finished, advance the candidates to their respective next bins
-    for (auto p_itr = begin; p_itr != end; ++p_itr) {
-      p_itr->next_bin(reader);
+      // get some info about possibilities
+      bool in_radius = c_itr->sq_distance < p_itr->sq_radius;
+      bool better = c_itr->sq_distance < batch->back().sq_distance;
+      bool last_in_radius = batch->back().sq_distance < p_itr->sq_radius;
+      // TODO: this is a bit blunt in that any reachable edges between the best or ones within
+      // the radius will make unreachable edges that are even the tiniest bit further away unviable
+      // it seems like we should have a slightly looser radius to allow for unreachable edges but
+      // its unclear what that should be as in most cases we are working around not actually knowing
+      // the accuracy or even input modality of the incoming location
+      bool closer_external_reachable =
+          reachable && c_itr->sq_distance < p_itr->closest_external_reachable;
+
+      // it has to either be better or in the radius to move on
+      if (in_radius || better) {
+        c_itr->edge = edge;
+        c_itr->edge_id = e;
+        c_itr->edge_info = edge_info;
+        c_itr->tile = tile;
+        // the last one wasnt in the radius so replace it with this one because its better or is
+        // in the radius
+        if (!last_in_radius) {
+          if (closer_external_reachable)
+            p_itr->closest_external_reachable = batch->back().sq_distance;
+          batch->back() = std::move(*c_itr);
+          // last one is in the radius but this one is better so put it on the end
+        } else if (better) {
+          batch->emplace_back(std::move(*c_itr));
+          // last one and this one are both in the radius but this one is not as good
+        } else {
+          batch->emplace_back(std::move(*c_itr));
+          std::swap(*(batch->end() - 1), *(batch->end() - 2));
+        }
+      } // not in radius or better and reachable and closer than closest one outside of radius
+      else if (closer_external_reachable)
+        p_itr->closest_external_reachable = c_itr->sq_distance;
     }
   }
 
@@ -619,100 +731,129 @@ struct bin_handler_t {
     // at this point we have candidates for each location so now we
     // need to go get the actual correlated location with edge_id etc.
     std::unordered_map<Location, PathLocation> searched;
-    for (auto& pp : pps) {
-      // remove non-sensical island candidates
-      auto new_end = std::remove_if(pp.unreachable.begin(), pp.unreachable.end(),
-                                    [&pp](const candidate_t& c) -> bool {
-                                      return c.sq_distance > pp.closest_external_reachable;
-                                    });
-      pp.unreachable.erase(new_end, pp.unreachable.end());
-      // concatenate and sort
-      pp.reachable.reserve(pp.reachable.size() + pp.unreachable.size());
-      std::move(pp.unreachable.begin(), pp.unreachable.end(), std::back_inserter(pp.reachable));
-      std::sort(pp.reachable.begin(), pp.reachable.end());
-      // keep a look up around so we dont add duplicates with worse scores
-      correlated_edges.reserve(pp.reachable.size());
-      correlated_edges.clear();
-      // go through getting all the results for this one
-      PathLocation correlated(pp.location);
-      // TODO: this is already in PathLocation, use it there
-      std::vector<PathLocation::PathEdge> filtered;
-      for (const auto& candidate : pp.reachable) {
-        // this may be at a node, either because it was the closest thing or from snap tolerance
-        bool front = candidate.point == candidate.edge_info->shape().front() ||
-                     pp.location.latlng_.Distance(candidate.edge_info->shape().front()) <
-                         pp.location.node_snap_tolerance_;
-        bool back = candidate.point == candidate.edge_info->shape().back() ||
-                    pp.location.latlng_.Distance(candidate.edge_info->shape().back()) <
-                        pp.location.node_snap_tolerance_;
-        // it was the begin node
-        if ((front && candidate.edge->forward()) || (back && !candidate.edge->forward())) {
-          const GraphTile* other_tile;
-          auto opposing_edge = reader.GetOpposingEdge(candidate.edge_id, other_tile);
-          if (!other_tile) {
-            continue; // TODO: do an edge snap instead, but you'll only get one direction
-          }
-          correlate_node(pp.location, opposing_edge->endnode(), candidate, correlated, filtered);
-        } // it was the end node
-        else if ((back && candidate.edge->forward()) || (front && !candidate.edge->forward())) {
-          correlate_node(pp.location, candidate.edge->endnode(), candidate, correlated, filtered);
-        } // it was along the edge
-        else {
-          correlate_edge(pp.location, candidate, correlated, filtered);
+    if (!runner) {
+      for (auto& pp : pps) {
+        PathLocation correlated(pp.location);
+        finalize(reader, pp, correlated, nullptr);
+        // if we found nothing that is no good but if its batch maybe throwing makes no sense?
+        if (correlated.edges.size() != 0) {
+          searched.insert({pp.location, correlated});
         }
       }
+      return searched;
+    }
 
-      // if it was a through location with a heading its pretty confusing.
-      // does the user want to come into and exit the location at the preferred
-      // angle? for now we are just saying that they want it to exit at the
-      // heading provided. this means that if it was node snapped we only
-      // want the outbound edges
-      if ((pp.location.stoptype_ == Location::StopType::THROUGH ||
-           pp.location.stoptype_ == Location::StopType::BREAK_THROUGH) &&
-          pp.location.heading_) {
-        // partition the ones we want to move to the end
-        auto new_end =
-            std::stable_partition(correlated.edges.begin(), correlated.edges.end(),
-                                  [](const PathLocation::PathEdge& e) { return !e.end_node(); });
-        // move them to the end
-        filtered.insert(filtered.end(), std::make_move_iterator(new_end),
-                        std::make_move_iterator(correlated.edges.end()));
-        // remove them from the original
-        correlated.edges.erase(new_end, correlated.edges.end());
+    // the locations only share the reaches, which the threads read as the search left them and
+    // add to their own. they would compute the same reaches as the ones the others add
+    std::vector<PathLocation> correlated;
+    correlated.reserve(pps.size());
+    for (const auto& pp : pps) {
+      correlated.emplace_back(pp.location);
+    }
+    runner->Run(pps.size(), [this, &correlated](GraphReader& reader, const uint32_t i) {
+      reach_cache_t new_reaches;
+      finalize(reader, pps[i], correlated[i], &new_reaches);
+    });
+    for (size_t i = 0; i < pps.size(); ++i) {
+      if (correlated[i].edges.size() != 0) {
+        searched.insert({pps[i].location, std::move(correlated[i])});
       }
+    }
+    return searched;
+  }
 
-      // if we have nothing because of filtering (heading/side) we'll just ignore it
-      if (correlated.edges.size() == 0 && filtered.size()) {
-        for (auto& path_edge : filtered) {
-          if (correlated_edges.insert(path_edge.id).second) {
-            correlated.edges.push_back(std::move(path_edge));
-          }
+  // correlate one location to the edges of its candidates
+  void finalize(GraphReader& reader,
+                projector_wrapper& pp,
+                PathLocation& correlated,
+                reach_cache_t* new_reaches) {
+    // remove non-sensical island candidates
+    auto new_end = std::remove_if(pp.unreachable.begin(), pp.unreachable.end(),
+                                  [&pp](const candidate_t& c) -> bool {
+                                    return c.sq_distance > pp.closest_external_reachable;
+                                  });
+    pp.unreachable.erase(new_end, pp.unreachable.end());
+    // concatenate and sort
+    pp.reachable.reserve(pp.reachable.size() + pp.unreachable.size());
+    std::move(pp.unreachable.begin(), pp.unreachable.end(), std::back_inserter(pp.reachable));
+    std::sort(pp.reachable.begin(), pp.reachable.end());
+    // keep a look up around so we dont add duplicates with worse scores
+    std::unordered_set<uint64_t> correlated_edges;
+    correlated_edges.reserve(pp.reachable.size());
+    // go through getting all the results for this one
+    // TODO: this is already in PathLocation, use it there
+    std::vector<PathLocation::PathEdge> filtered;
+    for (const auto& candidate : pp.reachable) {
+      // this may be at a node, either because it was the closest thing or from snap tolerance
+      bool front = candidate.point == candidate.edge_info->shape().front() ||
+                   pp.location.latlng_.Distance(candidate.edge_info->shape().front()) <
+                       pp.location.node_snap_tolerance_;
+      bool back = candidate.point == candidate.edge_info->shape().back() ||
+                  pp.location.latlng_.Distance(candidate.edge_info->shape().back()) <
+                      pp.location.node_snap_tolerance_;
+      // it was the begin node
+      if ((front && candidate.edge->forward()) || (back && !candidate.edge->forward())) {
+        const GraphTile* other_tile;
+        auto opposing_edge = reader.GetOpposingEdge(candidate.edge_id, other_tile);
+        if (!other_tile) {
+          continue; // TODO: do an edge snap instead, but you'll only get one direction
         }
-        filtered.clear();
+        correlate_node(reader, pp.location, opposing_edge->endnode(), candidate, correlated,
+                       filtered, correlated_edges, new_reaches);
+      } // it was the end node
+      else if ((back && candidate.edge->forward()) || (front && !candidate.edge->forward())) {
+        correlate_node(reader, pp.location, candidate.edge->endnode(), candidate, correlated,
+                       filtered, correlated_edges, new_reaches);
+      } // it was along the edge
+      else {
+        correlate_edge(reader, pp.location, candidate, correlated, filtered, correlated_edges,
+                       new_reaches);
       }
+    }
 
-      // keep filtered edges for retry in case we cant find a route with non filtered edges
-      // use the max score of the non filtered edges as a penalty increase on each of the
-      // filtered edges so that when finding a route using non filtered edges fails the
-      // use of filtered edges are always penalized higher than the non filtered ones
-      auto max =
-          std::max_element(correlated.edges.begin(), correlated.edges.end(),
-                           [](const PathLocation::PathEdge& a, const PathLocation::PathEdge& b) {
-                             return a.distance < b.distance;
-                           });
-      std::for_each(filtered.begin(), filtered.end(),
-                    [&max](PathLocation::PathEdge& e) { e.distance += (3600.0f + max->distance); });
-      correlated.filtered_edges.insert(correlated.filtered_edges.end(),
-                                       std::make_move_iterator(filtered.begin()),
-                                       std::make_move_iterator(filtered.end()));
-
-      // if we found nothing that is no good but if its batch maybe throwing makes no sense?
-      if (correlated.edges.size() != 0) {
-        searched.insert({pp.location, correlated});
+    // if it was a through location with a heading its pretty confusing.
+    // does the user want to come into and exit the location at the preferred
+    // angle? for now we are just saying that they want it to exit at the
+    // heading provided. this means that if it was node snapped we only
+    // want the outbound edges
+    if ((pp.location.stoptype_ == Location::StopType::THROUGH ||
+         pp.location.stoptype_ == Location::StopType::BREAK_THROUGH) &&
+        pp.location.heading_) {
+      // partition the ones we want to move to the end
+      auto new_end =
+          std::stable_partition(correlated.edges.begin(), correlated.edges.end(),
+                                [](const PathLocation::PathEdge& e) { return !e.end_node(); });
+      // move them to the end
+      filtered.insert(filtered.end(), std::make_move_iterator(new_end),
+                      std::make_move_iterator(correlated.edges.end()));
+      // remove them from the original
+      correlated.edges.erase(new_end, correlated.edges.end());
+    }
+
+    // if we have nothing because of filtering (heading/side) we'll just ignore it
+    if (correlated.edges.size() == 0 && filtered.size()) {
+      for (auto& path_edge : filtered) {
+        if (correlated_edges.insert(path_edge.id).second) {
+          correlated.edges.push_back(std::move(path_edge));
+        }
       }
+      filtered.clear();
     }
-    // give back all the results
-    return searched;
+
+    // keep filtered edges for retry in case we cant find a route with non filtered edges
+    // use the max score of the non filtered edges as a penalty increase on each of the
+    // filtered edges so that when finding a route using non filtered edges fails the
+    // use of filtered edges are always penalized higher than the non filtered ones
+    auto max =
+        std::max_element(correlated.edges.begin(), correlated.edges.end(),
+                         [](const PathLocation::PathEdge& a, const PathLocation::PathEdge& b) {
+                           return a.distance < b.distance;
+                         });
+    std::for_each(filtered.begin(), filtered.end(),
+                  [&max](PathLocation::PathEdge& e) { e.distance += (3600.0f + max->distance); });
+    correlated.filtered_edges.insert(correlated.filtered_edges.end(),
+                                     std::make_move_iterator(filtered.begin()),
+                                     std::make_move_iterator(filtered.end()));
   }
 };
 
@@ -724,12 +865,13 @@ namespace loki {
 std::unordered_map<valhalla::baldr::Location, PathLocation>
 Search(const std::vector<valhalla::baldr::Location>& locations,
        GraphReader& reader,
-       const DynamicCost* costing) {
+       const DynamicCost* costing,
+       const std::vector<std::shared_ptr<GraphReader>>& helper_readers) {
   // trivially finished already
   if (locations.empty())
     return std::unordered_map<valhalla::baldr::Location, PathLocation>{};
   // setup the unique list of locations
-  bin_handler_t handler(locations, reader, costing);
+  bin_handler_t handler(locations, reader, costing, helper_readers);
   // search over the bins doing multiple locations per bin
   handler.search();
   // turn each locations candidate set into path locations
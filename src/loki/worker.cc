@@ -144,7 +144,9 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
       max_contours(config.get<size_t>("service_limits.isochrone.max_contours")),
       max_time(config.get<size_t>("service_limits.isochrone.max_time")),
       max_trace_shape(config.get<size_t>("service_limits.trace.max_shape")),
-      sample(config.get<std::string>("additional_data.elevation", "test/data/")),
+      sample(config.get<std::string>("additional_data.elevation", "test/data/"),
+             config.get<size_t>("additional_data.elevation_max_cache_size",
+                                skadi::kDefaultMaxUnzippedBytes)),
       max_elevation_shape(config.get<size_t>("service_limits.skadi.max_shape")),
       min_resample(config.get<float>("service_limits.skadi.min_resample")) {
   // If we weren't provided with a graph reader make our own
@@ -227,12 +229,42 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config,
 
   // Register standard edge/node costing methods
   factory.RegisterStandardCostingModels();
+
+  // Extra threads (each with their own graph reader) a matrix or route search may use
+  auto search_threads = config.get<unsigned int>("loki.search_max_threads", 1);
+  for (unsigned int i = 1; i < search_threads; ++i) {
+    search_readers.emplace_back(new baldr::GraphReader(config.get_child("mjolnir")));
+  }
 }
 
 void loki_worker_t::cleanup() {
+  // the request is done with its tiles, a shared tile cache can free what was evicted meanwhile
   if (reader->OverCommitted()) {
     reader->Trim();
   }
+  reader->Release();
+  for (auto& search_reader : search_readers) {
+    if (search_reader->OverCommitted()) {
+      search_reader->Trim();
+    }
+    search_reader->Release();
+  }
+}
+
+// log request if greater than X (ms) per unit of work
+void loki_worker_t::log_long_request(const Api& request,
+                                     const uint64_t id,
+                                     const float elapsed_time) const {
+  const auto& options = request.options();
+  auto work_units = options.locations_size()
+                        ? options.locations_size()
+                        : (options.sources_size() ? options.sources_size() + options.targets_size()
+                                                  : options.shape_size() * 20);
+  if (!options.do_not_track() && elapsed_time / work_units > long_request) {
+    LOG_WARN("loki::request elapsed time (ms)::" + std::to_string(elapsed_time));
+    LOG_WARN("loki::request exceeded threshold::" + std::to_string(id));
+    midgard::logging::Log("valhalla_loki_long_request", " [ANALYTICS] ");
+  }
 }
 
 #ifdef HAVE_HTTP
@@ -300,16 +332,7 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
     // get processing time for loki
     auto e = std::chrono::system_clock::now();
     std::chrono::duration<float, std::milli> elapsed_time = e - s;
-    // log request if greater than X (ms)
-    auto work_units = options.locations_size()
-                          ? options.locations_size()
-                          : (options.sources_size() ? options.sources_size() + options.targets_size()
-                                                    : options.shape_size() * 20);
-    if (!options.do_not_track() && elapsed_time.count() / work_units > long_request) {
-      LOG_WARN("loki::request elapsed time (ms)::" + std::to_string(elapsed_time.count()));
-      LOG_WARN("loki::request exceeded threshold::" + std::to_string(info.id));
-      midgard::logging::Log("valhalla_loki_long_request", " [ANALYTICS] ");
-    }
+    log_long_request(request, info.id, elapsed_time.count());
 
     return result;
   } catch (const valhalla_exception_t& e) {
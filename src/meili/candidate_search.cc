@@ -2,6 +2,8 @@
 #include "baldr/tilehierarchy.h"
 #include "meili/geometry_helpers.h"
 
+#include <limits>
+
 using namespace valhalla::midgard;
 
 namespace valhalla {
@@ -157,24 +159,90 @@ void IndexBin(const baldr::GraphTile& tile,
   }
 }
 
+CandidateGridCache::CandidateGridCache(size_t max_grids)
+    : max_grids_(std::max<size_t>(max_grids, 1)), memory_(0), hits_(0), misses_(0) {
+}
+
+CandidateGridCache::grid_ptr_t
+CandidateGridCache::Get(int32_t bin_id, float cell_width, float cell_height) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = index_.find({bin_id, cell_width, cell_height});
+  if (it == index_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  grids_.splice(grids_.begin(), grids_, it->second);
+  return it->second->grid;
+}
+
+CandidateGridCache::grid_ptr_t
+CandidateGridCache::Put(int32_t bin_id, float cell_width, float cell_height, grid_ptr_t grid) {
+  // Size the grid up front, it does not change once built
+  const Key key{bin_id, cell_width, cell_height};
+  const size_t memory = grid->MemoryUsage();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Another thread may have built the same grid in the mean time
+  const auto it = index_.find(key);
+  if (it != index_.end()) {
+    grids_.splice(grids_.begin(), grids_, it->second);
+    return it->second->grid;
+  }
+
+  // Drop the least recently used grids to make room
+  while (grids_.size() >= max_grids_) {
+    memory_ -= grids_.back().memory;
+    index_.erase(grids_.back().key);
+    grids_.pop_back();
+  }
+  grids_.push_front({key, std::move(grid), memory});
+  index_.emplace(key, grids_.begin());
+  memory_ += memory;
+  return grids_.front().grid;
+}
+
+void CandidateGridCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  grids_.clear();
+  index_.clear();
+  memory_ = 0;
+}
+
+size_t CandidateGridCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return grids_.size();
+}
+
+CandidateGridCache::Stats CandidateGridCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {hits_, misses_, grids_.size(), memory_};
+}
+
 CandidateGridQuery::CandidateGridQuery(baldr::GraphReader& reader,
                                        float cell_width,
-                                       float cell_height)
-    : CandidateQuery(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_() {
+                                       float cell_height,
+                                       const std::shared_ptr<CandidateGridCache>& cache)
+    : CandidateQuery(reader), cell_width_(cell_width), cell_height_(cell_height),
+      grid_cache_(cache) {
+  // keep our own grids, as many as we use, if we are not sharing them
+  if (!grid_cache_) {
+    grid_cache_ = std::make_shared<CandidateGridCache>(std::numeric_limits<size_t>::max());
+  }
   bin_level_ = baldr::TileHierarchy::levels().rbegin()->second.level;
 }
 
 CandidateGridQuery::~CandidateGridQuery() {
 }
 
-inline const CandidateGridQuery::grid_t*
+inline CandidateGridCache::grid_ptr_t
 CandidateGridQuery::GetGrid(const int32_t bin_id,
                             const Tiles<PointLL>& tiles,
                             const Tiles<PointLL>& bins) const {
   // Check if the bin is in the cache
-  const auto it = grid_cache_.find(bin_id);
-  if (it != grid_cache_.end()) {
-    return &(it->second);
+  auto grid = grid_cache_->Get(bin_id, cell_width_, cell_height_);
+  if (grid) {
+    return grid;
   }
 
   // Not in the cache. Get the tile and Index the bin within the tile.
@@ -192,11 +260,10 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   int32_t bin_col = rc.second % ndiv;
   int32_t bin_index = (bin_row * ndiv) + bin_col;
 
-  // Insert the bin into the cache and index the bin
-  const auto inserted =
-      grid_cache_.emplace(bin_id, grid_t(tile->BoundingBox(), cell_width_, cell_height_));
-  IndexBin(*tile, bin_index, reader_, inserted.first->second);
-  return &(inserted.first->second);
+  // Index the bin, without holding up other threads, and insert it into the cache
+  auto built = std::make_shared<grid_t>(tile->BoundingBox(), cell_width_, cell_height_);
+  IndexBin(*tile, bin_index, reader_, *built);
+  return grid_cache_->Put(bin_id, cell_width_, cell_height_, std::move(built));
 }
 
 std::unordered_set<baldr::GraphId>
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/costconstants.h"
@@ -20,6 +25,32 @@ inline float local_tile_size() {
   return tiles.TileSize();
 }
 
+// Candidate grids only depend on the tiles, so all the living factories of the process reading
+// the same tiles share one cache of them. The cache is sized by the first of those factories,
+// meili.grid.cache_size is process wide and the value of the later ones is ignored
+std::mutex grid_caches_mutex;
+std::unordered_map<std::string, std::weak_ptr<valhalla::meili::CandidateGridCache>> grid_caches;
+
+std::shared_ptr<valhalla::meili::CandidateGridCache>
+get_grid_cache(const boost::property_tree::ptree& root) {
+  const auto source = root.get<std::string>("mjolnir.tile_extract", "") + '|' +
+                      root.get<std::string>("mjolnir.tile_dir", "") + '|' +
+                      root.get<std::string>("mjolnir.tile_url", "");
+  const auto cache_size = root.get<size_t>("meili.grid.cache_size");
+  std::lock_guard<std::mutex> lock(grid_caches_mutex);
+  auto& entry = grid_caches[source];
+  auto cache = entry.lock();
+  if (!cache) {
+    cache = std::make_shared<valhalla::meili::CandidateGridCache>(cache_size);
+    entry = cache;
+  } else if (cache->max_grids() != std::max<size_t>(cache_size, 1)) {
+    LOG_WARN("meili.grid.cache_size of " + std::to_string(cache_size) +
+             " ignored, the shared candidate grid cache already keeps " +
+             std::to_string(cache->max_grids()) + " grids");
+  }
+  return cache;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -27,13 +58,13 @@ namespace meili {
 
 MapMatcherFactory::MapMatcherFactory(const boost::property_tree::ptree& root,
                                      const std::shared_ptr<baldr::GraphReader>& graph_reader)
-    : config_(root.get_child("meili")), graphreader_(graph_reader),
-      max_grid_cache_size_(root.get<float>("meili.grid.cache_size")) {
+    : config_(root.get_child("meili")), graphreader_(graph_reader) {
   if (!graphreader_)
     graphreader_.reset(new baldr::GraphReader(root.get_child("mjolnir")));
   candidatequery_.reset(
       new CandidateGridQuery(*graphreader_, local_tile_size() / root.get<size_t>("meili.grid.size"),
-                             local_tile_size() / root.get<size_t>("meili.grid.size")));
+                             local_tile_size() / root.get<size_t>("meili.grid.size"),
+                             get_grid_cache(root)));
   cost_factory_.RegisterStandardCostingModels();
 }
 
@@ -95,14 +126,26 @@ void MapMatcherFactory::ClearFullCache() {
     graphreader_->Trim();
   }
 
-  if (candidatequery_->size() > max_grid_cache_size_) {
-    candidatequery_->Clear();
-  }
+  // The grid cache keeps itself within its size, just report on it
+  const auto stats = candidatequery_->grid_cache()->stats();
+  LOG_DEBUG("Candidate grid cache: " + std::to_string(stats.grids) + " grids, " +
+            std::to_string(stats.memory) + " bytes, " + std::to_string(stats.hits) + " hits, " +
+            std::to_string(stats.misses) + " misses, hit rate " +
+            std::to_string(stats.hit_rate()));
+}
+
+CandidateGridCache::Stats MapMatcherFactory::grid_cache_stats() const {
+  return candidatequery_->grid_cache()->stats();
 }
 
 void MapMatcherFactory::ClearCache() {
   graphreader_->Clear();
-  candidatequery_->Clear();
+
+  // Other factories may still be using the shared grids, only drop them if we are the last one
+  std::lock_guard<std::mutex> lock(grid_caches_mutex);
+  if (candidatequery_->grid_cache().use_count() == 1) {
+    candidatequery_->Clear();
+  }
 }
 
 } // namespace meili
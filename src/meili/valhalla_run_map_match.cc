@@ -1,8 +1,11 @@
 #include "baldr/rapidjson_utils.h"
 #include <boost/property_tree/ptree.hpp>
+#include <cstring>
+#include <thread>
 
 #include "meili/map_matcher_factory.h"
 #include "meili/measurement.h"
+#include "tyr/actor.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::meili;
@@ -36,13 +39,25 @@ ReadMeasurements(istream_t& istream, float default_gps_accuracy, float default_s
 }
 
 int main(int argc, char* argv[]) {
-  if (argc < 2) {
-    std::cout << "usage: map_matching CONFIG" << std::endl;
+  if (argc < 2 || (argc > 2 && std::strcmp(argv[2], "--batch") != 0)) {
+    std::cout << "usage: map_matching CONFIG [--batch [CONCURRENCY]]" << std::endl;
+    std::cout << "  reads sequences of \"lng lat\" lines separated by blank lines, or with --batch"
+              << std::endl;
+    std::cout << "  one trace_attributes request per line which are answered one per line in order"
+              << std::endl;
     return 1;
   }
 
   boost::property_tree::ptree config;
   rapidjson::read_json(argv[1], config);
+
+  // Offline match a stream of requests on all the cores
+  if (argc > 2) {
+    size_t concurrency = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    std::ios::sync_with_stdio(false);
+    valhalla::tyr::trace_attributes_batch(config, std::cin, std::cout, concurrency);
+    return 0;
+  }
   const std::string modename = config.get<std::string>("meili.mode");
   valhalla::Costing costing;
   if (!valhalla::Costing_Enum_Parse(modename, &costing)) {
@@ -83,6 +98,10 @@ int main(int argc, char* argv[]) {
     matcher_factory.ClearFullCache();
   }
 
+  const auto stats = matcher_factory.grid_cache_stats();
+  std::cout << "Candidate grids: " << stats.grids << " cached (" << stats.memory << " bytes), "
+            << stats.hits << " hits, " << stats.misses << " misses" << std::endl;
+
   delete mapmatcher;
   matcher_factory.ClearCache();
 
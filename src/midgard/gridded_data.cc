@@ -8,7 +8,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <sstream>
+#include <thread>
+#include <utility>
 
 namespace valhalla {
 namespace midgard {
@@ -24,245 +29,442 @@ GriddedData<coord_t>::GriddedData(const AABB2<coord_t>& bounds,
   std::fill(data_.begin(), data_.end(), value);
 }
 
+namespace {
+
+// The grid is cut into bands of at least this many rows to find the segments in parallel
+constexpr int kMinRowsPerBand = 64;
+
+// Cases of the CONREC triangle scheme for the signs of a triangle's three vertices
+constexpr int kCaseTable[3][3][3] = {{{0, 0, 8}, {0, 2, 5}, {7, 6, 9}},
+                                     {{0, 3, 4}, {1, 3, 1}, {4, 3, 0}},
+                                     {{9, 6, 7}, {5, 2, 0}, {8, 0, 0}}};
+
+template <class coord_t> using segments_t = std::vector<std::pair<coord_t, coord_t>>;
+
+// Maps the loose ends of the lines being stitched to their line. Open addressing over one array
+// since the ends come and go far too often for a node based map
+template <class coord_t> class EndIndex {
+public:
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  EndIndex(size_t count) {
+    size_t size = 16;
+    while (size < count * 2) {
+      size <<= 1;
+    }
+    slots_.resize(size, {0, kNone});
+    mask_ = size - 1;
+  }
+
+  uint32_t find(const coord_t& pt) const {
+    auto key = Key(pt);
+    for (auto i = Slot(key);; i = (i + 1) & mask_) {
+      if (slots_[i].second == kNone || slots_[i].first == key) {
+        return slots_[i].second;
+      }
+    }
+  }
+
+  // like the map it replaces an existing key is left alone
+  void emplace(const coord_t& pt, uint32_t line) {
+    auto key = Key(pt);
+    auto i = Slot(key);
+    for (; slots_[i].second != kNone; i = (i + 1) & mask_) {
+      if (slots_[i].first == key) {
+        return;
+      }
+    }
+    slots_[i] = {key, line};
+  }
+
+  void erase(const coord_t& pt) {
+    auto key = Key(pt);
+    auto i = Slot(key);
+    for (; slots_[i].second != kNone && slots_[i].first != key; i = (i + 1) & mask_) {
+    }
+    if (slots_[i].second == kNone) {
+      return;
+    }
+    // shift back the entries after it that would no longer be found
+    for (auto j = (i + 1) & mask_; slots_[j].second != kNone; j = (j + 1) & mask_) {
+      auto home = Slot(slots_[j].first);
+      if (((j - home) & mask_) >= ((j - i) & mask_)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].second = kNone;
+  }
+
+protected:
+  static uint64_t Key(const coord_t& pt) {
+    uint64_t key;
+    std::memcpy(&key, &pt.first, 4);
+    std::memcpy(reinterpret_cast<char*>(&key) + 4, &pt.second, 4);
+    return key;
+  }
+
+  size_t Slot(uint64_t key) const {
+    return (key * 0x9E3779B97F4A7C15ull >> 32) & mask_;
+  }
+
+  std::vector<std::pair<uint64_t, uint32_t>> slots_;
+  size_t mask_;
+};
+
+// Joins the segments of one contour into lines. Segments are taken in the order the grid was
+// scanned and the lines come out in the order the linked list version used to keep them, newest
+// first, so that sorting them afterwards breaks ties the same way. The points of all the lines
+// live in one pool and are linked to their neighbours so lines can be joined without copying
+template <class coord_t>
+std::vector<std::vector<coord_t>>
+StitchSegments(const std::vector<const segments_t<coord_t>*>& bands) {
+  constexpr uint32_t kNone = EndIndex<coord_t>::kNone;
+  struct node_t {
+    coord_t pt;
+    uint32_t prev;
+    uint32_t next;
+  };
+  struct line_t {
+    uint32_t front;
+    uint32_t back;
+    size_t size;
+  };
+
+  size_t count = 0;
+  for (const auto* band : bands) {
+    count += band->size();
+  }
+  std::vector<node_t> nodes;
+  nodes.reserve(count * 2);
+  // the lines so far, empty ones have been joined to another one
+  std::vector<line_t> lines;
+  // and the line each loose end belongs to
+  EndIndex<coord_t> lookup(count);
+
+  auto front = [&nodes, &lines](uint32_t line) -> const coord_t& {
+    return nodes[lines[line].front].pt;
+  };
+  auto back = [&nodes, &lines](uint32_t line) -> const coord_t& {
+    return nodes[lines[line].back].pt;
+  };
+  auto push_front = [&nodes, &lines](uint32_t line, const coord_t& pt) {
+    nodes.push_back({pt, kNone, lines[line].front});
+    nodes[lines[line].front].prev = nodes.size() - 1;
+    lines[line].front = nodes.size() - 1;
+    ++lines[line].size;
+  };
+  auto push_back = [&nodes, &lines](uint32_t line, const coord_t& pt) {
+    nodes.push_back({pt, lines[line].back, kNone});
+    nodes[lines[line].back].next = nodes.size() - 1;
+    lines[line].back = nodes.size() - 1;
+    ++lines[line].size;
+  };
+  auto reverse = [&nodes, &lines](uint32_t line) {
+    for (auto i = lines[line].front; i != kNone; i = nodes[i].prev) {
+      std::swap(nodes[i].prev, nodes[i].next);
+    }
+    std::swap(lines[line].front, lines[line].back);
+  };
+  // puts line b on the end of line a
+  auto join = [&nodes, &lines](uint32_t a, uint32_t b) {
+    nodes[lines[a].back].next = lines[b].front;
+    nodes[lines[b].front].prev = lines[a].back;
+    lines[a].back = lines[b].back;
+    lines[a].size += lines[b].size;
+    lines[b].size = 0;
+  };
+
+  for (const auto* band : bands) {
+    for (auto segment : *band) {
+      auto& pt1 = segment.first;
+      auto& pt2 = segment.second;
+
+      // see if we have anything to connect this segment to
+      auto a = lookup.find(pt1);
+      auto b = lookup.find(pt2);
+      if (b != kNone) {
+        std::swap(pt1, pt2);
+        std::swap(a, b);
+      }
+
+      // we want to merge two records
+      if (b != kNone) {
+        // get the lines in question and remove their lookup info
+        bool head_a = pt1 == front(a);
+        bool head_b = pt2 == front(b);
+        lookup.erase(pt1);
+        lookup.erase(pt2);
+
+        // this line is now a ring
+        if (a == b) {
+          push_back(a, front(a));
+          continue;
+        }
+
+        // erase the other lookups
+        lookup.erase(head_a ? back(a) : front(a));
+        lookup.erase(head_b ? back(b) : front(b));
+
+        // add b to a
+        if (!head_a && head_b) {
+          join(a, b);
+        } // add a to b
+        else if (!head_b && head_a) {
+          join(b, a);
+          a = b;
+        } // flip a and add b
+        else if (head_a && head_b) {
+          reverse(a);
+          join(a, b);
+        } // flip b and add to a
+        else {
+          reverse(b);
+          join(a, b);
+        }
+
+        // update the look up
+        lookup.emplace(front(a), a);
+        lookup.emplace(back(a), a);
+      } // ap/prepend to an existing one
+      else if (a != kNone) {
+        // it goes on the front
+        if (front(a) == pt1) {
+          push_front(a, pt2);
+          // it goes on the back
+        } else {
+          push_back(a, pt2);
+        }
+
+        // update the lookup table
+        lookup.erase(pt1);
+        lookup.emplace(pt2, a);
+      } // this is an orphan segment for now
+      else {
+        nodes.push_back({pt1, kNone, static_cast<uint32_t>(nodes.size() + 1)});
+        nodes.push_back({pt2, static_cast<uint32_t>(nodes.size() - 1), kNone});
+        lines.push_back({static_cast<uint32_t>(nodes.size() - 2),
+                         static_cast<uint32_t>(nodes.size() - 1), 2});
+        lookup.emplace(pt1, lines.size() - 1);
+        lookup.emplace(pt2, lines.size() - 1);
+      }
+    }
+  }
+
+  // newest first
+  std::vector<std::vector<coord_t>> stitched;
+  for (auto line = lines.rbegin(); line != lines.rend(); ++line) {
+    if (line->size > 0) {
+      stitched.emplace_back();
+      stitched.back().reserve(line->size);
+      for (auto i = line->front; i != kNone; i = nodes[i].next) {
+        stitched.back().push_back(nodes[i].pt);
+      }
+    }
+  }
+  return stitched;
+}
+
+} // namespace
+
 // Generate contour lines from the isotile data.
 // contours is an ordered list of contour interval values
 // Derivation from the C code version of CONREC by Paul Bourke:
 // http://paulbourke.net/papers/conrec/
+// The segments of all the contours are found in one scan of the grid, which is split into bands
+// of rows scanned in parallel. The contours are then stitched and cleaned up in parallel.
 template <class coord_t>
 typename GriddedData<coord_t>::contours_t
 GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_intervals,
                                        const bool rings_only,
                                        const float denoise,
-                                       const float generalize) const {
+                                       const float generalize,
+                                       const unsigned int threads) const {
   // TODO: sort and validate contour range
 
-  // Values at tile corners and center (0 element is center)
-  int sh[5];
-  typename coord_t::first_type s[5]; // Values at the tile corners and center
-  coord_t tile_corners[5];           // coord_t at tile corners and center
-
-  // Find the intersection along a tile edge
-  auto intersect = [&tile_corners, &s](int p1, int p2) {
-    auto ds = s[p2] - s[p1];
-    return coord_t((s[p2] * tile_corners[p1].x() - s[p1] * tile_corners[p2].x()) / ds,
-                   (s[p2] * tile_corners[p1].y() - s[p1] * tile_corners[p2].y()) / ds);
-  };
-
   // we need something to hold each iso-line, bigger ones first
   contours_t contours([](float a, float b) { return a > b; });
   for (auto v : contour_intervals) {
     contours[v].emplace_back();
   }
-  // and something to find them quickly
-  using contour_lookup_t = std::unordered_map<coord_t, typename feature_t::iterator>;
-  std::unordered_map<float, contour_lookup_t> lookup(contour_intervals.size());
-  // TODO: preallocate the lookups for each interval
+  if (contour_intervals.empty()) {
+    return contours;
+  }
+  std::vector<float> levels;
+  std::vector<std::list<feature_t>*> collections;
+  for (auto& collection : contours) {
+    levels.push_back(collection.first);
+    collections.push_back(&collection.second);
+  }
 
+  // Find the segments of every contour within some rows of the grid
   int tile_inc[4] = {0, 1, this->ncolumns_ + 1, this->ncolumns_};
-  int case_value;
-  int case_table[3][3][3] = {{{0, 0, 8}, {0, 2, 5}, {7, 6, 9}},
-                             {{0, 3, 4}, {1, 3, 1}, {4, 3, 0}},
-                             {{9, 6, 7}, {5, 2, 0}, {8, 0, 0}}};
+  auto scan = [this, &contour_intervals, &levels,
+               &tile_inc](int first_row, int last_row, std::vector<segments_t<coord_t>>& segments) {
+    segments.resize(levels.size());
 
-  // For each cell, skipping the outer rim since its out of bounds
-  for (int row = 1; row < this->nrows_ - 1; ++row) {
-    for (int col = 1; col < this->ncolumns_ - 1; ++col) {
-      int tileid = this->TileId(col, row);
-      auto cell1 = data_[tileid];
-      auto cell2 = data_[tileid + this->ncolumns_];     // TileId(col,   row+1)];
-      auto cell3 = data_[tileid + 1];                   // TileId(col+1, row)];
-      auto cell4 = data_[tileid + this->ncolumns_ + 1]; // TileId(col+1, row+1)];
-      auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
-      auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
-
-      // Continue if outside the range of contour values
-      if (dmax < contour_intervals.front() || dmin > contour_intervals.back()) {
-        continue;
-      }
+    // Values at tile corners and center (0 element is center)
+    int sh[5];
+    typename coord_t::first_type s[5]; // Values at the tile corners and center
+    float values[5];                   // Data at the tile corners
+    coord_t tile_corners[5];           // coord_t at tile corners and center
+
+    // Find the intersection along a tile edge
+    auto intersect = [&tile_corners, &s](int p1, int p2) {
+      auto ds = s[p2] - s[p1];
+      return coord_t((s[p2] * tile_corners[p1].x() - s[p1] * tile_corners[p2].x()) / ds,
+                     (s[p2] * tile_corners[p1].y() - s[p1] * tile_corners[p2].y()) / ds);
+    };
 
-      for (auto contour : contour_intervals) {
-        if (contour < dmin || contour > dmax) {
+    for (int row = first_row; row < last_row; ++row) {
+      for (int col = 1; col < this->ncolumns_ - 1; ++col) {
+        int tileid = this->TileId(col, row);
+        auto cell1 = data_[tileid];
+        auto cell2 = data_[tileid + this->ncolumns_];     // TileId(col,   row+1)];
+        auto cell3 = data_[tileid + 1];                   // TileId(col+1, row)];
+        auto cell4 = data_[tileid + this->ncolumns_ + 1]; // TileId(col+1, row+1)];
+        auto dmin = std::min(std::min(cell1, cell2), std::min(cell3, cell4));
+        auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
+
+        // Continue if outside the range of contour values
+        if (dmax < contour_intervals.front() || dmin > contour_intervals.back()) {
           continue;
         }
-        for (int m = 4; m >= 0; m--) {
-          if (m > 0) {
-            int newtileid = tileid + tile_inc[m - 1];
-            // Make sure the tile corner value is not set to the max_value
-            // (messes up the intersect method). Set a value slightly above
-            // the contour (e.g. 1 minute higher).
-            // TODO - the value 1 is a bit of a hack.
-            s[m] = (data_[newtileid] < max_value_) ? data_[newtileid] - contour : 1.0f;
-            tile_corners[m] = this->Base(newtileid);
-          } else {
-            s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
-            tile_corners[0] = this->Center(tileid);
-          }
-          if (s[m] > 0.0f) {
-            sh[m] = 1;
-          } else if (s[m] < 0.0f) {
-            sh[m] = -1;
-          } else {
-            sh[m] = 0;
-          }
+
+        // The corners are the same for every contour
+        for (int m = 1; m <= 4; ++m) {
+          int newtileid = tileid + tile_inc[m - 1];
+          values[m] = data_[newtileid];
+          tile_corners[m] = this->Base(newtileid);
         }
+        tile_corners[0] = this->Center(tileid);
 
-        /*
-         Note: at this stage the relative heights of the corners and the
-         centre are in the h array, and the corresponding coordinates are
-         in the xh and yh arrays. The centre of the box is indexed by 0
-         and the 4 corners by 1 to 4 as shown below.
-         Each triangle is then indexed by the parameter m, and the 3
-         vertices of each triangle are indexed by parameters m1,m2,and m3.
-         It is assumed that the centre of the box is always vertex 2
-         though this is important only when all 3 vertices lie exactly on
-         the same contour level, in which case only the side of the box
-         is drawn.
-            vertex 4 +-------------------+ vertex 3
-                     | \               / |
-                     |   \    m-3    /   |
-                     |     \       /     |
-                     |       \   /       |
-                     |  m=2    X   m=2   |       the centre is vertex 0
-                     |       /   \       |
-                     |     /       \     |
-                     |   /    m=1    \   |
-                     | /               \ |
-            vertex 1 +-------------------+ vertex 2
-        */
-
-        // Scan each triangle in the box
-        coord_t pt1, pt2;
-        for (int m = 1; m <= 4; m++) {
-          int m1 = m;
-          int m2 = 0;
-          int m3 = (m != 4) ? m + 1 : 1;
-          if ((case_value = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1]) == 0) {
+        for (size_t level = 0; level < levels.size(); ++level) {
+          auto contour = levels[level];
+          if (contour < dmin || contour > dmax) {
             continue;
           }
-
-          switch (case_value) {
-            case 1: // Line between vertices 1 and 2
-              pt1 = tile_corners[m1];
-              pt2 = tile_corners[m2];
-              break;
-            case 2: // Line between vertices 2 and 3
-              pt1 = tile_corners[m2];
-              pt2 = tile_corners[m3];
-              break;
-            case 3: // Line between vertices 3 and 1
-              pt1 = tile_corners[m3];
-              pt2 = tile_corners[m1];
-              break;
-            case 4: // Line between vertex 1 and side 2-3
-              pt1 = tile_corners[m1];
-              pt2 = intersect(m2, m3);
-              break;
-            case 5: // Line between vertex 2 and side 3-1
-              pt1 = tile_corners[m2];
-              pt2 = intersect(m3, m1);
-              break;
-            case 6: // Line between vertex 3 and side 1-2
-              pt1 = tile_corners[m3];
-              pt2 = intersect(m1, m2);
-              break;
-            case 7: // Line between sides 1-2 and 2-3
-              pt1 = intersect(m1, m2);
-              pt2 = intersect(m2, m3);
-              break;
-            case 8: // Line between sides 2-3 and 3-1
-              pt1 = intersect(m2, m3);
-              pt2 = intersect(m3, m1);
-              break;
-            case 9: // Line between sides 3-1 and 1-2
-              pt1 = intersect(m3, m1);
-              pt2 = intersect(m1, m2);
-              break;
-            default:
-              break;
-          }
-
-          // this isnt a segment..
-          if (pt1 == pt2) {
-            continue;
+          for (int m = 4; m >= 0; m--) {
+            if (m > 0) {
+              // Make sure the tile corner value is not set to the max_value
+              // (messes up the intersect method). Set a value slightly above
+              // the contour (e.g. 1 minute higher).
+              // TODO - the value 1 is a bit of a hack.
+              s[m] = (values[m] < max_value_) ? values[m] - contour : 1.0f;
+            } else {
+              s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
+            }
+            if (s[m] > 0.0f) {
+              sh[m] = 1;
+            } else if (s[m] < 0.0f) {
+              sh[m] = -1;
+            } else {
+              sh[m] = 0;
+            }
           }
 
-          // see if we have anything to connect this segment to
-          typename contour_lookup_t::iterator rec_a = lookup[contour].find(pt1);
-          typename contour_lookup_t::iterator rec_b = lookup[contour].find(pt2);
-          if (rec_b != lookup[contour].end()) {
-            std::swap(pt1, pt2);
-            std::swap(rec_a, rec_b);
-          }
+          /*
+           Note: at this stage the relative heights of the corners and the
+           centre are in the h array, and the corresponding coordinates are
+           in the xh and yh arrays. The centre of the box is indexed by 0
+           and the 4 corners by 1 to 4 as shown below.
+           Each triangle is then indexed by the parameter m, and the 3
+           vertices of each triangle are indexed by parameters m1,m2,and m3.
+           It is assumed that the centre of the box is always vertex 2
+           though this is important only when all 3 vertices lie exactly on
+           the same contour level, in which case only the side of the box
+           is drawn.
+              vertex 4 +-------------------+ vertex 3
+                       | \               / |
+                       |   \    m-3    /   |
+                       |     \       /     |
+                       |       \   /       |
+                       |  m=2    X   m=2   |       the centre is vertex 0
+                       |       /   \       |
+                       |     /       \     |
+                       |   /    m=1    \   |
+                       | /               \ |
+              vertex 1 +-------------------+ vertex 2
+          */
 
-          // we want to merge two records
-          if (rec_b != lookup[contour].end()) {
-            // get the segments in question and remove their lookup info
-            auto segment_a = rec_a->second;
-            bool head_a = rec_a->first == segment_a->front();
-            auto segment_b = rec_b->second;
-            bool head_b = rec_b->first == segment_b->front();
-            lookup[contour].erase(rec_a);
-            lookup[contour].erase(rec_b);
-
-            // this segment is now a ring
-            if (segment_a == segment_b) {
-              segment_a->push_back(segment_a->front());
+          // Scan each triangle in the box
+          coord_t pt1, pt2;
+          for (int m = 1; m <= 4; m++) {
+            int m1 = m;
+            int m2 = 0;
+            int m3 = (m != 4) ? m + 1 : 1;
+            int case_value = kCaseTable[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1];
+            if (case_value == 0) {
               continue;
             }
 
-            // erase the other lookups
-            lookup[contour].erase(lookup[contour].find(
-                pt1 == segment_a->front() ? segment_a->back() : segment_a->front()));
-            lookup[contour].erase(lookup[contour].find(
-                pt2 == segment_b->front() ? segment_b->back() : segment_b->front()));
-
-            // add b to a
-            if (!head_a && head_b) {
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            } // add a to b
-            else if (!head_b && head_a) {
-              segment_b->splice(segment_b->end(), *segment_a);
-              contours[contour].front().erase(segment_a);
-              segment_a = segment_b;
-            } // flip a and add b
-            else if (head_a && head_b) {
-              segment_a->reverse();
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            } // flip b and add to a
-            else if (!head_a && !head_b) {
-              segment_b->reverse();
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
+            switch (case_value) {
+              case 1: // Line between vertices 1 and 2
+                pt1 = tile_corners[m1];
+                pt2 = tile_corners[m2];
+                break;
+              case 2: // Line between vertices 2 and 3
+                pt1 = tile_corners[m2];
+                pt2 = tile_corners[m3];
+                break;
+              case 3: // Line between vertices 3 and 1
+                pt1 = tile_corners[m3];
+                pt2 = tile_corners[m1];
+                break;
+              case 4: // Line between vertex 1 and side 2-3
+                pt1 = tile_corners[m1];
+                pt2 = intersect(m2, m3);
+                break;
+              case 5: // Line between vertex 2 and side 3-1
+                pt1 = tile_corners[m2];
+                pt2 = intersect(m3, m1);
+                break;
+              case 6: // Line between vertex 3 and side 1-2
+                pt1 = tile_corners[m3];
+                pt2 = intersect(m1, m2);
+                break;
+              case 7: // Line between sides 1-2 and 2-3
+                pt1 = intersect(m1, m2);
+                pt2 = intersect(m2, m3);
+                break;
+              case 8: // Line between sides 2-3 and 3-1
+                pt1 = intersect(m2, m3);
+                pt2 = intersect(m3, m1);
+                break;
+              case 9: // Line between sides 3-1 and 1-2
+                pt1 = intersect(m3, m1);
+                pt2 = intersect(m1, m2);
+                break;
+              default:
+                break;
             }
 
-            // update the look up
-            lookup[contour].emplace(segment_a->front(), segment_a);
-            lookup[contour].emplace(segment_a->back(), segment_a);
-          } // ap/prepend to an existing one
-          else if (rec_a != lookup[contour].end()) {
-            // it goes on the front
-            if (rec_a->second->front() == pt1) {
-              rec_a->second->push_front(pt2);
-              // it goes on the back
-            } else {
-              rec_a->second->push_back(pt2);
+            // this isnt a segment..
+            if (pt1 == pt2) {
+              continue;
             }
-
-            // update the lookup table
-            lookup[contour].emplace(pt2, rec_a->second);
-            lookup[contour].erase(rec_a);
-          } // this is an orphan segment for now
-          else {
-            contours[contour].front().push_front(contour_t{pt1, pt2});
-            lookup[contour].emplace(pt1, contours[contour].front().begin());
-            lookup[contour].emplace(pt2, contours[contour].front().begin());
+            segments[level].emplace_back(pt1, pt2);
           }
-        }
-      } // Each contour
-    }   // Each tile col
-  }     // Each tile row
+        } // Each contour
+      }   // Each tile col
+    }     // Each tile row
+  };
+
+  // For each cell, skipping the outer rim since its out of bounds
+  int rows = std::max(this->nrows_ - 2, 0);
+  size_t band_count = std::max(std::min<size_t>(threads, rows / kMinRowsPerBand), size_t(1));
+  std::vector<std::vector<segments_t<coord_t>>> bands(band_count);
+  {
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < band_count; ++i) {
+      threads.emplace_back(scan, 1 + rows * i / band_count, 1 + rows * (i + 1) / band_count,
+                           std::ref(bands[i]));
+    }
+    scan(1, 1 + rows / band_count, bands.front());
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
 
   // If the generalization value equals kOptimalGeneralization then set
   // the generalization factor to 1/4 of the grid size
@@ -272,51 +474,77 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
   }
 
   // some info about the area the image covers
-  auto c = this->TileBounds().Center();
   auto h = this->tilesize_ / 2;
-  // for each contour
-  for (auto& collection : contours) {
-    auto& contour = collection.second.front();
+  // turns the segments of a contour into its features
+  auto finish = [&](size_t level) {
+    auto& collection = *collections[level];
+    std::vector<const segments_t<coord_t>*> segments;
+    for (const auto& band : bands) {
+      segments.push_back(&band[level]);
+    }
+    auto lines = StitchSegments<coord_t>(segments);
     // they only wanted rings
     if (rings_only) {
-      contour.remove_if([](const contour_t& line) { return line.front() != line.back(); });
+      lines.erase(std::remove_if(lines.begin(), lines.end(),
+                                 [](const contour_t& line) { return line.front() != line.back(); }),
+                  lines.end());
     }
     // sort them by area (maybe length would be sufficient?) biggest first
-    std::unordered_map<const contour_t*, typename coord_t::first_type> cache(contour.size());
-    std::for_each(contour.cbegin(), contour.cend(),
-                  [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
-    contour.sort([&cache](const contour_t& a, const contour_t& b) {
-      return std::abs(cache[&a]) > std::abs(cache[&b]);
-    });
-    // they only want the most significant ones!
-    if (denoise > 0.f) {
-      contour.remove_if([&cache, &contour, denoise](const contour_t& c) {
-        return std::abs(cache[&c] / cache[&contour.front()]) < denoise;
-      });
+    std::vector<typename coord_t::first_type> areas(lines.size());
+    std::vector<size_t> order(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+      areas[i] = polygon_area(lines[i]);
+      order[i] = i;
     }
-    // clean up the lines
-    for (auto& line : contour) {
+    std::stable_sort(order.begin(), order.end(), [&areas](size_t a, size_t b) {
+      return std::abs(areas[a]) > std::abs(areas[b]);
+    });
+    for (auto i : order) {
+      // they only want the most significant ones!
+      if (denoise > 0.f && std::abs(areas[i] / areas[order.front()]) < denoise) {
+        continue;
+      }
+      // clean up the lines
+      auto& line = lines[i];
       // TODO: generalizing makes self intersections which makes other libraries unhappy
       if (gen_factor > 0.f) {
         Polyline2<coord_t>::Generalize(line, gen_factor, {});
       }
       // if this ends up as an inner we'll undo this later
-      if (cache[&line] > 0) {
-        line.reverse();
+      if (areas[i] > 0) {
+        std::reverse(line.begin(), line.end());
       }
       // sampling the bottom left corner means everything is skewed, so unskew it
       for (auto& coord : line) {
         coord.first += h;
         coord.second += h;
       }
+      // if they just wanted linestrings we need only one per feature
+      if (rings_only) {
+        collection.front().push_back(std::move(line));
+      } else {
+        collection.push_back({std::move(line)});
+      }
     }
-    // if they just wanted linestrings we need only one per feature
     if (!rings_only) {
-      for (auto& linestring : contour) {
-        collection.second.push_back({std::move(linestring)});
-      }
-      collection.second.pop_front();
+      collection.pop_front();
+    }
+  };
+
+  // each contour is independent of the others, spread them over the threads
+  size_t thread_count = std::max(std::min<size_t>(threads, levels.size()), size_t(1));
+  auto finish_some = [&finish, &levels, thread_count](size_t first) {
+    for (size_t level = first; level < levels.size(); level += thread_count) {
+      finish(level);
     }
+  };
+  std::vector<std::thread> finishers;
+  for (size_t i = 1; i < thread_count; ++i) {
+    finishers.emplace_back(finish_some, i);
+  }
+  finish_some(0);
+  for (auto& thread : finishers) {
+    thread.join();
   }
 
   return contours;
@@ -4,6 +4,8 @@
 #include <boost/filesystem/operations.hpp>
 #include <spatialite.h>
 #include <sqlite3.h>
+#include <algorithm>
+#include <exception>
 #include <unordered_map>
 
 namespace valhalla {
@@ -77,6 +79,98 @@ uint32_t GetMultiPolyId(const std::unordered_multimap<uint32_t, multi_polygon_ty
   return index;
 }
 
+MultiPolyIndex::MultiPolyIndex(const std::unordered_multimap<uint32_t, multi_polygon_type>& polys,
+                               const AABB2<PointLL>& aabb)
+    : clip_(point_type(aabb.minx() - kClipMargin, aabb.miny() - kClipMargin),
+            point_type(aabb.maxx() + kClipMargin, aabb.maxy() + kClipMargin)) {
+  std::vector<value_type> boxes;
+  polys_.reserve(polys.size());
+  for (const auto& poly : polys) {
+    uint32_t order = polys_.size();
+    polys_.emplace_back(poly.first, &poly.second);
+    for (const auto& polygon : poly.second) {
+      // skip the parts that are nowhere near the tile and keep the ones entirely within it
+      auto envelope = boost::geometry::return_envelope<box_type>(polygon);
+      if (!boost::geometry::intersects(envelope, clip_)) {
+        continue;
+      }
+      if (boost::geometry::covered_by(envelope, clip_)) {
+        parts_.emplace_back(order, polygon);
+        continue;
+      }
+      // clip the rest, if the polygon is too broken to clip just keep all of it
+      multi_polygon_type clipped;
+      try {
+        polygon_type corrected = polygon;
+        boost::geometry::correct(corrected);
+        boost::geometry::intersection(corrected, clip_, clipped);
+      } catch (const std::exception& e) {
+        LOG_WARN("Could not clip polygon " + std::to_string(poly.first) + ": " + e.what());
+        clipped.assign(1, polygon);
+      }
+      for (auto& part : clipped) {
+        parts_.emplace_back(order, std::move(part));
+      }
+    }
+  }
+
+  // bulk load the tree
+  boxes.reserve(parts_.size());
+  for (uint32_t i = 0; i < parts_.size(); ++i) {
+    boxes.emplace_back(boost::geometry::return_envelope<box_type>(parts_[i].second), i);
+  }
+  rtree_ = decltype(rtree_)(boxes.begin(), boxes.end());
+}
+
+std::vector<uint32_t> MultiPolyIndex::Covering(const PointLL& ll) const {
+  point_type p(ll.lng(), ll.lat());
+  std::vector<uint32_t> orders;
+  if (boost::geometry::covered_by(p, clip_)) {
+    for (auto itr = rtree_.qbegin(boost::geometry::index::covers(p)); itr != rtree_.qend();
+         ++itr) {
+      const auto& part = parts_[itr->second];
+      if (boost::geometry::covered_by(p, part.second)) {
+        orders.push_back(part.first);
+      }
+    }
+    // a polygon can be in more than one piece, and the order is the one of the map
+    std::sort(orders.begin(), orders.end());
+    orders.erase(std::unique(orders.begin(), orders.end()), orders.end());
+  } else {
+    for (uint32_t i = 0; i < polys_.size(); ++i) {
+      if (boost::geometry::covered_by(p, *polys_[i].second)) {
+        orders.push_back(i);
+      }
+    }
+  }
+
+  // the orders become ids
+  for (auto& order : orders) {
+    order = polys_[order].first;
+  }
+  return orders;
+}
+
+// Get the polygon index using the spatial index of a tile's polys.
+uint32_t
+GetMultiPolyId(const MultiPolyIndex& polys, const PointLL& ll, GraphTileBuilder& graphtile) {
+  uint32_t index = 0;
+  for (auto id : polys.Covering(ll)) {
+    const auto& admin = graphtile.admins_builder(id);
+    if (!admin.state_offset())
+      index = id;
+    else
+      return id;
+  }
+  return index;
+}
+
+// Get the polygon index using the spatial index of a tile's polys.
+uint32_t GetMultiPolyId(const MultiPolyIndex& polys, const PointLL& ll) {
+  auto ids = polys.Covering(ll);
+  return ids.empty() ? 0 : ids.front();
+}
+
 // Get the timezone polys from the db
 std::unordered_multimap<uint32_t, multi_polygon_type> GetTimeZones(sqlite3* db_handle,
                                                                    const AABB2<PointLL>& aabb) {
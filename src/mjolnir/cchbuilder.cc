@@ -0,0 +1,376 @@
+#include "mjolnir/cchbuilder.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "baldr/cchoverlay.h"
+#include "baldr/graphconstants.h"
+#include "baldr/graphid.h"
+#include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+constexpr uint32_t kNoVertex = CCHOverlay::kNoVertex;
+
+// Cells of the nested dissection with up to this many vertices are not split any further
+constexpr size_t kLeafSize = 4;
+
+// Vertices, arcs and edges have to fit in 31 bits, the metric uses the top bit to tell them apart
+constexpr uint64_t kMaxCount = 1ull << 31;
+
+// A directed edge of the road network between two graph nodes (rows)
+struct RawEdge {
+  uint32_t from;
+  uint32_t to;
+  uint64_t edgeid;
+};
+
+// The nodes of the road network, numbered tile by tile, and the edges between them
+struct Network {
+  std::vector<CCHTile> tiles;
+  std::unordered_map<uint32_t, uint32_t> first_rows;
+  std::vector<uint32_t> groups; // union find over the nodes of an intersection on each level
+  std::vector<PointLL> lls;
+  std::vector<RawEdge> edges;
+
+  uint32_t row(const GraphId& node) const {
+    auto first = first_rows.find(node.tile_value());
+    return first == first_rows.cend() ? kNoVertex : first->second + node.id();
+  }
+
+  uint32_t group(uint32_t row) {
+    while (groups[row] != row) {
+      groups[row] = groups[groups[row]];
+      row = groups[row];
+    }
+    return row;
+  }
+};
+
+Network ReadNetwork(GraphReader& reader, const uint32_t access) {
+  // number the nodes of the road network, transit has its own hierarchy level we skip
+  auto max_level = TileHierarchy::levels().rbegin()->first;
+  std::vector<GraphId> tile_ids;
+  for (const auto& id : reader.GetTileSet()) {
+    if (id.level() <= max_level) {
+      tile_ids.push_back(id);
+    }
+  }
+  std::sort(tile_ids.begin(), tile_ids.end());
+
+  Network network;
+  uint64_t rows = 0;
+  for (const auto& id : tile_ids) {
+    const GraphTile* tile = reader.GetGraphTile(id);
+    uint32_t count = tile->header()->nodecount();
+    network.tiles.push_back({id.tile_value(), rows, count, 0});
+    network.first_rows.emplace(id.tile_value(), rows);
+    rows += count;
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  if (rows >= kNoVertex) {
+    throw std::runtime_error("Too many nodes for a contraction hierarchy overlay: " +
+                             std::to_string(rows));
+  }
+
+  // gather the edges of the access mode and join the nodes connected by transitions
+  network.groups.resize(rows);
+  network.lls.resize(rows);
+  for (uint32_t i = 0; i < rows; ++i) {
+    network.groups[i] = i;
+  }
+  for (const auto& t : network.tiles) {
+    GraphId tile_id(t.tile);
+    const GraphTile* tile = reader.GetGraphTile(tile_id);
+    for (uint32_t n = 0; n < t.node_count; ++n) {
+      uint32_t row = t.first_row + n;
+      const NodeInfo* node = tile->node(n);
+      network.lls[row] = node->latlng(tile->header()->base_ll());
+      GraphId edgeid(tile_id.tileid(), tile_id.level(), node->edge_index());
+      const DirectedEdge* edge = tile->directededge(node->edge_index());
+      for (uint32_t i = 0; i < node->edge_count(); ++i, ++edge, ++edgeid) {
+        if (edge->is_shortcut() || !(edge->forwardaccess() & access)) {
+          continue;
+        }
+        uint32_t end = network.row(edge->endnode());
+        if (end != kNoVertex) {
+          network.edges.push_back({row, end, edgeid.value});
+        }
+      }
+      for (const auto& transition : tile->GetNodeTransitions(node)) {
+        uint32_t end = network.row(transition.endnode());
+        if (end != kNoVertex) {
+          network.groups[network.group(end)] = network.group(row);
+        }
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  return network;
+}
+
+// Undirected adjacency lists of the vertices
+struct Adjacency {
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> neighbors;
+};
+
+// Orders the vertices of a cell by nested dissection: the cell is split in two at the median
+// of its longer side, the ends on one side of the edges between the halves are the separator
+// and go last, after the two halves which are ordered the same way. The separators end up
+// ranked above everything they separate so contracting a half never adds arcs into the other.
+void Dissect(const Adjacency& adjacency,
+             const std::vector<PointLL>& lls,
+             std::vector<uint32_t> cell,
+             std::vector<uint32_t>& cells,
+             uint32_t& next_cell,
+             std::vector<uint32_t>& order) {
+  if (cell.size() <= kLeafSize) {
+    order.insert(order.end(), cell.begin(), cell.end());
+    return;
+  }
+
+  double min_lng = 180.0, max_lng = -180.0, min_lat = 90.0, max_lat = -90.0;
+  for (auto v : cell) {
+    min_lng = std::min(min_lng, static_cast<double>(lls[v].lng()));
+    max_lng = std::max(max_lng, static_cast<double>(lls[v].lng()));
+    min_lat = std::min(min_lat, static_cast<double>(lls[v].lat()));
+    max_lat = std::max(max_lat, static_cast<double>(lls[v].lat()));
+  }
+  bool by_lng = max_lng - min_lng > max_lat - min_lat;
+  auto middle = cell.begin() + cell.size() / 2;
+  std::nth_element(cell.begin(), middle, cell.end(), [&lls, by_lng](uint32_t a, uint32_t b) {
+    return by_lng ? lls[a].lng() < lls[b].lng() : lls[a].lat() < lls[b].lat();
+  });
+
+  uint32_t first = next_cell++;
+  uint32_t second = next_cell++;
+  for (auto v = cell.begin(); v != cell.end(); ++v) {
+    cells[*v] = v < middle ? first : second;
+  }
+
+  // the edges between the halves have to be cut, take whichever side has fewer of their ends
+  std::vector<uint32_t> first_ends, second_ends;
+  for (auto v = cell.begin(); v != middle; ++v) {
+    for (uint64_t i = adjacency.offsets[*v]; i < adjacency.offsets[*v + 1]; ++i) {
+      if (cells[adjacency.neighbors[i]] == second) {
+        first_ends.push_back(*v);
+        second_ends.push_back(adjacency.neighbors[i]);
+      }
+    }
+  }
+  for (auto* ends : {&first_ends, &second_ends}) {
+    std::sort(ends->begin(), ends->end());
+    ends->erase(std::unique(ends->begin(), ends->end()), ends->end());
+  }
+  const auto& separator = first_ends.size() < second_ends.size() ? first_ends : second_ends;
+  uint32_t separated = next_cell++;
+  for (auto v : separator) {
+    cells[v] = separated;
+  }
+
+  std::vector<uint32_t> halves[2];
+  for (auto v : cell) {
+    if (cells[v] != separated) {
+      halves[cells[v] == second].push_back(v);
+    }
+  }
+  cell.clear();
+  cell.shrink_to_fit();
+  Dissect(adjacency, lls, std::move(halves[0]), cells, next_cell, order);
+  Dissect(adjacency, lls, std::move(halves[1]), cells, next_cell, order);
+  order.insert(order.end(), separator.begin(), separator.end());
+}
+
+// Orders and contracts the vertices of the network and writes the overlay
+void WriteOverlay(Network& network, const uint32_t access, const std::string& file_name) {
+  // every intersection with an edge is a vertex
+  std::vector<uint32_t> group_vertex(network.groups.size(), kNoVertex);
+  std::vector<PointLL> lls;
+  std::vector<std::pair<uint32_t, uint32_t>> pairs;
+  auto vertex = [&](const uint32_t row) {
+    uint32_t group = network.group(row);
+    if (group_vertex[group] == kNoVertex) {
+      group_vertex[group] = lls.size();
+      lls.push_back(network.lls[row]);
+    }
+    return group_vertex[group];
+  };
+  for (auto& edge : network.edges) {
+    edge.from = vertex(edge.from);
+    edge.to = vertex(edge.to);
+    if (edge.from != edge.to) {
+      pairs.emplace_back(std::min(edge.from, edge.to), std::max(edge.from, edge.to));
+    }
+  }
+  const uint32_t vertex_count = lls.size();
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  // order the vertices by nested dissection
+  Adjacency adjacency;
+  adjacency.offsets.assign(vertex_count + 1, 0);
+  for (const auto& pair : pairs) {
+    ++adjacency.offsets[pair.first + 1];
+    ++adjacency.offsets[pair.second + 1];
+  }
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    adjacency.offsets[v + 1] += adjacency.offsets[v];
+  }
+  adjacency.neighbors.resize(adjacency.offsets.back());
+  {
+    auto next = adjacency.offsets;
+    for (const auto& pair : pairs) {
+      adjacency.neighbors[next[pair.first]++] = pair.second;
+      adjacency.neighbors[next[pair.second]++] = pair.first;
+    }
+  }
+  std::vector<uint32_t> all(vertex_count), cells(vertex_count, 0), order;
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    all[v] = v;
+  }
+  order.reserve(vertex_count);
+  uint32_t next_cell = 1;
+  Dissect(adjacency, lls, std::move(all), cells, next_cell, order);
+  adjacency = Adjacency();
+  std::vector<uint32_t> rank(vertex_count);
+  for (uint32_t i = 0; i < vertex_count; ++i) {
+    rank[order[i]] = i;
+  }
+
+  // contract the vertices lowest rank first: the higher neighbors of a vertex become neighbors
+  // of its lowest higher neighbor, which is all the shortcuts any metric could need
+  std::vector<std::vector<uint32_t>> up(vertex_count);
+  for (const auto& pair : pairs) {
+    uint32_t a = rank[pair.first], b = rank[pair.second];
+    up[std::min(a, b)].push_back(std::max(a, b));
+  }
+  pairs.clear();
+  pairs.shrink_to_fit();
+  for (auto& heads : up) {
+    std::sort(heads.begin(), heads.end());
+  }
+  std::vector<uint32_t> merged;
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    if (up[v].size() > 1) {
+      auto& parent = up[up[v].front()];
+      merged.clear();
+      std::set_union(parent.begin(), parent.end(), up[v].begin() + 1, up[v].end(),
+                     std::back_inserter(merged));
+      parent.swap(merged);
+    }
+  }
+
+  std::vector<uint32_t> first_arcs(vertex_count + 1, 0), heads;
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    first_arcs[v + 1] = first_arcs[v] + up[v].size();
+    if (first_arcs[v + 1] >= kMaxCount) {
+      throw std::runtime_error("Too many arcs for a contraction hierarchy overlay");
+    }
+  }
+  heads.reserve(first_arcs.back());
+  for (auto& arcs : up) {
+    heads.insert(heads.end(), arcs.begin(), arcs.end());
+    std::vector<uint32_t>().swap(arcs);
+  }
+
+  // the directed edges of each arc
+  if (network.edges.size() >= kMaxCount || vertex_count >= kMaxCount) {
+    throw std::runtime_error("Too many edges for a contraction hierarchy overlay");
+  }
+  std::vector<uint32_t> edge_arcs;
+  edge_arcs.reserve(network.edges.size());
+  std::vector<uint32_t> first_edges(heads.size() + 1, 0);
+  for (const auto& edge : network.edges) {
+    uint32_t arc = CCHOverlay::kNoArc;
+    if (edge.from != edge.to) {
+      uint32_t lower = std::min(rank[edge.from], rank[edge.to]);
+      uint32_t higher = std::max(rank[edge.from], rank[edge.to]);
+      auto first = heads.begin() + first_arcs[lower];
+      auto last = heads.begin() + first_arcs[lower + 1];
+      arc = std::lower_bound(first, last, higher) - heads.begin();
+      ++first_edges[arc + 1];
+    }
+    edge_arcs.push_back(arc);
+  }
+  for (size_t arc = 0; arc < heads.size(); ++arc) {
+    first_edges[arc + 1] += first_edges[arc];
+  }
+  std::vector<CCHEdge> edges(first_edges.back());
+  {
+    auto next = first_edges;
+    for (size_t i = 0; i < network.edges.size(); ++i) {
+      if (edge_arcs[i] != CCHOverlay::kNoArc) {
+        auto& edge = edges[next[edge_arcs[i]]++];
+        edge.edgeid = network.edges[i].edgeid;
+        edge.down = rank[network.edges[i].from] > rank[network.edges[i].to];
+      }
+    }
+  }
+
+  // the vertex of each graph node
+  std::vector<uint32_t> vertices(network.groups.size());
+  for (uint32_t row = 0; row < vertices.size(); ++row) {
+    uint32_t v = group_vertex[network.group(row)];
+    vertices[row] = v == kNoVertex ? kNoVertex : rank[v];
+  }
+
+  auto dir = boost::filesystem::path(file_name).parent_path();
+  if (!dir.empty()) {
+    boost::filesystem::create_directories(dir);
+  }
+  CCHOverlay::Write(file_name, access, network.tiles, vertices, first_arcs, heads, first_edges,
+                    edges);
+  LOG_INFO("CCHBuilder: wrote " + file_name + " with " + std::to_string(vertex_count) +
+           " vertices, " + std::to_string(heads.size()) + " arcs and " +
+           std::to_string(edges.size()) + " edges");
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void CCHBuilder::Build(const boost::property_tree::ptree& pt) {
+  if (!pt.get<bool>("mjolnir.cch.build", false)) {
+    LOG_INFO("CCHBuilder: not enabled, skipping");
+    return;
+  }
+  auto file_name = pt.get<std::string>("mjolnir.cch.file",
+                                       pt.get<std::string>("mjolnir.tile_dir") + "/overlay.cch");
+  auto start = std::chrono::steady_clock::now();
+
+  // the overlay is for auto routes, the only costing thor routes on it
+  const uint32_t access = kAutoAccess;
+  GraphReader reader(pt.get_child("mjolnir"));
+  Network network = ReadNetwork(reader, access);
+  if (network.edges.empty()) {
+    LOG_WARN("CCHBuilder: no edges, skipping");
+    return;
+  }
+  WriteOverlay(network, access, file_name);
+  auto secs = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+  LOG_INFO("CCHBuilder: took " + std::to_string(secs) + " secs");
+}
+
+} // namespace mjolnir
+} // namespace valhalla
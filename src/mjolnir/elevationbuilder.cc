@@ -174,7 +174,9 @@ void ElevationBuilder::Build(const boost::property_tree::ptree& pt) {
   boost::optional<std::string> elevation = pt.get_optional<std::string>("additional_data.elevation");
   std::unique_ptr<const skadi::sample> sample;
   if (elevation && boost::filesystem::exists(*elevation)) {
-    sample.reset(new skadi::sample(*elevation));
+    sample.reset(new skadi::sample(*elevation,
+                                   pt.get<size_t>("additional_data.elevation_max_cache_size",
+                                                  skadi::kDefaultMaxUnzippedBytes)));
   } else {
     LOG_INFO("ElevationBuilder: no elevation data, skipping");
     return;
@@ -8,7 +8,9 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/format.hpp>
+#include <deque>
 #include <future>
+#include <mutex>
 #include <set>
 #include <thread>
 #include <utility>
@@ -380,6 +382,13 @@ uint32_t AddAccessRestrictions(const uint32_t edgeid,
   return modes;
 }
 
+// A tile to build and where its nodes are in the sorted nodes sequence
+struct TileNodes {
+  GraphId tile_id;
+  size_t node_index;
+  size_t node_count;
+};
+
 void BuildTileSet(const std::string& ways_file,
                   const std::string& way_nodes_file,
                   const std::string& nodes_file,
@@ -388,11 +397,12 @@ void BuildTileSet(const std::string& ways_file,
                   const std::string& complex_restriction_to_file,
                   const std::string& tile_dir,
                   const OSMData& osmdata,
-                  std::map<GraphId, size_t>::const_iterator tile_start,
-                  std::map<GraphId, size_t>::const_iterator tile_end,
+                  std::deque<TileNodes>& tilequeue,
+                  std::mutex& lock,
                   const uint32_t tile_creation_date,
                   const boost::property_tree::ptree& pt,
                   std::promise<DataQuality>& result) {
+  WorkerTimer timer("GraphBuilder");
 
   sequence<OSMWay> ways(ways_file, false);
   sequence<OSMWayNode> way_nodes(way_nodes_file, false);
@@ -446,11 +456,20 @@ void BuildTileSet(const std::string& ways_file,
   std::unordered_map<uint32_t, std::pair<float, uint32_t>> geo_attribute_cache;
 
   ////////////////////////////////////////////////////////////////////////////
-  // Iterate over tiles
-  for (; tile_start != tile_end; ++tile_start) {
+  // Iterate over tiles, taking the next one off of the queue
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    TileNodes tile = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
     try {
       // What actually writes the tile
-      GraphId tile_id = tile_start->first.Tile_Base();
+      GraphId tile_id = tile.tile_id.Tile_Base();
       GraphTileBuilder graphtile(tile_dir, tile_id, false);
 
       // Information about tile creation
@@ -487,17 +506,24 @@ void BuildTileSet(const std::string& ways_file,
         }
       }
 
+      // Index the polygons when there is more than one to pick from
+      MultiPolyIndex admin_index_polys, tz_index_polys;
+      if (!tile_within_one_admin && !admin_polys.empty()) {
+        admin_index_polys = MultiPolyIndex(admin_polys, tiling.TileBounds(id));
+      }
+      if (!tile_within_one_tz && !tz_polys.empty()) {
+        tz_index_polys = MultiPolyIndex(tz_polys, tiling.TileBounds(id));
+      }
+
       // Iterate through the nodes
       uint32_t idx = 0; // Current directed edge index
 
       ////////////////////////////////////////////////////////////////////////
       // Iterate over nodes in the tile
-      auto node_itr = nodes[tile_start->second];
+      auto node_itr = nodes[tile.node_index];
       // to avoid realloc we guess how many edges there might be in a given tile
       geo_attribute_cache.clear();
-      geo_attribute_cache.reserve(5 * (std::next(tile_start) == tile_end
-                                           ? nodes.end() - node_itr
-                                           : std::next(tile_start)->second - tile_start->second));
+      geo_attribute_cache.reserve(5 * tile.node_count);
 
       while (node_itr != nodes.end() && (*node_itr).graph_id.Tile_Base() == tile_id) {
         // amalgamate all the node duplicates into one and the edges that connect to it
@@ -516,7 +542,7 @@ void BuildTileSet(const std::string& ways_file,
         // Get the admin index
         uint32_t admin_index = (tile_within_one_admin)
                                    ? admin_polys.begin()->first
-                                   : GetMultiPolyId(admin_polys, node_ll, graphtile);
+                                   : GetMultiPolyId(admin_index_polys, node_ll, graphtile);
 
         // Look for potential duplicates
         // CheckForDuplicates(nodeid, node, edgelengths, nodes, edges, osmdata.ways, stats);
@@ -1010,8 +1036,8 @@ void BuildTileSet(const std::string& ways_file,
         }
 
         // Set the time zone index
-        uint32_t tz_index =
-            (tile_within_one_tz) ? tz_polys.begin()->first : GetMultiPolyId(tz_polys, node_ll);
+        uint32_t tz_index = (tile_within_one_tz) ? tz_polys.begin()->first
+                                                 : GetMultiPolyId(tz_index_polys, node_ll);
 
         graphtile.nodes().back().set_timezone(tz_index);
 
@@ -1036,14 +1062,15 @@ void BuildTileSet(const std::string& ways_file,
       graphtile.StoreTileData();
 
       // Made a tile
-      LOG_DEBUG((boost::format("Wrote tile %1%: %2% bytes") % tile_start->first %
+      LOG_DEBUG((boost::format("Wrote tile %1%: %2% bytes") % tile.tile_id %
                  graphtile.header_builder().end_offset())
                     .str());
+      timer.AddTile(tile.node_count);
     } // Whatever happens in Vegas..
     catch (std::exception& e) {
       // ..gets sent back to the main thread
       result.set_exception(std::current_exception());
-      LOG_ERROR((boost::format("Failed tile %1%: %2%") % tile_start->first % e.what()).str());
+      LOG_ERROR((boost::format("Failed tile %1%: %2%") % tile.tile_id % e.what()).str());
       return;
     }
   }
@@ -1087,26 +1114,28 @@ void BuildLocalTiles(const unsigned int thread_count,
   // Hold the results (DataQuality/stats) for the threads
   std::vector<std::promise<DataQuality>> results(threads.size());
 
-  // Divvy up the work
-  size_t floor = tiles.size() / threads.size();
-  size_t at_ceiling = tiles.size() - (threads.size() * floor);
-  std::map<GraphId, size_t>::const_iterator tile_start, tile_end = tiles.begin();
+  // Queue up the work, the tiles with the most nodes first so that the
+  // threads finish at about the same time
+  std::deque<TileNodes> tilequeue;
+  size_t node_total = sequence<Node>(nodes_file, false).size();
+  for (auto tile = tiles.begin(); tile != tiles.end(); ++tile) {
+    size_t node_end = std::next(tile) == tiles.end() ? node_total : std::next(tile)->second;
+    tilequeue.push_back({tile->first, tile->second, node_end - tile->second});
+  }
+  std::stable_sort(tilequeue.begin(), tilequeue.end(), [](const TileNodes& a, const TileNodes& b) {
+    return a.node_count > b.node_count;
+  });
+  std::mutex lock;
 
   // Atomically pass around stats info
   for (size_t i = 0; i < threads.size(); ++i) {
-    // Figure out how many this thread will work on (either ceiling or floor)
-    size_t tile_count = (i < at_ceiling ? floor + 1 : floor);
-    // Where the range begins
-    tile_start = tile_end;
-    // Where the range ends
-    std::advance(tile_end, tile_count);
-    // Make the thread
     threads[i].reset(new std::thread(BuildTileSet, std::cref(ways_file), std::cref(way_nodes_file),
                                      std::cref(nodes_file), std::cref(edges_file),
                                      std::cref(complex_from_restriction_file),
                                      std::cref(complex_to_restriction_file), std::cref(tile_dir),
-                                     std::cref(osmdata), tile_start, tile_end, tile_creation_date,
-                                     std::cref(pt.get_child("mjolnir")), std::ref(results[i])));
+                                     std::cref(osmdata), std::ref(tilequeue), std::ref(lock),
+                                     tile_creation_date, std::cref(pt.get_child("mjolnir")),
+                                     std::ref(results[i])));
   }
 
   // Join all the threads to wait for them to finish up their work
@@ -1438,6 +1438,7 @@ void enhance(const boost::property_tree::ptree& pt,
   uint32_t urban_rc_speed[] = {89, 73, 57, 49, 40, 35, 30, 20};
 
   // Get some things we need throughout
+  WorkerTimer timer("GraphEnhancer");
   enhancer_stats stats{std::numeric_limits<float>::min(), 0};
   const auto& local_level = TileHierarchy::levels().rbegin()->second.level;
   const auto& tiles = TileHierarchy::levels().rbegin()->second.tiles;
@@ -1816,6 +1817,7 @@ void enhance(const boost::property_tree::ptree& pt,
     lock.lock();
     tilebuilder.StoreTileData();
     LOG_TRACE((boost::format("GraphEnhancer completed tile %1%") % tile_id).str());
+    timer.AddTile(tilebuilder.header()->directededgecount());
 
     // Check if we need to clear the tile cache
     if (reader.OverCommitted()) {
@@ -1851,17 +1853,12 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
   // A place to hold the results of those threads, exceptions or otherwise
   std::list<std::promise<enhancer_stats>> results;
 
-  // Create a randomized queue of tiles to work from
-  std::deque<GraphId> tempqueue;
+  // Create a queue of tiles to work from, the most expensive tiles first
   boost::property_tree::ptree hierarchy_properties = pt.get_child("mjolnir");
   auto local_level = TileHierarchy::levels().rbegin()->second.level;
   GraphReader reader(hierarchy_properties);
   auto local_tiles = reader.GetTileSet(local_level);
-  for (const auto& tile_id : local_tiles) {
-    tempqueue.emplace_back(tile_id);
-  }
-  std::random_shuffle(tempqueue.begin(), tempqueue.end());
-  std::queue<GraphId> tilequeue(tempqueue);
+  std::queue<GraphId> tilequeue(CostOrderedTileQueue(reader.tile_dir(), local_tiles));
 
   // An atomic object we can use to do the synchronization
   std::mutex lock;
@@ -269,6 +269,7 @@ void validate(
 
   // Vector to hold problem ways
   std::set<uint32_t> problem_ways;
+  WorkerTimer timer("GraphValidator");
 
   // Check for more tiles
   while (true) {
@@ -481,6 +482,7 @@ void validate(
 
     // Add possible duplicates to return class
     duplicates[level] += dupcount;
+    timer.AddTile(directededges.size());
   }
 
   // TODO - output problem ways - this could be a useful list!
@@ -550,14 +552,10 @@ void GraphValidator::Validate(const boost::property_tree::ptree& pt) {
   auto hierarchy_properties = pt.get_child("mjolnir");
   std::string tile_dir = hierarchy_properties.get<std::string>("tile_dir");
 
-  // Create a randomized queue of tiles (at all levels) to work from
-  std::deque<GraphId> tilequeue;
+  // Create a queue of tiles (at all levels) to work from, the most expensive
+  // tiles first
   GraphReader reader(pt.get_child("mjolnir"));
-  auto tileset = reader.GetTileSet();
-  for (const auto& id : tileset) {
-    tilequeue.emplace_back(id);
-  }
-  std::random_shuffle(tilequeue.begin(), tilequeue.end());
+  std::deque<GraphId> tilequeue = CostOrderedTileQueue(tile_dir, reader.GetTileSet());
 
   // Remember what the dataset id is in case we have to make some tiles
   auto dataset_id = GraphTile(tile_dir, *tilequeue.begin()).header()->dataset_id();
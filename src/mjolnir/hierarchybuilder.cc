@@ -5,11 +5,18 @@
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -122,78 +129,65 @@ bool OpposingEdgeInfoMatches(const GraphTile* tile, const DirectedEdge* edge) {
   return false;
 }
 
-// Form tiles in the new level.
-void FormTilesInNewLevel(GraphReader& reader,
-                         const std::string& new_to_old_file,
-                         const std::string& old_to_new_file) {
-  // Use the sequence that associate new nodes to old nodes
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-
-  // Use the sorted sequence that associates old nodes to new nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
-
-  // lambda to indicate whether a directed edge should be included
-  auto include_edge = [&old_to_new](const DirectedEdge* directededge, const GraphId& base_node,
-                                    const uint8_t current_level) {
-    if (directededge->use() == Use::kTransitConnection ||
-        directededge->use() == Use::kEgressConnection ||
-        directededge->use() == Use::kPlatformConnection) {
-      // Transit connection edges should live on the lowest class level
-      // where a new node exists
-      uint8_t lowest_level;
-      auto f = find_nodes(old_to_new, base_node);
-      if (f.local_node.Is_Valid()) {
-        lowest_level = 2;
-      } else if (f.arterial_node.Is_Valid()) {
-        lowest_level = 1;
-      } else if (f.highway_node.Is_Valid()) {
-        lowest_level = 0;
-      }
-      return (lowest_level == current_level);
-    } else if (directededge->bss_connection()) {
-      // Despite the road class, Bike Share Stations' connections are always at local level
-      return (2 == current_level);
-    } else {
-      return (TileHierarchy::get_level(directededge->classification()) == current_level);
+// Should a directed edge of a base node be included on the level
+bool IncludeEdge(sequence<OldToNewNodes>& old_to_new,
+                 const DirectedEdge* directededge,
+                 const GraphId& base_node,
+                 const uint8_t current_level) {
+  if (directededge->use() == Use::kTransitConnection ||
+      directededge->use() == Use::kEgressConnection ||
+      directededge->use() == Use::kPlatformConnection) {
+    // Transit connection edges should live on the lowest class level
+    // where a new node exists
+    uint8_t lowest_level;
+    auto f = find_nodes(old_to_new, base_node);
+    if (f.local_node.Is_Valid()) {
+      lowest_level = 2;
+    } else if (f.arterial_node.Is_Valid()) {
+      lowest_level = 1;
+    } else if (f.highway_node.Is_Valid()) {
+      lowest_level = 0;
     }
-  };
+    return (lowest_level == current_level);
+  } else if (directededge->bss_connection()) {
+    // Despite the road class, Bike Share Stations' connections are always at local level
+    return (2 == current_level);
+  } else {
+    return (TileHierarchy::get_level(directededge->classification()) == current_level);
+  }
+}
 
-  // Iterate through the new nodes. They have been sorted by level so that
-  // highway level is done first.
-  reader.Clear();
-  bool added = false;
-  uint8_t current_level;
+// Range of the (sorted) new to old sequence holding the nodes of a new tile
+struct NewTileRange {
   GraphId tile_id;
+  size_t begin;
+  size_t end;
+};
+
+// Form a tile in the new level from the base nodes associated to its new nodes.
+void FormTileInNewLevel(GraphReader& reader,
+                        sequence<std::pair<GraphId, GraphId>>& new_to_old,
+                        sequence<OldToNewNodes>& old_to_new,
+                        const NewTileRange& range) {
+  bool added = false;
   std::hash<std::string> hasher;
-  PointLL base_ll;
-  GraphTileBuilder* tilebuilder = nullptr;
-  for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++) {
-    // Get the node - check if a new tile
-    GraphId nodea = (*new_node).first;
-    if (nodea.Tile_Base() != tile_id) {
-      // Store the prior tile
-      if (tilebuilder != nullptr) {
-        tilebuilder->StoreTileData();
-        delete tilebuilder;
-      }
 
-      // New tilebuilder for the next tile. Update current level.
-      tile_id = nodea.Tile_Base();
-      tilebuilder = new GraphTileBuilder(reader.tile_dir(), tile_id, false);
-      current_level = nodea.level();
+  // New tilebuilder for the tile
+  GraphId tile_id = range.tile_id;
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+  uint8_t current_level = tile_id.level();
 
-      // Set the base ll for this tile
-      base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
-      tilebuilder->header_builder().set_base_ll(base_ll);
+  // Set the base ll for this tile
+  PointLL base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
+  tilebuilder.header_builder().set_base_ll(base_ll);
 
-      // Check if we need to clear the base/local tile cache
-      if (reader.OverCommitted()) {
-        reader.Trim();
-      }
-    }
+  // Iterate through the new nodes of the tile
+  for (size_t n = range.begin; n < range.end; ++n) {
+    const std::pair<GraphId, GraphId> new_node = new_to_old[n];
+    GraphId nodea = new_node.first;
 
     // Get the node in the base level
-    GraphId base_node = (*new_node).second;
+    GraphId base_node = new_node.second;
     const GraphTile* tile = reader.GetGraphTile(base_node);
     if (tile == nullptr) {
       LOG_ERROR("Base tile is null? ");
@@ -201,17 +195,17 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
 
     // Copy the data version
-    tilebuilder->header_builder().set_dataset_id(tile->header()->dataset_id());
+    tilebuilder.header_builder().set_dataset_id(tile->header()->dataset_id());
 
     // Copy node information and set the node lat,lon offsets within the new tile
     NodeInfo baseni = *(tile->node(base_node.id()));
-    tilebuilder->nodes().push_back(baseni);
+    tilebuilder.nodes().push_back(baseni);
     const auto& admin = tile->admininfo(baseni.admin_index());
-    NodeInfo& node = tilebuilder->nodes().back();
+    NodeInfo& node = tilebuilder.nodes().back();
     node.set_latlng(base_ll, baseni.latlng(tile->header()->base_ll()));
-    node.set_edge_index(tilebuilder->directededges().size());
+    node.set_edge_index(tilebuilder.directededges().size());
     node.set_timezone(baseni.timezone());
-    node.set_admin_index(tilebuilder->AddAdmin(admin.country_text(), admin.state_text(),
+    node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
                                                admin.country_iso(), admin.state_iso()));
 
     // Update node LL based on tile base
@@ -219,7 +213,7 @@ void FormTilesInNewLevel(GraphReader& reader,
     uint32_t density1 = baseni.density();
 
     // Current edge count
-    size_t edge_count = tilebuilder->directededges().size();
+    size_t edge_count = tilebuilder.directededges().size();
 
     // Iterate through directed edges of the base node to get remaining
     // directed edges (based on classification/importance cutoff)
@@ -227,7 +221,7 @@ void FormTilesInNewLevel(GraphReader& reader,
     for (uint32_t i = 0; i < baseni.edge_count(); i++, ++base_edge_id) {
       // Check if the directed edge should exist on this level
       const DirectedEdge* directededge = tile->directededge(base_edge_id);
-      if (!include_edge(directededge, base_node, current_level)) {
+      if (!IncludeEdge(old_to_new, directededge, base_node, current_level)) {
         continue;
       }
 
@@ -273,13 +267,13 @@ void FormTilesInNewLevel(GraphReader& reader,
         if (signs.size() == 0) {
           LOG_ERROR("Base edge should have signs, but none found");
         }
-        tilebuilder->AddSigns(tilebuilder->directededges().size(), signs);
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
       }
 
       // Get turn lanes from the base directed edge
       if (directededge->turnlanes()) {
         uint32_t offset = tile->turnlanes_offset(base_edge_id.id());
-        tilebuilder->AddTurnLanes(tilebuilder->directededges().size(), tile->GetName(offset));
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
       }
 
       // Get access restrictions from the base directed edge. Add these to
@@ -288,7 +282,7 @@ void FormTilesInNewLevel(GraphReader& reader,
       if (directededge->access_restriction()) {
         auto restrictions = tile->GetAccessRestrictions(base_edge_id.id(), kAllAccess);
         for (const auto& res : restrictions) {
-          tilebuilder->AddAccessRestriction(AccessRestriction(tilebuilder->directededges().size(),
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
                                                               res.type(), res.modes(), res.value()));
         }
       }
@@ -300,9 +294,9 @@ void FormTilesInNewLevel(GraphReader& reader,
           LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
         for (auto& lc : laneconnectivity) {
-          lc.set_to(tilebuilder->directededges().size());
+          lc.set_to(tilebuilder.directededges().size());
         }
-        tilebuilder->AddLaneConnectivity(laneconnectivity);
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
       }
 
       // Do we need to force adding edgeinfo (opposing edge could have diff names)?
@@ -320,39 +314,39 @@ void FormTilesInNewLevel(GraphReader& reader,
       std::string encoded_shape = edgeinfo.encoded_shape();
       uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
       uint32_t edge_info_offset =
-          tilebuilder->AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
+          tilebuilder.AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
                                    edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
                                    tile->GetNames(idx), tile->GetTypes(idx), added, diff_names);
       newedge.set_edgeinfo_offset(edge_info_offset);
 
       // Add directed edge
-      tilebuilder->directededges().emplace_back(std::move(newedge));
+      tilebuilder.directededges().emplace_back(std::move(newedge));
     }
 
     // Add node transitions
-    uint32_t index = tilebuilder->transitions().size();
+    uint32_t index = tilebuilder.transitions().size();
     auto new_nodes = find_nodes(old_to_new, base_node);
     if (current_level == 0) {
-      AddDownwardTransition(new_nodes.arterial_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddDownwardTransition(new_nodes.arterial_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 1) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     }
     if (current_level == 2) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddUpwardTransition(new_nodes.arterial_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddUpwardTransition(new_nodes.arterial_node, &tilebuilder);
     }
 
     // Set the node transition count and index
-    uint32_t count = tilebuilder->transitions().size() - index;
+    uint32_t count = tilebuilder.transitions().size() - index;
     if (count > 0) {
       node.set_transition_count(count);
       node.set_transition_index(index);
     }
 
     // Set the edge count for the new node
-    node.set_edge_count(tilebuilder->directededges().size() - edge_count);
+    node.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
     // Get named signs from the base node
     if (baseni.named_intersection()) {
@@ -361,14 +355,206 @@ void FormTilesInNewLevel(GraphReader& reader,
         LOG_ERROR("Base node should have signs, but none found");
       }
       node.set_named_intersection(true);
-      tilebuilder->AddSigns(tilebuilder->nodes().size() - 1, signs);
+      tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
+    }
+  }
+
+  // Store the tile
+  tilebuilder.StoreTileData();
+}
+
+/**
+ * Forms a set of tiles in the new levels. Each thread pulls a tile off of
+ * the queue.
+ */
+void FormTilesInNewLevel(const boost::property_tree::ptree& pt,
+                         const std::string& new_to_old_file,
+                         const std::string& old_to_new_file,
+                         std::deque<NewTileRange>& tilequeue,
+                         std::mutex& lock,
+                         std::promise<uint32_t>& result) {
+  // Local Graphreader and handles on the sequences
+  GraphReader reader(pt);
+  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+
+  uint32_t tile_count = 0;
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    // Get the next tile
+    NewTileRange range = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    try {
+      FormTileInNewLevel(reader, new_to_old, old_to_new, range);
+      tile_count++;
+    } // Send any failure back to the main thread
+    catch (std::exception& e) {
+      result.set_exception(std::current_exception());
+      LOG_ERROR((boost::format("Failed tile %1%: %2%") % range.tile_id % e.what()).str());
+      return;
+    }
+
+    // Check if we need to clear the base/local tile cache
+    if (reader.OverCommitted()) {
+      reader.Trim();
     }
   }
+  result.set_value(tile_count);
+}
+
+// Form tiles in the new levels.
+void FormTilesInNewLevels(const boost::property_tree::ptree& pt,
+                          const std::string& new_to_old_file,
+                          const std::string& old_to_new_file,
+                          const size_t thread_count) {
+  // Find the range of each new tile within the new nodes. They have been
+  // sorted by level so that highway level comes first. The new local tiles
+  // replace the base tiles they are formed from, so the tiles of the other
+  // levels are all formed before the first of them is written. A new local
+  // tile only reads its own base tile, the local tiles can be formed in any
+  // order after that.
+  std::deque<NewTileRange> upper_tiles, local_tiles;
+  {
+    uint8_t local_level = TileHierarchy::levels().rbegin()->second.level;
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    size_t n = 0;
+    for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); ++new_node, ++n) {
+      GraphId tile_id = (*new_node).first.Tile_Base();
+      auto& tiles = tile_id.level() == local_level ? local_tiles : upper_tiles;
+      if (tiles.empty() || tiles.back().tile_id != tile_id) {
+        tiles.push_back({tile_id, n, n});
+      }
+      tiles.back().end = n + 1;
+    }
+  }
+
+  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+  for (auto* tilequeue : {&upper_tiles, &local_tiles}) {
+    std::mutex lock;
+    std::list<std::promise<uint32_t>> results;
+    for (auto& thread : threads) {
+      results.emplace_back();
+      thread.reset(new std::thread(FormTilesInNewLevel, std::cref(pt.get_child("mjolnir")),
+                                   std::cref(new_to_old_file), std::cref(old_to_new_file),
+                                   std::ref(*tilequeue), std::ref(lock),
+                                   std::ref(results.back())));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+
+    // If something bad went down this will rethrow it
+    for (auto& result : results) {
+      result.get_future().get();
+    }
+  }
+}
+
+// Levels a base node exists on. The new nodes on the highway and arterial
+// levels are given by the tile they fall in, their ids are assigned later.
+struct NodeLevels {
+  GraphId highway_tile;  // Tile on the highway level (invalid if not on the level)
+  GraphId arterial_tile; // Tile on the arterial level (invalid if not on the level)
+  bool local;            // Exists on the local level
+  uint32_t density;      // Density at the node
+};
+
+/**
+ * Find the levels of the nodes in a set of base tiles. Each thread pulls the
+ * index of a tile off of the shared counter and sets the result of that tile.
+ */
+void FindNodeLevels(const boost::property_tree::ptree& pt,
+                    const std::vector<GraphId>& tiles,
+                    size_t& next_tile,
+                    std::mutex& lock,
+                    std::vector<std::promise<std::vector<NodeLevels>>>& results) {
+  // Local Graphreader
+  GraphReader reader(pt);
+
+  // Hierarchy level information
+  auto tile_level = TileHierarchy::levels().rbegin();
+  tile_level++;
+  auto& arterial_level = tile_level->second;
+  tile_level++;
+  auto& highway_level = tile_level->second;
+  uint32_t al = static_cast<uint32_t>(arterial_level.level);
+  uint32_t hl = static_cast<uint32_t>(highway_level.level);
+
+  while (true) {
+    lock.lock();
+    if (next_tile == tiles.size()) {
+      lock.unlock();
+      break;
+    }
+    // Get the next tile
+    size_t index = next_tile++;
+    lock.unlock();
+
+    try {
+      // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
+      std::vector<NodeLevels> nodes;
+      const GraphId& base_tile_id = tiles[index];
+      const GraphTile* tile = reader.GetGraphTile(base_tile_id);
+      if (tile == nullptr || tile->header()->nodecount() == 0) {
+        results[index].set_value(std::move(nodes));
+        continue;
+      }
+
+      // Iterate through the nodes. Add nodes to the new level when
+      // best road class <= the new level classification cutoff
+      bool levels[3];
+      uint32_t nodecount = tile->header()->nodecount();
+      GraphId edgeid = base_tile_id;
+      PointLL base_ll = tile->header()->base_ll();
+      const NodeInfo* nodeinfo = tile->node(base_tile_id);
+      nodes.reserve(nodecount);
+      for (uint32_t i = 0; i < nodecount; i++, nodeinfo++) {
+        // Iterate through the edges to see which levels this node exists.
+        levels[0] = levels[1] = levels[2] = false;
+        for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
+          // Update the flag for the level of this edge (skip transit
+          // connection edges)
+          const DirectedEdge* directededge = tile->directededge(edgeid);
+          if (directededge->bss_connection()) {
+            // Despite the road class, Bike Share Stations' connections are always at local level
+            levels[2] = true;
+          } else if (directededge->use() != Use::kTransitConnection &&
+                     directededge->use() != Use::kEgressConnection &&
+                     directededge->use() != Use::kPlatformConnection) {
+            levels[TileHierarchy::get_level(directededge->classification())] = true;
+          }
+        }
 
-  // Delete the tile builder
-  if (tilebuilder != nullptr) {
-    tilebuilder->StoreTileData();
-    delete tilebuilder;
+        NodeLevels node{{}, {}, levels[2], nodeinfo->density()};
+        if (levels[0]) {
+          node.highway_tile = GraphId(highway_level.tiles.TileId(nodeinfo->latlng(base_ll)), hl, 0);
+        }
+        if (levels[1]) {
+          node.arterial_tile =
+              GraphId(arterial_level.tiles.TileId(nodeinfo->latlng(base_ll)), al, 0);
+        }
+        if (!levels[0] && !levels[1] && !levels[2]) {
+          LOG_ERROR("No valid level for this node!");
+        }
+        nodes.push_back(node);
+      }
+      results[index].set_value(std::move(nodes));
+    } // Send any failure back to the main thread
+    catch (std::exception& e) {
+      results[index].set_exception(std::current_exception());
+      LOG_ERROR((boost::format("Failed tile %1%: %2%") % tiles[index] % e.what()).str());
+    }
+
+    // Check if we need to clear the tile cache
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
   }
 }
 
@@ -377,11 +563,14 @@ void FormTilesInNewLevel(GraphReader& reader,
  * hierarchy levels and the existing nodes on the base/local level. The
  * associations go both ways: from the "old" nodes on the base/local level
  * to new nodes (using a mapping in memory) and from new nodes to old nodes
- * using a sequence (file).
+ * using a sequence (file). The levels of the nodes are found in parallel,
+ * the new node ids are then assigned tile by tile in the order of the tile
+ * set so they do not depend on the number of threads.
  */
-void CreateNodeAssociations(GraphReader& reader,
+void CreateNodeAssociations(const boost::property_tree::ptree& pt,
                             const std::string& new_to_old_file,
-                            const std::string& old_to_new_file) {
+                            const std::string& old_to_new_file,
+                            const size_t thread_count) {
   // Map of tiles vs. count of nodes. Used to construct new node Ids.
   std::unordered_map<GraphId, uint32_t> new_nodes;
 
@@ -405,88 +594,64 @@ void CreateNodeAssociations(GraphReader& reader,
   // Create a sequence to associate new nodes to old nodes
   sequence<OldToNewNodes> old_to_new(old_to_new_file, true);
 
-  // Hierarchy level information
-  auto tile_level = TileHierarchy::levels().rbegin();
-  auto& base_level = tile_level->second;
-  tile_level++;
-  auto& arterial_level = tile_level->second;
-  tile_level++;
-  auto& highway_level = tile_level->second;
-
   // Get the set of tiles on the local level
-  auto local_tiles = reader.GetTileSet(base_level.level);
-
-  // Iterate through all tiles in the local level
-  uint32_t ntiles = base_level.tiles.TileCount();
-  uint32_t bl = static_cast<uint32_t>(base_level.level);
-  uint32_t al = static_cast<uint32_t>(arterial_level.level);
-  uint32_t hl = static_cast<uint32_t>(highway_level.level);
-  for (const auto& base_tile_id : local_tiles) {
-    // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
-    const GraphTile* tile = reader.GetGraphTile(base_tile_id);
-    if (tile == nullptr || tile->header()->nodecount() == 0) {
-      continue;
-    }
+  GraphReader reader(pt.get_child("mjolnir"));
+  auto local_level = TileHierarchy::levels().rbegin()->second.level;
+  auto local_tileset = reader.GetTileSet(local_level);
+  std::vector<GraphId> local_tiles(local_tileset.begin(), local_tileset.end());
+
+  // Find the levels of the nodes in all tiles in the local level
+  size_t next_tile = 0;
+  std::mutex lock;
+  std::vector<std::promise<std::vector<NodeLevels>>> results(local_tiles.size());
+  std::vector<std::shared_ptr<std::thread>> threads(thread_count);
+  for (auto& thread : threads) {
+    thread.reset(new std::thread(FindNodeLevels, std::cref(pt.get_child("mjolnir")),
+                                 std::cref(local_tiles), std::ref(next_tile), std::ref(lock),
+                                 std::ref(results)));
+  }
 
-    // Iterate through the nodes. Add nodes to the new level when
-    // best road class <= the new level classification cutoff
-    bool levels[3];
-    uint32_t nodecount = tile->header()->nodecount();
-    GraphId basenode = base_tile_id;
-    GraphId edgeid = base_tile_id;
-    PointLL base_ll = tile->header()->base_ll();
-    const NodeInfo* nodeinfo = tile->node(basenode);
-    for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
-      // Iterate through the edges to see which levels this node exists.
-      levels[0] = levels[1] = levels[2] = false;
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
-        // Update the flag for the level of this edge (skip transit
-        // connection edges)
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        if (directededge->bss_connection()) {
-          // Despite the road class, Bike Share Stations' connections are always at local level
-          levels[2] = true;
-        } else if (directededge->use() != Use::kTransitConnection &&
-                   directededge->use() != Use::kEgressConnection &&
-                   directededge->use() != Use::kPlatformConnection) {
-          levels[TileHierarchy::get_level(directededge->classification())] = true;
+  // Associate new nodes to base nodes and base node to new nodes as the
+  // tiles are done, in order
+  std::exception_ptr failure;
+  try {
+    for (size_t t = 0; t < local_tiles.size(); ++t) {
+      GraphId basenode = local_tiles[t];
+      for (const auto& node : results[t].get_future().get()) {
+        GraphId highway_node, arterial_node, local_node;
+        if (node.highway_tile.Is_Valid()) {
+          // New node is on the highway level. Associate back to base/local node
+          highway_node = get_new_node(node.highway_tile);
+          new_to_old.push_back(std::make_pair(highway_node, basenode));
+        }
+        if (node.arterial_tile.Is_Valid()) {
+          // New node is on the arterial level. Associate back to base/local node
+          arterial_node = get_new_node(node.arterial_tile);
+          new_to_old.push_back(std::make_pair(arterial_node, basenode));
+        }
+        if (node.local) {
+          // New node is on the local level. Associate back to base/local node
+          local_node = get_new_node(local_tiles[t]);
+          new_to_old.push_back(std::make_pair(local_node, basenode));
         }
-      }
-
-      // Associate new nodes to base nodes and base node to new nodes
-      GraphId highway_node, arterial_node, local_node;
-      if (levels[0]) {
-        // New node is on the highway level. Associate back to base/local node
-        GraphId new_tile(highway_level.tiles.TileId(nodeinfo->latlng(base_ll)), hl, 0);
-        highway_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(highway_node, basenode));
-      }
-      if (levels[1]) {
-        // New node is on the arterial level. Associate back to base/local node
-        GraphId new_tile(arterial_level.tiles.TileId(nodeinfo->latlng(base_ll)), al, 0);
-        arterial_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(arterial_node, basenode));
-      }
-      if (levels[2]) {
-        // New node is on the local level. Associate back to base/local node
-        local_node = get_new_node(base_tile_id);
-        new_to_old.push_back(std::make_pair(local_node, basenode));
-      }
 
-      if (!levels[0] && !levels[1] && !levels[2]) {
-        LOG_ERROR("No valid level for this node!");
+        // Associate the old node to the new node(s). Entries in the tuple
+        // that are invalid nodes indicate no node exists in the new level.
+        OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, node.density);
+        old_to_new.push_back(assoc);
+        ++basenode;
       }
-
-      // Associate the old node to the new node(s). Entries in the tuple
-      // that are invalid nodes indicate no node exists in the new level.
-      OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, nodeinfo->density());
-      old_to_new.push_back(assoc);
     }
+  } catch (...) {
+    failure = std::current_exception();
+  }
 
-    // Check if we need to clear the tile cache
-    if (reader.OverCommitted()) {
-      reader.Trim();
-    }
+  // Wait for the threads, and if something bad went down rethrow it
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  if (failure) {
+    std::rethrow_exception(failure);
   }
 }
 
@@ -587,22 +752,22 @@ void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
                              const std::string& new_to_old_file,
                              const std::string& old_to_new_file) {
 
-  // TODO: thread this. Might be more possible now that we don't create
-  // shortcuts in the HierarchyBuilder
-
   // Construct GraphReader
   LOG_INFO("HierarchyBuilder");
   GraphReader reader(pt.get_child("mjolnir"));
+  size_t thread_count =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
 
   // Association of old nodes to new nodes
-  CreateNodeAssociations(reader, new_to_old_file, old_to_new_file);
+  CreateNodeAssociations(pt, new_to_old_file, old_to_new_file, thread_count);
 
   // Sort the sequences
   SortSequences(new_to_old_file, old_to_new_file);
 
   // Iterate through the hierarchy (from highway down to local) and build
   // new tiles
-  FormTilesInNewLevel(reader, new_to_old_file, old_to_new_file);
+  FormTilesInNewLevels(pt, new_to_old_file, old_to_new_file, thread_count);
 
   // Remove any base tiles that no longer have any data (nodes and edges
   // only exist on arterial and highway levels)
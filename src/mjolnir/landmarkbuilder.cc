@@ -0,0 +1,334 @@
+#include "mjolnir/landmarkbuilder.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "baldr/graphconstants.h"
+#include "baldr/graphid.h"
+#include "baldr/graphreader.h"
+#include "baldr/landmarks.h"
+#include "baldr/tilehierarchy.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// Default number of landmarks per table
+constexpr uint32_t kDefaultLandmarkCount = 16;
+
+// Number of random nodes the landmark selection is started from. The one reaching the most nodes
+// is used so the landmarks end up in the largest connected part of the graph
+constexpr uint32_t kSeedCount = 4;
+constexpr uint32_t kSeedTries = 1000;
+
+constexpr uint32_t kNoRow = LandmarkTable::kUnreached;
+
+// The graph flattened into arrays so the many searches over all of it don't go through the
+// graph reader. Nodes are numbered tile by tile in the order of the landmark table rows, the
+// arcs of each node are contiguous. Shortcuts are left out, they only repeat the edges they
+// cover, and moving between hierarchy levels is free.
+struct Graph {
+  std::vector<LandmarkTile> tiles;
+  std::unordered_map<uint32_t, uint32_t> first_rows;
+  std::vector<uint64_t> offsets; // first arc of each node and one past the last arc
+  std::vector<uint32_t> targets;
+  std::vector<uint32_t> lengths;
+  std::vector<uint16_t> access;
+
+  uint32_t node_count() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+
+  uint32_t row(const GraphId& node) const {
+    auto first = first_rows.find(node.tile_value());
+    return first == first_rows.cend() ? kNoRow : first->second + node.id();
+  }
+
+  GraphId node(const uint32_t row) const {
+    auto tile = std::upper_bound(tiles.cbegin(), tiles.cend(), row,
+                                 [](const uint32_t row, const LandmarkTile& tile) {
+                                   return row < tile.first_row;
+                                 }) -
+                1;
+    return GraphId(tile->tile + (static_cast<uint64_t>(row - tile->first_row) << 25));
+  }
+
+  // the same graph with all the arcs turned around
+  Graph transpose() const {
+    Graph reversed;
+    reversed.offsets.assign(offsets.size(), 0);
+    for (auto target : targets) {
+      ++reversed.offsets[target + 1];
+    }
+    for (size_t i = 1; i < reversed.offsets.size(); ++i) {
+      reversed.offsets[i] += reversed.offsets[i - 1];
+    }
+    reversed.targets.resize(targets.size());
+    reversed.lengths.resize(lengths.size());
+    reversed.access.resize(access.size());
+    auto next = reversed.offsets;
+    for (uint32_t from = 0; from < node_count(); ++from) {
+      for (uint64_t arc = offsets[from]; arc < offsets[from + 1]; ++arc) {
+        auto reversed_arc = next[targets[arc]]++;
+        reversed.targets[reversed_arc] = from;
+        reversed.lengths[reversed_arc] = lengths[arc];
+        reversed.access[reversed_arc] = access[arc];
+      }
+    }
+    return reversed;
+  }
+};
+
+Graph BuildGraph(GraphReader& reader) {
+  // number the nodes of the road network, transit has its own hierarchy level we skip
+  auto max_level = TileHierarchy::levels().rbegin()->first;
+  std::vector<GraphId> tile_ids;
+  for (const auto& id : reader.GetTileSet()) {
+    if (id.level() <= max_level) {
+      tile_ids.push_back(id);
+    }
+  }
+  std::sort(tile_ids.begin(), tile_ids.end());
+
+  Graph graph;
+  uint64_t rows = 0;
+  for (const auto& id : tile_ids) {
+    const GraphTile* tile = reader.GetGraphTile(id);
+    uint32_t count = tile->header()->nodecount();
+    graph.tiles.push_back({id.tile_value(), rows, count, 0});
+    graph.first_rows.emplace(id.tile_value(), rows);
+    rows += count;
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  if (rows >= kNoRow) {
+    throw std::runtime_error("Too many nodes for landmark tables: " + std::to_string(rows));
+  }
+
+  // add the arcs
+  graph.offsets.reserve(rows + 1);
+  for (const auto& t : graph.tiles) {
+    const GraphTile* tile = reader.GetGraphTile(GraphId(t.tile));
+    for (uint32_t n = 0; n < t.node_count; ++n) {
+      graph.offsets.push_back(graph.targets.size());
+      const NodeInfo* node = tile->node(n);
+      const DirectedEdge* edge = tile->directededge(node->edge_index());
+      for (uint32_t i = 0; i < node->edge_count(); ++i, ++edge) {
+        uint32_t row = graph.row(edge->endnode());
+        if (edge->is_shortcut() || !edge->forwardaccess() || row == kNoRow) {
+          continue;
+        }
+        graph.targets.push_back(row);
+        graph.lengths.push_back(edge->length());
+        graph.access.push_back(edge->forwardaccess());
+      }
+      for (const auto& transition : tile->GetNodeTransitions(node)) {
+        uint32_t row = graph.row(transition.endnode());
+        if (row != kNoRow) {
+          graph.targets.push_back(row);
+          graph.lengths.push_back(0);
+          graph.access.push_back(kAllAccess);
+        }
+      }
+    }
+    if (reader.OverCommitted()) {
+      reader.Trim();
+    }
+  }
+  graph.offsets.push_back(graph.targets.size());
+  return graph;
+}
+
+// Network distances from the sources to every node over the arcs the access mode may use
+void Distances(const Graph& graph,
+               const std::vector<uint32_t>& sources,
+               const uint32_t access,
+               std::vector<uint32_t>& distances) {
+  using entry_t = std::pair<uint32_t, uint32_t>; // distance, node
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+  distances.assign(graph.node_count(), LandmarkTable::kUnreached);
+  for (auto source : sources) {
+    distances[source] = 0;
+    queue.emplace(0, source);
+  }
+  while (!queue.empty()) {
+    auto current = queue.top();
+    queue.pop();
+    if (current.first > distances[current.second]) {
+      continue;
+    }
+    for (uint64_t arc = graph.offsets[current.second]; arc < graph.offsets[current.second + 1];
+         ++arc) {
+      if (!(graph.access[arc] & access)) {
+        continue;
+      }
+      uint32_t distance = current.first + graph.lengths[arc];
+      if (distance < distances[graph.targets[arc]]) {
+        distances[graph.targets[arc]] = distance;
+        queue.emplace(distance, graph.targets[arc]);
+      }
+    }
+  }
+}
+
+// Farthest first selection: each landmark is the node farthest from the ones picked before it,
+// which spreads them around the edges of the graph where they give the best bounds
+std::vector<uint32_t>
+SelectLandmarks(const Graph& graph, const uint32_t access, const uint32_t count) {
+  std::mt19937 gen(access);
+  std::uniform_int_distribution<uint32_t> pick(0, graph.node_count() - 1);
+  auto usable = [&graph, access](const uint32_t node) {
+    for (uint64_t arc = graph.offsets[node]; arc < graph.offsets[node + 1]; ++arc) {
+      if (graph.access[arc] & access) {
+        return true;
+      }
+    }
+    return false;
+  };
+  std::vector<uint32_t> distances, best;
+  size_t most = 0;
+  for (uint32_t i = 0; i < kSeedCount; ++i) {
+    // most random nodes are unusable for the rarer access modes, try a few more
+    uint32_t seed = pick(gen);
+    for (uint32_t tries = 0; tries < kSeedTries && !usable(seed); ++tries) {
+      seed = pick(gen);
+    }
+    Distances(graph, {seed}, access, distances);
+    size_t reached = std::count_if(distances.cbegin(), distances.cend(), [](const uint32_t d) {
+      return d != LandmarkTable::kUnreached;
+    });
+    if (reached > most) {
+      most = reached;
+      best.swap(distances);
+    }
+  }
+
+  std::vector<uint32_t> landmarks;
+  while (most > 1 && landmarks.size() < count) {
+    uint32_t farthest = kNoRow;
+    for (uint32_t i = 0; i < best.size(); ++i) {
+      if (best[i] != LandmarkTable::kUnreached &&
+          (farthest == kNoRow || best[i] > best[farthest])) {
+        farthest = i;
+      }
+    }
+    // every node reached is a landmark already
+    if (farthest == kNoRow || best[farthest] == 0) {
+      break;
+    }
+    landmarks.push_back(farthest);
+    Distances(graph, landmarks, access, best);
+  }
+  return landmarks;
+}
+
+void BuildTable(const Graph& graph,
+                const Graph& reversed,
+                const std::string& file_name,
+                const uint32_t access,
+                const uint32_t count,
+                const uint32_t nthreads) {
+  auto landmarks = SelectLandmarks(graph, access, count);
+  if (landmarks.empty()) {
+    LOG_WARN("LandmarkBuilder: no landmarks found for " + file_name + ", skipping");
+    return;
+  }
+
+  // a search from and to each landmark fills in a column of the rows
+  const size_t width = 2 * landmarks.size();
+  std::vector<uint32_t> rows(graph.node_count() * width);
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    std::vector<uint32_t> distances;
+    for (size_t column = next++; column < width; column = next++) {
+      bool from = column < landmarks.size();
+      uint32_t landmark = landmarks[column % landmarks.size()];
+      Distances(from ? graph : reversed, {landmark}, access, distances);
+      for (size_t i = 0; i < distances.size(); ++i) {
+        rows[i * width + column] = distances[i];
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < nthreads; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<GraphId> ids;
+  for (auto landmark : landmarks) {
+    ids.push_back(graph.node(landmark));
+  }
+  LandmarkTable::Write(file_name, access, ids, graph.tiles, rows);
+  LOG_INFO("LandmarkBuilder: wrote " + file_name + " with " + std::to_string(ids.size()) +
+           " landmarks");
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void LandmarkBuilder::Build(const boost::property_tree::ptree& pt) {
+  // which costings to build tables for, none unless asked for
+  std::vector<std::pair<std::string, uint32_t>> costings;
+  auto configured = pt.get_child_optional("mjolnir.landmarks.costings");
+  if (configured) {
+    for (const auto& kv : *configured) {
+      auto name = kv.second.get_value<std::string>();
+      auto costing = std::find_if(kLandmarkCostings.cbegin(), kLandmarkCostings.cend(),
+                                  [&name](const std::pair<std::string, uint32_t>& costing) {
+                                    return costing.first == name;
+                                  });
+      if (costing == kLandmarkCostings.cend()) {
+        LOG_WARN("LandmarkBuilder: no landmark tables for costing " + name);
+      } else {
+        costings.push_back(*costing);
+      }
+    }
+  }
+  if (costings.empty()) {
+    LOG_INFO("LandmarkBuilder: no costings configured, skipping");
+    return;
+  }
+
+  auto count = pt.get<uint32_t>("mjolnir.landmarks.count", kDefaultLandmarkCount);
+  auto dir = pt.get<std::string>("mjolnir.landmarks.dir",
+                                 pt.get<std::string>("mjolnir.tile_dir") + "/landmarks");
+  boost::filesystem::create_directories(dir);
+  uint32_t nthreads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+
+  GraphReader reader(pt.get_child("mjolnir"));
+  Graph graph = BuildGraph(reader);
+  Graph reversed = graph.transpose();
+  LOG_INFO("LandmarkBuilder: " + std::to_string(graph.node_count()) + " nodes and " +
+           std::to_string(graph.targets.size()) + " arcs");
+  if (graph.node_count() == 0) {
+    return;
+  }
+
+  for (const auto& costing : costings) {
+    BuildTable(graph, reversed, dir + "/" + costing.first + ".landmarks", costing.second, count,
+               nthreads);
+  }
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -27,7 +27,16 @@
 
 // This is largely based off of: https://github.com/CanalTP/libosmpbfreader
 // there have been some minor changes for our own purposes but its largely the same
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 #ifdef _MSC_VER
 #include <winsock2.h> // ntohl
 #else
@@ -81,9 +90,8 @@ BlobHeader read_header(char* buffer, std::ifstream& file, bool& finished) {
   return result;
 }
 
-int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
-  Blob blob;
-
+// read the bytes of the blob that goes with the blob header
+void read_blob(std::vector<char>& buffer, std::ifstream& file, const BlobHeader& header) {
   // is the size of the following blob sane
   int32_t sz = header.datasize();
   if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
@@ -91,31 +99,43 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   }
 
   // pull out the bytes
-  if (!file.read(buffer, sz)) {
+  buffer.resize(sz);
+  if (!file.read(buffer.data(), sz)) {
     throw std::runtime_error("unable to read blob from file");
   }
+}
 
+// unpack the bytes of a blob, returns the size of the unpacked data
+int32_t unpack_blob(const std::vector<char>& buffer, std::vector<char>& unpack_buffer) {
   // turn it into a protobuf object
-  if (!blob.ParseFromArray(buffer, sz)) {
+  Blob blob;
+  if (!blob.ParseFromArray(buffer.data(), buffer.size())) {
     throw std::runtime_error("unable to parse blob");
   }
 
   // if the blob was uncompressed
   if (blob.has_raw()) {
     // check that raw_size is set correctly and move it to the final buffer
-    sz = blob.raw().size();
+    int32_t sz = blob.raw().size();
     if (sz != blob.raw_size()) {
       LOG_WARN("blob reports wrong raw_size: " + std::to_string(blob.raw_size()) + " bytes");
     }
-    memcpy(unpack_buffer, buffer, sz);
+    if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
+      throw std::runtime_error("raw blob-size is bigger than allowed");
+    }
+    unpack_buffer.resize(sz);
+    memcpy(unpack_buffer.data(), blob.raw().data(), sz);
     return sz;
   } // if the blob was zlib compressed
   else if (blob.has_zlib_data()) {
-    sz = blob.zlib_data().size();
+    if (blob.raw_size() > MAX_UNCOMPRESSED_BLOB_SIZE) {
+      throw std::runtime_error("raw blob-size is bigger than allowed");
+    }
+    unpack_buffer.resize(blob.raw_size());
     z_stream z;
     z.next_in = (unsigned char*)blob.zlib_data().c_str();
-    z.avail_in = sz;
-    z.next_out = (unsigned char*)unpack_buffer;
+    z.avail_in = blob.zlib_data().size();
+    z.next_out = (unsigned char*)unpack_buffer.data();
     z.avail_out = blob.raw_size();
     z.zalloc = Z_NULL;
     z.zfree = Z_NULL;
@@ -272,6 +292,184 @@ void parse_header_block(char* unpack_buffer, int32_t sz) {
   // TODO: do something with replication information?
 }
 
+// records the callbacks of a primitive block so they can be replayed later on another thread
+struct recorded_block_t : public Callback {
+  enum kind_t : uint8_t { NODE, WAY, RELATION, CHANGESET };
+  struct node_t {
+    uint64_t osmid;
+    double lng;
+    double lat;
+    Tags tags;
+  };
+  struct way_t {
+    uint64_t osmid;
+    Tags tags;
+    std::vector<uint64_t> nodes;
+  };
+  struct relation_t {
+    uint64_t osmid;
+    Tags tags;
+    std::vector<Member> members;
+  };
+
+  void node_callback(const uint64_t osmid, const double lng, const double lat, const Tags& tags)
+      override {
+    order.push_back(NODE);
+    nodes.push_back({osmid, lng, lat, tags});
+  }
+  void way_callback(const uint64_t osmid, const Tags& tags, const std::vector<uint64_t>& nodes)
+      override {
+    order.push_back(WAY);
+    ways.push_back({osmid, tags, nodes});
+  }
+  void relation_callback(const uint64_t osmid, const Tags& tags, const std::vector<Member>& members)
+      override {
+    order.push_back(RELATION);
+    relations.push_back({osmid, tags, {}});
+    auto& copy = relations.back().members;
+    copy.reserve(members.size());
+    for (const auto& member : members) {
+      copy.emplace_back(member.member_type, member.member_id, member.role);
+    }
+  }
+  void changeset_callback(const uint64_t changeset_id) override {
+    order.push_back(CHANGESET);
+    changesets.push_back(changeset_id);
+  }
+
+  // calls back in the order the callbacks were recorded
+  void replay(Callback& callback) const {
+    size_t node = 0, way = 0, relation = 0, changeset = 0;
+    for (auto kind : order) {
+      switch (kind) {
+        case NODE:
+          callback.node_callback(nodes[node].osmid, nodes[node].lng, nodes[node].lat,
+                                 nodes[node].tags);
+          ++node;
+          break;
+        case WAY:
+          callback.way_callback(ways[way].osmid, ways[way].tags, ways[way].nodes);
+          ++way;
+          break;
+        case RELATION:
+          callback.relation_callback(relations[relation].osmid, relations[relation].tags,
+                                     relations[relation].members);
+          ++relation;
+          break;
+        case CHANGESET:
+          callback.changeset_callback(changesets[changeset++]);
+          break;
+      }
+    }
+  }
+
+  std::vector<kind_t> order;
+  std::vector<node_t> nodes;
+  std::vector<way_t> ways;
+  std::vector<relation_t> relations;
+  std::vector<uint64_t> changesets;
+};
+
+// unpacks and decodes blobs on a pool of threads
+class decoder_pool_t {
+public:
+  decoder_pool_t(const unsigned int threads) : done(false) {
+    for (unsigned int i = 0; i < threads; ++i) {
+      workers.emplace_back(&decoder_pool_t::work, this);
+    }
+  }
+
+  ~decoder_pool_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+    }
+    signal.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  // queue up the decoding of a data blob, the result holds its callbacks
+  std::future<recorded_block_t> decode(std::vector<char>&& buffer, const Interest interest) {
+    auto blob = std::make_shared<std::vector<char>>(std::move(buffer));
+    std::packaged_task<recorded_block_t()> task([blob, interest]() {
+      std::vector<char> unpack_buffer;
+      int32_t sz = unpack_blob(*blob, unpack_buffer);
+      blob->clear();
+      recorded_block_t block;
+      parse_primitive_block(unpack_buffer.data(), sz, interest, block);
+      return block;
+    });
+    auto result = task.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.emplace_back(std::move(task));
+    }
+    signal.notify_one();
+    return result;
+  }
+
+private:
+  void work() {
+    while (true) {
+      std::packaged_task<recorded_block_t()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        signal.wait(lock, [this]() { return done || !tasks.empty(); });
+        if (done) {
+          return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      // exceptions end up in the future
+      task();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable signal;
+  std::deque<std::packaged_task<recorded_block_t()>> tasks;
+  bool done;
+  std::vector<std::thread> workers;
+};
+
+// logs how far along a pass over the file is
+class progress_t {
+public:
+  progress_t(std::ifstream& file) : start(std::chrono::steady_clock::now()), next_report(25) {
+    file.seekg(0, std::ios::end);
+    size = file.tellg();
+    file.seekg(0, std::ios::beg);
+  }
+
+  void update(std::ifstream& file) {
+    // once the file is read tellg fails
+    auto position = file.tellg();
+    if (size > 0 && position > 0 && position * 100 / size >= next_report) {
+      LOG_INFO(std::to_string(next_report) + "% of the file parsed at " + rate(position));
+      next_report += 25;
+    }
+  }
+
+  void finish() const {
+    LOG_INFO("Parsed " + std::to_string(size >> 20) + " MB at " + rate(size));
+  }
+
+private:
+  std::string rate(const std::streamoff bytes) const {
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return std::to_string(static_cast<uint64_t>(bytes / std::max(seconds, 1e-3) / (1 << 20))) +
+           " MB/s";
+  }
+
+  std::chrono::steady_clock::time_point start;
+  std::streamoff size;
+  std::streamoff next_report;
+};
+
 } // namespace
 
 // extend the protobuf osmpbf namespace
@@ -285,38 +483,62 @@ Member::Member(Member&& other)
     : member_type(other.member_type), member_id(other.member_id), role(std::move(other.role)) {
 }
 
-void Parser::parse(std::ifstream& file, const Interest interest, Callback& callback) {
-  char* buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
-  char* unpack_buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
+void Parser::parse(std::ifstream& file,
+                   const Interest interest,
+                   Callback& callback,
+                   const unsigned int threads) {
+  std::vector<char> header_buffer(MAX_BLOB_HEADER_SIZE);
+  std::vector<char> buffer;
+  std::vector<char> unpack_buffer;
 
   // start from the top
   file.clear();
-  file.seekg(0, std::ios::beg);
+  progress_t progress(file);
+
+  // blocks being decoded on other threads in file order, we only allow so many at once
+  std::unique_ptr<decoder_pool_t> pool(threads > 1 ? new decoder_pool_t(threads) : nullptr);
+  std::deque<std::future<recorded_block_t>> decoding;
+  const size_t max_decoding = threads * 4;
 
   // while there is more to read
   while (!file.eof()) {
     // grab the blob header
     bool finished = false;
-    BlobHeader header = read_header(buffer, file, finished);
+    BlobHeader header = read_header(header_buffer.data(), file, finished);
     // if we didnt hit the end
     if (!finished) {
       // grab the blob that goes with the blob header
-      int32_t sz = read_blob(buffer, unpack_buffer, file, header);
+      read_blob(buffer, file, header);
       // if its data parse it
       if (header.type() == "OSMData") {
-        parse_primitive_block(unpack_buffer, sz, interest, callback);
+        if (pool) {
+          // hand it off and call back for the oldest blocks, keeping the order
+          decoding.emplace_back(pool->decode(std::move(buffer), interest));
+          buffer = std::vector<char>();
+          while (decoding.size() >= max_decoding) {
+            decoding.front().get().replay(callback);
+            decoding.pop_front();
+          }
+        } else {
+          int32_t sz = unpack_blob(buffer, unpack_buffer);
+          parse_primitive_block(unpack_buffer.data(), sz, interest, callback);
+        }
         // if its something other than a header
       } else if (header.type() == "OSMHeader") {
-        parse_header_block(unpack_buffer, sz);
+        int32_t sz = unpack_blob(buffer, unpack_buffer);
+        parse_header_block(unpack_buffer.data(), sz);
       } else {
         LOG_WARN("Unknown blob type: " + header.type());
       }
+      progress.update(file);
     }
   }
 
-  // done with protobuf and buffers
-  delete[] buffer;
-  delete[] unpack_buffer;
+  // call back for whatever is left
+  for (auto& block : decoding) {
+    block.get().replay(callback);
+  }
+  progress.finish();
 }
 
 void Parser::free() {
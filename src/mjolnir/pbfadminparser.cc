@@ -146,6 +146,11 @@ namespace mjolnir {
 
 OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
                                    const std::vector<std::string>& input_files) {
+  // Threads to unpack and decode the blobs of the pbf with
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+
   // Create OSM data. Set the member pointer so that the parsing callback
   // methods can use it.
   OSMAdminData osmdata{};
@@ -169,7 +174,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.admins_.size()) +
            " admin polygons comprised of " + std::to_string(osmdata.osm_way_count) + " ways");
@@ -180,7 +185,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.way_map.size()) + " ways comprised of " +
            std::to_string(osmdata.node_count) + " nodes");
@@ -192,7 +197,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_node_count) + " nodes");
 
@@ -4,12 +4,18 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -18,6 +24,7 @@
 #include "baldr/graphreader.h"
 #include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -551,157 +558,193 @@ uint32_t AddShortcutEdges(GraphReader& reader,
   return shortcut_count;
 }
 
-// Form shortcuts for tiles in this level.
-uint32_t FormShortcuts(GraphReader& reader, const TileLevel& level) {
-  // Iterate through the tiles at this level (TODO - can we mark the tiles
-  // the tiles that shortcuts end within?)
-  reader.Clear();
+// Form shortcuts for a tile. The new tile is written to the staging directory
+// so that other threads still read the original tile while it is being worked.
+uint32_t FormShortcuts(GraphReader& reader,
+                       const GraphId& tile_id,
+                       const std::string& staging_dir) {
+  // Get the graph tile. Skip if no tile exists (common case)
   bool added = false;
   uint32_t shortcut_count = 0;
-  uint32_t ntiles = level.tiles.TileCount();
-  uint32_t tile_level = (uint32_t)level.level;
-  const GraphTile* tile = nullptr;
-  for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
-    // Get the graph tile. Skip if no tile exists (common case)
-    tile = reader.GetGraphTile(GraphId(tileid, tile_level, 0));
-    if (tile == nullptr || tile->header()->nodecount() == 0) {
-      continue;
+  uint32_t tileid = tile_id.tileid();
+  uint32_t tile_level = tile_id.level();
+  const GraphTile* tile = reader.GetGraphTile(tile_id);
+  if (tile == nullptr || tile->header()->nodecount() == 0) {
+    return shortcut_count;
+  }
+
+  // Create GraphTileBuilder for the new tile. Copy the header of the old
+  // tile as it would be read from the tile directory
+  GraphId new_tile(tileid, tile_level, 0);
+  GraphTileBuilder tilebuilder(staging_dir, new_tile, false);
+  tilebuilder.header_builder() = *tile->header();
+  tilebuilder.header_builder().set_graphid(new_tile);
+
+  // Since the old tile is not serialized we must copy any data that is not
+  // dependent on edge Id into the new builders (e.g., node transitions)
+  if (tile->header()->transitioncount() > 0) {
+    for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
+      tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
     }
+  }
 
-    // Create GraphTileBuilder for the new tile
-    GraphId new_tile(tileid, tile_level, 0);
-    GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
+  // Iterate through the nodes in the tile
+  GraphId node_id(tileid, tile_level, 0);
+  for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
+    // Get the node info, copy node index and count from old tile
+    NodeInfo nodeinfo = *(tile->node(node_id));
+    uint32_t old_edge_index = nodeinfo.edge_index();
+    uint32_t old_edge_count = nodeinfo.edge_count();
+
+    // Update node information
+    const auto& admin = tile->admininfo(nodeinfo.admin_index());
+    nodeinfo.set_edge_index(tilebuilder.directededges().size());
+    nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                  admin.country_iso(), admin.state_iso()));
+
+    // Current edge count
+    size_t edge_count = tilebuilder.directededges().size();
+
+    // Add shortcut edges first.
+    std::unordered_map<uint32_t, uint32_t> shortcuts;
+    shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
+                                       old_edge_count, shortcuts);
+
+    // Copy the rest of the directed edges from this node
+    GraphId edgeid(tileid, tile_level, old_edge_index);
+    for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
+      // Copy the directed edge information and update end node,
+      // edge data offset, and opp_index
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      DirectedEdge newedge = *directededge;
 
-    // Since the old tile is not serialized we must copy any data that is not
-    // dependent on edge Id into the new builders (e.g., node transitions)
-    if (tile->header()->transitioncount() > 0) {
-      for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
-        tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
+      // Get signs from the base directed edge
+      if (directededge->sign()) {
+        std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+        if (signs.size() == 0) {
+          LOG_ERROR("Base edge should have signs, but none found");
+        }
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
       }
-    }
 
-    // Iterate through the nodes in the tile
-    GraphId node_id(tileid, tile_level, 0);
-    for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
-      // Get the node info, copy node index and count from old tile
-      NodeInfo nodeinfo = *(tile->node(node_id));
-      uint32_t old_edge_index = nodeinfo.edge_index();
-      uint32_t old_edge_count = nodeinfo.edge_count();
-
-      // Update node information
-      const auto& admin = tile->admininfo(nodeinfo.admin_index());
-      nodeinfo.set_edge_index(tilebuilder.directededges().size());
-      nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                    admin.country_iso(), admin.state_iso()));
-
-      // Current edge count
-      size_t edge_count = tilebuilder.directededges().size();
-
-      // Add shortcut edges first.
-      std::unordered_map<uint32_t, uint32_t> shortcuts;
-      shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
-                                         old_edge_count, shortcuts);
-
-      // Copy the rest of the directed edges from this node
-      GraphId edgeid(tileid, tile_level, old_edge_index);
-      for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
-        // Copy the directed edge information and update end node,
-        // edge data offset, and opp_index
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        DirectedEdge newedge = *directededge;
-
-        // Get signs from the base directed edge
-        if (directededge->sign()) {
-          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-          if (signs.size() == 0) {
-            LOG_ERROR("Base edge should have signs, but none found");
-          }
-          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
-        }
+      // Get turn lanes from the base directed edge
+      if (directededge->turnlanes()) {
+        uint32_t offset = tile->turnlanes_offset(edgeid.id());
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      }
 
-        // Get turn lanes from the base directed edge
-        if (directededge->turnlanes()) {
-          uint32_t offset = tile->turnlanes_offset(edgeid.id());
-          tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      // Get access restrictions from the base directed edge. Add these to
+      // the list of access restrictions in the new tile. Update the
+      // edge index in the restriction to be the current directed edge Id
+      if (directededge->access_restriction()) {
+        auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+        for (const auto& res : restrictions) {
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
+      }
 
-        // Get access restrictions from the base directed edge. Add these to
-        // the list of access restrictions in the new tile. Update the
-        // edge index in the restriction to be the current directed edge Id
-        if (directededge->access_restriction()) {
-          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-          for (const auto& res : restrictions) {
-            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                               res.type(), res.modes(), res.value()));
-          }
+      // Copy lane connectivity
+      if (directededge->laneconnectivity()) {
+        auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+        if (laneconnectivity.size() == 0) {
+          LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
-
-        // Copy lane connectivity
-        if (directededge->laneconnectivity()) {
-          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-          if (laneconnectivity.size() == 0) {
-            LOG_ERROR("Base edge should have lane connectivity, but none found");
-          }
-          for (auto& lc : laneconnectivity) {
-            lc.set_to(tilebuilder.directededges().size());
-          }
-          tilebuilder.AddLaneConnectivity(laneconnectivity);
+        for (auto& lc : laneconnectivity) {
+          lc.set_to(tilebuilder.directededges().size());
         }
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
+      }
 
-        // Get edge info, shape, and names from the old tile and add
-        // to the new. Use prior edgeinfo offset as the key to make sure
-        // edges that have the same end nodes are differentiated (this
-        // should be a valid key since tile sizes aren't changed)
-        auto edgeinfo = tile->edgeinfo(directededge->edgeinfo_offset());
-        uint32_t edge_info_offset =
-            tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
-                                    edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                    edgeinfo.bike_network(), edgeinfo.speed_limit(),
-                                    edgeinfo.encoded_shape(),
-                                    tile->GetNames(directededge->edgeinfo_offset()),
-                                    tile->GetTypes(directededge->edgeinfo_offset()), added);
-        newedge.set_edgeinfo_offset(edge_info_offset);
-
-        // Set the superseded mask - this is the shortcut mask that supersedes this edge
-        // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
-        // from a node has been exceeded.
-        auto s = shortcuts.find(i);
-        uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
-        if (superseded_idx <= kMaxShortcutsFromNode) {
-          newedge.set_superseded(superseded_idx);
-        }
+      // Get edge info, shape, and names from the old tile and add
+      // to the new. Use prior edgeinfo offset as the key to make sure
+      // edges that have the same end nodes are differentiated (this
+      // should be a valid key since tile sizes aren't changed)
+      auto edgeinfo = tile->edgeinfo(directededge->edgeinfo_offset());
+      uint32_t edge_info_offset =
+          tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
+                                  edgeinfo.wayid(), edgeinfo.mean_elevation(),
+                                  edgeinfo.bike_network(), edgeinfo.speed_limit(),
+                                  edgeinfo.encoded_shape(),
+                                  tile->GetNames(directededge->edgeinfo_offset()),
+                                  tile->GetTypes(directededge->edgeinfo_offset()), added);
+      newedge.set_edgeinfo_offset(edge_info_offset);
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
+      // Set the superseded mask - this is the shortcut mask that supersedes this edge
+      // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
+      // from a node has been exceeded.
+      auto s = shortcuts.find(i);
+      uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
+      if (superseded_idx <= kMaxShortcutsFromNode) {
+        newedge.set_superseded(superseded_idx);
       }
 
-      // Set the edge count for the new node
-      nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
+      // Add directed edge
+      tilebuilder.directededges().emplace_back(std::move(newedge));
+    }
+
+    // Set the edge count for the new node
+    nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
-      // Get named signs from the base node
-      if (nodeinfo.named_intersection()) {
+    // Get named signs from the base node
+    if (nodeinfo.named_intersection()) {
 
-        std::vector<SignInfo> signs = tile->GetSigns(n, true);
-        if (signs.size() == 0) {
-          LOG_ERROR("Base node should have signs, but none found");
-        }
-        tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
+      std::vector<SignInfo> signs = tile->GetSigns(n, true);
+      if (signs.size() == 0) {
+        LOG_ERROR("Base node should have signs, but none found");
       }
-      tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+      tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
     }
+    tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+  }
 
-    // Store the new tile
-    tilebuilder.StoreTileData();
-    LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
-               tilebuilder.header_builder().end_offset())
-                  .str());
+  // Store the new tile
+  tilebuilder.StoreTileData();
+  LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % new_tile %
+             tilebuilder.header_builder().end_offset())
+                .str());
+  return shortcut_count;
+}
+
+/**
+ * Forms shortcuts for a set of tiles on one level. Each thread pulls a tile
+ * off of the queue.
+ */
+void FormShortcutsInTiles(const boost::property_tree::ptree& pt,
+                          std::deque<GraphId>& tilequeue,
+                          std::mutex& lock,
+                          const std::string& staging_dir,
+                          std::promise<uint32_t>& result) {
+  // Local Graphreader
+  GraphReader reader(pt);
+
+  uint32_t shortcut_count = 0;
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    // Get the next tile Id
+    GraphId tile_id = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    try {
+      shortcut_count += FormShortcuts(reader, tile_id, staging_dir);
+    } // Send any failure back to the main thread
+    catch (std::exception& e) {
+      result.set_exception(std::current_exception());
+      LOG_ERROR((boost::format("Failed tile %1%: %2%") % tile_id % e.what()).str());
+      return;
+    }
 
     // Check if we need to clear the tile cache.
     if (reader.OverCommitted()) {
       reader.Trim();
     }
   }
-  return shortcut_count;
+  result.set_value(shortcut_count);
 }
 
 } // namespace
@@ -713,21 +756,64 @@ namespace mjolnir {
 // only connect to 2 edges on the hierarchy level, and have compatible
 // attributes. Shortcut edges are inserted before regular edges.
 void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
-
-  // TODO: thread this. would need to make sure we dont make shortcuts
-  // across tile boundaries so that we are only messing with one tile
-  // in one thread at a time
-
-  // Get GraphReader
+  // Shortcuts can cross tile boundaries so forming them reads the neighboring
+  // tiles. The tiles of a level are formed in parallel into a staging directory
+  // and only moved into place once the whole level is done. That way every
+  // tile is formed from the original tiles no matter which thread gets to it
+  // first, the output is the same for any number of threads.
   GraphReader reader(pt.get_child("mjolnir"));
+  std::string staging_dir =
+      reader.tile_dir() + filesystem::path::preferred_separator + "shortcuts_staging";
+
+  // A place to hold worker threads and their results
+  std::vector<std::shared_ptr<std::thread>> threads(
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency())));
 
   auto level = TileHierarchy::levels().rbegin();
   level++;
   for (; level != TileHierarchy::levels().rend(); ++level) {
-    // Create shortcuts on this level
+    // Queue the tiles on this level, in order so the tiles are moved in order
     auto tile_level = level->second;
-    LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level.level));
-    uint32_t count = FormShortcuts(reader, tile_level);
+    auto tileset = reader.GetTileSet(tile_level.level);
+    std::vector<GraphId> tiles(tileset.begin(), tileset.end());
+    std::sort(tiles.begin(), tiles.end());
+    std::deque<GraphId> tilequeue(tiles.begin(), tiles.end());
+    std::mutex lock;
+
+    // Clean up after any prior run that did not finish
+    boost::filesystem::remove_all(staging_dir);
+
+    // Create shortcuts on this level
+    LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level.level) + " with " +
+             std::to_string(threads.size()) + " threads");
+    std::list<std::promise<uint32_t>> results;
+    for (auto& thread : threads) {
+      results.emplace_back();
+      thread.reset(new std::thread(FormShortcutsInTiles, std::cref(pt.get_child("mjolnir")),
+                                   std::ref(tilequeue), std::ref(lock), std::cref(staging_dir),
+                                   std::ref(results.back())));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+
+    // If something bad went down this will rethrow it, the level is left as is
+    uint32_t count = 0;
+    for (auto& result : results) {
+      count += result.get_future().get();
+    }
+
+    // Move the new tiles into place
+    for (const auto& tile_id : tiles) {
+      auto suffix = GraphTile::FileSuffix(tile_id);
+      boost::filesystem::path staged(staging_dir + filesystem::path::preferred_separator + suffix);
+      if (boost::filesystem::exists(staged)) {
+        boost::filesystem::rename(staged, reader.tile_dir() +
+                                              filesystem::path::preferred_separator + suffix);
+      }
+    }
+    boost::filesystem::remove_all(staging_dir);
     LOG_INFO("Finished with " + std::to_string(count) + " shortcuts");
   }
 }
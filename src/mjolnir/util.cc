@@ -1,5 +1,6 @@
 #include "mjolnir/util.h"
 
+#include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/aabb2.h"
@@ -7,12 +8,14 @@
 #include "midgard/point2.h"
 #include "midgard/polyline2.h"
 #include "mjolnir/bssbuilder.h"
+#include "mjolnir/cchbuilder.h"
 #include "mjolnir/elevationbuilder.h"
 #include "mjolnir/graphbuilder.h"
 #include "mjolnir/graphenhancer.h"
 #include "mjolnir/graphfilter.h"
 #include "mjolnir/graphvalidator.h"
 #include "mjolnir/hierarchybuilder.h"
+#include "mjolnir/landmarkbuilder.h"
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfgraphparser.h"
 #include "mjolnir/restrictionbuilder.h"
@@ -24,6 +27,11 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+using namespace valhalla::baldr;
 using namespace valhalla::midgard;
 
 namespace {
@@ -130,6 +138,49 @@ bool shapes_match(const std::vector<PointLL>& shape1, const std::vector<PointLL>
   }
 }
 
+// Get a queue of tiles ordered by the size of their files, largest first.
+std::deque<GraphId> CostOrderedTileQueue(const std::string& tile_dir,
+                                         const std::unordered_set<GraphId>& tiles) {
+  std::vector<std::pair<uintmax_t, GraphId>> costs;
+  costs.reserve(tiles.size());
+  for (const auto& tile_id : tiles) {
+    // Tiles that are not on disk (e.g. in a tar extract) all cost the same
+    boost::system::error_code ec;
+    auto size = boost::filesystem::file_size(tile_dir + filesystem::path::preferred_separator +
+                                                 GraphTile::FileSuffix(tile_id),
+                                             ec);
+    costs.emplace_back(ec ? 0 : size, tile_id);
+  }
+  std::sort(costs.begin(), costs.end(),
+            [](const std::pair<uintmax_t, GraphId>& a, const std::pair<uintmax_t, GraphId>& b) {
+              return a.first == b.first ? a.second < b.second : a.first > b.first;
+            });
+
+  std::deque<GraphId> tilequeue;
+  for (const auto& cost : costs) {
+    tilequeue.push_back(cost.second);
+  }
+  return tilequeue;
+}
+
+WorkerTimer::WorkerTimer(const std::string& stage)
+    : stage_(stage), tiles_(0), cost_(0), start_(std::chrono::steady_clock::now()) {
+}
+
+WorkerTimer::~WorkerTimer() {
+  std::stringstream thread_id;
+  thread_id << std::this_thread::get_id();
+  auto secs =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  LOG_INFO(stage_ + " thread " + thread_id.str() + " finished " + std::to_string(tiles_) +
+           " tiles (cost " + std::to_string(cost_) + ") in " + std::to_string(secs) + " secs");
+}
+
+void WorkerTimer::AddTile(const size_t cost) {
+  tiles_++;
+  cost_ += cost;
+}
+
 bool build_tile_set(const boost::property_tree::ptree& config,
                     const std::vector<std::string>& input_files,
                     const BuildStage start_stage,
@@ -286,6 +337,16 @@ bool build_tile_set(const boost::property_tree::ptree& config,
     GraphValidator::Validate(config);
   }
 
+  // Build the landmark tables for the ALT heuristic (only if costings are configured)
+  if (start_stage <= BuildStage::kLandmarks && BuildStage::kLandmarks <= end_stage) {
+    LandmarkBuilder::Build(config);
+  }
+
+  // Build the contraction hierarchy overlay (only if enabled)
+  if (start_stage <= BuildStage::kCCH && BuildStage::kCCH <= end_stage) {
+    CCHBuilder::Build(config);
+  }
+
   // Cleanup bin files
   if (start_stage <= BuildStage::kCleanup && BuildStage::kCleanup <= end_stage) {
     LOG_INFO("Cleaning up temporary *.bin files within " + tile_dir);
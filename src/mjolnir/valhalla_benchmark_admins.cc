@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cinttypes>
 #include <cstdint>
 #include <future>
@@ -41,15 +42,18 @@
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
 #include "midgard/util.h"
+#include "mjolnir/admin.h"
 
 namespace bpo = boost::program_options;
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
 
 // Geometry types for admin queries
-typedef boost::geometry::model::d2::point_xy<double> point_type;
-typedef boost::geometry::model::polygon<point_type> polygon_type;
-typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+using valhalla::mjolnir::multi_polygon_type;
+using valhalla::mjolnir::MultiPolyIndex;
+
+// Points per side of the grid of lookups made in each tile
+constexpr uint32_t kLookupGridSize = 64;
 
 boost::filesystem::path config_file_path;
 
@@ -202,15 +206,54 @@ void Benchmark(const boost::property_tree::ptree& pt) {
   // Iterate through the tiles and perform enhancements
   std::unordered_map<uint32_t, multi_polygon_type> polys;
   std::unordered_map<uint32_t, bool> drive_on_right;
+  std::chrono::duration<double> scan_time(0), index_time(0);
+  uint64_t lookups = 0, mismatches = 0;
   for (uint32_t id = 0; id < tiles.TileCount(); id++) {
     // Get the admin polys if there is data for tiles that exist
     GraphId tile_id(id, local_level, 0);
     if (GraphReader::DoesTileExist(hierarchy_properties, tile_id)) {
-      polys = GetAdminInfo(db_handle, drive_on_right, tiles.TileBounds(id));
+      auto bounds = tiles.TileBounds(id);
+      polys = GetAdminInfo(db_handle, drive_on_right, bounds);
       LOG_INFO("polys: " + std::to_string(polys.size()));
       if (polys.size() < 128) {
         counts[polys.size()]++;
       }
+
+      // Look up a grid of points in the tile by scanning all of the polys and by the spatial
+      // index, the time to make the index counts against it
+      if (polys.size() < 2) {
+        continue;
+      }
+      std::unordered_multimap<uint32_t, multi_polygon_type> tile_polys(polys.begin(),
+                                                                       polys.end());
+      std::vector<PointLL> points;
+      points.reserve(kLookupGridSize * kLookupGridSize);
+      for (uint32_t y = 0; y < kLookupGridSize; ++y) {
+        for (uint32_t x = 0; x < kLookupGridSize; ++x) {
+          points.emplace_back(bounds.minx() + bounds.Width() * (x + 0.5f) / kLookupGridSize,
+                              bounds.miny() + bounds.Height() * (y + 0.5f) / kLookupGridSize);
+        }
+      }
+
+      std::vector<uint32_t> scanned, indexed;
+      scanned.reserve(points.size());
+      indexed.reserve(points.size());
+      auto start = std::chrono::steady_clock::now();
+      for (const auto& point : points) {
+        scanned.push_back(valhalla::mjolnir::GetMultiPolyId(tile_polys, point));
+      }
+      auto middle = std::chrono::steady_clock::now();
+      MultiPolyIndex index(tile_polys, bounds);
+      for (const auto& point : points) {
+        indexed.push_back(valhalla::mjolnir::GetMultiPolyId(index, point));
+      }
+      auto end = std::chrono::steady_clock::now();
+      scan_time += middle - start;
+      index_time += end - middle;
+      lookups += points.size();
+      for (size_t i = 0; i < points.size(); ++i) {
+        mismatches += scanned[i] != indexed[i];
+      }
     }
   }
   for (uint32_t i = 0; i < 128; i++) {
@@ -218,6 +261,15 @@ void Benchmark(const boost::property_tree::ptree& pt) {
       LOG_INFO("Tiles with " + std::to_string(i) + " admin polys: " + std::to_string(counts[i]));
     }
   }
+  if (lookups > 0) {
+    LOG_INFO(std::to_string(lookups) + " lookups in tiles with more than one admin poly");
+    LOG_INFO("Scanning the polys: " + std::to_string(scan_time.count()) + " secs");
+    LOG_INFO("Spatial index: " + std::to_string(index_time.count()) + " secs (" +
+             std::to_string(scan_time.count() / index_time.count()) + "x)");
+    if (mismatches > 0) {
+      LOG_WARN(std::to_string(mismatches) + " lookups found a different admin poly");
+    }
+  }
 }
 
 bool ParseArguments(int argc, char* argv[]) {
@@ -227,6 +279,7 @@ bool ParseArguments(int argc, char* argv[]) {
                                    " Usage: adminbenchmark [options] \n"
                                    "\n"
                                    "adminbenchmark is a program to time the admin queries "
+                                   "and the lookups of points in the admin polygons "
                                    "\n"
                                    "\n");
 
@@ -493,6 +493,7 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
                 std::vector<OneStopTest>& onestoptests,
                 bool tile_within_one_tz,
                 const std::unordered_multimap<uint32_t, multi_polygon_type>& tz_polys,
+                const MultiPolyIndex& tz_index_polys,
                 uint32_t& no_dir_edge_count) {
   auto t1 = std::chrono::high_resolution_clock::now();
 
@@ -574,8 +575,8 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
 
       if (timezone == 0) {
         // fallback to tz database.
-        timezone =
-            (tile_within_one_tz) ? tz_polys.begin()->first : GetMultiPolyId(tz_polys, station_ll);
+        timezone = (tile_within_one_tz) ? tz_polys.begin()->first
+                                        : GetMultiPolyId(tz_index_polys, station_ll);
 
         if (timezone == 0) {
           LOG_WARN("Timezone not found for station " + station.name());
@@ -620,8 +621,8 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
 
         if (timezone == 0) {
           // fallback to tz database.
-          timezone =
-              (tile_within_one_tz) ? tz_polys.begin()->first : GetMultiPolyId(tz_polys, egress_ll);
+          timezone = (tile_within_one_tz) ? tz_polys.begin()->first
+                                          : GetMultiPolyId(tz_index_polys, egress_ll);
           if (timezone == 0) {
             LOG_WARN("Timezone not found for egress " + egress.name());
           }
@@ -800,8 +801,8 @@ void AddToGraph(GraphTileBuilder& tilebuilder_transit,
 
     if (timezone == 0) {
       // fallback to tz database.
-      timezone =
-          (tile_within_one_tz) ? tz_polys.begin()->first : GetMultiPolyId(tz_polys, platform_ll);
+      timezone = (tile_within_one_tz) ? tz_polys.begin()->first
+                                      : GetMultiPolyId(tz_index_polys, platform_ll);
       if (timezone == 0) {
         LOG_WARN("Timezone not found for platform " + platform.name());
       }
@@ -1154,11 +1155,15 @@ void build_tiles(const boost::property_tree::ptree& pt,
         tile_within_one_tz = true;
       }
     }
+    MultiPolyIndex tz_index_polys;
+    if (!tile_within_one_tz && !tz_polys.empty()) {
+      tz_index_polys = MultiPolyIndex(tz_polys, filter);
+    }
 
     // Add nodes, directededges, and edgeinfo
     AddToGraph(tilebuilder_transit, tile_id, file, transit_dir, lock, all_tiles, stop_edge_map,
                stop_access, shapes, distances, route_types, onestoptests, tile_within_one_tz,
-               tz_polys, stats.no_dir_edge_count);
+               tz_polys, tz_index_polys, stats.no_dir_edge_count);
 
     LOG_INFO("Tile " + std::to_string(tile_id.tileid()) + ": added " +
              std::to_string(transit.nodes_size()) + " stops, " +
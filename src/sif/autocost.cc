@@ -42,16 +42,6 @@ constexpr float kDefaultUseFerry = 0.5f;    // Factor between 0 and 1
 constexpr float kDefaultUseHighways = 1.0f; // Factor between 0 and 1
 constexpr float kDefaultUseTolls = 0.5f;    // Factor between 0 and 1
 
-// Default turn costs
-constexpr float kTCStraight = 0.5f;
-constexpr float kTCSlight = 0.75f;
-constexpr float kTCFavorable = 1.0f;
-constexpr float kTCFavorableSharp = 1.5f;
-constexpr float kTCCrossing = 2.0f;
-constexpr float kTCUnfavorable = 2.5f;
-constexpr float kTCUnfavorableSharp = 3.5f;
-constexpr float kTCReverse = 5.0f;
-
 // How much to favor hov roads.
 constexpr float kHOVFactor = 0.85f;
 
@@ -61,14 +51,6 @@ constexpr float kTaxiFactor = 0.85f;
 // Do not avoid alleys by default
 constexpr float kDefaultAlleyFactor = 1.0f;
 
-// Turn costs based on side of street driving
-constexpr float kRightSideTurnCosts[] = {kTCStraight,       kTCSlight,  kTCFavorable,
-                                         kTCFavorableSharp, kTCReverse, kTCUnfavorableSharp,
-                                         kTCUnfavorable,    kTCSlight};
-constexpr float kLeftSideTurnCosts[] = {kTCStraight,         kTCSlight,  kTCUnfavorable,
-                                        kTCUnfavorableSharp, kTCReverse, kTCFavorableSharp,
-                                        kTCFavorable,        kTCSlight};
-
 constexpr float kMinFactor = 0.1f;
 constexpr float kMaxFactor = 100000.0f;
 
@@ -91,239 +73,13 @@ constexpr ranged_default_t<float> kUseFerryRange{0, kDefaultUseFerry, 1.0f};
 constexpr ranged_default_t<float> kUseHighwaysRange{0, kDefaultUseHighways, 1.0f};
 constexpr ranged_default_t<float> kUseTollsRange{0, kDefaultUseTolls, 1.0f};
 
-constexpr float kHighwayFactor[] = {
-    10.0f, // Motorway
-    0.5f,  // Trunk
-    0.0f,  // Primary
-    0.0f,  // Secondary
-    0.0f,  // Tertiary
-    0.0f,  // Unclassified
-    0.0f,  // Residential
-    0.0f   // Service, other
-};
-
-constexpr float kSurfaceFactor[] = {
-    0.0f, // kPavedSmooth
-    0.0f, // kPaved
-    0.0f, // kPaveRough
-    0.1f, // kCompacted
-    0.2f, // kDirt
-    0.5f, // kGravel
-    1.0f  // kPath
-};
-
 } // namespace
 
-/**
- * Derived class providing dynamic edge costing for "direct" auto routes. This
- * is a route that is generally shortest time but uses route hierarchies that
- * can result in slightly longer routes that avoid shortcuts on residential
- * roads.
- */
-class AutoCost : public DynamicCost {
-public:
-  /**
-   * Construct auto costing. Pass in cost type and options using protocol buffer(pbf).
-   * @param  costing specified costing type.
-   * @param  options pbf with request options.
-   */
-  AutoCost(const Costing costing, const Options& options);
-
-  virtual ~AutoCost() {
-  }
-
-  /**
-   * Does the costing method allow multiple passes (with relaxed hierarchy
-   * limits).
-   * @return  Returns true if the costing model allows multiple passes.
-   */
-  virtual bool AllowMultiPass() const {
-    return true;
-  }
-
-  /**
-   * Get the access mode used by this costing method.
-   * @return  Returns access mode.
-   */
-  uint32_t access_mode() const {
-    return kAutoAccess;
-  }
-
-  /**
-   * Checks if access is allowed for the provided directed edge.
-   * This is generally based on mode of travel and the access modes
-   * allowed on the edge. However, it can be extended to exclude access
-   * based on other parameters such as conditional restrictions and
-   * conditional access that can depend on time and travel mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the directed edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::DirectedEdge* edge,
-                       const EdgeLabel& pred,
-                       const baldr::GraphTile*& tile,
-                       const baldr::GraphId& edgeid,
-                       const uint64_t current_time,
-                       const uint32_t tz_index,
-                       bool& has_time_restrictions) const;
-
-  /**
-   * Checks if access is allowed for an edge on the reverse path
-   * (from destination towards origin). Both opposing edges (current and
-   * predecessor) are provided. The access check is generally based on mode
-   * of travel and the access modes allowed on the edge. However, it can be
-   * extended to exclude access based on other parameters such as conditional
-   * restrictions and conditional access that can depend on time and travel
-   * mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  opp_edge       Pointer to the opposing directed edge.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the opposing edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool AllowedReverse(const baldr::DirectedEdge* edge,
-                              const EdgeLabel& pred,
-                              const baldr::DirectedEdge* opp_edge,
-                              const baldr::GraphTile*& tile,
-                              const baldr::GraphId& opp_edgeid,
-                              const uint64_t current_time,
-                              const uint32_t tz_index,
-                              bool& has_time_restrictions) const;
-
-  /**
-   * Checks if access is allowed for the provided node. Node access can
-   * be restricted if bollards or gates are present.
-   * @param  node  Pointer to node information.
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::NodeInfo* node) const {
-    return (node->access() & kAutoAccess);
-  }
-
-  /**
-   * Only transit costings are valid for this method call, hence we throw
-   * @param edge
-   * @param departure
-   * @param curr_time
-   * @return
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::TransitDeparture* departure,
-                        const uint32_t curr_time) const {
-    throw std::runtime_error("AutoCost::EdgeCost does not support transit edges");
-  }
-
-  /**
-   * Get the cost to traverse the specified directed edge. Cost includes
-   * the time (seconds) to traverse the edge.
-   * @param   edge    Pointer to a directed edge.
-   * @param   tile    Graph tile.
-   * @param   seconds Time of week in seconds.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::GraphTile* tile,
-                        const uint32_t seconds) const;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge.
-   * Defaults to 0. Costing models that wish to include edge transition
-   * costs (i.e., intersection/turn costs) must override this method.
-   * @param  edge  Directed edge (the to edge)
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  Predecessor edge information.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCost(const baldr::DirectedEdge* edge,
-                              const baldr::NodeInfo* node,
-                              const EdgeLabel& pred) const;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge
-   * when using a reverse search (from destination towards the origin).
-   * @param  idx   Directed edge local index
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  the opposing current edge in the reverse tree.
-   * @param  edge  the opposing predecessor in the reverse tree
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCostReverse(const uint32_t idx,
-                                     const baldr::NodeInfo* node,
-                                     const baldr::DirectedEdge* pred,
-                                     const baldr::DirectedEdge* edge) const;
-
-  /**
-   * Get the cost factor for A* heuristics. This factor is multiplied
-   * with the distance to the destination to produce an estimate of the
-   * minimum cost to the destination. The A* heuristic must underestimate the
-   * cost to the destination. So a time based estimate based on speed should
-   * assume the maximum speed is used to the destination such that the time
-   * estimate is less than the least possible time along roads.
-   */
-  virtual float AStarCostFactor() const {
-    return speedfactor_[kMaxSpeedKph];
-  }
-
-  /**
-   * Get the current travel type.
-   * @return  Returns the current travel type.
-   */
-  virtual uint8_t travel_type() const {
-    return static_cast<uint8_t>(type_);
-  }
-
-  /**
-   * Returns a function/functor to be used in location searching which will
-   * exclude and allow ranking results from the search by looking at each
-   * edges attribution and suitability for use as a location by the travel
-   * mode used by the costing method. Function/functor is also used to filter
-   * edges not usable / inaccessible by automobile.
-   */
-  virtual const EdgeFilter GetEdgeFilter() const {
-    // Throw back a lambda that checks the access for this type of costing
-    return [](const baldr::DirectedEdge* edge) {
-      if (edge->is_shortcut() || !(edge->forwardaccess() & kAutoAccess)) {
-        return 0.0f;
-      } else {
-        // TODO - use classification/use to alter the factor
-        return 1.0f;
-      }
-    };
-  }
-
-  /**
-   * Returns a function/functor to be used in location searching which will
-   * exclude results from the search by looking at each node's attribution
-   * @return Function/functor to be used in filtering out nodes
-   */
-  virtual const NodeFilter GetNodeFilter() const {
-    // throw back a lambda that checks the access for this type of costing
-    return [](const baldr::NodeInfo* node) { return !(node->access() & kAutoAccess); };
-  }
-
-  // Hidden in source file so we don't need it to be protected
-  // We expose it within the source file for testing purposes
-public:
-  VehicleType type_; // Vehicle type: car (default), motorcycle, etc
-  float speedfactor_[kMaxSpeedKph + 1];
-  float density_factor_[16]; // Density factor
-  float highway_factor_;     // Factor applied when road is a motorway or trunk
-  float alley_factor_;       // Avoid alleys factor.
-  float toll_factor_;        // Factor applied when road has a toll
-  float surface_factor_;     // How much the surface factors are applied.
-
-  // Density factor used in edge transition costing
-  std::vector<float> trans_density_factor_;
-};
+// Definitions of the tables the inline costing methods index, needed until C++17
+constexpr float AutoCost::kRightSideTurnCosts[];
+constexpr float AutoCost::kLeftSideTurnCosts[];
+constexpr float AutoCost::kHighwayFactor[];
+constexpr float AutoCost::kSurfaceFactor[];
 
 // Constructor
 AutoCost::AutoCost(const Costing costing, const Options& options)
@@ -383,159 +139,28 @@ AutoCost::AutoCost(const Costing costing, const Options& options)
   }
 }
 
-// Check if access is allowed on the specified edge.
-bool AutoCost::Allowed(const baldr::DirectedEdge* edge,
-                       const EdgeLabel& pred,
-                       const baldr::GraphTile*& tile,
-                       const baldr::GraphId& edgeid,
-                       const uint64_t current_time,
-                       const uint32_t tz_index,
-                       bool& has_time_restrictions) const {
-  // Check access, U-turn, and simple turn restriction.
-  // Allow U-turns at dead-end nodes in case the origin is inside
-  // a not thru region and a heading selected an edge entering the
-  // region.
-  if (!(edge->forwardaccess() & kAutoAccess) ||
-      (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
-      (pred.restrictions() & (1 << edge->localedgeidx())) ||
-      edge->surface() == Surface::kImpassable || IsUserAvoidEdge(edgeid) ||
-      (!allow_destination_only_ && !pred.destonly() && edge->destonly())) {
-    return false;
-  }
-
-  return DynamicCost::EvaluateRestrictions(kAutoAccess, edge, tile, edgeid, current_time, tz_index,
-                                           has_time_restrictions);
-}
-
-// Checks if access is allowed for an edge on the reverse path (from
-// destination towards origin). Both opposing edges are provided.
-bool AutoCost::AllowedReverse(const baldr::DirectedEdge* edge,
-                              const EdgeLabel& pred,
-                              const baldr::DirectedEdge* opp_edge,
-                              const baldr::GraphTile*& tile,
-                              const baldr::GraphId& opp_edgeid,
-                              const uint64_t current_time,
-                              const uint32_t tz_index,
-                              bool& has_time_restrictions) const {
-  // Check access, U-turn, and simple turn restriction.
-  // Allow U-turns at dead-end nodes.
-  if (!(opp_edge->forwardaccess() & kAutoAccess) ||
-      (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
-      (opp_edge->restrictions() & (1 << pred.opp_local_idx())) ||
-      opp_edge->surface() == Surface::kImpassable || IsUserAvoidEdge(opp_edgeid) ||
-      (!allow_destination_only_ && !pred.destonly() && opp_edge->destonly())) {
-    return false;
-  }
-
-  return DynamicCost::EvaluateRestrictions(kAutoAccess, edge, tile, opp_edgeid, current_time,
-                                           tz_index, has_time_restrictions);
-}
-
-// Get the cost to traverse the edge in seconds
-Cost AutoCost::EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::GraphTile* tile,
-                        const uint32_t seconds) const {
-  auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
-  float factor = (edge->use() == Use::kFerry) ? ferry_factor_ : density_factor_[edge->density()];
-
-  factor += highway_factor_ * kHighwayFactor[static_cast<uint32_t>(edge->classification())] +
-            surface_factor_ * kSurfaceFactor[static_cast<uint32_t>(edge->surface())];
-  if (edge->toll()) {
-    factor += toll_factor_;
-  }
-
-  if (edge->use() == Use::kAlley) {
-    factor *= alley_factor_;
-  }
-
-  float sec = (edge->length() * speedfactor_[speed]);
-  return Cost(sec * factor, sec);
-}
-
-// Returns the time (in seconds) to make the transition from the predecessor
-Cost AutoCost::TransitionCost(const baldr::DirectedEdge* edge,
-                              const baldr::NodeInfo* node,
-                              const EdgeLabel& pred) const {
-  // Get the transition cost for country crossing, ferry, gate, toll booth,
-  // destination only, alley, maneuver penalty
-  uint32_t idx = pred.opp_local_idx();
-  Cost c = base_transition_cost(node, edge, pred, idx);
-
-  // Intersection transition time = factor * stopimpact * turncost. Factor depends
-  // on density and whether traffic is available
-  if (edge->stopimpact(idx) > 0) {
-    float turn_cost;
-    if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-      turn_cost = kTCCrossing;
-    } else {
-      turn_cost = (node->drive_on_right())
-                      ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
-                      : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
-    }
-
-    if ((edge->use() != Use::kRamp && pred.use() == Use::kRamp) ||
-        (edge->use() == Use::kRamp && pred.use() != Use::kRamp)) {
-      turn_cost += 1.5f;
-      if (edge->roundabout())
-        turn_cost += 0.5f;
-    }
-
-    // Separate time and penalty when traffic is present. With traffic, edge speeds account for
-    // much of the intersection transition time (TODO - evaluate different elapsed time settings).
-    // Still want to add a penalty so routes avoid high cost intersections.
-    float seconds = turn_cost * edge->stopimpact(idx);
-    // Apply density factor penality if there isnt traffic on this edge or youre not using traffic
-    if (!edge->has_flow_speed() || flow_mask_ == 0)
-      seconds *= trans_density_factor_[node->density()];
-
-    c.cost += seconds;
-    c.secs += seconds;
-  }
-  return c;
-}
-
-// Returns the cost to make the transition from the predecessor edge
-// when using a reverse search (from destination towards the origin).
-// pred is the opposing current edge in the reverse tree
-// edge is the opposing predecessor in the reverse tree
-Cost AutoCost::TransitionCostReverse(const uint32_t idx,
-                                     const baldr::NodeInfo* node,
-                                     const baldr::DirectedEdge* pred,
-                                     const baldr::DirectedEdge* edge) const {
-  // Get the transition cost for country crossing, ferry, gate, toll booth,
-  // destination only, alley, maneuver penalty
-  Cost c = base_transition_cost(node, edge, pred, idx);
-
-  // Transition time = densityfactor * stopimpact * turncost
-  if (edge->stopimpact(idx) > 0) {
-    float turn_cost;
-    if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-      turn_cost = kTCCrossing;
-    } else {
-      turn_cost = (node->drive_on_right())
-                      ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
-                      : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
-    }
-
-    if ((edge->use() != Use::kRamp && pred->use() == Use::kRamp) ||
-        (edge->use() == Use::kRamp && pred->use() != Use::kRamp)) {
-      turn_cost += 1.5f;
-      if (edge->roundabout())
-        turn_cost += 0.5f;
-    }
-
-    // Separate time and penalty when traffic is present. With traffic, edge speeds account for
-    // much of the intersection transition time (TODO - evaluate different elapsed time settings).
-    // Still want to add a penalty so routes avoid high cost intersections.
-    float seconds = turn_cost * edge->stopimpact(idx);
-    // Apply density factor penality if there isnt traffic on this edge or youre not using traffic
-    if (!edge->has_flow_speed() || flow_mask_ == 0)
-      seconds *= trans_density_factor_[node->density()];
-
-    c.secs += seconds;
-    c.cost += seconds;
-  }
-  return c;
+// Cost every directed edge of the tile once and keep the costs with the tile. Access is checked
+// without a time so the edges with time dependent restrictions are marked rather than decided.
+const EdgeCostTable* AutoCost::BuildEdgeCostTable(const GraphTile* tile,
+                                                  const uint64_t key,
+                                                  const uint32_t seconds) const {
+  EdgeCostTables* tables = tile->edge_costs();
+  if (tables->full()) {
+    return nullptr;
+  }
+
+  uint32_t count = tile->header()->directededgecount();
+  std::unique_ptr<EdgeCostTable> table(new EdgeCostTable(key, count));
+  const GraphTile* edge_tile = tile;
+  GraphId edgeid(tile->id().tileid(), tile->id().level(), 0);
+  for (uint32_t idx = 0; idx < count; ++idx, ++edgeid) {
+    const DirectedEdge* edge = tile->directededge(idx);
+    bool timed = false;
+    bool allowed = AllowedEdge(edge, edge_tile, edgeid, 0, 0, timed);
+    Cost cost = ComputeEdgeCost(edge, tile, seconds);
+    table->set(idx, cost.cost, cost.secs, allowed, timed);
+  }
+  return tables->add(std::move(table));
 }
 
 void ParseAutoCostOptions(const rapidjson::Document& doc,
@@ -681,7 +306,8 @@ public:
   virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
                         const baldr::GraphTile* tile,
                         const uint32_t seconds) const {
-    auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
+    auto speed = tile->GetSpeed(edge, flow_mask_, seconds, nullptr, seconds_from_now(seconds),
+                                speed_cache());
     float factor = (edge->use() == Use::kFerry) ? ferry_factor_ : 1.0f;
     return Cost(edge->length() * adjspeedfactor_[speed] * factor,
                 edge->length() * speedfactor_[speed]);
@@ -972,7 +598,8 @@ public:
   virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
                         const baldr::GraphTile* tile,
                         const uint32_t seconds) const {
-    auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
+    auto speed = tile->GetSpeed(edge, flow_mask_, seconds, nullptr, seconds_from_now(seconds),
+                                speed_cache());
     float factor = (edge->use() == Use::kFerry) ? ferry_factor_ : density_factor_[edge->density()];
     if ((edge->forwardaccess() & kHOVAccess) && !(edge->forwardaccess() & kAutoAccess)) {
       factor *= kHOVFactor;
@@ -1168,7 +795,8 @@ public:
   virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
                         const baldr::GraphTile* tile,
                         const uint32_t seconds) const {
-    auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
+    auto speed = tile->GetSpeed(edge, flow_mask_, seconds, nullptr, seconds_from_now(seconds),
+                                speed_cache());
     float factor = (edge->use() == Use::kFerry) ? ferry_factor_ : density_factor_[edge->density()];
     if ((edge->forwardaccess() & kTaxiAccess) && !(edge->forwardaccess() & kAutoAccess)) {
       factor *= kTaxiFactor;
@@ -41,50 +41,6 @@ constexpr float kDefaultUseFerry = 0.5f;          // Factor between 0 and 1
 constexpr float kDefaultAvoidBadSurfaces = 0.25f; // Factor between 0 and 1
 const std::string kDefaultBicycleType = "Hybrid"; // Bicycle type
 
-// Default turn costs - modified by the stop impact.
-constexpr float kTCStraight = 0.15f;
-constexpr float kTCFavorableSlight = 0.2f;
-constexpr float kTCFavorable = 0.3f;
-constexpr float kTCFavorableSharp = 0.5f;
-constexpr float kTCCrossing = 0.75f;
-constexpr float kTCUnfavorableSlight = 0.4f;
-constexpr float kTCUnfavorable = 1.0f;
-constexpr float kTCUnfavorableSharp = 1.5f;
-constexpr float kTCReverse = 5.0f;
-
-// Turn costs based on side of street driving
-constexpr float kRightSideTurnCosts[] = {kTCStraight,       kTCFavorableSlight,  kTCFavorable,
-                                         kTCFavorableSharp, kTCReverse,          kTCUnfavorableSharp,
-                                         kTCUnfavorable,    kTCUnfavorableSlight};
-constexpr float kLeftSideTurnCosts[] = {kTCStraight,         kTCUnfavorableSlight, kTCUnfavorable,
-                                        kTCUnfavorableSharp, kTCReverse,           kTCFavorableSharp,
-                                        kTCFavorable,        kTCFavorableSlight};
-
-// Turn stress penalties for low-stress bike.
-constexpr float kTPStraight = 0.0f;
-constexpr float kTPFavorableSlight = 0.25f;
-constexpr float kTPFavorable = 0.75f;
-constexpr float kTPFavorableSharp = 1.0f;
-constexpr float kTPUnfavorableSlight = 0.75f;
-constexpr float kTPUnfavorable = 1.75f;
-constexpr float kTPUnfavorableSharp = 2.25f;
-constexpr float kTPReverse = 4.0f;
-
-constexpr float kRightSideTurnPenalties[] = {kTPStraight,    kTPFavorableSlight,
-                                             kTPFavorable,   kTPFavorableSharp,
-                                             kTPReverse,     kTPUnfavorableSharp,
-                                             kTPUnfavorable, kTPUnfavorableSlight};
-constexpr float kLeftSideTurnPenalties[] = {kTPStraight,    kTPUnfavorableSlight,
-                                            kTPUnfavorable, kTPUnfavorableSharp,
-                                            kTPReverse,     kTPFavorableSharp,
-                                            kTPFavorable,   kTPFavorableSlight};
-
-// Additional stress factor for designated truck routes
-const float kTruckStress = 0.5f;
-
-// Cost of traversing an edge with steps. Make this high but not impassible.
-const float kBicycleStepsFactor = 8.0f;
-
 // Default cycling speed on smooth, flat roads - based on bicycle type (KPH)
 constexpr float kDefaultCyclingSpeed[] = {
     25.0f, // Road bicycle: ~15.5 MPH
@@ -93,8 +49,6 @@ constexpr float kDefaultCyclingSpeed[] = {
     16.0f  // Mountain bicycle: ~10 MPH
 };
 
-constexpr float kDismountSpeed = 5.1f;
-
 // Minimum and maximum average bicycling speed (to validate input).
 // Maximum is just above the fastest average speed in Tour de France time trial
 constexpr float kMinCyclingSpeed = 5.0f;  // KPH
@@ -114,44 +68,6 @@ constexpr Surface kWorstAllowedSurface[] = {Surface::kCompacted, // Road bicycle
                                             Surface::kDirt,      // Hybrid
                                             Surface::kPath};     // Mountain
 
-constexpr float kSurfaceFactors[] = {1.0f, 2.5f, 4.5f, 7.0f};
-
-// Weighting factor based on road class. These apply penalties to higher class
-// roads. These penalties are modulated by the useroads factor - further
-// avoiding higher class roads for those with low propensity for using roads.
-constexpr float kRoadClassFactor[] = {
-    1.0f,  // Motorway
-    0.4f,  // Trunk
-    0.2f,  // Primary
-    0.1f,  // Secondary
-    0.05f, // Tertiary
-    0.05f, // Unclassified
-    0.0f,  // Residential
-    0.5f   // Service, other
-};
-
-// Speed adjustment factors based on weighted grade. Comments here show an
-// example of speed changes based on "grade", using a base speed of 18 MPH
-// on flat roads
-constexpr float kGradeBasedSpeedFactor[] = {
-    2.2f,  // -10%  - 39.6
-    2.0f,  // -8%   - 36
-    1.9f,  // -6.5% - 34.2
-    1.7f,  // -5%   - 30.6
-    1.4f,  // -3%   - 25
-    1.2f,  // -1.5% - 21.6
-    1.0f,  // 0%    - 18
-    0.95f, // 1.5%  - 17
-    0.85f, // 3%    - 15
-    0.75f, // 5%    - 13.5
-    0.65f, // 6.5%  - 12
-    0.55f, // 8%    - 10
-    0.5f,  // 10%   - 9
-    0.45f, // 11.5% - 8
-    0.4f,  // 13%   - 7
-    0.3f   // 15%   - 5.5
-};
-
 // User propensity to use "hilly" roads. Ranges from a value of 0 (avoid
 // hills) to 1 (take hills when they offer a more direct, less time, path).
 constexpr float kDefaultUseHills = 0.25f;
@@ -185,9 +101,6 @@ constexpr float kAvoidHillsStrength[] = {
 // factors.
 constexpr uint32_t kSpeedPenaltyThreshold = 40; // 40 KPH ~ 25 MPH
 
-// How much to favor bicycle networks.
-constexpr float kBicycleNetworkFactor = 0.95f;
-
 // Valid ranges and defaults
 constexpr ranged_default_t<float> kDestinationOnlyPenaltyRange{0, kDefaultDestinationOnlyPenalty,
                                                                kMaxPenalty};
@@ -207,226 +120,15 @@ constexpr ranged_default_t<float> kUseHillsRange{0.0f, kDefaultUseHills, 1.0f};
 constexpr ranged_default_t<float> kAvoidBadSurfacesRange{0.0f, kDefaultAvoidBadSurfaces, 1.0f};
 } // namespace
 
-/**
- * Derived class providing dynamic edge costing for bicycle routes.
- */
-class BicycleCost : public DynamicCost {
-public:
-  /**
-   * Construct bicycle costing. Pass in cost type and options using protocol buffer(pbf).
-   * @param  costing specified costing type.
-   * @param  options pbf with request options.
-   */
-  BicycleCost(const Costing costing, const Options& options);
-
-  // virtual destructor
-  virtual ~BicycleCost() {
-  }
-
-  /**
-   * Get the access mode used by this costing method.
-   * @return  Returns access mode.
-   */
-  uint32_t access_mode() const {
-    return kBicycleAccess;
-  }
-
-  /**
-   * Checks if access is allowed for the provided directed edge.
-   * This is generally based on mode of travel and the access modes
-   * allowed on the edge. However, it can be extended to exclude access
-   * based on other parameters such as conditional restrictions and
-   * conditional access that can depend on time and travel mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the directed edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::DirectedEdge* edge,
-                       const EdgeLabel& pred,
-                       const baldr::GraphTile*& tile,
-                       const baldr::GraphId& edgeid,
-                       const uint64_t current_time,
-                       const uint32_t tz_index,
-                       bool& time_restricted) const;
-
-  /**
-   * Checks if access is allowed for an edge on the reverse path
-   * (from destination towards origin). Both opposing edges (current and
-   * predecessor) are provided. The access check is generally based on mode
-   * of travel and the access modes allowed on the edge. However, it can be
-   * extended to exclude access based on other parameters such as conditional
-   * restrictions and conditional access that can depend on time and travel
-   * mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  opp_edge       Pointer to the opposing directed edge.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the opposing edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool AllowedReverse(const baldr::DirectedEdge* edge,
-                              const EdgeLabel& pred,
-                              const baldr::DirectedEdge* opp_edge,
-                              const baldr::GraphTile*& tile,
-                              const baldr::GraphId& opp_edgeid,
-                              const uint64_t current_time,
-                              const uint32_t tz_index,
-                              bool& has_time_restrictions) const;
-
-  /**
-   * Checks if access is allowed for the provided node. Node access can
-   * be restricted if bollards or gates are present. (TODO - others?)
-   * @param  node  Pointer to node information.
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::NodeInfo* node) const {
-    return (node->access() & kBicycleAccess);
-  }
-
-  /**
-   * Only transit costings are valid for this method call, hence we throw
-   * @param edge
-   * @param departure
-   * @param curr_time
-   * @return
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::TransitDeparture* departure,
-                        const uint32_t curr_time) const {
-    throw std::runtime_error("BicycleCost::EdgeCost does not support transit edges");
-  }
-
-  /**
-   * Get the cost to traverse the specified directed edge. Cost includes
-   * the time (seconds) to traverse the edge.
-   * @param   edge      Pointer to a directed edge.
-   * @param   tile      Current tile.
-   * @param   seconds   Time of week in seconds.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::GraphTile* tile,
-                        const uint32_t seconds) const;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge.
-   * Defaults to 0. Costing models that wish to include edge transition
-   * costs (i.e., intersection/turn costs) must override this method.
-   * @param  edge  Directed edge (the to edge)
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  Predecessor edge information.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCost(const baldr::DirectedEdge* edge,
-                              const baldr::NodeInfo* node,
-                              const EdgeLabel& pred) const;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge
-   * when using a reverse search (from destination towards the origin).
-   * @param  idx   Directed edge local index
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  the opposing current edge in the reverse tree.
-   * @param  edge  the opposing predecessor in the reverse tree
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCostReverse(const uint32_t idx,
-                                     const baldr::NodeInfo* node,
-                                     const baldr::DirectedEdge* pred,
-                                     const baldr::DirectedEdge* edge) const;
-
-  /**
-   * Get the cost factor for A* heuristics. This factor is multiplied
-   * with the distance to the destination to produce an estimate of the
-   * minimum cost to the destination. The A* heuristic must underestimate the
-   * cost to the destination. So a time based estimate based on speed should
-   * assume the maximum speed is used to the destination such that the time
-   * estimate is less than the least possible time along roads.
-   */
-  virtual float AStarCostFactor() const {
-    // Assume max speed of 2 * the average speed set for costing
-    return speedfactor_[2 * static_cast<uint32_t>(speed_)];
-  }
-
-  /**
-   * Get the current travel type.
-   * @return  Returns the current travel type.
-   */
-  virtual uint8_t travel_type() const {
-    return static_cast<uint8_t>(type_);
-  }
-
-  // Hidden in source file so we don't need it to be protected
-  // We expose it within the source file for testing purposes
+// Definitions of the tables the inline costing methods index, needed until C++17
+constexpr float BicycleCost::kRightSideTurnCosts[];
+constexpr float BicycleCost::kLeftSideTurnCosts[];
+constexpr float BicycleCost::kRightSideTurnPenalties[];
+constexpr float BicycleCost::kLeftSideTurnPenalties[];
+constexpr float BicycleCost::kSurfaceFactors[];
+constexpr float BicycleCost::kRoadClassFactor[];
+constexpr float BicycleCost::kGradeBasedSpeedFactor[];
 
-  float speedfactor_[kMaxSpeedKph + 1]; // Cost factors based on speed in kph
-  float use_roads_;                     // Preference of using roads between 0 and 1
-  float road_factor_;                   // Road factor based on use_roads_
-  float avoid_bad_surfaces_;            // Preference of avoiding bad surfaces for the bike type
-
-  // Average speed (kph) on smooth, flat roads.
-  float speed_;
-
-  // Bicycle type
-  BicycleType type_;
-
-  // Minimal surface type that will be penalized for costing
-  Surface minimal_surface_penalized_;
-  Surface worst_allowed_surface_;
-
-  // Surface speed factors (based on road surface type).
-  const float* surface_speed_factor_;
-
-  // Speed penalty factor. Penalties apply above a threshold
-  // (based on the use_roads factor)
-  float speedpenalty_[kMaxSpeedKph + 1];
-  uint32_t speed_penalty_threshold_;
-
-  // Elevation/grade penalty (weighting applied based on the edge's weighted
-  // grade (relative value from 0-15)
-  float grade_penalty[16];
-
-protected:
-  /**
-   * Returns a function/functor to be used in location searching which will
-   * exclude and allow ranking results from the search by looking at each
-   * edges attribution and suitability for use as a location by the travel
-   * mode used by the costing method. Function/functor is also used to filter
-   * edges not usable / inaccessible by bicycle.
-   */
-  virtual const EdgeFilter GetEdgeFilter() const {
-    // Throw back a lambda that checks the access for this type of costing
-    Surface s = worst_allowed_surface_;
-    float a = avoid_bad_surfaces_;
-    return [s, a](const baldr::DirectedEdge* edge) {
-      if (edge->is_shortcut() || !(edge->forwardaccess() & kBicycleAccess) ||
-          edge->use() == Use::kSteps || (a == 1.0f && edge->surface() > s)) {
-        return 0.0f;
-      } else {
-        // TODO - use classification/use to alter the factor
-        return 1.0f;
-      }
-    };
-  }
-
-  /**
-   * Returns a function/functor to be used in location searching which will
-   * exclude results from the search by looking at each node's attribution
-   * @return Function to be used in filtering out nodes
-   */
-  virtual const NodeFilter GetNodeFilter() const {
-    // throw back a lambda that checks the access for this type of costing
-    return [](const baldr::NodeInfo* node) { return !(node->access() & kBicycleAccess); };
-  }
-};
 
 // Bicycle route costs are distance based with some favor/avoid based on
 // attribution. Speed is derived based on bicycle type or user input and
@@ -512,339 +214,6 @@ BicycleCost::BicycleCost(const Costing costing, const Options& options)
   }
 }
 
-// Check if access is allowed on the specified edge.
-bool BicycleCost::Allowed(const baldr::DirectedEdge* edge,
-                          const EdgeLabel& pred,
-                          const baldr::GraphTile*& tile,
-                          const baldr::GraphId& edgeid,
-                          const uint64_t current_time,
-                          const uint32_t tz_index,
-                          bool& has_time_restrictions) const {
-  // Check bicycle access and turn restrictions. Bicycles should obey
-  // vehicular turn restrictions. Allow Uturns at dead ends only.
-  // Skip impassable edges and shortcut edges.
-  if (!(edge->forwardaccess() & kBicycleAccess) || edge->is_shortcut() ||
-      (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
-      (pred.restrictions() & (1 << edge->localedgeidx())) || IsUserAvoidEdge(edgeid)) {
-    return false;
-  }
-
-  // Disallow transit connections
-  // (except when set for multi-modal routes (FUTURE)
-  if (edge->use() == Use::kTransitConnection || edge->use() == Use::kEgressConnection ||
-      edge->use() == Use::kPlatformConnection /* && !allow_transit_connections_*/) {
-    return false;
-  }
-
-  // Prohibit certain roads based on surface type and bicycle type
-  if (edge->surface() > worst_allowed_surface_) {
-    return false;
-  }
-  return DynamicCost::EvaluateRestrictions(kBicycleAccess, edge, tile, edgeid, current_time, tz_index,
-                                           has_time_restrictions);
-}
-
-// Checks if access is allowed for an edge on the reverse path (from
-// destination towards origin). Both opposing edges are provided.
-bool BicycleCost::AllowedReverse(const baldr::DirectedEdge* edge,
-                                 const EdgeLabel& pred,
-                                 const baldr::DirectedEdge* opp_edge,
-                                 const baldr::GraphTile*& tile,
-                                 const baldr::GraphId& opp_edgeid,
-                                 const uint64_t current_time,
-                                 const uint32_t tz_index,
-                                 bool& has_time_restrictions) const {
-  // Check access, U-turn (allow at dead-ends), and simple turn restriction.
-  // Do not allow transit connection edges.
-  if (!(opp_edge->forwardaccess() & kBicycleAccess) || opp_edge->is_shortcut() ||
-      opp_edge->use() == Use::kTransitConnection || opp_edge->use() == Use::kEgressConnection ||
-      opp_edge->use() == Use::kPlatformConnection ||
-      (!pred.deadend() && pred.opp_local_idx() == edge->localedgeidx()) ||
-      (opp_edge->restrictions() & (1 << pred.opp_local_idx())) || IsUserAvoidEdge(opp_edgeid)) {
-    return false;
-  }
-
-  // Prohibit certain roads based on surface type and bicycle type
-  if (edge->surface() > worst_allowed_surface_) {
-    return false;
-  }
-  return DynamicCost::EvaluateRestrictions(kBicycleAccess, edge, tile, opp_edgeid, current_time,
-                                           tz_index, has_time_restrictions);
-}
-
-// Returns the cost to traverse the edge and an estimate of the actual time
-// (in seconds) to traverse the edge.
-Cost BicycleCost::EdgeCost(const baldr::DirectedEdge* edge,
-                           const baldr::GraphTile* tile,
-                           const uint32_t seconds) const {
-  auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
-
-  // Stairs/steps - high cost (travel speed = 1kph) so they are generally avoided.
-  if (edge->use() == Use::kSteps) {
-    float sec = (edge->length() * speedfactor_[1]);
-    return {sec * kBicycleStepsFactor, sec};
-  }
-
-  // Ferries are a special case - they use the ferry speed (stored on the edge)
-  if (edge->use() == Use::kFerry) {
-    // Compute elapsed time based on speed. Modulate cost with weighting factors.
-    float sec = (edge->length() * speedfactor_[speed]);
-    return {sec * ferry_factor_, sec};
-  }
-
-  // If you have to dismount on the edge then we set speed to an average walking speed
-  // Otherwise, Update speed based on surface factor. Lower speed for rougher surfaces
-  // depending on the bicycle type. Modulate speed based on weighted grade
-  // (relative measure of elevation change along the edge)
-  uint32_t bike_speed =
-      edge->dismount() ? kDismountSpeed
-                       : static_cast<uint32_t>(
-                             (speed_ * surface_speed_factor_[static_cast<uint32_t>(edge->surface())] *
-                              kGradeBasedSpeedFactor[edge->weighted_grade()]) +
-                             0.5f);
-
-  // Represents how stressful a roadway is without looking at grade or cycle accommodations
-  float roadway_stress = 1.0f;
-  // Represents the amount of accommodation that is being made for bicycling
-  float accommodation_factor = 1.0f;
-
-  // Special use cases: cycleway, footway, and path
-  uint32_t road_speed = static_cast<uint32_t>(speed + 0.5f);
-  if (edge->use() == Use::kCycleway || edge->use() == Use::kFootway || edge->use() == Use::kPath) {
-
-    // Differentiate how segregated the way is from pedestrians
-    if (edge->cyclelane() == CycleLane::kSeparated) { // No pedestrians allowed on path
-      accommodation_factor = use_roads_ * 0.8f;
-    } else if (edge->cyclelane() == CycleLane::kDedicated) { // Segregated lane from pedestrians
-      accommodation_factor = 0.1f + use_roads_ * 0.9f;
-    } else { // Share path with pedestrians
-      accommodation_factor = 0.2f + use_roads_;
-    }
-  } else if (edge->use() == Use::kMountainBike && type_ == BicycleType::kMountain) {
-    // Slightly less reduction than a footway or path because even with a mountain bike
-    // these paths can be a little stressful to ride. No traffic though so still favorable
-    accommodation_factor = 0.3f + use_roads_;
-  } else if (edge->use() == Use::kLivingStreet) {
-    roadway_stress = 0.2f + use_roads_ * 0.8f;
-  } else if (edge->use() == Use::kTrack) {
-    roadway_stress = 0.5f + use_roads_;
-  } else {
-    // Favor roads where a cycle lane exists
-    if (edge->cyclelane() == CycleLane::kShared) {
-      accommodation_factor = 0.9f + use_roads_ * 0.05f;
-    } else if (edge->cyclelane() == CycleLane::kDedicated) {
-      accommodation_factor = 0.4f + use_roads_ * 0.45f;
-    } else if (edge->cyclelane() == CycleLane::kSeparated) {
-      accommodation_factor = 0.15f + use_roads_ * 0.6f;
-    } else if (edge->shoulder()) {
-      // If no cycle lane, but there is a shoulder then have a slight preference for this road
-      accommodation_factor = 0.7f + use_roads_ * 0.2f;
-    }
-
-    // Penalize roads that have more than one lane (in the direction of travel)
-    if (edge->lanecount() > 1) {
-      roadway_stress += (static_cast<float>(edge->lanecount()) - 1) * 0.05f * road_factor_;
-    }
-
-    // Designated truck routes add to roadway stress
-    if (edge->truck_route()) {
-      roadway_stress += kTruckStress;
-    }
-
-    // Add in penalization for road classification
-    roadway_stress += road_factor_ * kRoadClassFactor[static_cast<uint32_t>(edge->classification())];
-    // Then multiply by speed so that higher classified roads are more severely punished for being
-    // fast.
-    roadway_stress *= speedpenalty_[road_speed];
-  }
-
-  // We want to try and avoid roads that specify to use a cycling path to the side
-  if (edge->use_sidepath()) {
-    accommodation_factor += 3.0f * (1.0f - use_roads_);
-  }
-
-  // Favor bicycle networks very slightly.
-  // TODO - do we need to differentiate between types of network?
-  if (edge->bike_network() > 0) {
-    accommodation_factor *= kBicycleNetworkFactor;
-  }
-
-  // The stress of this road after accommodation but before grade
-  float total_stress = accommodation_factor * roadway_stress;
-
-  float surface_factor = 0.0f;
-  if (edge->surface() >= minimal_surface_penalized_) {
-    surface_factor =
-        avoid_bad_surfaces_ * kSurfaceFactors[static_cast<uint32_t>(edge->surface()) -
-                                              static_cast<uint32_t>(minimal_surface_penalized_)];
-  }
-
-  // Create a final edge factor based on total stress and the weighted grade penalty for the edge.
-  float factor = 1.0f + grade_penalty[edge->weighted_grade()] + total_stress + surface_factor;
-
-  // Compute elapsed time based on speed. Modulate cost with weighting factors.
-  float sec = (edge->length() * speedfactor_[bike_speed]);
-  return {sec * factor, sec};
-}
-
-// Returns the time (in seconds) to make the transition from the predecessor
-Cost BicycleCost::TransitionCost(const baldr::DirectedEdge* edge,
-                                 const baldr::NodeInfo* node,
-                                 const EdgeLabel& pred) const {
-  // Get the transition cost for country crossing, ferry, gate, toll booth,
-  // destination only, alley, maneuver penalty
-  uint32_t idx = pred.opp_local_idx();
-  Cost c = base_transition_cost(node, edge, pred, idx);
-
-  // Accumulate cost and penalty
-  float seconds = 0.0f;
-  float penalty = 0.0f;
-  float class_factor = kRoadClassFactor[static_cast<uint32_t>(edge->classification())];
-
-  // Reduce penalty to make this turn if the road we are turning on has some kind of bicycle
-  // accommodation
-  float bike_accom = 1.0f;
-  if (edge->use() == Use::kCycleway || edge->use() == Use::kFootway || edge->use() == Use::kPath) {
-    bike_accom = 0.05f;
-    // These uses are classified as "service/other" roads but should not be penalized as such so we
-    // change it's factor
-    class_factor = 0.1f;
-  } else if (edge->use() == Use::kLivingStreet) {
-    bike_accom = 0.15f;
-  } else {
-    if (edge->cyclelane() == CycleLane::kShared) {
-      bike_accom = 0.5f;
-    } else if (edge->cyclelane() == CycleLane::kDedicated) {
-      bike_accom = 0.25f;
-    } else if (edge->cyclelane() == CycleLane::kSeparated) {
-      bike_accom = 0.1f;
-    } else if (edge->shoulder()) {
-      bike_accom = 0.4f;
-    }
-  }
-
-  float turn_stress = 1.0f;
-
-  if (edge->stopimpact(idx) > 0) {
-    // Increase turn stress depending on the kind of turn that has to be made.
-    float turn_penalty = (node->drive_on_right())
-                             ? kRightSideTurnPenalties[static_cast<uint32_t>(edge->turntype(idx))]
-                             : kLeftSideTurnPenalties[static_cast<uint32_t>(edge->turntype(idx))];
-    turn_stress += turn_penalty;
-
-    // Take the higher of the turn degree cost and the crossing cost
-    float turn_cost = (node->drive_on_right())
-                          ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
-                          : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
-    if (turn_cost < kTCCrossing && edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-      turn_cost = kTCCrossing;
-    }
-
-    // Transition time = stopimpact * turncost
-    seconds += edge->stopimpact(idx) * turn_cost;
-  }
-
-  // Reduce stress by road class factor the closer use_roads_ is to 0
-  float avoid_roads = 1.0f - use_roads_;
-  turn_stress *= (class_factor * avoid_roads) + use_roads_ + 1.0f;
-
-  // Penalize transition to higher class road.
-  if (edge->classification() < pred.classification() && edge->use() != Use::kLivingStreet) {
-    penalty += 10.0f * (static_cast<uint32_t>(pred.classification()) -
-                        static_cast<uint32_t>(edge->classification()));
-    // Reduce the turn stress if there is a traffic signal
-    turn_stress += (node->traffic_signal()) ? 0.4 : 1.0;
-  }
-
-  // Reduce penalty by bike_accom the closer use_roads_ is to 0
-  penalty *= (bike_accom * avoid_roads) + use_roads_;
-
-  // Return cost (time and penalty)
-  c.cost += (seconds * (turn_stress + 1.0f)) + penalty;
-  c.secs += seconds;
-  return c;
-}
-
-// Returns the cost to make the transition from the predecessor edge
-// when using a reverse search (from destination towards the origin).
-// pred is the opposing current edge in the reverse tree
-// edge is the opposing predecessor in the reverse tree
-Cost BicycleCost::TransitionCostReverse(const uint32_t idx,
-                                        const baldr::NodeInfo* node,
-                                        const baldr::DirectedEdge* pred,
-                                        const baldr::DirectedEdge* edge) const {
-  // Get the transition cost for country crossing, ferry, gate, toll booth,
-  // destination only, alley, maneuver penalty
-  Cost c = base_transition_cost(node, edge, pred, idx);
-
-  // Additional costs
-  float seconds = 0.0f;
-  float penalty = 0.0f;
-
-  // Reduce penalty to make this turn if the road we are turning on has some kind of bicycle
-  // accommodation
-  float class_factor = kRoadClassFactor[static_cast<uint32_t>(edge->classification())];
-  float bike_accom = 1.0f;
-  if (edge->use() == Use::kCycleway || edge->use() == Use::kFootway || edge->use() == Use::kPath) {
-    bike_accom = 0.05f;
-    // These uses are considered "service/other" roads but should not be penalized as such so we
-    // change it's factor
-    class_factor = 0.1f;
-  } else if (edge->use() == Use::kLivingStreet) {
-    bike_accom = 0.15f;
-  } else {
-    if (edge->cyclelane() == CycleLane::kShared) {
-      bike_accom = 0.5f;
-    } else if (edge->cyclelane() == CycleLane::kDedicated) {
-      bike_accom = 0.25f;
-    } else if (edge->cyclelane() == CycleLane::kSeparated) {
-      bike_accom = 0.1f;
-    } else if (edge->shoulder()) {
-      bike_accom = 0.4f;
-    }
-  }
-
-  float turn_stress = 1.0f;
-  if (edge->stopimpact(idx) > 0) {
-    // Increase turn stress depending on the kind of turn that has to be made.
-    float turn_penalty = (node->drive_on_right())
-                             ? kRightSideTurnPenalties[static_cast<uint32_t>(edge->turntype(idx))]
-                             : kLeftSideTurnPenalties[static_cast<uint32_t>(edge->turntype(idx))];
-    turn_stress += turn_penalty;
-
-    // Take the higher of the turn degree cost and the crossing cost
-    float turn_cost = (node->drive_on_right())
-                          ? kRightSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))]
-                          : kLeftSideTurnCosts[static_cast<uint32_t>(edge->turntype(idx))];
-    if (turn_cost < kTCCrossing && edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-      turn_cost = kTCCrossing;
-    }
-
-    // Transition time = stopimpact * turncost
-    seconds += edge->stopimpact(idx) * turn_cost;
-  }
-
-  // Reduce stress by road class factor the closer use_roads_ is to 0
-  float avoid_roads = 1.0f - use_roads_;
-  turn_stress *= (class_factor * avoid_roads) + use_roads_ + 1.0f;
-
-  // Penalize transition to higher class road.
-  if (edge->classification() < pred->classification() && edge->use() != Use::kLivingStreet) {
-    penalty += 10.0f * (static_cast<uint32_t>(pred->classification()) -
-                        static_cast<uint32_t>(edge->classification()));
-    // Reduce the turn stress if there is a traffic signal
-    turn_stress += (node->traffic_signal()) ? 0.4 : 1.0;
-  }
-
-  // Reduce penalty by bike_accom the closer use_roads_ is to 0
-  penalty *= (bike_accom * avoid_roads) + use_roads_;
-
-  // Return cost (time and penalty)
-  c.cost += (seconds * (turn_stress + 1.0f)) + penalty;
-  c.secs += seconds;
-  return c;
-}
-
 void ParseBicycleCostOptions(const rapidjson::Document& doc,
                              const std::string& costing_options_key,
                              CostingOptions* pbf_costing_options) {
@@ -1,5 +1,7 @@
 #include "sif/dynamiccost.h"
 #include "baldr/graphconstants.h"
+#include <atomic>
+#include <string>
 
 using namespace valhalla::baldr;
 
@@ -40,7 +42,13 @@ namespace sif {
 
 DynamicCost::DynamicCost(const Options& options, const TravelMode mode)
     : pass_(0), allow_transit_connections_(false), allow_destination_only_(true), travel_mode_(mode),
-      flow_mask_(kDefaultFlowMask) {
+      flow_mask_(kDefaultFlowMask),
+      leaves_now_(!options.has_date_time_type() || options.date_time_type() == Options::current),
+      start_seconds_of_week_(kInvalidSecondsOfWeek), edge_cost_key_(0) {
+  // Every costing starts with empty speed caches, 0 is for threads that have none yet
+  static std::atomic<uint64_t> speed_cache_ids(1);
+  speed_cache_id_ = speed_cache_ids++;
+
   // Parse property tree to get hierarchy limits
   // TODO - get the number of levels
   uint32_t n_levels = sizeof(kDefaultMaxUpTransitions) / sizeof(kDefaultMaxUpTransitions[0]);
@@ -64,6 +72,16 @@ bool DynamicCost::AllowMultiPass() const {
   return false;
 }
 
+// Keep the edge costs of the tiles for the costing options of the request
+void DynamicCost::UseEdgeCostTables(const Costing costing, const Options& options) {
+  std::string key = std::to_string(static_cast<int>(costing));
+  if (options.costing_options_size() > static_cast<int>(costing)) {
+    key += options.costing_options(static_cast<int>(costing)).SerializeAsString();
+  }
+  // The lowest bit is left for the time of day
+  edge_cost_key_ = EdgeCostTables::key(key);
+}
+
 // We provide a convenience method for those algorithms which dont have time components or aren't
 // using them for the current route. Here we just call out to the derived classes costing function
 // with a time that tells the function that we aren't using time. This avoids having to worry about
@@ -447,7 +447,8 @@ bool MotorcycleCost::AllowedReverse(const baldr::DirectedEdge* edge,
 Cost MotorcycleCost::EdgeCost(const baldr::DirectedEdge* edge,
                               const baldr::GraphTile* tile,
                               const uint32_t seconds) const {
-  auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
+  auto speed = tile->GetSpeed(edge, flow_mask_, seconds, nullptr, seconds_from_now(seconds),
+                              speed_cache());
 
   // Special case for travel on a ferry
   if (edge->use() == Use::kFerry) {
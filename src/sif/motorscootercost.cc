@@ -455,7 +455,8 @@ bool MotorScooterCost::AllowedReverse(const baldr::DirectedEdge* edge,
 Cost MotorScooterCost::EdgeCost(const baldr::DirectedEdge* edge,
                                 const baldr::GraphTile* tile,
                                 const uint32_t seconds) const {
-  auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
+  auto speed = tile->GetSpeed(edge, flow_mask_, seconds, nullptr, seconds_from_now(seconds),
+                              speed_cache());
 
   if (edge->use() == Use::kFerry) {
     float sec = (edge->length() * speedfactor_[speed]);
@@ -67,17 +67,10 @@ constexpr uint32_t kTransitStartEndMaxDistance = 2415; // 1.5 miles
 // distance you are willing to walk between transfers.
 constexpr uint32_t kTransitTransferMaxDistance = 805; // 0.5 miles
 
-// Avoid roundabouts
-constexpr float kRoundaboutFactor = 2.0f;
-
 // Minimum and maximum average pedestrian speed (to validate input).
 constexpr float kMinPedestrianSpeed = 0.5f;
 constexpr float kMaxPedestrianSpeed = 25.0f;
 
-// Crossing penalties. TODO - may want to lower stop impact when
-// 2 cycleways or walkways cross
-constexpr uint32_t kCrossingCosts[] = {0, 0, 1, 1, 2, 3, 5, 15};
-
 constexpr float kMinFactor = 0.1f;
 constexpr float kMaxFactor = 100000.0f;
 
@@ -126,401 +119,13 @@ constexpr ranged_default_t<uint32_t> kTransitTransferMaxDistanceRange{0, kTransi
                                                                       50000}; // Max 50k
 constexpr ranged_default_t<float> kUseFerryRange{0, kDefaultUseFerry, 1.0f};
 
-constexpr float kSacScaleSpeedFactor[] = {
-    1.0f,  // kNone
-    1.11f, // kHiking (~90% speed)
-    1.25f, // kMountainHiking (80% speed)
-    1.54f, // kDemandingMountainHiking (~65% speed)
-    2.5f,  // kAlpineHiking (40% speed)
-    4.0f,  // kDemandingAlpineHiking (25% speed)
-    6.67f  // kDifficultAlpineHiking (~15% speed)
-};
-
-constexpr float kSacScaleCostFactor[] = {
-    0.0f,  // kNone
-    0.25f, // kHiking
-    0.75f, // kMountainHiking
-    1.25f, // kDemandingMountainHiking
-    2.0f,  // kAlpineHiking
-    2.5f,  // kDemandingAlpineHiking
-    3.0f   // kDifficultAlpineHiking
-};
-
 } // namespace
 
-/**
- * Derived class providing dynamic edge costing for pedestrian routes.
- */
-class PedestrianCost : public DynamicCost {
-public:
-  /**
-   * Construct pedestrian costing. Pass in cost type and options using protocol buffer(pbf).
-   * @param  costing specified costing type.
-   * @param  options pbf with request options.
-   */
-  PedestrianCost(const Costing costing, const Options& options);
-
-  // virtual destructor
-  virtual ~PedestrianCost() {
-  }
-
-  /**
-   * Does the costing method allow multiple passes (with relaxed hierarchy
-   * limits).
-   * @return  Returns true if the costing model allows multiple passes.
-   */
-  virtual bool AllowMultiPass() const {
-    return true;
-  }
-
-  /**
-   * This method overrides the max_distance with the max_distance_mm per segment
-   * distance. An example is a pure walking route may have a max distance of
-   * 10000 meters (10km) but for a multi-modal route a lower limit of 5000
-   * meters per segment (e.g. from origin to a transit stop or from the last
-   * transit stop to the destination).
-   */
-  virtual void UseMaxMultiModalDistance() {
-    max_distance_ = transit_start_end_max_distance_;
-  }
-
-  /**
-   * Returns the maximum transfer distance between stops that you are willing
-   * to travel for this mode.  In this case, it is the max walking
-   * distance you are willing to walk between transfers.
-   */
-  virtual uint32_t GetMaxTransferDistanceMM() {
-    return transit_transfer_max_distance_;
-  }
-
-  /**
-   * This method overrides the factor for this mode.  The higher the value
-   * the more the mode is favored.
-   */
-  virtual float GetModeFactor() {
-    return mode_factor_;
-  }
-
-  /**
-   * Get the access mode used by this costing method.
-   * @return  Returns access mode.
-   */
-  uint32_t access_mode() const {
-    return access_mask_;
-  }
-
-  /**
-   * Checks if access is allowed for the provided directed edge.
-   * This is generally based on mode of travel and the access modes
-   * allowed on the edge. However, it can be extended to exclude access
-   * based on other parameters such as conditional restrictions and
-   * conditional access that can depend on time and travel mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the directed edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::DirectedEdge* edge,
-                       const EdgeLabel& pred,
-                       const baldr::GraphTile*& tile,
-                       const baldr::GraphId& edgeid,
-                       const uint64_t current_time,
-                       const uint32_t tz_index,
-                       bool& time_restricted) const;
-
-  /**
-   * Checks if access is allowed for an edge on the reverse path
-   * (from destination towards origin). Both opposing edges (current and
-   * predecessor) are provided. The access check is generally based on mode
-   * of travel and the access modes allowed on the edge. However, it can be
-   * extended to exclude access based on other parameters such as conditional
-   * restrictions and conditional access that can depend on time and travel
-   * mode.
-   * @param  edge           Pointer to a directed edge.
-   * @param  pred           Predecessor edge information.
-   * @param  opp_edge       Pointer to the opposing directed edge.
-   * @param  tile           Current tile.
-   * @param  edgeid         GraphId of the opposing edge.
-   * @param  current_time   Current time (seconds since epoch). A value of 0
-   *                        indicates the route is not time dependent.
-   * @param  tz_index       timezone index for the node
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool AllowedReverse(const baldr::DirectedEdge* edge,
-                              const EdgeLabel& pred,
-                              const baldr::DirectedEdge* opp_edge,
-                              const baldr::GraphTile*& tile,
-                              const baldr::GraphId& opp_edgeid,
-                              const uint64_t current_time,
-                              const uint32_t tz_index,
-                              bool& has_time_restrictions) const;
-
-  /**
-   * Checks if access is allowed for the provided node. Node access can
-   * be restricted if bollards or gates are present.
-   * @param  node  Pointer to node information.
-   * @return  Returns true if access is allowed, false if not.
-   */
-  virtual bool Allowed(const baldr::NodeInfo* node) const {
-    return (node->access() & access_mask_);
-  }
-
-  /**
-   * Only transit costings are valid for this method call, hence we throw
-   * @param edge
-   * @param departure
-   * @param curr_time
-   * @return
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::TransitDeparture* departure,
-                        const uint32_t curr_time) const {
-    throw std::runtime_error("PedestrianCost::EdgeCost does not support transit edges");
-  }
-
-  /**
-   * Get the cost to traverse the specified directed edge. Cost includes
-   * the time (seconds) to traverse the edge.
-   * @param  edge      Pointer to a directed edge.
-   * @param  tile      Current tile.
-   * @param  seconds   Time of week in seconds.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost EdgeCost(const baldr::DirectedEdge* edge,
-                        const baldr::GraphTile* tile,
-                        const uint32_t seconds) const;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge.
-   * Defaults to 0. Costing models that wish to include edge transition
-   * costs (i.e., intersection/turn costs) must override this method.
-   * @param  edge  Directed edge (the to edge)
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  Predecessor edge information.
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCost(const baldr::DirectedEdge* edge,
-                              const baldr::NodeInfo* node,
-                              const EdgeLabel& pred) const;
-
-  /**
-   * Returns the cost to make the transition from the predecessor edge
-   * when using a reverse search (from destination towards the origin).
-   * Defaults to 0. Costing models that wish to include edge transition
-   * costs (i.e., intersection/turn costs) must override this method.
-   * @param  idx   Directed edge local index
-   * @param  node  Node (intersection) where transition occurs.
-   * @param  pred  the opposing current edge in the reverse tree.
-   * @param  edge  the opposing predecessor in the reverse tree
-   * @return  Returns the cost and time (seconds)
-   */
-  virtual Cost TransitionCostReverse(const uint32_t idx,
-                                     const baldr::NodeInfo* node,
-                                     const baldr::DirectedEdge* pred,
-                                     const baldr::DirectedEdge* edge) const;
-
-  /**
-   * Get the cost factor for A* heuristics. This factor is multiplied
-   * with the distance to the destination to produce an estimate of the
-   * minimum cost to the destination. The A* heuristic must underestimate the
-   * cost to the destination. So a time based estimate based on speed should
-   * assume the maximum speed is used to the destination such that the time
-   * estimate is less than the least possible time along roads.
-   */
-  virtual float AStarCostFactor() const {
-    // On first pass use the walking speed plus a small factor to account for
-    // favoring walkways, on the second pass use the the maximum ferry speed.
-    if (pass_ == 0) {
-
-      // Determine factor based on all of the factor options
-      float factor = 1.f;
-      if (walkway_factor_ < 1.f) {
-        factor *= walkway_factor_;
-      }
-      if (sidewalk_factor_ < 1.f) {
-        factor *= sidewalk_factor_;
-      }
-      if (alley_factor_ < 1.f) {
-        factor *= alley_factor_;
-      }
-      if (driveway_factor_ < 1.f) {
-        factor *= driveway_factor_;
-      }
-
-      return (speedfactor_ * factor);
-    } else {
-      return (kSecPerHour * 0.001f) / static_cast<float>(kMaxFerrySpeedKph);
-    }
-  }
-
-  /**
-   * Get the current travel type.
-   * @return  Returns the current travel type.
-   */
-  virtual uint8_t travel_type() const {
-    return static_cast<uint8_t>(type_);
-  }
-
-  /**
-   * Returns a function/functor to be used in location searching which will
-   * exclude and allow ranking results from the search by looking at each
-   * edges attribution and suitability for use as a location by the travel
-   * mode used by the costing method. Function/functor is also used to filter
-   * edges not usable / inaccessible by pedestrians.
-   */
-  virtual const EdgeFilter GetEdgeFilter() const {
-    // Throw back a lambda that checks the access for this type of costing
-    auto access_mask = access_mask_;
-    auto max_sac_scale = max_hiking_difficulty_;
-    return [access_mask, max_sac_scale](const baldr::DirectedEdge* edge) {
-      return !(edge->is_shortcut() || edge->use() >= Use::kRail ||
-               edge->sac_scale() > max_sac_scale || !(edge->forwardaccess() & access_mask));
-    };
-  }
-
-  /**
-   * Returns a function/functor to be used in location searching which will
-   * exclude results from the search by looking at each node's attribution
-   * @return Function/functor to be used in filtering out nodes
-   */
-  virtual const NodeFilter GetNodeFilter() const {
-    // throw back a lambda that checks the access for this type of costing
-    auto access_mask = access_mask_;
-    return [access_mask](const baldr::NodeInfo* node) { return !(node->access() & access_mask); };
-  }
-
-public:
-  // Type: foot (default), wheelchair, etc.
-  PedestrianType type_;
-
-  uint32_t access_mask_;
-
-  // Maximum pedestrian distance.
-  uint32_t max_distance_;
-
-  // This is the factor for this mode.  The higher the value the more the
-  // mode is favored.
-  float mode_factor_;
-
-  // Maximum pedestrian distance in meters for multimodal routes.
-  // Maximum distance at the beginning or end of a multimodal route
-  // that you are willing to travel for this mode.  In this case,
-  // it is the max walking distance.
-  uint32_t transit_start_end_max_distance_;
-
-  // Maximum transfer, distance in meters for multimodal routes.
-  // Maximum transfer distance between stops that you are willing
-  // to travel for this mode.  In this case, it is the max distance
-  // you are willing to walk between transfers.
-  uint32_t transit_transfer_max_distance_;
-
-  // Minimal surface type usable by the pedestrian type
-  Surface minimal_allowed_surface_;
-
-  uint32_t max_grade_;             // Maximum grade (percent).
-  SacScale max_hiking_difficulty_; // Max sac_scale (0 - 6)
-  float speed_;                    // Pedestrian speed.
-  float speedfactor_;              // Speed factor for costing. Based on speed.
-  float walkway_factor_;           // Factor for favoring walkways and paths.
-  float sidewalk_factor_;          // Factor for favoring sidewalks.
-  float alley_factor_;             // Avoid alleys factor.
-  float driveway_factor_;          // Avoid driveways factor.
-  float step_penalty_;             // Penalty applied to steps/stairs (seconds).
-
-  /**
-   * Override the base transition cost to not add maneuver penalties onto transit edges.
-   * Base transition cost that all costing methods use. Includes costs for
-   * country crossing, boarding a ferry, toll booth, gates, entering destination
-   * only, alleys, and maneuver penalties. Each costing method can provide different
-   * costs for these transitions (via costing options).
-   * @param node Node at the intersection where the edge transition occurs.
-   * @param edge Directed edge entering.
-   * @param pred Predecessor edge information.
-   * @param idx  Index used for name consistency.
-   * @return Returns the transition cost (cost, elapsed time).
-   */
-  sif::Cost base_transition_cost(const baldr::NodeInfo* node,
-                                 const baldr::DirectedEdge* edge,
-                                 const sif::EdgeLabel& pred,
-                                 const uint32_t idx) const {
-    // Cases with both time and penalty: country crossing, ferry, gate, toll booth
-    sif::Cost c;
-    if (node->type() == baldr::NodeType::kBorderControl) {
-      c += country_crossing_cost_;
-    }
-    if (node->type() == baldr::NodeType::kGate) {
-      c += gate_cost_;
-    }
-    if (node->type() == baldr::NodeType::kTollBooth) {
-      c += toll_booth_cost_;
-    }
-    if (edge->use() == baldr::Use::kFerry && pred.use() != baldr::Use::kFerry) {
-      c += ferry_transition_cost_;
-    }
+// Definitions of the tables the inline costing methods index, needed until C++17
+constexpr uint32_t PedestrianCost::kCrossingCosts[];
+constexpr float PedestrianCost::kSacScaleSpeedFactor[];
+constexpr float PedestrianCost::kSacScaleCostFactor[];
 
-    // Additional penalties without any time cost
-    if (edge->destonly() && !pred.destonly()) {
-      c.cost += destination_only_penalty_;
-    }
-    if (edge->use() == baldr::Use::kAlley && pred.use() != baldr::Use::kAlley) {
-      c.cost += alley_penalty_;
-    }
-    if (!edge->link() && edge->use() != Use::kEgressConnection &&
-        edge->use() != Use::kPlatformConnection && !edge->name_consistency(idx)) {
-      c.cost += maneuver_penalty_;
-    }
-    return c;
-  }
-
-  /**
-   * Override the base transition cost to not add maneuver penalties onto transit edges.
-   * Base transition cost that all costing methods use. Includes costs for
-   * country crossing, boarding a ferry, toll booth, gates, entering destination
-   * only, alleys, and maneuver penalties. Each costing method can provide different
-   * costs for these transitions (via costing options).
-   * @param node Node at the intersection where the edge transition occurs.
-   * @param edge Directed edge entering.
-   * @param pred Predecessor edge.
-   * @param idx  Index used for name consistency.
-   * @return Returns the transition cost (cost, elapsed time).
-   */
-  sif::Cost base_transition_cost(const baldr::NodeInfo* node,
-                                 const baldr::DirectedEdge* edge,
-                                 const baldr::DirectedEdge* pred,
-                                 const uint32_t idx) const {
-    // Cases with both time and penalty: country crossing, ferry, gate, toll booth
-    sif::Cost c;
-    if (node->type() == baldr::NodeType::kBorderControl) {
-      c += country_crossing_cost_;
-    }
-    if (node->type() == baldr::NodeType::kGate) {
-      c += gate_cost_;
-    }
-    if (node->type() == baldr::NodeType::kTollBooth) {
-      c += toll_booth_cost_;
-    }
-    if (edge->use() == baldr::Use::kFerry && pred->use() != baldr::Use::kFerry) {
-      c += ferry_transition_cost_;
-    }
-
-    // Additional penalties without any time cost
-    if (edge->destonly() && !pred->destonly()) {
-      c.cost += destination_only_penalty_;
-    }
-    if (edge->use() == baldr::Use::kAlley && pred->use() != baldr::Use::kAlley) {
-      c.cost += alley_penalty_;
-    }
-    if (!edge->link() && edge->use() != Use::kEgressConnection &&
-        edge->use() != Use::kPlatformConnection && !edge->name_consistency(idx)) {
-      c.cost += maneuver_penalty_;
-    }
-    return c;
-  }
-};
 
 // Constructor. Parse pedestrian options from property tree. If option is
 // not present, set the default.
@@ -581,144 +186,6 @@ PedestrianCost::PedestrianCost(const Costing costing, const Options& options)
   speedfactor_ = (kSecPerHour * 0.001f) / speed_;
 }
 
-// Check if access is allowed on the specified edge. Disallow if no
-// access for this pedestrian type, if surface type exceeds (worse than)
-// the minimum allowed surface type, or if max grade is exceeded.
-// Disallow edges where max. distance will be exceeded.
-bool PedestrianCost::Allowed(const baldr::DirectedEdge* edge,
-                             const EdgeLabel& pred,
-                             const baldr::GraphTile*& tile,
-                             const baldr::GraphId& edgeid,
-                             const uint64_t current_time,
-                             const uint32_t tz_index,
-                             bool& has_time_restrictions) const {
-  if (!(edge->forwardaccess() & access_mask_) || (edge->surface() > minimal_allowed_surface_) ||
-      edge->is_shortcut() || IsUserAvoidEdge(edgeid) || edge->sac_scale() > max_hiking_difficulty_ ||
-      //      (edge->max_up_slope() > max_grade_ || edge->max_down_slope() > max_grade_) ||
-      ((pred.path_distance() + edge->length()) > max_distance_)) {
-    return false;
-  }
-  // Disallow transit connections (except when set for multi-modal routes)
-  if (!allow_transit_connections_ &&
-      (edge->use() == Use::kPlatformConnection || edge->use() == Use::kEgressConnection ||
-       edge->use() == Use::kTransitConnection)) {
-    return false;
-  }
-
-  return DynamicCost::EvaluateRestrictions(access_mask_, edge, tile, edgeid, current_time, tz_index,
-                                           has_time_restrictions);
-}
-
-// Checks if access is allowed for an edge on the reverse path (from
-// destination towards origin). Both opposing edges are provided.
-bool PedestrianCost::AllowedReverse(const baldr::DirectedEdge* edge,
-                                    const EdgeLabel& pred,
-                                    const baldr::DirectedEdge* opp_edge,
-                                    const baldr::GraphTile*& tile,
-                                    const baldr::GraphId& opp_edgeid,
-                                    const uint64_t current_time,
-                                    const uint32_t tz_index,
-                                    bool& has_time_restrictions) const {
-  // TODO - obtain and check the access restrictions.
-
-  // Do not check max walking distance and assume we are not allowing
-  // transit connections. Assume this method is never used in
-  // multimodal routes).
-  if (!(opp_edge->forwardaccess() & access_mask_) ||
-      (opp_edge->surface() > minimal_allowed_surface_) || opp_edge->is_shortcut() ||
-      IsUserAvoidEdge(opp_edgeid) || edge->sac_scale() > max_hiking_difficulty_ ||
-      //      (opp_edge->max_up_slope() > max_grade_ || opp_edge->max_down_slope() > max_grade_) ||
-      opp_edge->use() == Use::kTransitConnection || opp_edge->use() == Use::kEgressConnection ||
-      opp_edge->use() == Use::kPlatformConnection) {
-    return false;
-  }
-
-  return DynamicCost::EvaluateRestrictions(access_mask_, edge, tile, opp_edgeid, current_time,
-                                           tz_index, has_time_restrictions);
-}
-
-// Returns the cost to traverse the edge and an estimate of the actual time
-// (in seconds) to traverse the edge.
-Cost PedestrianCost::EdgeCost(const baldr::DirectedEdge* edge,
-                              const baldr::GraphTile* tile,
-                              const uint32_t seconds) const {
-
-  // Ferries are a special case - they use the ferry speed (stored on the edge)
-  if (edge->use() == Use::kFerry) {
-    auto speed = tile->GetSpeed(edge, flow_mask_, seconds);
-    float sec = edge->length() * (kSecPerHour * 0.001f) / static_cast<float>(speed);
-    return {sec * ferry_factor_, sec};
-  }
-
-  // TODO - consider using an array of "use factors" to avoid this conditional
-  float factor = 1.0f + kSacScaleCostFactor[static_cast<uint8_t>(edge->sac_scale())];
-  if (edge->use() == Use::kFootway || edge->use() == Use::kSidewalk) {
-    factor *= walkway_factor_;
-  } else if (edge->use() == Use::kAlley) {
-    factor *= alley_factor_;
-  } else if (edge->use() == Use::kDriveway) {
-    factor *= driveway_factor_;
-  } else if (edge->sidewalk_left() || edge->sidewalk_right()) {
-    factor *= sidewalk_factor_;
-  } else if (edge->roundabout()) {
-    factor *= kRoundaboutFactor;
-  }
-
-  // Slightly favor walkways/paths and penalize alleys and driveways.
-  float sec =
-      edge->length() * speedfactor_ * kSacScaleSpeedFactor[static_cast<uint8_t>(edge->sac_scale())];
-  return {sec * factor, sec};
-}
-
-// Returns the time (in seconds) to make the transition from the predecessor
-Cost PedestrianCost::TransitionCost(const baldr::DirectedEdge* edge,
-                                    const baldr::NodeInfo* node,
-                                    const EdgeLabel& pred) const {
-  // Special cases: fixed penalty for steps/stairs
-  if (edge->use() == Use::kSteps) {
-    return {step_penalty_, 0.0f};
-  }
-
-  // Get the transition cost for country crossing, ferry, gate, toll booth,
-  // destination only, alley, maneuver penalty
-  uint32_t idx = pred.opp_local_idx();
-  Cost c = base_transition_cost(node, edge, pred, idx);
-
-  // Costs for crossing an intersection.
-  if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-    float seconds = kCrossingCosts[edge->stopimpact(idx)];
-    c.secs += seconds;
-    c.cost += seconds;
-  }
-  return c;
-}
-
-// Returns the cost to make the transition from the predecessor edge
-// when using a reverse search (from destination towards the origin).
-// Defaults to 0. Costing models that wish to include edge transition
-// costs (i.e., intersection/turn costs) must override this method.
-Cost PedestrianCost::TransitionCostReverse(const uint32_t idx,
-                                           const baldr::NodeInfo* node,
-                                           const baldr::DirectedEdge* pred,
-                                           const baldr::DirectedEdge* edge) const {
-  // Special cases: fixed penalty for steps/stairs
-  if (edge->use() == Use::kSteps) {
-    return {step_penalty_, 0.0f};
-  }
-
-  // Get the transition cost for country crossing, ferry, gate, toll booth,
-  // destination only, alley, maneuver penalty
-  Cost c = base_transition_cost(node, edge, pred, idx);
-
-  // Costs for crossing an intersection.
-  if (edge->edge_to_right(idx) && edge->edge_to_left(idx)) {
-    float seconds = kCrossingCosts[edge->stopimpact(idx)];
-    c.secs += seconds;
-    c.cost += seconds;
-  }
-  return c;
-}
-
 void ParsePedestrianCostOptions(const rapidjson::Document& doc,
                                 const std::string& costing_options_key,
                                 CostingOptions* pbf_costing_options) {
@@ -1,17 +1,24 @@
 #include "skadi/sample.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <fstream>
 #include <limits>
 #include <list>
+#include <mutex>
 #include <regex>
 #include <stdexcept>
 #include <string>
 #include <sys/stat.h>
+#include <unordered_map>
 
 #include <boost/optional.hpp>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "baldr/compression_utils.h"
 #include "filesystem.h"
 #include "midgard/logging.h"
@@ -101,14 +108,227 @@ uint64_t file_size(const std::string& file_name) {
   return rc == 0 ? s.st_size : -1;
 }
 
+template <class coord_t> uint16_t tile_index(const coord_t& coord) {
+  auto lon = std::floor(coord.first);
+  auto lat = std::floor(coord.second);
+  return static_cast<uint16_t>(lat + 90) * 360 + static_cast<uint16_t>(lon + 180);
+}
+
+template <class coord_t> double interpolate(const coord_t& coord, const int16_t* t) {
+  auto lon = std::floor(coord.first);
+  auto lat = std::floor(coord.second);
+
+  // figure out what row and column we need from the array of data
+  // NOTE: data is arranged from upper left to bottom right, so y is flipped
+
+  // fractional pixel
+  double u = (coord.first - lon) * (HGT_DIM - 1);
+  double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
+
+  // integer pixel
+  size_t x = std::floor(u);
+  size_t y = std::floor(v);
+
+  // coefficients
+  double u_ratio = u - x;
+  double v_ratio = v - y;
+  double u_inv = 1 - u_ratio;
+  double v_inv = 1 - v_ratio;
+  double a_coef = u_inv * v_inv;
+  double b_coef = u_ratio * v_inv;
+  double c_coef = u_inv * v_ratio;
+  double d_coef = u_ratio * v_ratio;
+
+  // values
+  double adjust = 0;
+  auto a = flip(t[y * HGT_DIM + x]);
+  auto b = flip(t[y * HGT_DIM + x + 1]);
+  if (out_of_range(a)) {
+    a_coef = 0;
+  }
+  if (out_of_range(b)) {
+    b_coef = 0;
+  }
+
+  // first part of the bilinear interpolation
+  auto value = a * a_coef + b * b_coef;
+  adjust += a_coef + b_coef;
+  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x) + ',' + std::to_string(a) + '}');
+  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x + 1) + ',' + std::to_string(b) + '}');
+  // only need the second part if you aren't right on the row
+  // this also protects from a corner case where you sample past the end of the image
+  if (y < HGT_DIM - 1) {
+    auto c = flip(t[(y + 1) * HGT_DIM + x]);
+    auto d = flip(t[(y + 1) * HGT_DIM + x + 1]);
+    if (out_of_range(c)) {
+      c_coef = 0;
+    }
+    if (out_of_range(d)) {
+      d_coef = 0;
+    }
+    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x) + ',' + std::to_string(c) + '}');
+    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x + 1) + ',' + std::to_string(d) + '}');
+    value += c * c_coef + d * d_coef;
+    adjust += c_coef + d_coef;
+  }
+  // if we are missing everything then give up
+  if (adjust == 0) {
+    return NO_DATA_VALUE;
+  }
+  // if we were missing some we need to adjust by that
+  return value / adjust;
+}
+
+// number of postings interpolate_tile works on at a time
+constexpr size_t BATCH_SIZE = 64;
+
+// the four pixels around each posting of a batch and where in between them it is
+struct batch_t {
+  alignas(16) int16_t raw[4][BATCH_SIZE];    // a, b, c, d pixels as stored (big endian)
+  alignas(16) double pixels[4][BATCH_SIZE];  // a, b, c, d pixels
+  alignas(16) double u_ratio[BATCH_SIZE];    // fraction of the way from a to b
+  alignas(16) double v_ratio[BATCH_SIZE];    // fraction of the way from a to c
+  alignas(16) double values[BATCH_SIZE];     // interpolated values
+};
+
+// swaps the bytes of the raw pixels and widens them to doubles
+void flip_batch(batch_t& batch, const size_t count) {
+  for (size_t p = 0; p < 4; ++p) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+      __m128i raw = _mm_load_si128(reinterpret_cast<const __m128i*>(batch.raw[p] + i));
+      raw = _mm_or_si128(_mm_slli_epi16(raw, 8), _mm_srli_epi16(raw, 8));
+      // sign extend to 32 bits by putting each value in the high half and shifting it down
+      __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+      __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+      _mm_store_pd(batch.pixels[p] + i, _mm_cvtepi32_pd(lo));
+      _mm_store_pd(batch.pixels[p] + i + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(lo, 0x4e)));
+      _mm_store_pd(batch.pixels[p] + i + 4, _mm_cvtepi32_pd(hi));
+      _mm_store_pd(batch.pixels[p] + i + 6, _mm_cvtepi32_pd(_mm_shuffle_epi32(hi, 0x4e)));
+    }
+#endif
+    for (; i < count; ++i) {
+      batch.pixels[p][i] = flip(batch.raw[p][i]);
+    }
+  }
+}
+
+// bilinear interpolation of the flipped pixels, the same arithmetic as interpolate
+void weigh_batch(batch_t& batch, const size_t count) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d high = _mm_set1_pd(NO_DATA_HIGH);
+  const __m128d low = _mm_set1_pd(NO_DATA_LOW);
+  const __m128d no_data = _mm_set1_pd(NO_DATA_VALUE);
+  // pixels that are out of range get no weight
+  auto in_range = [&high, &low](const __m128d v, const __m128d coef) {
+    return _mm_and_pd(coef, _mm_and_pd(_mm_cmple_pd(v, high), _mm_cmpge_pd(v, low)));
+  };
+  for (; i + 2 <= count; i += 2) {
+    __m128d u_ratio = _mm_load_pd(batch.u_ratio + i);
+    __m128d v_ratio = _mm_load_pd(batch.v_ratio + i);
+    __m128d u_inv = _mm_sub_pd(one, u_ratio);
+    __m128d v_inv = _mm_sub_pd(one, v_ratio);
+    __m128d a = _mm_load_pd(batch.pixels[0] + i);
+    __m128d b = _mm_load_pd(batch.pixels[1] + i);
+    __m128d c = _mm_load_pd(batch.pixels[2] + i);
+    __m128d d = _mm_load_pd(batch.pixels[3] + i);
+    __m128d a_coef = in_range(a, _mm_mul_pd(u_inv, v_inv));
+    __m128d b_coef = in_range(b, _mm_mul_pd(u_ratio, v_inv));
+    __m128d c_coef = in_range(c, _mm_mul_pd(u_inv, v_ratio));
+    __m128d d_coef = in_range(d, _mm_mul_pd(u_ratio, v_ratio));
+
+    __m128d value = _mm_add_pd(_mm_mul_pd(a, a_coef), _mm_mul_pd(b, b_coef));
+    __m128d adjust = _mm_add_pd(a_coef, b_coef);
+    value = _mm_add_pd(value, _mm_add_pd(_mm_mul_pd(c, c_coef), _mm_mul_pd(d, d_coef)));
+    adjust = _mm_add_pd(adjust, _mm_add_pd(c_coef, d_coef));
+
+    // no data where we are missing everything
+    __m128d missing = _mm_cmpeq_pd(adjust, zero);
+    __m128d result = _mm_div_pd(value, adjust);
+    _mm_store_pd(batch.values + i,
+                 _mm_or_pd(_mm_and_pd(missing, no_data), _mm_andnot_pd(missing, result)));
+  }
+#endif
+  for (; i < count; ++i) {
+    double u_inv = 1 - batch.u_ratio[i];
+    double v_inv = 1 - batch.v_ratio[i];
+    double a = batch.pixels[0][i], b = batch.pixels[1][i];
+    double c = batch.pixels[2][i], d = batch.pixels[3][i];
+    double a_coef = out_of_range(a) ? 0 : u_inv * v_inv;
+    double b_coef = out_of_range(b) ? 0 : batch.u_ratio[i] * v_inv;
+    double c_coef = out_of_range(c) ? 0 : u_inv * batch.v_ratio[i];
+    double d_coef = out_of_range(d) ? 0 : batch.u_ratio[i] * batch.v_ratio[i];
+    double value = a * a_coef + b * b_coef;
+    double adjust = a_coef + b_coef;
+    value += c * c_coef + d * d_coef;
+    adjust += c_coef + d_coef;
+    batch.values[i] = adjust == 0 ? NO_DATA_VALUE : value / adjust;
+  }
+}
+
+/**
+ * Interpolates the postings that are all in the same tile, a batch at a
+ * time: the pixels are gathered first, then flipped and weighed together.
+ * Gives the same values as interpolate.
+ * @param postings  the postings
+ * @param ranges    ranges of consecutive postings in the tile
+ * @param t         the data of the tile
+ * @param values    where to put the values, by posting index
+ */
+template <class posting_t>
+void interpolate_tile(const std::vector<const posting_t*>& postings,
+                     const std::vector<std::pair<size_t, size_t>>& ranges,
+                     const int16_t* t,
+                     std::vector<double>& values) {
+  batch_t batch{};
+  for (const auto& range : ranges) {
+    for (size_t begin = range.first; begin < range.second; begin += BATCH_SIZE) {
+      size_t count = std::min<size_t>(range.second - begin, BATCH_SIZE);
+
+      // gather the pixels around each posting, see interpolate
+      for (size_t i = 0; i < count; ++i) {
+        const auto& coord = *postings[begin + i];
+        auto lon = std::floor(coord.first);
+        auto lat = std::floor(coord.second);
+        double u = (coord.first - lon) * (HGT_DIM - 1);
+        double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
+        size_t x = std::floor(u);
+        size_t y = std::floor(v);
+        batch.u_ratio[i] = u - x;
+        batch.v_ratio[i] = v - y;
+        batch.raw[0][i] = t[y * HGT_DIM + x];
+        batch.raw[1][i] = t[y * HGT_DIM + x + 1];
+        // there is no row below the last one, that is the same as it having no data
+        if (y < HGT_DIM - 1) {
+          batch.raw[2][i] = t[(y + 1) * HGT_DIM + x];
+          batch.raw[3][i] = t[(y + 1) * HGT_DIM + x + 1];
+        } else {
+          batch.raw[2][i] = batch.raw[3][i] = flip(NO_DATA_VALUE);
+        }
+      }
+
+      flip_batch(batch, count);
+      weigh_batch(batch, count);
+      for (size_t i = 0; i < count; ++i) {
+        values[begin + i] = batch.values[i];
+      }
+    }
+  }
+}
+
 } // namespace
 
 namespace valhalla {
 namespace skadi {
 
-::valhalla::skadi::sample::sample(const std::string& data_source)
-    : mapped_cache(TILE_COUNT), unzipped_cache(-1, std::vector<int16_t>(HGT_PIXELS)),
-      data_source(data_source) {
+::valhalla::skadi::sample::sample(const std::string& data_source, size_t max_unzipped_bytes)
+    : mapped_cache(TILE_COUNT),
+      max_unzipped_tiles(std::max<size_t>(max_unzipped_bytes / HGT_BYTES, 1)),
+      cache_lock(new std::mutex), data_source(data_source) {
   // messy but needed
   while (this->data_source.size() &&
          this->data_source.back() == filesystem::path::preferred_separator) {
@@ -133,13 +353,14 @@ namespace skadi {
   }
 }
 
-const int16_t* sample::source(uint16_t index) const {
+std::shared_ptr<const int16_t> sample::source(uint16_t index) const {
   // bail if its out of bounds
   if (index >= TILE_COUNT) {
     return nullptr;
   }
 
   // if we dont have anything maybe its lazy loaded
+  std::unique_lock<std::mutex> lock(*cache_lock);
   auto& mapped = mapped_cache[index];
   if (mapped.second.get() == nullptr) {
     auto f = data_source + name_hgt(index);
@@ -151,15 +372,18 @@ const int16_t* sample::source(uint16_t index) const {
     mapped.second.map(f, size, POSIX_MADV_SEQUENTIAL);
   }
 
-  // we have it raw or we dont
+  // we have it raw or we dont, maps are never unmapped so it needs no owner
   if (mapped.first == format_t::RAW) {
-    return static_cast<const int16_t*>(static_cast<const void*>(mapped.second.get()));
+    return std::shared_ptr<const int16_t>(std::shared_ptr<const int16_t>(),
+                                          static_cast<const int16_t*>(
+                                              static_cast<const void*>(mapped.second.get())));
   }
 
   // if we have it already unzipped
-  if (unzipped_cache.first == index) {
-    return unzipped_cache.second.data();
+  if (auto unzipped = get_unzipped(index)) {
+    return std::shared_ptr<const int16_t>(unzipped, unzipped->data());
   }
+  lock.unlock();
 
   // for setting where to read compressed data from
   auto src_func = [&mapped](z_stream& s) -> void {
@@ -168,103 +392,86 @@ const int16_t* sample::source(uint16_t index) const {
   };
 
   // for setting where to write the uncompressed data to
-  auto dst_func = [this](z_stream& s) -> int {
-    s.next_out = static_cast<Byte*>(static_cast<void*>(unzipped_cache.second.data()));
+  auto unzipped = std::make_shared<std::vector<int16_t>>(HGT_PIXELS);
+  auto dst_func = [&unzipped](z_stream& s) -> int {
+    s.next_out = static_cast<Byte*>(static_cast<void*>(unzipped->data()));
     s.avail_out = HGT_BYTES;
     return Z_FINISH; // we know the output will hold all the input
   };
 
-  // we have to unzip it
+  // we have to unzip it, without holding the lock so other threads can sample other tiles
   if (!baldr::inflate(src_func, dst_func)) {
     LOG_WARN("Corrupt compressed elevation data");
-    unzipped_cache.first = -1;
     return nullptr;
   }
 
-  // update the simple cache
-  // TODO: LRU
-  unzipped_cache.first = index;
-  return unzipped_cache.second.data();
+  // keep it for next time
+  lock.lock();
+  auto cached = put_unzipped(index, std::move(unzipped));
+  return std::shared_ptr<const int16_t>(cached, cached->data());
 }
 
-template <class coord_t> double sample::get(const coord_t& coord) const {
-  // check the cache and load
-  auto lon = std::floor(coord.first);
-  auto lat = std::floor(coord.second);
-  auto index = static_cast<uint16_t>(lat + 90) * 360 + static_cast<uint16_t>(lon + 180);
-
-  // get the proper source of the data
-  const auto* t = source(index);
-  if (t == nullptr) {
-    return NO_DATA_VALUE;
+sample::unzipped_t sample::get_unzipped(uint16_t index) const {
+  auto found = unzipped_index.find(index);
+  if (found == unzipped_index.end()) {
+    return nullptr;
   }
+  unzipped_cache.splice(unzipped_cache.begin(), unzipped_cache, found->second);
+  return found->second->second;
+}
 
-  // figure out what row and column we need from the array of data
-  // NOTE: data is arranged from upper left to bottom right, so y is flipped
-
-  // fractional pixel
-  double u = (coord.first - lon) * (HGT_DIM - 1);
-  double v = (1.0 - (coord.second - lat)) * (HGT_DIM - 1);
-
-  // integer pixel
-  size_t x = std::floor(u);
-  size_t y = std::floor(v);
-
-  // coefficients
-  double u_ratio = u - x;
-  double v_ratio = v - y;
-  double u_inv = 1 - u_ratio;
-  double v_inv = 1 - v_ratio;
-  double a_coef = u_inv * v_inv;
-  double b_coef = u_ratio * v_inv;
-  double c_coef = u_inv * v_ratio;
-  double d_coef = u_ratio * v_ratio;
-
-  // values
-  double adjust = 0;
-  auto a = flip(t[y * HGT_DIM + x]);
-  auto b = flip(t[y * HGT_DIM + x + 1]);
-  if (out_of_range(a)) {
-    a_coef = 0;
-  }
-  if (out_of_range(b)) {
-    b_coef = 0;
+sample::unzipped_t sample::put_unzipped(uint16_t index, unzipped_t unzipped) const {
+  // another thread may have unzipped the same tile in the mean time
+  if (auto cached = get_unzipped(index)) {
+    return cached;
   }
 
-  // first part of the bilinear interpolation
-  auto value = a * a_coef + b * b_coef;
-  adjust += a_coef + b_coef;
-  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x) + ',' + std::to_string(a) + '}');
-  // LOG_INFO('{' + std::to_string(y * HGT_DIM + x + 1) + ',' + std::to_string(b) + '}');
-  // only need the second part if you aren't right on the row
-  // this also protects from a corner case where you sample past the end of the image
-  if (y < HGT_DIM - 1) {
-    auto c = flip(t[(y + 1) * HGT_DIM + x]);
-    auto d = flip(t[(y + 1) * HGT_DIM + x + 1]);
-    if (out_of_range(c)) {
-      c_coef = 0;
-    }
-    if (out_of_range(d)) {
-      d_coef = 0;
-    }
-    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x) + ',' + std::to_string(c) + '}');
-    // LOG_INFO('{' + std::to_string((y + 1) * HGT_DIM + x + 1) + ',' + std::to_string(d) + '}');
-    value += c * c_coef + d * d_coef;
-    adjust += c_coef + d_coef;
+  // drop the least recently used tiles, threads still sampling them keep them alive
+  while (unzipped_cache.size() >= max_unzipped_tiles) {
+    unzipped_index.erase(unzipped_cache.back().first);
+    unzipped_cache.pop_back();
   }
-  // if we are missing everything then give up
-  if (adjust == 0) {
+  unzipped_cache.emplace_front(index, std::move(unzipped));
+  unzipped_index.emplace(index, unzipped_cache.begin());
+  return unzipped_cache.front().second;
+}
+
+template <class coord_t> double sample::get(const coord_t& coord) const {
+  // get the proper source of the data
+  auto t = source(tile_index(coord));
+  if (t == nullptr) {
     return NO_DATA_VALUE;
   }
-  // if we were missing some we need to adjust by that
-  return value / adjust;
+  return interpolate(coord, t.get());
 }
 
 template <class coords_t> std::vector<double> sample::get_all(const coords_t& coords) const {
-  std::vector<double> values;
-  values.reserve(coords.size());
+  // group the postings by tile in one pass. postings usually come in long runs within a tile
+  // so each tile gets the ranges of consecutive postings in it
+  std::unordered_map<uint16_t, std::vector<std::pair<size_t, size_t>>> tiles;
+  std::vector<const typename coords_t::value_type*> postings;
+  postings.reserve(coords.size());
+  std::pair<size_t, size_t>* run = nullptr;
+  uint16_t run_index = 0;
   for (const auto& coord : coords) {
-    values.emplace_back(get(coord));
+    auto index = tile_index(coord);
+    if (run == nullptr || index != run_index) {
+      auto& ranges = tiles[index];
+      ranges.emplace_back(postings.size(), postings.size());
+      run = &ranges.back();
+      run_index = index;
+    }
+    postings.push_back(&coord);
+    run->second = postings.size();
+  }
+
+  // look each tile up once and interpolate all of its postings together
+  std::vector<double> values(postings.size(), NO_DATA_VALUE);
+  for (const auto& tile : tiles) {
+    auto t = source(tile.first);
+    if (t != nullptr) {
+      interpolate_tile(postings, tile.second, t.get(), values);
+    }
   }
   return values;
 }
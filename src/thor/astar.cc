@@ -215,7 +215,8 @@ void AStarPathAlgorithm::ExpandForward(GraphReader& graphreader,
       if (t2 == nullptr) {
         continue;
       }
-      sortcost += astarheuristic_.Get(t2->get_node_ll(directededge->endnode()), dist);
+      sortcost += astarheuristic_.Get(t2->get_node_ll(directededge->endnode()),
+                                      directededge->endnode(), dist);
     }
 
     // Add to the adjacency list and edge labels.
@@ -268,6 +269,13 @@ AStarPathAlgorithm::GetBestPath(valhalla::Location& origin,
   uint32_t density = SetDestination(graphreader, destination);
   SetOrigin(graphreader, origin, destination, kInvalidSecondsOfWeek);
 
+  // Tighten the A* heuristic with the landmarks, if there are any for this costing
+  const baldr::LandmarkTable* landmarks = landmark_table(costing_->access_mode());
+  if (landmarks != nullptr) {
+    astarheuristic_.InitLandmarks(landmarks, LandmarkTargets(graphreader, destination, true),
+                                  false);
+  }
+
   // Update hierarchy limits
   ModifyHierarchyLimits(mindist, density);
 
@@ -319,6 +327,11 @@ AStarPathAlgorithm::GetBestPath(valhalla::Location& origin,
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
 
+    // setting this edge as settled
+    if (expansion_callback_) {
+      expansion_callback_(graphreader, "astar", pred.edgeid(), "s", false);
+    }
+
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations
     float dist2dest = pred.distance();
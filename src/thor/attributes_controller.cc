@@ -1,6 +1,9 @@
 #include <thor/attributes_controller.h>
 
+#include <bitset>
+#include <cstring>
 #include <string>
+#include <unordered_map>
 
 namespace valhalla {
 namespace thor {
@@ -125,26 +128,193 @@ const std::unordered_map<std::string, bool> AttributesController::kDefaultAttrib
     {kShapeAttributesLength, false},
     {kShapeAttributesSpeed, false}};
 
+namespace {
+
+// All of the keys, in the order of their bits
+constexpr AttributeKey kAttributeKeys[] = {
+    kEdgeNames,
+    kEdgeLength,
+    kEdgeSpeed,
+    kEdgeRoadClass,
+    kEdgeBeginHeading,
+    kEdgeEndHeading,
+    kEdgeBeginShapeIndex,
+    kEdgeEndShapeIndex,
+    kEdgeTraversability,
+    kEdgeUse,
+    kEdgeToll,
+    kEdgeUnpaved,
+    kEdgeTunnel,
+    kEdgeBridge,
+    kEdgeRoundabout,
+    kEdgeInternalIntersection,
+    kEdgeDriveOnRight,
+    kEdgeSurface,
+    kEdgeSignExitNumber,
+    kEdgeSignExitBranch,
+    kEdgeSignExitToward,
+    kEdgeSignExitName,
+    kEdgeSignGuideBranch,
+    kEdgeSignGuideToward,
+    kEdgeSignJunctionName,
+    kEdgeSignGuidanceViewJunction,
+    kEdgeTravelMode,
+    kEdgeVehicleType,
+    kEdgePedestrianType,
+    kEdgeBicycleType,
+    kEdgeTransitType,
+    kEdgeTransitRouteInfoOnestopId,
+    kEdgeTransitRouteInfoBlockId,
+    kEdgeTransitRouteInfoTripId,
+    kEdgeTransitRouteInfoShortName,
+    kEdgeTransitRouteInfoLongName,
+    kEdgeTransitRouteInfoHeadsign,
+    kEdgeTransitRouteInfoColor,
+    kEdgeTransitRouteInfoTextColor,
+    kEdgeTransitRouteInfoDescription,
+    kEdgeTransitRouteInfoOperatorOnestopId,
+    kEdgeTransitRouteInfoOperatorName,
+    kEdgeTransitRouteInfoOperatorUrl,
+    kEdgeId,
+    kEdgeWayId,
+    kEdgeWeightedGrade,
+    kEdgeMaxUpwardGrade,
+    kEdgeMaxDownwardGrade,
+    kEdgeMeanElevation,
+    kEdgeLaneCount,
+    kEdgeLaneConnectivity,
+    kEdgeCycleLane,
+    kEdgeBicycleNetwork,
+    kEdgeSidewalk,
+    kEdgeDensity,
+    kEdgeSpeedLimit,
+    kEdgeTruckSpeed,
+    kEdgeTruckRoute,
+    kNodeIntersectingEdgeBeginHeading,
+    kNodeIntersectingEdgeFromEdgeNameConsistency,
+    kNodeIntersectingEdgeToEdgeNameConsistency,
+    kNodeIntersectingEdgeDriveability,
+    kNodeIntersectingEdgeCyclability,
+    kNodeIntersectingEdgeWalkability,
+    kNodeIntersectingEdgeUse,
+    kNodeIntersectingEdgeRoadClass,
+    kNodeElapsedTime,
+    kNodeaAdminIndex,
+    kNodeType,
+    kNodeFork,
+    kNodeTransitPlatformInfoType,
+    kNodeTransitPlatformInfoOnestopId,
+    kNodeTransitPlatformInfoName,
+    kNodeTransitPlatformInfoStationOnestopId,
+    kNodeTransitPlatformInfoStationName,
+    kNodeTransitPlatformInfoArrivalDateTime,
+    kNodeTransitPlatformInfoDepartureDateTime,
+    kNodeTransitPlatformInfoIsParentStop,
+    kNodeTransitPlatformInfoAssumedSchedule,
+    kNodeTransitPlatformInfoLatLon,
+    kNodeTransitStationInfoOnestopId,
+    kNodeTransitStationInfoName,
+    kNodeTransitStationInfoLatLon,
+    kNodeTransitEgressInfoOnestopId,
+    kNodeTransitEgressInfoName,
+    kNodeTransitEgressInfoLatLon,
+    kNodeTimeZone,
+    kNodeTransitionTime,
+    kOsmChangeset,
+    kAdminCountryCode,
+    kAdminCountryText,
+    kAdminStateCode,
+    kAdminStateText,
+    kShape,
+    kMatchedPoint,
+    kMatchedType,
+    kMatchedEdgeIndex,
+    kMatchedBeginRouteDiscontinuity,
+    kMatchedEndRouteDiscontinuity,
+    kMatchedDistanceAlongEdge,
+    kMatchedDistanceFromTracePoint,
+    kConfidenceScore,
+    kRawScore,
+    kShapeAttributesTime,
+    kShapeAttributesLength,
+    kShapeAttributesSpeed,
+};
+static_assert(sizeof(kAttributeKeys) / sizeof(kAttributeKeys[0]) == kAttributeCount,
+              "Every attribute key needs to be in kAttributeKeys");
+
+constexpr bool bits_in_order(size_t i = 0) {
+  return i == kAttributeCount || (kAttributeKeys[i].bit == i && bits_in_order(i + 1));
+}
+static_assert(bits_in_order(), "Attribute keys need to use the bits [0, kAttributeCount) in order");
+
+using attributes_t = std::bitset<kAttributeCount>;
+
+// The bits of the attributes by their names
+const std::unordered_map<std::string, uint8_t>& bits() {
+  static const std::unordered_map<std::string, uint8_t> bits = []() {
+    std::unordered_map<std::string, uint8_t> bits;
+    for (const auto& key : kAttributeKeys) {
+      bits.emplace(key.name, key.bit);
+    }
+    return bits;
+  }();
+  return bits;
+}
+
+// The attributes whose names start with the category
+attributes_t category_attributes(const std::string& category) {
+  attributes_t attributes;
+  for (const auto& key : kAttributeKeys) {
+    if (std::strncmp(key.name, category.c_str(), category.size()) == 0) {
+      attributes.set(key.bit);
+    }
+  }
+  return attributes;
+}
+
+} // namespace
+
 AttributesController::AttributesController() {
-  attributes = kDefaultAttributes;
+  static const attributes_t defaults = []() {
+    attributes_t defaults;
+    for (const auto& key_enabled : kDefaultAttributes) {
+      defaults[bits().at(key_enabled.first)] = key_enabled.second;
+    }
+    return defaults;
+  }();
+  attributes = defaults;
 }
 
 void AttributesController::disable_all() {
-  for (auto& pair : attributes) {
-    pair.second = false;
-  }
+  attributes.reset();
 }
 
 // Used to check if any keys starting with the `category` string are enabled.
 bool AttributesController::category_attribute_enabled(const std::string& category) const {
-  for (const auto& pair : attributes) {
-    // if the key starts with the specified category and it is enabled
-    // then return true
-    if ((pair.first.compare(0, category.size(), category) == 0) && pair.second) {
-      return true;
-    }
+  // the categories we know of are worked out once
+  static const std::unordered_map<std::string, attributes_t> categories = {
+      {kNodeCategory, category_attributes(kNodeCategory)},
+      {kAdminCategory, category_attributes(kAdminCategory)},
+      {kMatchedCategory, category_attributes(kMatchedCategory)},
+      {kShapeAttributesCategory, category_attributes(kShapeAttributesCategory)},
+  };
+  auto found = categories.find(category);
+  return (attributes & (found != categories.cend() ? found->second
+                                                   : category_attributes(category)))
+      .any();
+}
+
+bool AttributesController::operator()(const std::string& name) const {
+  return attributes[bits().at(name)];
+}
+
+bool AttributesController::set(const std::string& name, bool enabled) {
+  auto found = bits().find(name);
+  if (found == bits().cend()) {
+    return false;
   }
-  return false;
+  attributes[found->second] = enabled;
+  return true;
 }
 
 } // namespace thor
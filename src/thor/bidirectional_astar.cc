@@ -31,14 +31,13 @@ namespace valhalla {
 namespace thor {
 
 // Default constructor
-BidirectionalAStar::BidirectionalAStar() : PathAlgorithm() {
+BidirectionalAStar::BidirectionalAStar(const BucketQueueMode queue_mode)
+    : PathAlgorithm(), adjacencylist_forward_(queue_mode), adjacencylist_reverse_(queue_mode) {
   threshold_ = 0;
   mode_ = TravelMode::kDrive;
   access_mode_ = kAutoAccess;
   travel_type_ = 0;
   cost_diff_ = 0.0f;
-  adjacencylist_forward_ = nullptr;
-  adjacencylist_reverse_ = nullptr;
 }
 
 // Destructor
@@ -50,8 +49,8 @@ BidirectionalAStar::~BidirectionalAStar() {
 void BidirectionalAStar::Clear() {
   edgelabels_forward_.clear();
   edgelabels_reverse_.clear();
-  adjacencylist_forward_.reset();
-  adjacencylist_reverse_.reset();
+  adjacencylist_forward_.clear();
+  adjacencylist_reverse_.clear();
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
 
@@ -72,22 +71,14 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   edgelabels_forward_.reserve(kInitialEdgeLabelCountBD);
   edgelabels_reverse_.reserve(kInitialEdgeLabelCountBD);
 
-  // Set up lambdas to get sort costs
-  const auto forward_edgecost = [this](const uint32_t label) {
-    return edgelabels_forward_[label].sortcost();
-  };
-  const auto reverse_edgecost = [this](const uint32_t label) {
-    return edgelabels_reverse_[label].sortcost();
-  };
-
   // Construct adjacency list and initialize edge status lookup.
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
   float mincostf = astarheuristic_forward_.Get(origll);
-  adjacencylist_forward_.reset(new DoubleBucketQueue(mincostf, range, bucketsize, forward_edgecost));
+  adjacencylist_forward_.reset(mincostf, range, bucketsize, &edgelabels_forward_);
   float mincostr = astarheuristic_reverse_.Get(destll);
-  adjacencylist_reverse_.reset(new DoubleBucketQueue(mincostr, range, bucketsize, reverse_edgecost));
+  adjacencylist_reverse_.reset(mincostr, range, bucketsize, &edgelabels_reverse_);
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
 
@@ -109,7 +100,9 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
 }
 
 // Returns true if function ended up adding an edge for expansion
-bool BidirectionalAStar::ExpandForward(GraphReader& graphreader,
+template <typename cost_t>
+bool BidirectionalAStar::ExpandForward(const StaticCost<cost_t> costing,
+                                       GraphReader& graphreader,
                                        const GraphId& node,
                                        BDEdgeLabel& pred,
                                        const uint32_t pred_idx,
@@ -121,7 +114,7 @@ bool BidirectionalAStar::ExpandForward(GraphReader& graphreader,
     return false;
   }
   const NodeInfo* nodeinfo = tile->node(node);
-  if (!costing_->Allowed(nodeinfo)) {
+  if (!costing.Allowed(nodeinfo)) {
     return false;
   }
 
@@ -146,7 +139,7 @@ bool BidirectionalAStar::ExpandForward(GraphReader& graphreader,
     }
 
     found_valid_edge =
-        ExpandForwardInner(graphreader, pred, nodeinfo, pred_idx, meta, shortcuts, tile) ||
+        ExpandForwardInner(costing, graphreader, pred, nodeinfo, pred_idx, meta, shortcuts, tile) ||
         found_valid_edge;
   }
 
@@ -157,10 +150,12 @@ bool BidirectionalAStar::ExpandForward(GraphReader& graphreader,
       if (trans->up()) {
         hierarchy_limits_forward_[node.level()].up_transition_count++;
         found_valid_edge =
-            ExpandForward(graphreader, trans->endnode(), pred, pred_idx, true) || found_valid_edge;
+            ExpandForward(costing, graphreader, trans->endnode(), pred, pred_idx, true) ||
+            found_valid_edge;
       } else if (!hierarchy_limits_forward_[trans->endnode().level()].StopExpanding()) {
         found_valid_edge =
-            ExpandForward(graphreader, trans->endnode(), pred, pred_idx, true) || found_valid_edge;
+            ExpandForward(costing, graphreader, trans->endnode(), pred, pred_idx, true) ||
+            found_valid_edge;
       }
     }
   }
@@ -184,8 +179,8 @@ bool BidirectionalAStar::ExpandForward(GraphReader& graphreader,
         found_valid_edge = true;
       } else {
         // We didn't add any shortcut of the uturn, therefore evaluate the regular uturn instead
-        bool uturn_added =
-            ExpandForwardInner(graphreader, pred, nodeinfo, pred_idx, uturn_meta, shortcuts, tile);
+        bool uturn_added = ExpandForwardInner(costing, graphreader, pred, nodeinfo, pred_idx,
+                                              uturn_meta, shortcuts, tile);
         found_valid_edge = found_valid_edge || uturn_added;
       }
     }
@@ -200,7 +195,9 @@ bool BidirectionalAStar::ExpandForward(GraphReader& graphreader,
 // TODO: Merge this with ExpandReverseInner
 //
 // Returns true if any edge _could_ have been expanded after restrictions etc.
-inline bool BidirectionalAStar::ExpandForwardInner(GraphReader& graphreader,
+template <typename cost_t>
+inline bool BidirectionalAStar::ExpandForwardInner(const StaticCost<cost_t> costing,
+                                                   GraphReader& graphreader,
                                                    const BDEdgeLabel& pred,
                                                    const NodeInfo* nodeinfo,
                                                    const uint32_t pred_idx,
@@ -231,17 +228,17 @@ inline bool BidirectionalAStar::ExpandForwardInner(GraphReader& graphreader,
   const uint64_t localtime = 0; // Bidirectional is not yet time-aware
   const uint32_t tz_index = 0;
   bool has_time_restrictions = false;
-  if (!costing_->Allowed(meta.edge, pred, tile, meta.edge_id, localtime, tz_index,
-                         has_time_restrictions) ||
-      costing_->Restricted(meta.edge, pred, edgelabels_forward_, tile, meta.edge_id, true,
-                           &edgestatus_forward_, localtime, tz_index)) {
+  if (!costing.Allowed(meta.edge, pred, tile, meta.edge_id, localtime, tz_index,
+                       has_time_restrictions) ||
+      costing->Restricted(meta.edge, pred, edgelabels_forward_, tile, meta.edge_id, true,
+                          &edgestatus_forward_, localtime, tz_index)) {
     return false;
   }
 
   // Get cost. Separate out transition cost.
-  Cost transition_cost = costing_->TransitionCost(meta.edge, nodeinfo, pred);
+  Cost transition_cost = costing.TransitionCost(meta.edge, nodeinfo, pred);
   Cost newcost = pred.cost() + transition_cost +
-                 costing_->EdgeCost(meta.edge, tile, kConstrainedFlowSecondOfDay);
+                 costing.EdgeCost(meta.edge, tile, kConstrainedFlowSecondOfDay);
 
   // Check if edge is temporarily labeled and this path has less cost. If
   // less cost the predecessor is updated and the sort cost is decremented
@@ -250,7 +247,7 @@ inline bool BidirectionalAStar::ExpandForwardInner(GraphReader& graphreader,
     BDEdgeLabel& lab = edgelabels_forward_[meta.edge_status->index()];
     if (newcost.cost < lab.cost().cost) {
       float newsortcost = lab.sortcost() - (lab.cost().cost - newcost.cost);
-      adjacencylist_forward_->decrease(meta.edge_status->index(), newsortcost);
+      adjacencylist_forward_.decrease(meta.edge_status->index(), newsortcost);
       lab.Update(pred_idx, newcost, newsortcost, transition_cost, has_time_restrictions);
     }
     return true; // Returning true since this means we approved the edge
@@ -268,7 +265,8 @@ inline bool BidirectionalAStar::ExpandForwardInner(GraphReader& graphreader,
   // end node of the directed edge.
   float dist = 0.0f;
   float sortcost =
-      newcost.cost + astarheuristic_forward_.Get(t2->get_node_ll(meta.edge->endnode()), dist);
+      newcost.cost + astarheuristic_forward_.Get(t2->get_node_ll(meta.edge->endnode()),
+                                                 meta.edge->endnode(), dist);
 
   // Add edge label, add to the adjacency list and set edge status
   uint32_t idx = edgelabels_forward_.size();
@@ -277,7 +275,7 @@ inline bool BidirectionalAStar::ExpandForwardInner(GraphReader& graphreader,
                                    (pred.not_thru_pruning() || !meta.edge->not_thru()),
                                    has_time_restrictions);
 
-  adjacencylist_forward_->add(idx);
+  adjacencylist_forward_.add(idx);
   *meta.edge_status = {EdgeSet::kTemporary, idx};
 
   // setting this edge as reached
@@ -290,7 +288,9 @@ inline bool BidirectionalAStar::ExpandForwardInner(GraphReader& graphreader,
 // Expand from a node in reverse direction.
 //
 // Returns true if function ended up adding an edge for expansion
-bool BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
+template <typename cost_t>
+bool BidirectionalAStar::ExpandReverse(const StaticCost<cost_t> costing,
+                                       GraphReader& graphreader,
                                        const GraphId& node,
                                        BDEdgeLabel& pred,
                                        const uint32_t pred_idx,
@@ -303,7 +303,7 @@ bool BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
     return false;
   }
   const NodeInfo* nodeinfo = tile->node(node);
-  if (!costing_->Allowed(nodeinfo)) {
+  if (!costing.Allowed(nodeinfo)) {
     return false;
   }
 
@@ -327,8 +327,8 @@ bool BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
       continue;
     }
 
-    edge_was_added = ExpandReverseInner(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx, meta,
-                                        shortcuts, tile) ||
+    edge_was_added = ExpandReverseInner(costing, graphreader, pred, opp_pred_edge, nodeinfo,
+                                        pred_idx, meta, shortcuts, tile) ||
                      edge_was_added;
   }
 
@@ -338,13 +338,13 @@ bool BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
       if (trans->up()) {
         hierarchy_limits_reverse_[node.level()].up_transition_count++;
-        edge_was_added =
-            ExpandReverse(graphreader, trans->endnode(), pred, pred_idx, opp_pred_edge, true) ||
-            edge_was_added;
+        edge_was_added = ExpandReverse(costing, graphreader, trans->endnode(), pred, pred_idx,
+                                       opp_pred_edge, true) ||
+                         edge_was_added;
       } else if (!hierarchy_limits_reverse_[trans->endnode().level()].StopExpanding()) {
-        edge_was_added =
-            ExpandReverse(graphreader, trans->endnode(), pred, pred_idx, opp_pred_edge, true) ||
-            edge_was_added;
+        edge_was_added = ExpandReverse(costing, graphreader, trans->endnode(), pred, pred_idx,
+                                       opp_pred_edge, true) ||
+                         edge_was_added;
       }
     }
   }
@@ -368,8 +368,8 @@ bool BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
         edge_was_added = true;
       } else {
         // We didn't add any shortcut of the uturn, therefore evaluate the regular uturn instead
-        edge_was_added = ExpandReverseInner(graphreader, pred, opp_pred_edge, nodeinfo, pred_idx,
-                                            uturn_meta, shortcuts, tile) ||
+        edge_was_added = ExpandReverseInner(costing, graphreader, pred, opp_pred_edge, nodeinfo,
+                                            pred_idx, uturn_meta, shortcuts, tile) ||
                          edge_was_added;
       }
     }
@@ -383,7 +383,9 @@ bool BidirectionalAStar::ExpandReverse(GraphReader& graphreader,
 // TODO: Merge this with ExpandForwardInner
 //
 // Returns true if any edge _could_ have been expanded after restrictions etc.
-inline bool BidirectionalAStar::ExpandReverseInner(GraphReader& graphreader,
+template <typename cost_t>
+inline bool BidirectionalAStar::ExpandReverseInner(const StaticCost<cost_t> costing,
+                                                   GraphReader& graphreader,
                                                    const BDEdgeLabel& pred,
                                                    const DirectedEdge* opp_pred_edge,
                                                    const NodeInfo* nodeinfo,
@@ -430,18 +432,18 @@ inline bool BidirectionalAStar::ExpandReverseInner(GraphReader& graphreader,
   const uint64_t localtime = 0; // Bidirectional is not yet time-aware
   const uint32_t tz_index = 0;
   bool has_time_restrictions = false;
-  if (!costing_->AllowedReverse(meta.edge, pred, opp_edge, t2, opp_edge_id, localtime, tz_index,
-                                has_time_restrictions) ||
-      costing_->Restricted(meta.edge, pred, edgelabels_reverse_, tile, meta.edge_id, false,
-                           &edgestatus_reverse_, localtime, tz_index)) {
+  if (!costing.AllowedReverse(meta.edge, pred, opp_edge, t2, opp_edge_id, localtime, tz_index,
+                              has_time_restrictions) ||
+      costing->Restricted(meta.edge, pred, edgelabels_reverse_, tile, meta.edge_id, false,
+                          &edgestatus_reverse_, localtime, tz_index)) {
     return false;
   }
 
   // Get cost. Use opposing edge for EdgeCost. Separate the transition seconds so we
   // can properly recover elapsed time on the reverse path.
   Cost transition_cost =
-      costing_->TransitionCostReverse(meta.edge->localedgeidx(), nodeinfo, opp_edge, opp_pred_edge);
-  Cost newcost = pred.cost() + costing_->EdgeCost(opp_edge, t2, kConstrainedFlowSecondOfDay);
+      costing.TransitionCostReverse(meta.edge->localedgeidx(), nodeinfo, opp_edge, opp_pred_edge);
+  Cost newcost = pred.cost() + costing.EdgeCost(opp_edge, t2, kConstrainedFlowSecondOfDay);
   newcost.cost += transition_cost.cost;
 
   // Check if edge is temporarily labeled and this path has less cost. If
@@ -451,7 +453,7 @@ inline bool BidirectionalAStar::ExpandReverseInner(GraphReader& graphreader,
     BDEdgeLabel& lab = edgelabels_reverse_[meta.edge_status->index()];
     if (newcost.cost < lab.cost().cost) {
       float newsortcost = lab.sortcost() - (lab.cost().cost - newcost.cost);
-      adjacencylist_reverse_->decrease(meta.edge_status->index(), newsortcost);
+      adjacencylist_reverse_.decrease(meta.edge_status->index(), newsortcost);
       lab.Update(pred_idx, newcost, newsortcost, transition_cost, has_time_restrictions);
     }
     return true; // Returning true since this means we approved the edge
@@ -461,7 +463,8 @@ inline bool BidirectionalAStar::ExpandReverseInner(GraphReader& graphreader,
   // end node of the directed edge.
   float dist = 0.0f;
   float sortcost =
-      newcost.cost + astarheuristic_reverse_.Get(t2->get_node_ll(meta.edge->endnode()), dist);
+      newcost.cost + astarheuristic_reverse_.Get(t2->get_node_ll(meta.edge->endnode()),
+                                                 meta.edge->endnode(), dist);
 
   // Add edge label, add to the adjacency list and set edge status
   uint32_t idx = edgelabels_reverse_.size();
@@ -470,7 +473,7 @@ inline bool BidirectionalAStar::ExpandReverseInner(GraphReader& graphreader,
                                    (pred.not_thru_pruning() || !meta.edge->not_thru()),
                                    has_time_restrictions);
 
-  adjacencylist_reverse_->add(idx);
+  adjacencylist_reverse_.add(idx);
   *meta.edge_status = {EdgeSet::kTemporary, idx};
 
   // setting this edge as reached, sending the opposing because this is the reverse tree
@@ -508,11 +511,29 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
   SetOrigin(graphreader, origin);
   SetDestination(graphreader, destination);
 
-  // Find shortest path. Switch between a forward direction and a reverse
-  // direction search based on the current costs. Alternating like this
-  // prevents one tree from expanding much more quickly (if in a sparser
-  // portion of the graph) rather than strictly alternating.
-  // TODO - CostMatrix alternates, maybe should try alternating here?
+  // Tighten the A* heuristics with the landmarks, if there are any for this costing
+  const baldr::LandmarkTable* landmarks = landmark_table(access_mode_);
+  if (landmarks != nullptr) {
+    astarheuristic_forward_.InitLandmarks(landmarks,
+                                          LandmarkTargets(graphreader, destination, true), false);
+    astarheuristic_reverse_.InitLandmarks(landmarks, LandmarkTargets(graphreader, origin, false),
+                                          true);
+  }
+
+  return DispatchCost(*costing_, [this, &graphreader, &options](const auto costing) {
+    return Search(costing, graphreader, options);
+  });
+}
+
+// Find shortest path. Switch between a forward direction and a reverse
+// direction search based on the current costs. Alternating like this
+// prevents one tree from expanding much more quickly (if in a sparser
+// portion of the graph) rather than strictly alternating.
+// TODO - CostMatrix alternates, maybe should try alternating here?
+template <typename cost_t>
+std::vector<std::vector<PathInfo>> BidirectionalAStar::Search(const StaticCost<cost_t> costing,
+                                                              GraphReader& graphreader,
+                                                              const Options& options) {
   int n = 0;
   uint32_t forward_pred_idx, reverse_pred_idx;
   BDEdgeLabel fwd_pred, rev_pred;
@@ -526,7 +547,7 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
 
     // Get the next predecessor (based on which direction was expanded in prior step)
     if (expand_forward) {
-      forward_pred_idx = adjacencylist_forward_->pop();
+      forward_pred_idx = adjacencylist_forward_.pop();
       if (forward_pred_idx != kInvalidLabel) {
         fwd_pred = edgelabels_forward_[forward_pred_idx];
 
@@ -556,7 +577,7 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       }
     }
     if (expand_reverse) {
-      reverse_pred_idx = adjacencylist_reverse_->pop();
+      reverse_pred_idx = adjacencylist_reverse_.pop();
       if (reverse_pred_idx != kInvalidLabel) {
         rev_pred = edgelabels_reverse_[reverse_pred_idx];
 
@@ -608,7 +629,7 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
       }
 
       // Expand from the end node in forward direction.
-      ExpandForward(graphreader, fwd_pred.endnode(), fwd_pred, forward_pred_idx, false);
+      ExpandForward(costing, graphreader, fwd_pred.endnode(), fwd_pred, forward_pred_idx, false);
     } else {
       // Expand reverse - set to get next edge from reverse adj. list on the next pass
       expand_forward = false;
@@ -634,8 +655,8 @@ BidirectionalAStar::GetBestPath(valhalla::Location& origin,
           graphreader.GetGraphTile(rev_pred.opp_edgeid())->directededge(rev_pred.opp_edgeid());
 
       // Expand from the end node in reverse direction.
-      ExpandReverse(graphreader, rev_pred.endnode(), rev_pred, reverse_pred_idx, opp_pred_edge,
-                    false);
+      ExpandReverse(costing, graphreader, rev_pred.endnode(), rev_pred, reverse_pred_idx,
+                    opp_pred_edge, false);
     }
   }
   return {}; // If we are here the route failed
@@ -796,7 +817,7 @@ void BidirectionalAStar::SetOrigin(GraphReader& graphreader, valhalla::Location&
     edgestatus_forward_.Set(edgeid, EdgeSet::kTemporary, idx, tile);
     edgelabels_forward_.emplace_back(kInvalidLabel, edgeid, directededge, cost, sortcost, dist, mode_,
                                      false);
-    adjacencylist_forward_->add(idx);
+    adjacencylist_forward_.add(idx);
 
     // setting this edge as reached
     if (expansion_callback_) {
@@ -874,7 +895,7 @@ void BidirectionalAStar::SetDestination(GraphReader& graphreader, const valhalla
                             graphreader.GetGraphTile(opp_edge_id));
     edgelabels_reverse_.emplace_back(kInvalidLabel, opp_edge_id, edgeid, opp_dir_edge, cost, sortcost,
                                      dist, mode_, c, false, false);
-    adjacencylist_reverse_->add(idx);
+    adjacencylist_reverse_.add(idx);
 
     // setting this edge as settled, sending the opposing because this is the reverse tree
     if (expansion_callback_) {
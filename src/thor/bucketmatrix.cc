@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "midgard/logging.h"
+#include "thor/bucketmatrix.h"
+#include "worker.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace {
+
+constexpr uint32_t kMaxMatrixIterations = 2000000;
+
+// Append the bytes of a value to a key
+template <typename T> void Append(std::string& key, const T value) {
+  key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Key of a target selection phase, it has to change with anything the
+// backward searches depend on
+std::string TargetSetKey(const std::string& costing_key,
+                         const TravelMode mode,
+                         const float cost_threshold,
+                         const google::protobuf::RepeatedPtrField<valhalla::Location>& targets) {
+  std::string key = costing_key;
+  Append(key, static_cast<uint32_t>(mode));
+  Append(key, cost_threshold);
+  for (const auto& target : targets) {
+    Append(key, target.path_edges_size());
+    for (const auto& edge : target.path_edges()) {
+      Append(key, edge.graph_id());
+      Append(key, edge.percent_along());
+      Append(key, edge.distance());
+      Append(key, edge.begin_node());
+      Append(key, edge.end_node());
+    }
+  }
+  return key;
+}
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+constexpr size_t BucketMatrix::kDefaultMaxCacheSize;
+
+// Constructor with the bytes of target sets to keep and how long for.
+BucketMatrix::BucketMatrix(const size_t max_cache_size, const float target_set_ttl)
+    : CostMatrix(), max_cache_size_(max_cache_size), target_set_ttl_(target_set_ttl),
+      cache_size_(0) {
+}
+
+// Drop all cached target selection phases.
+void BucketMatrix::ClearCache() {
+  target_sets_.clear();
+  cache_size_ = 0;
+}
+
+// Drop the least recently used target sets until the cache fits.
+void BucketMatrix::Trim(const size_t keep) {
+  while (target_sets_.size() > keep && cache_size_ > max_cache_size_) {
+    cache_size_ -= target_sets_.back().size;
+    target_sets_.pop_back();
+  }
+}
+
+// Form a time distance matrix from the set of source locations
+// to the set of target locations.
+std::vector<TimeDistance> BucketMatrix::SourceToTarget(
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+    GraphReader& graphreader,
+    const std::shared_ptr<DynamicCost>* mode_costing,
+    const TravelMode mode,
+    const float max_matrix_distance,
+    const std::string& costing_key) {
+  // Set the mode and costing
+  mode_ = mode;
+  costing_ = mode_costing[static_cast<uint32_t>(mode_)];
+  access_mode_ = costing_->access_mode();
+
+  current_cost_threshold_ = GetCostThreshold(max_matrix_distance);
+  Clear();
+
+  // Reuse the target selection phase of an earlier request with the same
+  // targets and costing unless it is too old, otherwise run it and keep it
+  // for later
+  const auto key = TargetSetKey(costing_key, mode_, current_cost_threshold_, target_location_list);
+  const auto now = std::chrono::steady_clock::now();
+  auto target_set = std::find_if(target_sets_.begin(), target_sets_.end(),
+                                 [&key](const TargetSet& set) { return set.key == key; });
+  if (target_set != target_sets_.end() && target_set_ttl_ > 0.0f &&
+      std::chrono::duration<float>(now - target_set->selected).count() >= target_set_ttl_) {
+    cache_size_ -= target_set->size;
+    target_sets_.erase(target_set);
+    target_set = target_sets_.end();
+  }
+  if (target_set != target_sets_.end()) {
+    target_sets_.splice(target_sets_.begin(), target_sets_, target_set);
+  } else {
+    TargetSet selected;
+    selected.key = key;
+    selected.selected = now;
+    SelectTargets(graphreader, target_location_list, selected);
+    cache_size_ += selected.size;
+    target_sets_.push_front(std::move(selected));
+    Trim(1);
+  }
+
+  // Set the sources. Initialize best connections and status. Any locations
+  // that are the same get set to 0 time, distance and are not added to the
+  // remaining location set.
+  target_count_ = target_location_list.size();
+  SetSources(graphreader, source_location_list);
+  Initialize(source_location_list, target_location_list);
+
+  // One forward search per source, connections are checked against the
+  // buckets of the targets as it goes
+  for (uint32_t source = 0; source < source_count_; source++) {
+    if (!source_status_[source].remaining_locations.empty()) {
+      SweepSource(source, graphreader);
+    }
+  }
+
+  // Form the time, distance matrix from the destinations list
+  std::vector<TimeDistance> td;
+  for (const auto& connection : best_connection_) {
+    td.emplace_back(std::round(connection.cost.secs), std::round(connection.distance));
+  }
+
+  // A target set too large for the cache on its own is not kept
+  Trim(0);
+  return td;
+}
+
+// Run the backward search of each target until it is exhausted or exceeds
+// the cost threshold and keep the edges it reached.
+void BucketMatrix::SelectTargets(
+    GraphReader& graphreader,
+    const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+    TargetSet& target_set) {
+  // There are no sources yet, so exhausting a backward search has nothing
+  // to update but its own status. With no sources to connect to, nothing
+  // cuts a search short the way CostMatrix does, it runs until it settles
+  // an edge beyond the cost threshold of the max matrix distance (which sets
+  // its threshold to 0).
+  source_count_ = 0;
+  SetTargets(graphreader, targets);
+  target_status_.assign(target_count_, LocationStatus(std::numeric_limits<int>::max()));
+
+  for (uint32_t target = 0; target < target_count_; target++) {
+    DispatchCost(*costing_, [this, &graphreader, target](const auto costing) {
+      uint32_t n = 0;
+      while (target_status_[target].threshold > 0) {
+        target_status_[target].threshold--;
+        BackwardSearch(costing, target, graphreader);
+
+        // Protect against edge cases that may lead to never breaking out of
+        // this loop, the same as the forward searches.
+        if (n >= kMaxMatrixIterations) {
+          throw valhalla_exception_t{430};
+        }
+        n++;
+      }
+    });
+
+    // Add each reached edge to its bucket. Only the label the edge status
+    // points to is current, there may be an older one for origin edges.
+    // Keep what is needed to connect at the edge, along the lines of
+    // CostMatrix::CheckForwardConnections, so the labels can be dropped.
+    const auto& edgelabels = target_edgelabel_[target];
+    const auto& edgestatus = target_edgestatus_[target];
+    for (uint32_t idx = 0; idx < edgelabels.size(); idx++) {
+      const BDEdgeLabel& label = edgelabels[idx];
+      EdgeStatusInfo status = edgestatus.Get(label.edgeid());
+      if (status.set() == EdgeSet::kUnreachedOrReset || status.index() != idx) {
+        continue;
+      }
+
+      BucketEntry entry{};
+      entry.target = target;
+      entry.cost = label.transition_cost();
+      entry.secs = label.transition_secs();
+      uint32_t predidx = label.predecessor();
+      if (predidx == kInvalidLabel) {
+        entry.origin = true;
+        entry.origin_secs = label.cost().secs;
+        entry.origin_transition_cost = label.transition_cost();
+        entry.origin_transition_secs = label.transition_secs();
+        entry.origin_distance = label.path_distance();
+      } else {
+        entry.cost += edgelabels[predidx].cost().cost;
+        entry.secs += edgelabels[predidx].cost().secs;
+        entry.distance = edgelabels[predidx].path_distance();
+      }
+      target_set.buckets[label.edgeid()].push_back(entry);
+    }
+    target_set.label_counts.push_back(edgelabels.size());
+
+    // Free the search of this target before running the next one
+    std::vector<BDEdgeLabel>().swap(target_edgelabel_[target]);
+    target_edgestatus_[target].clear();
+    target_adjacency_[target].reset();
+    targets_.clear();
+  }
+
+  // Approximate the bytes the target set takes: the bucket array of the map,
+  // a node per bucket and the entries of each bucket
+  using bucket_node_t = std::pair<const GraphId, std::vector<BucketEntry>>;
+  target_set.size = sizeof(TargetSet) + target_set.key.capacity() +
+                    target_set.label_counts.capacity() * sizeof(uint32_t) +
+                    target_set.buckets.bucket_count() * sizeof(void*);
+  for (const auto& bucket : target_set.buckets) {
+    target_set.size += sizeof(bucket_node_t) + 2 * sizeof(void*) +
+                       bucket.second.capacity() * sizeof(BucketEntry);
+  }
+  LOG_DEBUG("BucketMatrix target selection: " + std::to_string(target_set.buckets.size()) +
+            " buckets, " + std::to_string(target_set.size) + " bytes");
+  Clear();
+}
+
+// Run the forward search of a source until it is done.
+void BucketMatrix::SweepSource(const uint32_t source, GraphReader& graphreader) {
+  DispatchCost(*costing_, [this, &graphreader, source](const auto costing) {
+    uint32_t n = 0;
+    while (source_status_[source].threshold > 0) {
+      source_status_[source].threshold--;
+      ForwardSearch(costing, source, n, graphreader);
+
+      // Protect against edge cases that may lead to never breaking out of
+      // this loop. This should never occur but lets make sure.
+      if (n >= kMaxMatrixIterations) {
+        throw valhalla_exception_t{430};
+      }
+      n++;
+    }
+  });
+
+  // Free the search of this source before running the next one
+  std::vector<BDEdgeLabel>().swap(source_edgelabel_[source]);
+  source_edgestatus_[source].clear();
+  source_adjacency_[source].reset();
+}
+
+// Number of edge labels of the backward search of a target.
+size_t BucketMatrix::TargetLabelCount(const uint32_t target) const {
+  return target_sets_.front().label_counts[target];
+}
+
+// Check if the edge on the forward search connects to the bucket of a
+// target at its opposing edge.
+void BucketMatrix::CheckForwardConnections(const uint32_t source,
+                                           const BDEdgeLabel& pred,
+                                           const uint32_t n) {
+  // Disallow connections that are part of a complex restriction.
+  if (pred.on_complex_rest()) {
+    return;
+  }
+
+  // Get the bucket of the opposing edge
+  GraphId oppedge = pred.opp_edgeid();
+  const auto& buckets = target_sets_.front().buckets;
+  auto bucket = buckets.find(oppedge);
+  if (bucket == buckets.end()) {
+    return;
+  }
+
+  // Iterate through the targets that reached the opposing edge
+  for (const auto& entry : bucket->second) {
+    const uint32_t target = entry.target;
+    uint32_t idx = source * target_count_ + target;
+    if (best_connection_[idx].found) {
+      continue;
+    }
+
+    // Update any targets whose threshold has been reached
+    if (best_connection_[idx].threshold > 0 && n > best_connection_[idx].threshold) {
+      best_connection_[idx].found = true;
+      continue;
+    }
+
+    // Special case - common edge for source and target are both initial edges
+    if (pred.predecessor() == kInvalidLabel && entry.origin) {
+      float s = std::abs(pred.cost().secs + entry.origin_secs - entry.origin_transition_cost);
+
+      // Update best connection and set found = true.
+      // distance computation only works with the casts.
+      uint32_t d = std::abs(static_cast<int>(pred.path_distance()) +
+                            static_cast<int>(entry.origin_distance) -
+                            static_cast<int>(entry.origin_transition_secs));
+      best_connection_[idx].Update(pred.edgeid(), oppedge, Cost(s, s), d);
+      best_connection_[idx].found = true;
+      UpdateStatus(source, target);
+    } else {
+      float c = pred.cost().cost + entry.cost;
+
+      // Check if best connection
+      if (c < best_connection_[idx].cost.cost) {
+        float s = pred.cost().secs + entry.secs;
+        uint32_t d = pred.path_distance() + entry.distance;
+
+        // Update best connection and set a threshold
+        best_connection_[idx].Update(pred.edgeid(), oppedge, Cost(c, s), d);
+        if (best_connection_[idx].threshold == 0) {
+          best_connection_[idx].threshold =
+              n + GetThreshold(mode_, source_edgelabel_[source].size() + TargetLabelCount(target));
+        }
+        UpdateStatus(source, target);
+      }
+    }
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
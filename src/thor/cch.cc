@@ -0,0 +1,557 @@
+#include "thor/cch.h"
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+
+#include "baldr/graphconstants.h"
+#include "midgard/logging.h"
+#include "sif/costfactory.h"
+#include "sif/edgelabel.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace valhalla {
+namespace thor {
+
+constexpr float CCHMetric::kNoPath;
+constexpr uint32_t CCHMetric::kEdgeVia;
+constexpr uint32_t CCHMetric::kNoVia;
+
+// Customize the overlay for a costing
+CCHMetric::CCHMetric(const CCHOverlay& overlay,
+                     GraphReader& graphreader,
+                     const DynamicCost& costing)
+    : weights_(overlay.arc_count(), {kNoPath, kNoPath, kNoVia, kNoVia}), customization_secs_(0.0f) {
+  auto start = std::chrono::steady_clock::now();
+
+  // The cheapest usable edge of each arc in each direction
+  auto filter = costing.GetEdgeFilter();
+  const GraphTile* tile = nullptr;
+  for (uint32_t arc = 0; arc < overlay.arc_count(); ++arc) {
+    Weight& weight = weights_[arc];
+    for (uint32_t i = overlay.first_edge(arc); i < overlay.last_edge(arc); ++i) {
+      GraphId edgeid(overlay.edge(i).edgeid);
+      if (tile == nullptr || tile->id() != edgeid.Tile_Base()) {
+        tile = graphreader.GetGraphTile(edgeid);
+        if (tile == nullptr) {
+          continue;
+        }
+      }
+      const DirectedEdge* edge = tile->directededge(edgeid);
+      if (!Usable(filter, edge)) {
+        continue;
+      }
+      float cost = costing.EdgeCost(edge, tile).cost;
+      float& best = overlay.edge(i).down ? weight.down : weight.up;
+      if (cost < best) {
+        best = cost;
+        (overlay.edge(i).down ? weight.down_via : weight.up_via) = kEdgeVia | i;
+      }
+    }
+    if (graphreader.OverCommitted()) {
+      graphreader.Trim();
+      tile = nullptr;
+    }
+  }
+
+  // Lower triangles, lowest vertex first: the arcs of a vertex v to u and w (u < w) give a path
+  // between u and w through v, which is all an arc between them can be better as. The overlay
+  // guarantees there is such an arc, it is among the arcs of u sorted by head like those of v.
+  for (uint32_t v = 0; v < overlay.vertex_count(); ++v) {
+    const uint32_t last = overlay.last_arc(v);
+    for (uint32_t a = overlay.first_arc(v); a < last; ++a) {
+      const Weight& va = weights_[a];
+      if (va.up == kNoPath && va.down == kNoPath) {
+        continue;
+      }
+      const uint32_t u = overlay.head(a);
+      uint32_t c = overlay.first_arc(u);
+      const uint32_t last_c = overlay.last_arc(u);
+      for (uint32_t b = a + 1; b < last; ++b) {
+        const uint32_t w = overlay.head(b);
+        while (c < last_c && overlay.head(c) < w) {
+          ++c;
+        }
+        if (c == last_c) {
+          break;
+        }
+        const Weight& vb = weights_[b];
+        Weight& uw = weights_[c];
+        // u to v to w
+        if (va.down != kNoPath && vb.up != kNoPath && va.down + vb.up < uw.up) {
+          uw.up = va.down + vb.up;
+          uw.up_via = v;
+        }
+        // w to v to u
+        if (vb.down != kNoPath && va.up != kNoPath && vb.down + va.up < uw.down) {
+          uw.down = vb.down + va.up;
+          uw.down_via = v;
+        }
+      }
+    }
+  }
+  customization_secs_ =
+      std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+}
+
+CCHCustomizer::CCHCustomizer(const std::shared_ptr<const CCHOverlay>& overlay,
+                             const boost::property_tree::ptree& mjolnir,
+                             const size_t max_pending)
+    : overlay_(overlay), mjolnir_(mjolnir), max_pending_(std::max<size_t>(max_pending, 1)),
+      stop_(false) {
+  thread_ = std::thread(&CCHCustomizer::Work, this);
+}
+
+// Give up the queued customizations and join the thread
+CCHCustomizer::~CCHCustomizer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_one();
+  thread_.join();
+  for (auto& job : jobs_) {
+    job.promise.set_value(nullptr);
+  }
+}
+
+// Get the customizer shared by the workers routing on an overlay file
+std::shared_ptr<CCHCustomizer>
+CCHCustomizer::get(const std::shared_ptr<const CCHOverlay>& overlay,
+                   const boost::property_tree::ptree& mjolnir,
+                   const size_t max_pending) {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<CCHCustomizer>> customizers;
+  const auto file_name =
+      mjolnir.get<std::string>("cch.file", mjolnir.get<std::string>("tile_dir", "") + "/overlay.cch");
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& entry = customizers[file_name];
+  auto customizer = entry.lock();
+  if (!customizer) {
+    customizer = std::make_shared<CCHCustomizer>(overlay, mjolnir, max_pending);
+    entry = customizer;
+  }
+  return customizer;
+}
+
+// Queue customizing a metric
+CCHCustomizer::metric_future_t CCHCustomizer::Customize(const std::string& key,
+                                                        const Options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto queued = std::find_if(jobs_.begin(), jobs_.end(),
+                             [&key](const Job& job) { return job.key == key; });
+  if (queued != jobs_.end()) {
+    return queued->metric;
+  }
+  if (jobs_.size() >= max_pending_) {
+    return {};
+  }
+  jobs_.emplace_back();
+  Job& job = jobs_.back();
+  job.key = key;
+  job.options = options;
+  job.metric = job.promise.get_future().share();
+  queued_.notify_one();
+  return job.metric;
+}
+
+// Customize the queued metrics until stopped
+void CCHCustomizer::Work() {
+  // One reader and costing factory for all the metrics, the reader is cleared after each one
+  GraphReader graphreader(mjolnir_);
+  CostFactory<DynamicCost> factory;
+  factory.RegisterStandardCostingModels();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+    if (stop_) {
+      return;
+    }
+    // Only this thread takes jobs off of the queue, the first one stays put while it runs
+    Job& job = jobs_.front();
+    lock.unlock();
+    std::shared_ptr<const CCHMetric> metric;
+    try {
+      auto costing = factory.Create(job.options.costing(), job.options);
+      metric.reset(new CCHMetric(*overlay_, graphreader, *costing));
+      LOG_INFO("Customized the contraction hierarchy overlay in " +
+               std::to_string(metric->customization_secs()) + " secs");
+    } catch (const std::exception& e) {
+      LOG_ERROR("Failed to customize the contraction hierarchy overlay: " + std::string(e.what()));
+    }
+    graphreader.Clear();
+    lock.lock();
+    job.promise.set_value(metric);
+    jobs_.pop_front();
+  }
+}
+
+CCHQuery::CCHQuery(const size_t max_cached_metrics,
+                   const float metric_ttl,
+                   const float max_turn_cost_ratio)
+    : PathAlgorithm(), max_cached_metrics_(max_cached_metrics), metric_ttl_(metric_ttl),
+      max_turn_cost_ratio_(max_turn_cost_ratio) {
+}
+
+// Sets the overlay to route on
+void CCHQuery::set_overlay(const std::shared_ptr<const CCHOverlay>& overlay,
+                           const boost::property_tree::ptree& mjolnir) {
+  overlay_ = overlay;
+  metrics_.clear();
+  customizer_ = overlay_ && !mjolnir.empty()
+                    ? CCHCustomizer::get(overlay_, mjolnir, max_cached_metrics_)
+                    : nullptr;
+  const uint32_t count = overlay_ ? overlay_->vertex_count() : 0;
+  for (auto* search : {&forward_, &reverse_}) {
+    search->costs.assign(count, CCHMetric::kNoPath);
+    search->preds.assign(count, CCHOverlay::kNoVertex);
+    search->ancestors.clear();
+    search->starts.clear();
+  }
+  marks_.assign(count, 0);
+}
+
+// Can requests with this costing be routed on the overlay
+bool CCHQuery::Supports(const DynamicCost& costing, const Options& options) const {
+  // avoids are per request, the metrics are shared. Without any turn cost allowed no path found on
+  // the overlay would be kept, so there is no point in searching it
+  return overlay_ && max_turn_cost_ratio_ > 0.0f && costing.access_mode() == overlay_->access() &&
+         options.avoid_edges_size() == 0;
+}
+
+// Clear the temporary information generated during path construction
+void CCHQuery::Clear() {
+  for (auto* search : {&forward_, &reverse_}) {
+    for (auto v : search->ancestors) {
+      search->costs[v] = CCHMetric::kNoPath;
+      search->preds[v] = CCHOverlay::kNoVertex;
+      marks_[v] = 0;
+    }
+    search->ancestors.clear();
+    search->starts.clear();
+  }
+  has_ferry_ = false;
+}
+
+// Drops all cached metrics
+void CCHQuery::ClearCache() {
+  metrics_.clear();
+}
+
+// Get the metric for the costing options of a request
+std::shared_ptr<const CCHMetric>
+CCHQuery::GetMetric(GraphReader& graphreader, const DynamicCost& costing, const Options& options) {
+  std::string key = std::to_string(static_cast<int>(options.costing()));
+  const int costing_index = static_cast<int>(options.costing());
+  if (options.costing_options_size() > costing_index) {
+    key += options.costing_options(costing_index).SerializeAsString();
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  auto cached = std::find_if(metrics_.begin(), metrics_.end(),
+                             [&key](const CachedMetric& metric) { return metric.key == key; });
+  if (cached == metrics_.end()) {
+    metrics_.push_front({key, now, nullptr, {}});
+    // Make room by dropping the least recently used metrics that aren't being customized
+    auto evict = std::prev(metrics_.end());
+    while (metrics_.size() > std::max<size_t>(max_cached_metrics_, 1) &&
+           evict != metrics_.begin()) {
+      auto prev = std::prev(evict);
+      if (!evict->pending.valid()) {
+        metrics_.erase(evict);
+      }
+      evict = prev;
+    }
+    cached = metrics_.begin();
+  } else {
+    metrics_.splice(metrics_.begin(), metrics_, cached);
+  }
+
+  // Take the metric customized by the customizer once it is ready
+  if (cached->pending.valid() &&
+      cached->pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    if (auto metric = cached->pending.get()) {
+      cached->metric = metric;
+      cached->customized = now;
+    }
+    cached->pending = {};
+  }
+
+  // Customize a metric if there is none or it is too old, using the old one until then. When the
+  // customizer is busy with too many this is tried again on a later request
+  if (!cached->pending.valid() &&
+      (cached->metric == nullptr ||
+       (metric_ttl_ > 0.0f &&
+        std::chrono::duration<float>(now - cached->customized).count() >= metric_ttl_))) {
+    if (!customizer_) {
+      cached->metric.reset(new CCHMetric(*overlay_, graphreader, costing));
+      cached->customized = now;
+      LOG_INFO("Customized the contraction hierarchy overlay in " +
+               std::to_string(cached->metric->customization_secs()) + " secs");
+    } else {
+      cached->pending = customizer_->Customize(key, options);
+    }
+  }
+  return cached->metric;
+}
+
+// Are any of the origin edges the same as a destination edge or its opposing edge
+bool CCHQuery::SharesEdge(GraphReader& graphreader,
+                          const valhalla::Location& origin,
+                          const valhalla::Location& destination) const {
+  for (const auto& origin_edge : origin.path_edges()) {
+    GraphId edgeid(origin_edge.graph_id());
+    GraphId opp_edgeid = graphreader.GetOpposingEdgeId(edgeid);
+    for (const auto& destination_edge : destination.path_edges()) {
+      GraphId other(destination_edge.graph_id());
+      if (other == edgeid || other == opp_edgeid) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Start a search at the vertices of the edges of a location
+void CCHQuery::Start(GraphReader& graphreader,
+                     const DynamicCost& costing,
+                     const valhalla::Location& location,
+                     const bool forward,
+                     Search& search) {
+  auto filter = costing.GetEdgeFilter();
+  for (int i = 0; i < location.path_edges_size(); ++i) {
+    // An origin at the end of an edge or a destination at its start has nothing to take from it
+    const auto& edge = location.path_edges(i);
+    if (forward ? edge.end_node() : edge.begin_node()) {
+      continue;
+    }
+    GraphId edgeid(edge.graph_id());
+    const GraphTile* tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      continue;
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    if (!CCHMetric::Usable(filter, directededge)) {
+      continue;
+    }
+    uint32_t vertex =
+        overlay_->vertex(forward ? directededge->endnode() : graphreader.edge_startnode(edgeid));
+    if (vertex == CCHOverlay::kNoVertex) {
+      continue;
+    }
+
+    // The partial edge and the edge score, as the other algorithms do
+    float percent = forward ? 1.0f - edge.percent_along() : edge.percent_along();
+    float cost = costing.EdgeCost(directededge, tile).cost * percent + edge.distance();
+    if (cost >= search.costs[vertex]) {
+      continue;
+    }
+    search.costs[vertex] = cost;
+    auto start = std::find_if(search.starts.begin(), search.starts.end(),
+                              [vertex](const std::pair<uint32_t, uint32_t>& start) {
+                                return start.first == vertex;
+                              });
+    if (start == search.starts.end()) {
+      search.starts.emplace_back(vertex, i);
+    } else {
+      start->second = i;
+    }
+  }
+
+  // The search can only reach the ancestors of where it starts
+  const uint8_t mark = forward ? 1 : 2;
+  for (const auto& start : search.starts) {
+    for (uint32_t v = start.first; v != CCHOverlay::kNoVertex && !(marks_[v] & mark);
+         v = overlay_->parent(v)) {
+      marks_[v] |= mark;
+      search.ancestors.push_back(v);
+    }
+  }
+  std::sort(search.ancestors.begin(), search.ancestors.end());
+}
+
+// Relax the arcs of the ancestors of a search, lowest first
+void CCHQuery::Sweep(const CCHMetric& metric, const bool forward, Search& search) {
+  for (auto v : search.ancestors) {
+    const float cost = search.costs[v];
+    if (cost == CCHMetric::kNoPath) {
+      continue;
+    }
+    for (uint32_t a = overlay_->first_arc(v); a < overlay_->last_arc(v); ++a) {
+      float weight = forward ? metric.up(a) : metric.down(a);
+      uint32_t u = overlay_->head(a);
+      if (weight != CCHMetric::kNoPath && cost + weight < search.costs[u]) {
+        search.costs[u] = cost + weight;
+        search.preds[u] = v;
+      }
+    }
+  }
+}
+
+// Append the directed edges an arc stands for
+void CCHQuery::Unpack(const CCHMetric& metric,
+                      const uint32_t lower,
+                      const uint32_t higher,
+                      const bool up,
+                      std::vector<uint32_t>& edges) const {
+  uint32_t via = metric.via(overlay_->arc(lower, higher), up);
+  if (via & CCHMetric::kEdgeVia) {
+    edges.push_back(via & ~CCHMetric::kEdgeVia);
+  } else if (up) {
+    Unpack(metric, via, lower, false, edges);
+    Unpack(metric, via, higher, true, edges);
+  } else {
+    Unpack(metric, via, higher, false, edges);
+    Unpack(metric, via, lower, true, edges);
+  }
+}
+
+// Cost the unpacked path edge by edge with the costing
+std::vector<PathInfo> CCHQuery::FormPath(GraphReader& graphreader,
+                                         const DynamicCost& costing,
+                                         const TravelMode mode,
+                                         const std::vector<GraphId>& edges,
+                                         const float origin_percent,
+                                         const float destination_percent) {
+  std::vector<EdgeLabel> edgelabels;
+  std::vector<PathInfo> path;
+  Cost cost;
+  float turn_cost = 0.0f;
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const GraphId& edgeid = edges[i];
+    const GraphTile* tile = graphreader.GetGraphTile(edgeid);
+    if (tile == nullptr) {
+      return {};
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    Cost edge_cost = costing.EdgeCost(directededge, tile);
+    if (i == 0) {
+      edge_cost *= 1.0f - origin_percent;
+    }
+    if (i + 1 == edges.size()) {
+      edge_cost *= destination_percent;
+    }
+
+    // The metric has no turns, check them and add their cost now
+    Cost transition_cost;
+    bool has_time_restrictions = false;
+    if (i > 0) {
+      const EdgeLabel& pred = edgelabels.back();
+      if (!costing.Allowed(directededge, pred, tile, edgeid, 0, 0, has_time_restrictions) ||
+          costing.Restricted(directededge, pred, edgelabels, tile, edgeid, true)) {
+        return {};
+      }
+      const NodeInfo* nodeinfo = tile->node(graphreader.edge_startnode(edgeid));
+      transition_cost = costing.TransitionCost(directededge, nodeinfo, pred);
+    }
+    cost += edge_cost + transition_cost;
+    turn_cost += transition_cost.cost;
+
+    uint32_t pred_idx = edgelabels.empty() ? kInvalidLabel : edgelabels.size() - 1;
+    edgelabels.emplace_back(pred_idx, edgeid, directededge, cost, cost.cost, 0.0f, mode, 0,
+                            transition_cost, has_time_restrictions);
+    path.emplace_back(mode, cost.secs, edgeid, 0, cost.cost, has_time_restrictions,
+                      transition_cost.secs);
+    if (directededge->use() == Use::kFerry) {
+      has_ferry_ = true;
+    }
+  }
+
+  // The metric doesn't know about turns, with too much turn cost a better path may exist
+  if (turn_cost > max_turn_cost_ratio_ * (cost.cost - turn_cost)) {
+    LOG_DEBUG("Path on the contraction hierarchy overlay has too much turn cost");
+    return {};
+  }
+  return path;
+}
+
+// Form the best path on the overlay
+std::vector<std::vector<PathInfo>>
+CCHQuery::GetBestPath(valhalla::Location& origin,
+                      valhalla::Location& destination,
+                      GraphReader& graphreader,
+                      const std::shared_ptr<DynamicCost>* mode_costing,
+                      const TravelMode mode,
+                      const Options& options) {
+  const auto& costing = mode_costing[static_cast<uint32_t>(mode)];
+  if (costing == nullptr || !Supports(*costing, options)) {
+    return {};
+  }
+
+  // Paths on a single edge and those turning around on it are for the other algorithms
+  if (SharesEdge(graphreader, origin, destination)) {
+    return {};
+  }
+  auto metric = GetMetric(graphreader, *costing, options);
+  if (metric == nullptr) {
+    LOG_DEBUG("Contraction hierarchy overlay is being customized");
+    return {};
+  }
+
+  // Search up from both ends and meet at the cheapest common ancestor
+  Clear();
+  Start(graphreader, *costing, origin, true, forward_);
+  Start(graphreader, *costing, destination, false, reverse_);
+  Sweep(*metric, true, forward_);
+  Sweep(*metric, false, reverse_);
+  uint32_t meet = CCHOverlay::kNoVertex;
+  float best = CCHMetric::kNoPath;
+  for (auto v : forward_.ancestors) {
+    if (marks_[v] == 3 && forward_.costs[v] != CCHMetric::kNoPath &&
+        reverse_.costs[v] != CCHMetric::kNoPath && forward_.costs[v] + reverse_.costs[v] < best) {
+      best = forward_.costs[v] + reverse_.costs[v];
+      meet = v;
+    }
+  }
+  if (meet == CCHOverlay::kNoVertex) {
+    LOG_DEBUG("No path on the contraction hierarchy overlay");
+    return {};
+  }
+
+  // Unpack the arcs up to where the searches met and back down
+  std::vector<std::pair<uint32_t, uint32_t>> up_arcs;
+  uint32_t first = meet;
+  for (; forward_.preds[first] != CCHOverlay::kNoVertex; first = forward_.preds[first]) {
+    up_arcs.emplace_back(forward_.preds[first], first);
+  }
+  std::vector<uint32_t> unpacked;
+  for (auto arc = up_arcs.rbegin(); arc != up_arcs.rend(); ++arc) {
+    Unpack(*metric, arc->first, arc->second, true, unpacked);
+  }
+  uint32_t last = meet;
+  for (; reverse_.preds[last] != CCHOverlay::kNoVertex; last = reverse_.preds[last]) {
+    Unpack(*metric, reverse_.preds[last], last, false, unpacked);
+  }
+
+  auto start_edge = [](const Search& search, const uint32_t vertex) {
+    return std::find_if(search.starts.begin(), search.starts.end(),
+                        [vertex](const std::pair<uint32_t, uint32_t>& start) {
+                          return start.first == vertex;
+                        })
+        ->second;
+  };
+  const auto& origin_edge = origin.path_edges(start_edge(forward_, first));
+  const auto& destination_edge = destination.path_edges(start_edge(reverse_, last));
+  std::vector<GraphId> edges;
+  edges.reserve(unpacked.size() + 2);
+  edges.emplace_back(origin_edge.graph_id());
+  for (auto index : unpacked) {
+    edges.emplace_back(overlay_->edge(index).edgeid);
+  }
+  edges.emplace_back(destination_edge.graph_id());
+
+  auto path = FormPath(graphreader, *costing, mode, edges, origin_edge.percent_along(),
+                       destination_edge.percent_along());
+  if (path.empty()) {
+    LOG_DEBUG("Path on the contraction hierarchy overlay not usable, leaving it to the others");
+    return {};
+  }
+  return {std::move(path)};
+}
+
+} // namespace thor
+} // namespace valhalla
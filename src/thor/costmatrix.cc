@@ -2,6 +2,7 @@
 #include <cmath>
 #include <vector>
 
+#include "baldr/passrunner.h"
 #include "midgard/logging.h"
 #include "thor/costmatrix.h"
 #include "worker.h"
@@ -13,17 +14,15 @@ namespace {
 
 constexpr uint32_t kMaxMatrixIterations = 2000000;
 
-// Find a threshold to continue the search - should be based on
-// the max edge cost in the adjacency set?
-int GetThreshold(const TravelMode mode, const int n) {
-  return (mode == TravelMode::kDrive) ? std::min(2700, std::max(100, n / 3)) : 500;
-}
-
 bool equals(const valhalla::LatLng& a, const valhalla::LatLng& b) {
   return a.has_lat() == b.has_lat() && a.has_lng() == b.has_lng() &&
          (!a.has_lat() || a.lat() == b.lat()) && (!a.has_lng() || a.lng() == b.lng());
 }
 
+// Each thread expanding searches concurrently should get at least this many
+// locations per pass, otherwise waiting on each other costs more than it saves
+constexpr uint32_t kMinLocationsPerThread = 8;
+
 } // namespace
 
 namespace valhalla {
@@ -32,7 +31,18 @@ namespace thor {
 // Constructor with cost threshold.
 CostMatrix::CostMatrix()
     : mode_(TravelMode::kDrive), access_mode_(kAutoAccess), source_count_(0), remaining_sources_(0),
-      target_count_(0), remaining_targets_(0), current_cost_threshold_(0) {
+      target_count_(0), remaining_targets_(0), current_cost_threshold_(0), queue_updates_(false) {
+}
+
+// Find a threshold to continue the search - should be based on
+// the max edge cost in the adjacency set?
+int CostMatrix::GetThreshold(const TravelMode mode, const int n) {
+  return (mode == TravelMode::kDrive) ? std::min(2700, std::max(100, n / 3)) : 500;
+}
+
+// Number of edge labels of the backward search of a target.
+size_t CostMatrix::TargetLabelCount(const uint32_t target) const {
+  return target_edgelabel_[target].size();
 }
 
 float CostMatrix::GetCostThreshold(const float max_matrix_distance) {
@@ -97,6 +107,10 @@ void CostMatrix::Clear() {
   target_hierarchy_limits_.clear();
   source_status_.clear();
   target_status_.clear();
+  queued_target_updates_.clear();
+  queued_target_edges_.clear();
+  exhausted_targets_.clear();
+  best_connection_.clear();
 }
 
 // Form a time distance matrix from the set of source locations
@@ -107,7 +121,8 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
     GraphReader& graphreader,
     const std::shared_ptr<DynamicCost>* mode_costing,
     const TravelMode mode,
-    const float max_matrix_distance) {
+    const float max_matrix_distance,
+    const std::vector<std::shared_ptr<GraphReader>>& helper_readers) {
   // Set the mode and costing
   mode_ = mode;
   costing_ = mode_costing[static_cast<uint32_t>(mode_)];
@@ -125,52 +140,128 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
   // location set.
   Initialize(source_location_list, target_location_list);
 
+  // Use helper threads if there are enough locations to keep them busy
+  uint32_t helpers = std::max(source_count_, target_count_) / kMinLocationsPerThread;
+  helpers = std::min<uint32_t>(helper_readers.size(), helpers > 0 ? helpers - 1 : 0);
+  std::unique_ptr<PassRunner> runner;
+  queue_updates_ = helpers > 0;
+  if (queue_updates_) {
+    queued_target_updates_.resize(source_count_);
+    queued_target_edges_.resize(target_count_);
+    exhausted_targets_.assign(target_count_, 0);
+    runner.reset(new PassRunner(graphreader, {helper_readers.begin(),
+                                              helper_readers.begin() + helpers}));
+  }
+  std::vector<uint32_t> expanding;
+
   // Perform backward search from all target locations. Perform forward
   // search from all source locations. Connections between the 2 search
-  // spaces is checked during the forward search.
+  // spaces is checked during the forward search. The costing is bound to
+  // its concrete type for the searches.
   int n = 0;
-  while (true) {
-    // Iterate all target locations in a backwards search
-    for (uint32_t i = 0; i < target_count_; i++) {
-      if (target_status_[i].threshold > 0) {
-        target_status_[i].threshold--;
-        BackwardSearch(i, graphreader);
-        if (target_status_[i].threshold == 0) {
-          target_status_[i].threshold = -1;
-          if (remaining_targets_ > 0) {
-            remaining_targets_--;
+  DispatchCost(*costing_, [this, &graphreader, &runner, &expanding, &n](const auto costing) {
+    while (true) {
+      if (runner) {
+        // The same passes as the serial ones below, with the searches of a pass run concurrently
+        // and their queued updates applied in location order afterwards
+        expanding.clear();
+        for (uint32_t i = 0; i < target_count_; i++) {
+          if (target_status_[i].threshold > 0) {
+            target_status_[i].threshold--;
+            expanding.push_back(i);
+          }
+        }
+        runner->Run(expanding.size(),
+                    [this, costing, &expanding](GraphReader& reader, const uint32_t i) {
+                      BackwardSearch(costing, expanding[i], reader);
+                    });
+        for (auto i : expanding) {
+          for (const auto& edgeid : queued_target_edges_[i]) {
+            targets_[edgeid].push_back(i);
+          }
+          queued_target_edges_[i].clear();
+          if (exhausted_targets_[i]) {
+            exhausted_targets_[i] = 0;
+            for (uint32_t source = 0; source < source_count_; source++) {
+              UpdateSourceStatus(source, i);
+              UpdateTargetStatus(source, i, source_edgelabel_[source].size());
+            }
+          }
+          if (target_status_[i].threshold == 0) {
+            target_status_[i].threshold = -1;
+            if (remaining_targets_ > 0) {
+              remaining_targets_--;
+            }
+          }
+        }
+
+        expanding.clear();
+        for (uint32_t i = 0; i < source_count_; i++) {
+          if (source_status_[i].threshold > 0) {
+            source_status_[i].threshold--;
+            expanding.push_back(i);
+          }
+        }
+        runner->Run(expanding.size(),
+                    [this, costing, &expanding, n](GraphReader& reader, const uint32_t i) {
+                      ForwardSearch(costing, expanding[i], n, reader);
+                    });
+        for (auto i : expanding) {
+          for (const auto& update : queued_target_updates_[i]) {
+            UpdateTargetStatus(i, update.first, update.second);
+          }
+          queued_target_updates_[i].clear();
+          if (source_status_[i].threshold == 0) {
+            source_status_[i].threshold = -1;
+            if (remaining_sources_ > 0) {
+              remaining_sources_--;
+            }
+          }
+        }
+      } else {
+        // Iterate all target locations in a backwards search
+        for (uint32_t i = 0; i < target_count_; i++) {
+          if (target_status_[i].threshold > 0) {
+            target_status_[i].threshold--;
+            BackwardSearch(costing, i, graphreader);
+            if (target_status_[i].threshold == 0) {
+              target_status_[i].threshold = -1;
+              if (remaining_targets_ > 0) {
+                remaining_targets_--;
+              }
+            }
           }
         }
-      }
-    }
 
-    // Iterate all source locations in a forward search
-    for (uint32_t i = 0; i < source_count_; i++) {
-      if (source_status_[i].threshold > 0) {
-        source_status_[i].threshold--;
-        ForwardSearch(i, n, graphreader);
-        if (source_status_[i].threshold == 0) {
-          source_status_[i].threshold = -1;
-          if (remaining_sources_ > 0) {
-            remaining_sources_--;
+        // Iterate all source locations in a forward search
+        for (uint32_t i = 0; i < source_count_; i++) {
+          if (source_status_[i].threshold > 0) {
+            source_status_[i].threshold--;
+            ForwardSearch(costing, i, n, graphreader);
+            if (source_status_[i].threshold == 0) {
+              source_status_[i].threshold = -1;
+              if (remaining_sources_ > 0) {
+                remaining_sources_--;
+              }
+            }
           }
         }
       }
-    }
 
-    // Break out when remaining sources and targets to expand are both 0
-    if (remaining_sources_ == 0 && remaining_targets_ == 0) {
-      LOG_DEBUG("SourceToTarget iterations: n = " + std::to_string(n));
-      break;
-    }
+      // Break out when remaining sources and targets to expand are both 0
+      if (remaining_sources_ == 0 && remaining_targets_ == 0) {
+        LOG_DEBUG("SourceToTarget iterations: n = " + std::to_string(n));
+        break;
+      }
 
-    // Protect against edge cases that may lead to never breaking out of
-    // this loop. This should never occur but lets make sure.
-    if (n >= kMaxMatrixIterations) {
-      throw valhalla_exception_t{430};
+      // Protect against edge cases that may lead to never breaking out of
+      // this loop. This should never occur but lets make sure.
+      if (n >= kMaxMatrixIterations) {
+        throw valhalla_exception_t{430};
+      }
+      n++;
     }
-    n++;
-  }
+  });
 
   // Form the time, distance matrix from the destinations list
   uint32_t idx = 0;
@@ -232,7 +323,11 @@ void CostMatrix::Initialize(
 }
 
 // Iterate the forward search from the source/origin location.
-void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphReader& graphreader) {
+template <typename cost_t>
+void CostMatrix::ForwardSearch(const StaticCost<cost_t> costing,
+                               const uint32_t index,
+                               const uint32_t n,
+                               GraphReader& graphreader) {
   // Get the next edge from the adjacency list for this source location
   auto& adj = source_adjacency_[index];
   auto& edgelabels = source_edgelabel_[index];
@@ -309,14 +404,14 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
       // Skip this edge if no access is allowed (based on costing method)
       // or if a complex restriction prevents transition onto this edge.
       bool has_time_restrictions = false;
-      if (!costing_->Allowed(directededge, pred, tile, edgeid, 0, 0, has_time_restrictions) ||
-          costing_->Restricted(directededge, pred, edgelabels, tile, edgeid, true)) {
+      if (!costing.Allowed(directededge, pred, tile, edgeid, 0, 0, has_time_restrictions) ||
+          costing->Restricted(directededge, pred, edgelabels, tile, edgeid, true)) {
         continue;
       }
 
       // Get cost. Separate out transition cost.
-      Cost tc = costing_->TransitionCost(directededge, nodeinfo, pred);
-      Cost newcost = pred.cost() + tc + costing_->EdgeCost(directededge, tile);
+      Cost tc = costing.TransitionCost(directededge, nodeinfo, pred);
+      Cost newcost = pred.cost() + tc + costing.EdgeCost(directededge, tile);
 
       // Check if edge is temporarily labeled and this path has less cost. If
       // less cost the predecessor is updated along with new cost and distance.
@@ -374,7 +469,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
   const GraphTile* tile = graphreader.GetGraphTile(node);
   if (tile != nullptr) {
     const NodeInfo* nodeinfo = tile->node(node);
-    if (costing_->Allowed(nodeinfo)) {
+    if (costing.Allowed(nodeinfo)) {
       expand(tile, node, nodeinfo, pred, pred_idx, false);
     }
   }
@@ -453,8 +548,8 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
           best_connection_[idx].Update(pred.edgeid(), oppedge, Cost(c, s), d);
           if (best_connection_[idx].threshold == 0) {
             best_connection_[idx].threshold =
-                n + GetThreshold(mode_,
-                                 source_edgelabel_[source].size() + target_edgelabel_[target].size());
+                n +
+                GetThreshold(mode_, source_edgelabel_[source].size() + TargetLabelCount(target));
           }
 
           // Update status and update threshold if this is the last location
@@ -468,6 +563,19 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
 // Update status when a connection is found.
 void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
+  UpdateSourceStatus(source, target);
+
+  // The target status is shared by all sources, so it has to wait while the
+  // forward searches run concurrently
+  if (queue_updates_) {
+    queued_target_updates_[source].emplace_back(target, source_edgelabel_[source].size());
+  } else {
+    UpdateTargetStatus(source, target, source_edgelabel_[source].size());
+  }
+}
+
+// Update the source status when a connection is found.
+void CostMatrix::UpdateSourceStatus(const uint32_t source, const uint32_t target) {
   // Remove the target from the source status
   auto& s = source_status_[source].remaining_locations;
   auto it = s.find(target);
@@ -477,35 +585,48 @@ void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
       // At least 1 connection has been found to each target for this source.
       // Set a threshold to continue search for a limited number of times.
       source_status_[source].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+          GetThreshold(mode_, source_edgelabel_[source].size() + TargetLabelCount(target));
     }
   }
+}
 
+// Update the target status when a connection is found.
+void CostMatrix::UpdateTargetStatus(const uint32_t source,
+                                    const uint32_t target,
+                                    const uint32_t source_label_count) {
   // Remove the source from the target status
   auto& t = target_status_[target].remaining_locations;
-  it = t.find(source);
+  auto it = t.find(source);
   if (it != t.end()) {
     t.erase(it);
     if (t.empty() && target_status_[target].threshold > 0) {
       // At least 1 connection has been found to each source for this target.
       // Set a threshold to continue search for a limited number of times.
       target_status_[target].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+          GetThreshold(mode_, source_label_count + TargetLabelCount(target));
     }
   }
 }
 
 // Expand the backwards search trees.
-void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader) {
+template <typename cost_t>
+void CostMatrix::BackwardSearch(const StaticCost<cost_t> costing,
+                                const uint32_t index,
+                                GraphReader& graphreader) {
   // Get the next edge from the adjacency list for this target location
   auto& adj = target_adjacency_[index];
   auto& edgelabels = target_edgelabel_[index];
   uint32_t pred_idx = adj->pop();
   if (pred_idx == kInvalidLabel) {
     // Backward search is exhausted - mark this and update so we don't
-    // extend searches more than we need to
-    for (uint32_t source = 0; source < source_count_; source++) {
-      UpdateStatus(source, index);
+    // extend searches more than we need to (once the pass is done when
+    // searches run concurrently as the source status is shared)
+    if (queue_updates_) {
+      exhausted_targets_[index] = 1;
+    } else {
+      for (uint32_t source = 0; source < source_count_; source++) {
+        UpdateStatus(source, index);
+      }
     }
     target_status_[index].threshold = 0;
     return;
@@ -581,17 +702,17 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
       // or if a complex restriction prevents transition onto this edge.
       const DirectedEdge* opp_edge = t2->directededge(oppedge);
       bool has_time_restrictions = false;
-      if (!costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedge, 0, 0,
-                                    has_time_restrictions) ||
-          costing_->Restricted(directededge, pred, edgelabels, tile, edgeid, false)) {
+      if (!costing.AllowedReverse(directededge, pred, opp_edge, t2, oppedge, 0, 0,
+                                  has_time_restrictions) ||
+          costing->Restricted(directededge, pred, edgelabels, tile, edgeid, false)) {
         continue;
       }
 
       // Get cost. Use opposing edge for EdgeCost. Separate the transition seconds so
       // we can properly recover elapsed time on the reverse path.
-      Cost tc = costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
-                                                opp_pred_edge);
-      Cost newcost = pred.cost() + tc + costing_->EdgeCost(opp_edge, tile);
+      Cost tc = costing.TransitionCostReverse(directededge->localedgeidx(), nodeinfo, opp_edge,
+                                              opp_pred_edge);
+      Cost newcost = pred.cost() + tc + costing.EdgeCost(opp_edge, t2);
 
       // Check if edge is temporarily labeled and this path has less cost. If
       // less cost the predecessor is updated along with new cost and distance.
@@ -615,7 +736,11 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
       adj->add(idx);
 
       // Add to the list of targets that have reached this edge
-      targets_[edgeid].push_back(index);
+      if (queue_updates_) {
+        queued_target_edges_[index].push_back(edgeid);
+      } else {
+        targets_[edgeid].push_back(index);
+      }
     }
 
     // Handle transitions - expand from the end node of the transition
@@ -644,7 +769,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
   const GraphTile* tile = graphreader.GetGraphTile(node);
   if (tile != nullptr) {
     const NodeInfo* nodeinfo = tile->node(node);
-    if (costing_->Allowed(nodeinfo)) {
+    if (costing.Allowed(nodeinfo)) {
       // Get the opposing predecessor directed edge. Need to make sure we get
       // the correct one if a transition occurred
       const DirectedEdge* opp_pred_edge;
@@ -825,5 +950,39 @@ void CostMatrix::SetTargets(baldr::GraphReader& graphreader,
   }
 }
 
+
+// The searches for each costing DispatchCost binds, BucketMatrix runs them too
+template void CostMatrix::ForwardSearch(const StaticCost<AutoCost>,
+                                        const uint32_t,
+                                        const uint32_t,
+                                        GraphReader&);
+template void CostMatrix::BackwardSearch(const StaticCost<AutoCost>, const uint32_t, GraphReader&);
+template void CostMatrix::ForwardSearch(const StaticCost<TruckCost>,
+                                        const uint32_t,
+                                        const uint32_t,
+                                        GraphReader&);
+template void CostMatrix::BackwardSearch(const StaticCost<TruckCost>, const uint32_t, GraphReader&);
+template void CostMatrix::ForwardSearch(const StaticCost<PedestrianCost>,
+                                        const uint32_t,
+                                        const uint32_t,
+                                        GraphReader&);
+template void CostMatrix::BackwardSearch(const StaticCost<PedestrianCost>,
+                                         const uint32_t,
+                                         GraphReader&);
+template void CostMatrix::ForwardSearch(const StaticCost<BicycleCost>,
+                                        const uint32_t,
+                                        const uint32_t,
+                                        GraphReader&);
+template void CostMatrix::BackwardSearch(const StaticCost<BicycleCost>,
+                                         const uint32_t,
+                                         GraphReader&);
+template void CostMatrix::ForwardSearch(const StaticCost<DynamicCost>,
+                                        const uint32_t,
+                                        const uint32_t,
+                                        GraphReader&);
+template void CostMatrix::BackwardSearch(const StaticCost<DynamicCost>,
+                                         const uint32_t,
+                                         GraphReader&);
+
 } // namespace thor
 } // namespace valhalla
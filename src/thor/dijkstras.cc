@@ -141,7 +141,9 @@ Dijkstras::SetTime(google::protobuf::RepeatedPtrField<valhalla::Location>& locat
 }
 
 // Expand from a node in the forward direction
-void Dijkstras::ExpandForward(GraphReader& graphreader,
+template <typename cost_t>
+void Dijkstras::ExpandForward(const StaticCost<cost_t> costing,
+                              GraphReader& graphreader,
                               const GraphId& node,
                               const EdgeLabel& pred,
                               const uint32_t pred_idx,
@@ -167,7 +169,7 @@ void Dijkstras::ExpandForward(GraphReader& graphreader,
   }
 
   // Bail if we cant expand from here
-  if (!costing_->Allowed(nodeinfo)) {
+  if (!costing.Allowed(nodeinfo)) {
     return;
   }
 
@@ -200,25 +202,25 @@ void Dijkstras::ExpandForward(GraphReader& graphreader,
     bool has_time_restrictions = false;
     if (has_date_time_) {
       // With date time we check time dependent restrictions and access
-      if (!costing_->Allowed(directededge, pred, tile, edgeid, localtime, nodeinfo->timezone(),
-                             has_time_restrictions) ||
-          costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true, todo, localtime,
-                               nodeinfo->timezone())) {
+      if (!costing.Allowed(directededge, pred, tile, edgeid, localtime, nodeinfo->timezone(),
+                           has_time_restrictions) ||
+          costing->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true, todo,
+                              localtime, nodeinfo->timezone())) {
         continue;
       }
     } else {
-      if (!costing_->Allowed(directededge, pred, tile, edgeid, 0, 0, has_time_restrictions) ||
-          costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true)) {
+      if (!costing.Allowed(directededge, pred, tile, edgeid, 0, 0, has_time_restrictions) ||
+          costing->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, true)) {
         continue;
       }
     }
 
     // Compute the cost to the end of this edge
-    Cost transition_cost = costing_->TransitionCost(directededge, nodeinfo, pred);
+    Cost transition_cost = costing.TransitionCost(directededge, nodeinfo, pred);
     Cost newcost =
         pred.cost() +
-        costing_->EdgeCost(directededge, tile,
-                           has_date_time_ ? seconds_of_week : kConstrainedFlowSecondOfDay) +
+        costing.EdgeCost(directededge, tile,
+                         has_date_time_ ? seconds_of_week : kConstrainedFlowSecondOfDay) +
         transition_cost;
 
     // Check if edge is temporarily labeled and this path has less cost. If
@@ -250,7 +252,8 @@ void Dijkstras::ExpandForward(GraphReader& graphreader,
   if (!from_transition && nodeinfo->transition_count() > 0) {
     const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
-      ExpandForward(graphreader, trans->endnode(), pred, pred_idx, true, localtime, seconds_of_week);
+      ExpandForward(costing, graphreader, trans->endnode(), pred, pred_idx, true, localtime,
+                    seconds_of_week);
     }
   }
 }
@@ -275,39 +278,48 @@ void Dijkstras::Compute(google::protobuf::RepeatedPtrField<valhalla::Location>&
   uint32_t start_seconds_of_week;
   auto node_id = bdedgelabels_.empty() ? GraphId{} : bdedgelabels_[0].endnode();
   std::tie(start_time, start_seconds_of_week) = SetTime(origin_locations, node_id, graphreader);
+  if (has_date_time_) {
+    costing_->set_start_time(start_seconds_of_week);
+  }
 
-  // Compute the isotile
-  auto cb_decision = ExpansionRecommendation::continue_expansion;
-  while (cb_decision != ExpansionRecommendation::stop_expansion) {
-    // Get next element from adjacency list. Check that it is valid. An
-    // invalid label indicates there are no edges that can be expanded.
-    uint32_t predindex = adjacencylist_->pop();
-    if (predindex == kInvalidLabel) {
-      return;
-    }
+  // Compute the isotile, with the costing bound to its concrete type for the expansion
+  DispatchCost(*costing_, [this, &graphreader, start_time,
+                           start_seconds_of_week](const auto costing) {
+    auto cb_decision = ExpansionRecommendation::continue_expansion;
+    while (cb_decision != ExpansionRecommendation::stop_expansion) {
+      // Get next element from adjacency list. Check that it is valid. An
+      // invalid label indicates there are no edges that can be expanded.
+      uint32_t predindex = adjacencylist_->pop();
+      if (predindex == kInvalidLabel) {
+        return;
+      }
 
-    // Copy the EdgeLabel for use in costing and settle the edge.
-    EdgeLabel pred = bdedgelabels_[predindex];
-    edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+      // Copy the EdgeLabel for use in costing and settle the edge.
+      EdgeLabel pred = bdedgelabels_[predindex];
+      edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
 
-    // Update local time and seconds from beginning of the week
-    uint64_t localtime = start_time + static_cast<uint32_t>(pred.cost().secs);
-    int32_t seconds_of_week = start_seconds_of_week + static_cast<uint32_t>(pred.cost().secs);
-    if (seconds_of_week > midgard::kSecondsPerWeek) {
-      seconds_of_week -= midgard::kSecondsPerWeek;
-    }
+      // Update local time and seconds from beginning of the week
+      uint64_t localtime = start_time + static_cast<uint32_t>(pred.cost().secs);
+      int32_t seconds_of_week = start_seconds_of_week + static_cast<uint32_t>(pred.cost().secs);
+      if (seconds_of_week > midgard::kSecondsPerWeek) {
+        seconds_of_week -= midgard::kSecondsPerWeek;
+      }
 
-    // Check if we should stop
-    cb_decision = ShouldExpand(graphreader, pred, InfoRoutingType::forward);
-    if (cb_decision != ExpansionRecommendation::prune_expansion) {
-      // Expand from the end node in forward direction.
-      ExpandForward(graphreader, pred.endnode(), pred, predindex, false, localtime, seconds_of_week);
+      // Check if we should stop
+      cb_decision = ShouldExpand(graphreader, pred, InfoRoutingType::forward);
+      if (cb_decision != ExpansionRecommendation::prune_expansion) {
+        // Expand from the end node in forward direction.
+        ExpandForward(costing, graphreader, pred.endnode(), pred, predindex, false, localtime,
+                      seconds_of_week);
+      }
     }
-  }
+  });
 }
 
 // Expand from a node in reverse direction.
-void Dijkstras::ExpandReverse(GraphReader& graphreader,
+template <typename cost_t>
+void Dijkstras::ExpandReverse(const StaticCost<cost_t> costing,
+                              GraphReader& graphreader,
                               const GraphId& node,
                               const BDEdgeLabel& pred,
                               const uint32_t pred_idx,
@@ -334,7 +346,7 @@ void Dijkstras::ExpandReverse(GraphReader& graphreader,
   }
 
   // Bail if we cant expand from here
-  if (!costing_->Allowed(nodeinfo)) {
+  if (!costing.Allowed(nodeinfo)) {
     return;
   }
 
@@ -373,26 +385,26 @@ void Dijkstras::ExpandReverse(GraphReader& graphreader,
     bool has_time_restrictions = false;
     if (has_date_time_) {
       // With date time we check time dependent restrictions and access
-      if (!costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedge, localtime,
-                                    nodeinfo->timezone(), has_time_restrictions) ||
-          costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, false, todo,
-                               localtime, nodeinfo->timezone())) {
+      if (!costing.AllowedReverse(directededge, pred, opp_edge, t2, oppedge, localtime,
+                                  nodeinfo->timezone(), has_time_restrictions) ||
+          costing->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, false, todo,
+                              localtime, nodeinfo->timezone())) {
         continue;
       }
     } else {
-      if (!costing_->AllowedReverse(directededge, pred, opp_edge, t2, oppedge, 0, 0,
-                                    has_time_restrictions) ||
-          costing_->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, false)) {
+      if (!costing.AllowedReverse(directededge, pred, opp_edge, t2, oppedge, 0, 0,
+                                  has_time_restrictions) ||
+          costing->Restricted(directededge, pred, bdedgelabels_, tile, edgeid, false)) {
         continue;
       }
     }
 
     // Compute the cost to the end of this edge with separate transition cost
-    Cost transition_cost = costing_->TransitionCostReverse(directededge->localedgeidx(), nodeinfo,
-                                                           opp_edge, opp_pred_edge);
+    Cost transition_cost = costing.TransitionCostReverse(directededge->localedgeidx(), nodeinfo,
+                                                         opp_edge, opp_pred_edge);
     Cost newcost = pred.cost() +
-                   costing_->EdgeCost(opp_edge, t2,
-                                      has_date_time_ ? seconds_of_week : kConstrainedFlowSecondOfDay);
+                   costing.EdgeCost(opp_edge, t2,
+                                    has_date_time_ ? seconds_of_week : kConstrainedFlowSecondOfDay);
     newcost.cost += transition_cost.cost;
 
     // Check if edge is temporarily labeled and this path has less cost. If
@@ -420,8 +432,8 @@ void Dijkstras::ExpandReverse(GraphReader& graphreader,
   if (!from_transition && nodeinfo->transition_count() > 0) {
     const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
     for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
-      ExpandReverse(graphreader, trans->endnode(), pred, pred_idx, opp_pred_edge, true, localtime,
-                    seconds_of_week);
+      ExpandReverse(costing, graphreader, trans->endnode(), pred, pred_idx, opp_pred_edge, true,
+                    localtime, seconds_of_week);
     }
   }
 }
@@ -445,39 +457,45 @@ void Dijkstras::ComputeReverse(google::protobuf::RepeatedPtrField<valhalla::Loca
   uint32_t start_seconds_of_week;
   auto node_id = bdedgelabels_.empty() ? GraphId{} : bdedgelabels_[0].endnode();
   std::tie(start_time, start_seconds_of_week) = SetTime(dest_locations, node_id, graphreader);
+  if (has_date_time_) {
+    costing_->set_start_time(start_seconds_of_week);
+  }
 
-  // Compute the isotile
-  auto cb_decision = ExpansionRecommendation::continue_expansion;
-  while (cb_decision != ExpansionRecommendation::stop_expansion) {
-    // Get next element from adjacency list. Check that it is valid. An
-    // invalid label indicates there are no edges that can be expanded.
-    uint32_t predindex = adjacencylist_->pop();
-    if (predindex == kInvalidLabel) {
-      return;
-    }
-
-    // Copy the EdgeLabel for use in costing and settle the edge.
-    BDEdgeLabel pred = bdedgelabels_[predindex];
-    edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
-
-    // Get the opposing predecessor directed edge. Need to make sure we get
-    // the correct one if a transition occurred
-    const DirectedEdge* opp_pred_edge =
-        graphreader.GetGraphTile(pred.opp_edgeid())->directededge(pred.opp_edgeid());
-
-    // Update local time and seconds from beginning of the week
-    uint64_t localtime = start_time + static_cast<uint32_t>(pred.cost().secs);
-    int32_t seconds_of_week = DateTime::normalize_seconds_of_week(
-        start_seconds_of_week - static_cast<uint32_t>(pred.cost().secs));
+  // Compute the isotile, with the costing bound to its concrete type for the expansion
+  DispatchCost(*costing_, [this, &graphreader, start_time,
+                           start_seconds_of_week](const auto costing) {
+    auto cb_decision = ExpansionRecommendation::continue_expansion;
+    while (cb_decision != ExpansionRecommendation::stop_expansion) {
+      // Get next element from adjacency list. Check that it is valid. An
+      // invalid label indicates there are no edges that can be expanded.
+      uint32_t predindex = adjacencylist_->pop();
+      if (predindex == kInvalidLabel) {
+        return;
+      }
 
-    // Check if we should stop
-    cb_decision = ShouldExpand(graphreader, pred, InfoRoutingType::forward);
-    if (cb_decision != ExpansionRecommendation::prune_expansion) {
-      // Expand from the end node in forward direction.
-      ExpandReverse(graphreader, pred.endnode(), pred, predindex, opp_pred_edge, false, localtime,
-                    seconds_of_week);
+      // Copy the EdgeLabel for use in costing and settle the edge.
+      BDEdgeLabel pred = bdedgelabels_[predindex];
+      edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
+
+      // Get the opposing predecessor directed edge. Need to make sure we get
+      // the correct one if a transition occurred
+      const DirectedEdge* opp_pred_edge =
+          graphreader.GetGraphTile(pred.opp_edgeid())->directededge(pred.opp_edgeid());
+
+      // Update local time and seconds from beginning of the week
+      uint64_t localtime = start_time + static_cast<uint32_t>(pred.cost().secs);
+      int32_t seconds_of_week = DateTime::normalize_seconds_of_week(
+          start_seconds_of_week - static_cast<uint32_t>(pred.cost().secs));
+
+      // Check if we should stop
+      cb_decision = ShouldExpand(graphreader, pred, InfoRoutingType::forward);
+      if (cb_decision != ExpansionRecommendation::prune_expansion) {
+        // Expand from the end node in forward direction.
+        ExpandReverse(costing, graphreader, pred.endnode(), pred, predindex, opp_pred_edge, false,
+                      localtime, seconds_of_week);
+      }
     }
-  }
+  });
 }
 
 // Expand from a node in forward direction using multimodal.
@@ -38,8 +38,8 @@ std::string thor_worker_t::isochrones(Api& request) {
                                           mode_costing, mode);
 
   // turn it into geojson
-  auto isolines =
-      grid->GenerateContours(contours, options.polygons(), options.denoise(), options.generalize());
+  auto isolines = grid->GenerateContours(contours, options.polygons(), options.denoise(),
+                                         options.generalize(), isochrone_threads);
 
   return tyr::serializeIsochrones<PointLL>(request, isolines, options.polygons(), colors,
                                            options.show_locations());
@@ -1,6 +1,7 @@
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/pedestriancost.h"
+#include "thor/bucketmatrix.h"
 #include "thor/costmatrix.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
@@ -45,7 +46,21 @@ std::string thor_worker_t::matrix(Api& request) {
   auto costmatrix = [&]() {
     thor::CostMatrix matrix;
     return matrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing, mode,
-                                 max_matrix_distance.find(costing)->second);
+                                 max_matrix_distance.find(costing)->second, matrix_readers);
+  };
+  auto bucketmatrix = [&]() {
+    // Target sets are only reused by requests with the same costing options and avoids
+    std::string costing_key = costing;
+    const int costing_index = static_cast<int>(options.costing());
+    if (options.costing_options_size() > costing_index) {
+      costing_key += options.costing_options(costing_index).SerializeAsString();
+    }
+    for (const auto& avoid : options.avoid_edges()) {
+      costing_key += avoid.SerializeAsString();
+    }
+    return bucket_matrix.SourceToTarget(options.sources(), options.targets(), *reader, mode_costing,
+                                        mode, max_matrix_distance.find(costing)->second,
+                                        costing_key);
   };
   auto timedistancematrix = [&]() {
     thor::TimeDistanceMatrix matrix;
@@ -80,6 +95,9 @@ std::string thor_worker_t::matrix(Api& request) {
     case TIME_DISTANCE_MATRIX:
       time_distances = timedistancematrix();
       break;
+    case BUCKET_MATRIX:
+      time_distances = bucketmatrix();
+      break;
   }
   return tyr::serializeMatrix(request, time_distances, distance_scale);
 }
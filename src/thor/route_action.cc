@@ -287,6 +287,16 @@ std::vector<std::vector<thor::PathInfo>> thor_worker_t::get_path(PathAlgorithm*
     cost->set_allow_destination_only(false);
   }
   cost->set_pass(0);
+
+  // Bidirectional A* routes may be found on the contraction hierarchy overlay instead. Anything
+  // it can't route, or routes against the turn restrictions of the costing, is left to A*
+  if (path_algorithm == &bidir_astar && cch_query.Supports(*cost, options)) {
+    auto paths = cch_query.GetBestPath(origin, destination, *reader, mode_costing, mode, options);
+    cch_query.Clear();
+    if (!paths.empty()) {
+      return paths;
+    }
+  }
   auto paths = path_algorithm->GetBestPath(origin, destination, *reader, mode_costing, mode, options);
 
   // Check if we should run a second pass pedestrian route with different A*
@@ -220,7 +220,8 @@ inline bool TimeDepForward::ExpandForwardInner(GraphReader& graphreader,
     if (t2 == nullptr) {
       return false;
     }
-    sortcost += astarheuristic_.Get(t2->get_node_ll(meta.edge->endnode()), dist);
+    sortcost += astarheuristic_.Get(t2->get_node_ll(meta.edge->endnode()), meta.edge->endnode(),
+                                    dist);
   }
 
   // Add to the adjacency list and edge labels.
@@ -269,6 +270,13 @@ TimeDepForward::GetBestPath(valhalla::Location& origin,
   // a timezone for converting a date_time of "current" to seconds_of_week
   SetOrigin(graphreader, origin, destination, kInvalidSecondsOfWeek);
 
+  // Tighten the A* heuristic with the landmarks, if there are any for this costing
+  const baldr::LandmarkTable* landmarks = landmark_table(costing_->access_mode());
+  if (landmarks != nullptr) {
+    astarheuristic_.InitLandmarks(landmarks, LandmarkTargets(graphreader, destination, true),
+                                  false);
+  }
+
   // Set the origin timezone to be the timezone at the end node
   origin_tz_index_ = edgelabels_.size() == 0 ? 0 : GetTimezone(graphreader, edgelabels_[0].endnode());
   if (origin_tz_index_ == 0) {
@@ -284,6 +292,7 @@ TimeDepForward::GetBestPath(valhalla::Location& origin,
   // Set seconds from beginning of the week
   seconds_of_week_ = DateTime::day_of_week(origin.date_time()) * midgard::kSecondsPerDay +
                      DateTime::seconds_from_midnight(origin.date_time());
+  costing_->set_start_time(seconds_of_week_);
   // Update hierarchy limits
   ModifyHierarchyLimits(mindist, density);
 
@@ -336,6 +345,11 @@ TimeDepForward::GetBestPath(valhalla::Location& origin,
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
 
+    // setting this edge as settled
+    if (expansion_callback_) {
+      expansion_callback_(graphreader, "timedep_forward", pred.edgeid(), "s", false);
+    }
+
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations. NOTE: due to somewhat high
     // penalty for entering a destination only (private) road this value needs to
@@ -276,7 +276,8 @@ inline bool TimeDepReverse::ExpandReverseInner(GraphReader& graphreader,
     if (t2 == nullptr) {
       return false;
     }
-    sortcost += astarheuristic_.Get(t2->get_node_ll(meta.edge->endnode()), dist);
+    sortcost += astarheuristic_.Get(t2->get_node_ll(meta.edge->endnode()), meta.edge->endnode(),
+                                    dist);
   }
 
   // Add edge label, add to the adjacency list and set edge status
@@ -325,12 +326,19 @@ TimeDepReverse::GetBestPath(valhalla::Location& origin,
   // Set seconds from beginning of the week
   seconds_of_week_ = DateTime::day_of_week(destination.date_time()) * midgard::kSecondsPerDay +
                      DateTime::seconds_from_midnight(destination.date_time());
+  costing_->set_start_time(seconds_of_week_);
 
   // Initialize the locations. For a reverse path search the destination location
   // is used as the "origin" and the origin location is used as the "destination".
   uint32_t density = SetDestination(graphreader, origin);
   SetOrigin(graphreader, destination, origin, seconds_of_week_);
 
+  // Tighten the A* heuristic with the landmarks, if there are any for this costing
+  const baldr::LandmarkTable* landmarks = landmark_table(access_mode_);
+  if (landmarks != nullptr) {
+    astarheuristic_.InitLandmarks(landmarks, LandmarkTargets(graphreader, origin, false), true);
+  }
+
   // Set the destination timezone
   dest_tz_index_ =
       edgelabels_rev_.size() == 0 ? 0 : GetTimezone(graphreader, edgelabels_rev_[0].endnode());
@@ -398,6 +406,11 @@ TimeDepReverse::GetBestPath(valhalla::Location& origin,
       edgestatus_.Update(pred.edgeid(), EdgeSet::kPermanent);
     }
 
+    // setting this edge as settled, sending the opposing because this is the reverse tree
+    if (expansion_callback_) {
+      expansion_callback_(graphreader, "timedep_reverse", pred.opp_edgeid(), "s", false);
+    }
+
     // Check that distance is converging towards the destination. Return route
     // failure if no convergence for TODO iterations
     float dist2dest = pred.distance();
@@ -67,22 +67,22 @@ void AssignAdmins(const AttributesController& controller,
       TripLeg_Admin* trip_admin = trip_path.add_admin();
 
       // Set country code if requested
-      if (controller.attributes.at(kAdminCountryCode)) {
+      if (controller(kAdminCountryCode)) {
         trip_admin->set_country_code(admin_info.country_iso());
       }
 
       // Set country text if requested
-      if (controller.attributes.at(kAdminCountryText)) {
+      if (controller(kAdminCountryText)) {
         trip_admin->set_country_text(admin_info.country_text());
       }
 
       // Set state code if requested
-      if (controller.attributes.at(kAdminStateCode)) {
+      if (controller(kAdminStateCode)) {
         trip_admin->set_state_code(admin_info.state_iso());
       }
 
       // Set state text if requested
-      if (controller.attributes.at(kAdminStateText)) {
+      if (controller(kAdminStateText)) {
         trip_admin->set_state_text(admin_info.state_text());
       }
     }
@@ -113,19 +113,19 @@ void SetShapeAttributes(const AttributesController& controller,
       double time = edge_time * distance_pct;                      // seconds
 
       // Set shape attributes time per shape point if requested
-      if (controller.attributes.at(kShapeAttributesTime)) {
+      if (controller(kShapeAttributesTime)) {
         // convert time to milliseconds and then round to an integer
         trip_path.mutable_shape_attributes()->add_time((time * kMillisecondPerSec) + 0.5);
       }
 
       // Set shape attributes length per shape point if requested
-      if (controller.attributes.at(kShapeAttributesLength)) {
+      if (controller(kShapeAttributesLength)) {
         // convert length to decimeters and then round to an integer
         trip_path.mutable_shape_attributes()->add_length((distance * kDecimeterPerMeter) + 0.5);
       }
 
       // Set shape attributes speed per shape point if requested
-      if (controller.attributes.at(kShapeAttributesSpeed)) {
+      if (controller(kShapeAttributesSpeed)) {
         // convert speed to decimeters per sec and then round to an integer
         trip_path.mutable_shape_attributes()->add_speed((distance * kDecimeterPerMeter / time) + 0.5);
       }
@@ -395,13 +395,13 @@ void SetHeadings(TripLeg_Edge* trip_edge,
                  const DirectedEdge* edge,
                  const std::vector<PointLL>& shape,
                  const uint32_t begin_index) {
-  if (controller.attributes.at(kEdgeBeginHeading) || controller.attributes.at(kEdgeEndHeading)) {
+  if (controller(kEdgeBeginHeading) || controller(kEdgeEndHeading)) {
     float offset = GetOffsetForHeading(edge->classification(), edge->use());
-    if (controller.attributes.at(kEdgeBeginHeading)) {
+    if (controller(kEdgeBeginHeading)) {
       trip_edge->set_begin_heading(
           std::round(PointLL::HeadingAlongPolyline(shape, offset, begin_index, shape.size() - 1)));
     }
-    if (controller.attributes.at(kEdgeEndHeading)) {
+    if (controller(kEdgeEndHeading)) {
       trip_edge->set_end_heading(
           std::round(PointLL::HeadingAtEndOfPolyline(shape, offset, begin_index, shape.size() - 1)));
     }
@@ -431,20 +431,19 @@ void AddTransitNodes(TripLeg_Node* trip_node,
 
     if (transit_station) {
       // Set onstop_id if requested
-      if (controller.attributes.at(kNodeTransitStationInfoOnestopId) &&
-          transit_station->one_stop_offset()) {
+      if (controller(kNodeTransitStationInfoOnestopId) && transit_station->one_stop_offset()) {
         transit_station_info->set_onestop_id(graphtile->GetName(transit_station->one_stop_offset()));
       }
 
       // Set name if requested
-      if (controller.attributes.at(kNodeTransitStationInfoName) && transit_station->name_offset()) {
+      if (controller(kNodeTransitStationInfoName) && transit_station->name_offset()) {
         transit_station_info->set_name(graphtile->GetName(transit_station->name_offset()));
       }
 
       // Set latitude and longitude
       LatLng* stop_ll = transit_station_info->mutable_ll();
       // Set transit stop lat/lon if requested
-      if (controller.attributes.at(kNodeTransitStationInfoLatLon)) {
+      if (controller(kNodeTransitStationInfoLatLon)) {
         PointLL ll = node->latlng(start_tile->header()->base_ll());
         stop_ll->set_lat(ll.lat());
         stop_ll->set_lng(ll.lng());
@@ -459,20 +458,19 @@ void AddTransitNodes(TripLeg_Node* trip_node,
 
     if (transit_egress) {
       // Set onstop_id if requested
-      if (controller.attributes.at(kNodeTransitEgressInfoOnestopId) &&
-          transit_egress->one_stop_offset()) {
+      if (controller(kNodeTransitEgressInfoOnestopId) && transit_egress->one_stop_offset()) {
         transit_egress_info->set_onestop_id(graphtile->GetName(transit_egress->one_stop_offset()));
       }
 
       // Set name if requested
-      if (controller.attributes.at(kNodeTransitEgressInfoName) && transit_egress->name_offset()) {
+      if (controller(kNodeTransitEgressInfoName) && transit_egress->name_offset()) {
         transit_egress_info->set_name(graphtile->GetName(transit_egress->name_offset()));
       }
 
       // Set latitude and longitude
       LatLng* stop_ll = transit_egress_info->mutable_ll();
       // Set transit stop lat/lon if requested
-      if (controller.attributes.at(kNodeTransitEgressInfoLatLon)) {
+      if (controller(kNodeTransitEgressInfoLatLon)) {
         PointLL ll = node->latlng(start_tile->header()->base_ll());
         stop_ll->set_lat(ll.lat());
         stop_ll->set_lng(ll.lng());
@@ -528,7 +526,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   auto edgeinfo = graphtile->edgeinfo(directededge->edgeinfo_offset());
 
   // Add names to edge if requested
-  if (controller.attributes.at(kEdgeNames)) {
+  if (controller(kEdgeNames)) {
     auto names_and_types = edgeinfo.GetNamesAndTypes();
     for (const auto& name_and_type : names_and_types) {
       auto* trip_edge_name = trip_edge->mutable_name()->Add();
@@ -550,7 +548,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
       for (const auto& sign : edge_signs) {
         switch (sign.type()) {
           case Sign::Type::kExitNumber: {
-            if (controller.attributes.at(kEdgeSignExitNumber)) {
+            if (controller(kEdgeSignExitNumber)) {
               auto* trip_sign_exit_number = trip_sign->mutable_exit_numbers()->Add();
               trip_sign_exit_number->set_text(sign.text());
               trip_sign_exit_number->set_is_route_number(sign.is_route_num());
@@ -558,7 +556,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
             break;
           }
           case Sign::Type::kExitBranch: {
-            if (controller.attributes.at(kEdgeSignExitBranch)) {
+            if (controller(kEdgeSignExitBranch)) {
               auto* trip_sign_exit_onto_street = trip_sign->mutable_exit_onto_streets()->Add();
               trip_sign_exit_onto_street->set_text(sign.text());
               trip_sign_exit_onto_street->set_is_route_number(sign.is_route_num());
@@ -566,7 +564,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
             break;
           }
           case Sign::Type::kExitToward: {
-            if (controller.attributes.at(kEdgeSignExitToward)) {
+            if (controller(kEdgeSignExitToward)) {
               auto* trip_sign_exit_toward_location =
                   trip_sign->mutable_exit_toward_locations()->Add();
               trip_sign_exit_toward_location->set_text(sign.text());
@@ -575,7 +573,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
             break;
           }
           case Sign::Type::kExitName: {
-            if (controller.attributes.at(kEdgeSignExitName)) {
+            if (controller(kEdgeSignExitName)) {
               auto* trip_sign_exit_name = trip_sign->mutable_exit_names()->Add();
               trip_sign_exit_name->set_text(sign.text());
               trip_sign_exit_name->set_is_route_number(sign.is_route_num());
@@ -583,7 +581,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
             break;
           }
           case Sign::Type::kGuideBranch: {
-            if (controller.attributes.at(kEdgeSignGuideBranch)) {
+            if (controller(kEdgeSignGuideBranch)) {
               auto* trip_sign_guide_onto_street = trip_sign->mutable_guide_onto_streets()->Add();
               trip_sign_guide_onto_street->set_text(sign.text());
               trip_sign_guide_onto_street->set_is_route_number(sign.is_route_num());
@@ -591,7 +589,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
             break;
           }
           case Sign::Type::kGuideToward: {
-            if (controller.attributes.at(kEdgeSignGuideToward)) {
+            if (controller(kEdgeSignGuideToward)) {
               auto* trip_sign_guide_toward_location =
                   trip_sign->mutable_guide_toward_locations()->Add();
               trip_sign_guide_toward_location->set_text(sign.text());
@@ -600,7 +598,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
             break;
           }
           case Sign::Type::kGuidanceViewJunction: {
-            if (controller.attributes.at(kEdgeSignGuidanceViewJunction)) {
+            if (controller(kEdgeSignGuidanceViewJunction)) {
               auto* trip_sign_guidance_view_junction =
                   trip_sign->mutable_guidance_view_junctions()->Add();
               trip_sign_guidance_view_junction->set_text(sign.text());
@@ -622,7 +620,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
       for (const auto& sign : node_signs) {
         switch (sign.type()) {
           case Sign::Type::kJunctionName: {
-            if (controller.attributes.at(kEdgeSignJunctionName)) {
+            if (controller(kEdgeSignJunctionName)) {
               auto* trip_sign_junction_name = trip_sign->mutable_junction_names()->Add();
               trip_sign_junction_name->set_text(sign.text());
               trip_sign_junction_name->set_is_route_number(sign.is_route_num());
@@ -644,18 +642,18 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   // Set road class if requested
-  if (controller.attributes.at(kEdgeRoadClass)) {
+  if (controller(kEdgeRoadClass)) {
     trip_edge->set_road_class(GetTripLegRoadClass(directededge->classification()));
   }
 
   // Set length if requested. Convert to km
-  if (controller.attributes.at(kEdgeLength)) {
+  if (controller(kEdgeLength)) {
     float km = std::max((directededge->length() * kKmPerMeter * length_percentage), 0.001f);
     trip_edge->set_length(km);
   }
 
   // Set speed if requested
-  if (controller.attributes.at(kEdgeSpeed)) {
+  if (controller(kEdgeSpeed)) {
     // TODO: could get better precision speed here by calling GraphTile::GetSpeed but we'd need to
     // know whether or not the costing actually cares about the speed of the edge. Perhaps a refactor
     // of costing to have a GetSpeed function which EdgeCost calls internally but which we can also
@@ -677,7 +675,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   // Test whether edge is traversed forward or reverse
   if (directededge->forward()) {
     // Set traversability for forward directededge if requested
-    if (controller.attributes.at(kEdgeTraversability)) {
+    if (controller(kEdgeTraversability)) {
       if ((directededge->forwardaccess() & kAccess) && (directededge->reverseaccess() & kAccess)) {
         trip_edge->set_traversability(TripLeg_Traversability::TripLeg_Traversability_kBoth);
       } else if ((directededge->forwardaccess() & kAccess) &&
@@ -692,7 +690,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
     }
   } else {
     // Set traversability for reverse directededge if requested
-    if (controller.attributes.at(kEdgeTraversability)) {
+    if (controller(kEdgeTraversability)) {
       if ((directededge->forwardaccess() & kAccess) && (directededge->reverseaccess() & kAccess)) {
         trip_edge->set_traversability(TripLeg_Traversability::TripLeg_Traversability_kBoth);
       } else if (!(directededge->forwardaccess() & kAccess) &&
@@ -712,47 +710,47 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   // Set the trip path use based on directed edge use if requested
-  if (controller.attributes.at(kEdgeUse)) {
+  if (controller(kEdgeUse)) {
     trip_edge->set_use(GetTripLegUse(directededge->use()));
   }
 
   // Set toll flag if requested
-  if (directededge->toll() && controller.attributes.at(kEdgeToll)) {
+  if (directededge->toll() && controller(kEdgeToll)) {
     trip_edge->set_toll(true);
   }
 
   // Set unpaved flag if requested
-  if (directededge->unpaved() && controller.attributes.at(kEdgeUnpaved)) {
+  if (directededge->unpaved() && controller(kEdgeUnpaved)) {
     trip_edge->set_unpaved(true);
   }
 
   // Set tunnel flag if requested
-  if (directededge->tunnel() && controller.attributes.at(kEdgeTunnel)) {
+  if (directededge->tunnel() && controller(kEdgeTunnel)) {
     trip_edge->set_tunnel(true);
   }
 
   // Set bridge flag if requested
-  if (directededge->bridge() && controller.attributes.at(kEdgeBridge)) {
+  if (directededge->bridge() && controller(kEdgeBridge)) {
     trip_edge->set_bridge(true);
   }
 
   // Set roundabout flag if requested
-  if (directededge->roundabout() && controller.attributes.at(kEdgeRoundabout)) {
+  if (directededge->roundabout() && controller(kEdgeRoundabout)) {
     trip_edge->set_roundabout(true);
   }
 
   // Set internal intersection flag if requested
-  if (directededge->internal() && controller.attributes.at(kEdgeInternalIntersection)) {
+  if (directededge->internal() && controller(kEdgeInternalIntersection)) {
     trip_edge->set_internal_intersection(true);
   }
 
   // Set drive_on_right if requested
-  if (controller.attributes.at(kEdgeDriveOnRight)) {
+  if (controller(kEdgeDriveOnRight)) {
     trip_edge->set_drive_on_right(drive_on_right);
   }
 
   // Set surface if requested
-  if (controller.attributes.at(kEdgeSurface)) {
+  if (controller(kEdgeSurface)) {
     trip_edge->set_surface(GetTripLegSurface(directededge->surface()));
   }
 
@@ -760,64 +758,64 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   if (mode == sif::TravelMode::kBicycle) {
     // Override bicycle mode with pedestrian if dismount flag or steps
     if (directededge->dismount() || directededge->use() == Use::kSteps) {
-      if (controller.attributes.at(kEdgeTravelMode)) {
+      if (controller(kEdgeTravelMode)) {
         trip_edge->set_travel_mode(TripLeg_TravelMode::TripLeg_TravelMode_kPedestrian);
       }
-      if (controller.attributes.at(kEdgePedestrianType)) {
+      if (controller(kEdgePedestrianType)) {
         trip_edge->set_pedestrian_type(TripLeg_PedestrianType::TripLeg_PedestrianType_kFoot);
       }
     } else {
-      if (controller.attributes.at(kEdgeTravelMode)) {
+      if (controller(kEdgeTravelMode)) {
         trip_edge->set_travel_mode(TripLeg_TravelMode::TripLeg_TravelMode_kBicycle);
       }
-      if (controller.attributes.at(kEdgeBicycleType)) {
+      if (controller(kEdgeBicycleType)) {
         trip_edge->set_bicycle_type(GetTripLegBicycleType(travel_type));
       }
     }
   } else if (mode == sif::TravelMode::kDrive) {
-    if (controller.attributes.at(kEdgeTravelMode)) {
+    if (controller(kEdgeTravelMode)) {
       trip_edge->set_travel_mode(TripLeg_TravelMode::TripLeg_TravelMode_kDrive);
     }
-    if (controller.attributes.at(kEdgeVehicleType)) {
+    if (controller(kEdgeVehicleType)) {
       trip_edge->set_vehicle_type(GetTripLegVehicleType(travel_type));
     }
   } else if (mode == sif::TravelMode::kPedestrian) {
-    if (controller.attributes.at(kEdgeTravelMode)) {
+    if (controller(kEdgeTravelMode)) {
       trip_edge->set_travel_mode(TripLeg_TravelMode::TripLeg_TravelMode_kPedestrian);
     }
-    if (controller.attributes.at(kEdgePedestrianType)) {
+    if (controller(kEdgePedestrianType)) {
       trip_edge->set_pedestrian_type(GetTripLegPedestrianType(travel_type));
     }
   } else if (mode == sif::TravelMode::kPublicTransit) {
-    if (controller.attributes.at(kEdgeTravelMode)) {
+    if (controller(kEdgeTravelMode)) {
       trip_edge->set_travel_mode(TripLeg_TravelMode::TripLeg_TravelMode_kTransit);
     }
   }
 
   // Set edge id (graphid value) if requested
-  if (controller.attributes.at(kEdgeId)) {
+  if (controller(kEdgeId)) {
     trip_edge->set_id(edge.value);
   }
 
   // Set way id (base data id) if requested
-  if (controller.attributes.at(kEdgeWayId)) {
+  if (controller(kEdgeWayId)) {
     trip_edge->set_way_id(edgeinfo.wayid());
   }
 
   // Set weighted grade if requested
-  if (controller.attributes.at(kEdgeWeightedGrade)) {
+  if (controller(kEdgeWeightedGrade)) {
     trip_edge->set_weighted_grade((directededge->weighted_grade() - 6.f) / 0.6f);
   }
 
   // Set maximum upward and downward grade if requested (set to kNoElevationData if unavailable)
-  if (controller.attributes.at(kEdgeMaxUpwardGrade)) {
+  if (controller(kEdgeMaxUpwardGrade)) {
     if (graphtile->header()->has_elevation()) {
       trip_edge->set_max_upward_grade(directededge->max_up_slope());
     } else {
       trip_edge->set_max_upward_grade(kNoElevationData);
     }
   }
-  if (controller.attributes.at(kEdgeMaxDownwardGrade)) {
+  if (controller(kEdgeMaxDownwardGrade)) {
     if (graphtile->header()->has_elevation()) {
       trip_edge->set_max_downward_grade(directededge->max_down_slope());
     } else {
@@ -826,7 +824,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
   }
 
   // Set mean elevation if requested (set to kNoElevationData if unavailable)
-  if (controller.attributes.at(kEdgeMeanElevation)) {
+  if (controller(kEdgeMeanElevation)) {
     if (graphtile->header()->has_elevation()) {
       trip_edge->set_mean_elevation(edgeinfo.mean_elevation());
     } else {
@@ -834,11 +832,11 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
     }
   }
 
-  if (controller.attributes.at(kEdgeLaneCount)) {
+  if (controller(kEdgeLaneCount)) {
     trip_edge->set_lane_count(directededge->lanecount());
   }
 
-  if (directededge->laneconnectivity() && controller.attributes.at(kEdgeLaneConnectivity)) {
+  if (directededge->laneconnectivity() && controller(kEdgeLaneConnectivity)) {
     for (const auto& l : graphtile->GetLaneConnectivity(idx)) {
       TripLeg_LaneConnectivity* path_lane = trip_edge->add_lane_connectivity();
       path_lane->set_from_way_id(l.from());
@@ -847,15 +845,15 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
     }
   }
 
-  if (directededge->cyclelane() != CycleLane::kNone && controller.attributes.at(kEdgeCycleLane)) {
+  if (directededge->cyclelane() != CycleLane::kNone && controller(kEdgeCycleLane)) {
     trip_edge->set_cycle_lane(GetTripLegCycleLane(directededge->cyclelane()));
   }
 
-  if (controller.attributes.at(kEdgeBicycleNetwork)) {
+  if (controller(kEdgeBicycleNetwork)) {
     trip_edge->set_bicycle_network(directededge->bike_network());
   }
 
-  if (controller.attributes.at(kEdgeSidewalk)) {
+  if (controller(kEdgeSidewalk)) {
     if (directededge->sidewalk_left() && directededge->sidewalk_right()) {
       trip_edge->set_sidewalk(TripLeg_Sidewalk::TripLeg_Sidewalk_kBothSides);
     } else if (directededge->sidewalk_left()) {
@@ -865,19 +863,19 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
     }
   }
 
-  if (controller.attributes.at(kEdgeDensity)) {
+  if (controller(kEdgeDensity)) {
     trip_edge->set_density(directededge->density());
   }
 
-  if (controller.attributes.at(kEdgeSpeedLimit)) {
+  if (controller(kEdgeSpeedLimit)) {
     trip_edge->set_speed_limit(edgeinfo.speed_limit());
   }
 
-  if (controller.attributes.at(kEdgeTruckSpeed)) {
+  if (controller(kEdgeTruckSpeed)) {
     trip_edge->set_truck_speed(directededge->truck_speed());
   }
 
-  if (directededge->truck_route() && controller.attributes.at(kEdgeTruckRoute)) {
+  if (directededge->truck_route() && controller(kEdgeTruckRoute)) {
     trip_edge->set_truck_route(true);
   }
 
@@ -888,12 +886,12 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
     TripLeg_TransitRouteInfo* transit_route_info = trip_edge->mutable_transit_route_info();
 
     // Set block_id if requested
-    if (controller.attributes.at(kEdgeTransitRouteInfoBlockId)) {
+    if (controller(kEdgeTransitRouteInfoBlockId)) {
       transit_route_info->set_block_id(block_id);
     }
 
     // Set trip_id if requested
-    if (controller.attributes.at(kEdgeTransitRouteInfoTripId)) {
+    if (controller(kEdgeTransitRouteInfoTripId)) {
       transit_route_info->set_trip_id(trip_id);
     }
 
@@ -904,8 +902,7 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
     if (transit_departure) {
 
       // Set headsign if requested
-      if (controller.attributes.at(kEdgeTransitRouteInfoHeadsign) &&
-          transit_departure->headsign_offset()) {
+      if (controller(kEdgeTransitRouteInfoHeadsign) && transit_departure->headsign_offset()) {
         transit_route_info->set_headsign(graphtile->GetName(transit_departure->headsign_offset()));
       }
 
@@ -913,61 +910,55 @@ TripLeg_Edge* AddTripEdge(const AttributesController& controller,
 
       if (transit_route) {
         // Set transit type if requested
-        if (controller.attributes.at(kEdgeTransitType)) {
+        if (controller(kEdgeTransitType)) {
           trip_edge->set_transit_type(GetTripLegTransitType(transit_route->route_type()));
         }
 
         // Set onestop_id if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOnestopId) &&
-            transit_route->one_stop_offset()) {
+        if (controller(kEdgeTransitRouteInfoOnestopId) && transit_route->one_stop_offset()) {
           transit_route_info->set_onestop_id(graphtile->GetName(transit_route->one_stop_offset()));
         }
 
         // Set short_name if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoShortName) &&
-            transit_route->short_name_offset()) {
+        if (controller(kEdgeTransitRouteInfoShortName) && transit_route->short_name_offset()) {
           transit_route_info->set_short_name(graphtile->GetName(transit_route->short_name_offset()));
         }
 
         // Set long_name if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoLongName) &&
-            transit_route->long_name_offset()) {
+        if (controller(kEdgeTransitRouteInfoLongName) && transit_route->long_name_offset()) {
           transit_route_info->set_long_name(graphtile->GetName(transit_route->long_name_offset()));
         }
 
         // Set color if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoColor)) {
+        if (controller(kEdgeTransitRouteInfoColor)) {
           transit_route_info->set_color(transit_route->route_color());
         }
 
         // Set text_color if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoTextColor)) {
+        if (controller(kEdgeTransitRouteInfoTextColor)) {
           transit_route_info->set_text_color(transit_route->route_text_color());
         }
 
         // Set description if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoDescription) &&
-            transit_route->desc_offset()) {
+        if (controller(kEdgeTransitRouteInfoDescription) && transit_route->desc_offset()) {
           transit_route_info->set_description(graphtile->GetName(transit_route->desc_offset()));
         }
 
         // Set operator_onestop_id if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOperatorOnestopId) &&
+        if (controller(kEdgeTransitRouteInfoOperatorOnestopId) &&
             transit_route->op_by_onestop_id_offset()) {
           transit_route_info->set_operator_onestop_id(
               graphtile->GetName(transit_route->op_by_onestop_id_offset()));
         }
 
         // Set operator_name if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOperatorName) &&
-            transit_route->op_by_name_offset()) {
+        if (controller(kEdgeTransitRouteInfoOperatorName) && transit_route->op_by_name_offset()) {
           transit_route_info->set_operator_name(
               graphtile->GetName(transit_route->op_by_name_offset()));
         }
 
         // Set operator_url if requested
-        if (controller.attributes.at(kEdgeTransitRouteInfoOperatorUrl) &&
-            transit_route->op_by_website_offset()) {
+        if (controller(kEdgeTransitRouteInfoOperatorUrl) && transit_route->op_by_website_offset()) {
           transit_route_info->set_operator_url(
               graphtile->GetName(transit_route->op_by_website_offset()));
         }
@@ -999,7 +990,7 @@ void AddTripIntersectingEdge(const AttributesController& controller,
   TripLeg_IntersectingEdge* itersecting_edge = trip_node->add_intersecting_edge();
 
   // Set the heading for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeBeginHeading)) {
+  if (controller(kNodeIntersectingEdgeBeginHeading)) {
     itersecting_edge->set_begin_heading(nodeinfo->heading(local_edge_index));
   }
 
@@ -1015,7 +1006,7 @@ void AddTripIntersectingEdge(const AttributesController& controller,
                          : Traversability::kNone;
   }
   // Set the walkability flag for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeWalkability)) {
+  if (controller(kNodeIntersectingEdgeWalkability)) {
     itersecting_edge->set_walkability(GetTripLegTraversability(traversability));
   }
 
@@ -1029,35 +1020,35 @@ void AddTripIntersectingEdge(const AttributesController& controller,
                                                                          : Traversability::kNone;
   }
   // Set the cyclability flag for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeCyclability)) {
+  if (controller(kNodeIntersectingEdgeCyclability)) {
     itersecting_edge->set_cyclability(GetTripLegTraversability(traversability));
   }
 
   // Set the driveability flag for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeDriveability)) {
+  if (controller(kNodeIntersectingEdgeDriveability)) {
     itersecting_edge->set_driveability(
         GetTripLegTraversability(nodeinfo->local_driveability(local_edge_index)));
   }
 
   // Set the previous/intersecting edge name consistency if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeFromEdgeNameConsistency)) {
+  if (controller(kNodeIntersectingEdgeFromEdgeNameConsistency)) {
     bool name_consistency =
         (prev_de == nullptr) ? false : prev_de->name_consistency(local_edge_index);
     itersecting_edge->set_prev_name_consistency(name_consistency);
   }
 
   // Set the current/intersecting edge name consistency if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeToEdgeNameConsistency)) {
+  if (controller(kNodeIntersectingEdgeToEdgeNameConsistency)) {
     itersecting_edge->set_curr_name_consistency(directededge->name_consistency(local_edge_index));
   }
 
   // Set the use for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeUse)) {
+  if (controller(kNodeIntersectingEdgeUse)) {
     itersecting_edge->set_use(GetTripLegUse(intersecting_de->use()));
   }
 
   // Set the road class for the intersecting edge if requested
-  if (controller.attributes.at(kNodeIntersectingEdgeRoadClass)) {
+  if (controller(kNodeIntersectingEdgeRoadClass)) {
     itersecting_edge->set_road_class(GetTripLegRoadClass(intersecting_de->classification()));
   }
 }
@@ -1215,11 +1206,11 @@ void TripLegBuilder::Build(
                     startnode.id(), false, nullptr, path_begin->has_time_restrictions);
 
     // Set begin shape index if requested
-    if (controller.attributes.at(kEdgeBeginShapeIndex)) {
+    if (controller(kEdgeBeginShapeIndex)) {
       trip_edge->set_begin_shape_index(0);
     }
     // Set end shape index if requested
-    if (controller.attributes.at(kEdgeEndShapeIndex)) {
+    if (controller(kEdgeEndShapeIndex)) {
       trip_edge->set_end_shape_index(shape.size() - 1);
     }
 
@@ -1233,17 +1224,17 @@ void TripLegBuilder::Build(
     SetHeadings(trip_edge, controller, edge, shape, 0);
 
     auto* node = trip_path.add_node();
-    if (controller.attributes.at(kNodeElapsedTime)) {
+    if (controller(kNodeElapsedTime)) {
       node->set_elapsed_time(path_begin->elapsed_time - trim_begin - trim_end);
     }
 
     const GraphTile* end_tile = graphreader.GetGraphTile(edge->endnode());
     if (end_tile == nullptr) {
-      if (controller.attributes.at(kNodeaAdminIndex)) {
+      if (controller(kNodeaAdminIndex)) {
         node->set_admin_index(0);
       }
     } else {
-      if (controller.attributes.at(kNodeaAdminIndex)) {
+      if (controller(kNodeaAdminIndex)) {
         node->set_admin_index(
             GetAdminIndex(end_tile->admininfo(end_tile->node(edge->endnode())->admin_index()),
                           admin_info_map, admin_info_list));
@@ -1254,11 +1245,11 @@ void TripLegBuilder::Build(
     SetBoundingBox(trip_path, shape);
 
     // Set shape if requested
-    if (controller.attributes.at(kShape)) {
+    if (controller(kShape)) {
       trip_path.set_shape(encode<std::vector<PointLL>>(shape));
     }
 
-    if (controller.attributes.at(kOsmChangeset)) {
+    if (controller(kOsmChangeset)) {
       trip_path.set_osm_changeset(tile->header()->dataset_id());
     }
 
@@ -1299,7 +1290,7 @@ void TripLegBuilder::Build(
     start_tile = graphreader.GetGraphTile(startnode, start_tile);
     const NodeInfo* node = start_tile->node(startnode);
 
-    if (osmchangeset == 0 && controller.attributes.at(kOsmChangeset)) {
+    if (osmchangeset == 0 && controller(kOsmChangeset)) {
       osmchangeset = start_tile->header()->dataset_id();
     }
 
@@ -1321,18 +1312,18 @@ void TripLegBuilder::Build(
     // Add a node to the trip path and set its attributes.
     TripLeg_Node* trip_node = trip_path.add_node();
 
-    if (controller.attributes.at(kNodeType)) {
+    if (controller(kNodeType)) {
       trip_node->set_type(GetTripLegNodeType(node->type()));
     }
 
     if (node->intersection() == IntersectionType::kFork) {
-      if (controller.attributes.at(kNodeFork)) {
+      if (controller(kNodeFork)) {
         trip_node->set_fork(true);
       }
     }
 
     // Assign the elapsed time from the start of the leg
-    if (controller.attributes.at(kNodeElapsedTime)) {
+    if (controller(kNodeElapsedTime)) {
       trip_node->set_elapsed_time(elapsedtime);
     }
 
@@ -1343,19 +1334,19 @@ void TripLegBuilder::Build(
     }
 
     // Assign the admin index
-    if (controller.attributes.at(kNodeaAdminIndex)) {
+    if (controller(kNodeaAdminIndex)) {
       trip_node->set_admin_index(
           GetAdminIndex(start_tile->admininfo(node->admin_index()), admin_info_map, admin_info_list));
     }
 
-    if (controller.attributes.at(kNodeTimeZone)) {
+    if (controller(kNodeTimeZone)) {
       auto tz = DateTime::get_tz_db().from_index(node->timezone());
       if (tz) {
         trip_node->set_time_zone(tz->name());
       }
     }
 
-    if (controller.attributes.at(kNodeTransitionTime) && edge_itr->turn_cost > 0) {
+    if (controller(kNodeTransitionTime) && edge_itr->turn_cost > 0) {
       trip_node->set_transition_time(edge_itr->turn_cost);
     }
 
@@ -1374,18 +1365,18 @@ void TripLegBuilder::Build(
       // Set type
       if (directededge->use() == Use::kRail) {
         // Set node transit info type if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoType)) {
+        if (controller(kNodeTransitPlatformInfoType)) {
           transit_platform_info->set_type(TransitPlatformInfo_Type_kStation);
         }
         prev_transit_node_type = TransitPlatformInfo_Type_kStation;
       } else if (directededge->use() == Use::kPlatformConnection) {
         // Set node transit info type if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoType)) {
+        if (controller(kNodeTransitPlatformInfoType)) {
           transit_platform_info->set_type(prev_transit_node_type);
         }
       } else { // bus logic
         // Set node transit info type if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoType)) {
+        if (controller(kNodeTransitPlatformInfoType)) {
           transit_platform_info->set_type(TransitPlatformInfo_Type_kStop);
         }
         prev_transit_node_type = TransitPlatformInfo_Type_kStop;
@@ -1393,15 +1384,13 @@ void TripLegBuilder::Build(
 
       if (transit_platform) {
         // Set onstop_id if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoOnestopId) &&
-            transit_platform->one_stop_offset()) {
+        if (controller(kNodeTransitPlatformInfoOnestopId) && transit_platform->one_stop_offset()) {
           transit_platform_info->set_onestop_id(
               graphtile->GetName(transit_platform->one_stop_offset()));
         }
 
         // Set name if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoName) &&
-            transit_platform->name_offset()) {
+        if (controller(kNodeTransitPlatformInfoName) && transit_platform->name_offset()) {
           transit_platform_info->set_name(graphtile->GetName(transit_platform->name_offset()));
         }
 
@@ -1415,15 +1404,14 @@ void TripLegBuilder::Build(
             const TransitStop* transit_station = endtile->GetTransitStop(nodeinfo2->stop_index());
 
             // Set station onstop_id if requested
-            if (controller.attributes.at(kNodeTransitPlatformInfoStationOnestopId) &&
+            if (controller(kNodeTransitPlatformInfoStationOnestopId) &&
                 transit_station->one_stop_offset()) {
               transit_platform_info->set_station_onestop_id(
                   endtile->GetName(transit_station->one_stop_offset()));
             }
 
             // Set station name if requested
-            if (controller.attributes.at(kNodeTransitPlatformInfoStationName) &&
-                transit_station->name_offset()) {
+            if (controller(kNodeTransitPlatformInfoStationName) && transit_station->name_offset()) {
               transit_platform_info->set_station_name(
                   endtile->GetName(transit_station->name_offset()));
             }
@@ -1436,7 +1424,7 @@ void TripLegBuilder::Build(
         // Set latitude and longitude
         LatLng* stop_ll = transit_platform_info->mutable_ll();
         // Set transit stop lat/lon if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoLatLon)) {
+        if (controller(kNodeTransitPlatformInfoLatLon)) {
           PointLL ll = node->latlng(start_tile->header()->base_ll());
           stop_ll->set_lat(ll.lat());
           stop_ll->set_lng(ll.lng());
@@ -1445,8 +1433,7 @@ void TripLegBuilder::Build(
 
       // Set the arrival time at this node (based on schedule from last trip
       // departure) if requested
-      if (controller.attributes.at(kNodeTransitPlatformInfoArrivalDateTime) &&
-          !arrival_time.empty()) {
+      if (controller(kNodeTransitPlatformInfoArrivalDateTime) && !arrival_time.empty()) {
         transit_platform_info->set_arrival_date_time(arrival_time);
       }
 
@@ -1464,7 +1451,7 @@ void TripLegBuilder::Build(
 
           if (graphtile->header()->date_created() > date) {
             // Set assumed schedule if requested
-            if (controller.attributes.at(kNodeTransitPlatformInfoAssumedSchedule)) {
+            if (controller(kNodeTransitPlatformInfoAssumedSchedule)) {
               transit_platform_info->set_assumed_schedule(true);
             }
             assumed_schedule = true;
@@ -1472,7 +1459,7 @@ void TripLegBuilder::Build(
             day = date - graphtile->header()->date_created();
             if (day > graphtile->GetTransitSchedule(transit_departure->schedule_index())->end_day()) {
               // Set assumed schedule if requested
-              if (controller.attributes.at(kNodeTransitPlatformInfoAssumedSchedule)) {
+              if (controller(kNodeTransitPlatformInfoAssumedSchedule)) {
                 transit_platform_info->set_assumed_schedule(true);
               }
               assumed_schedule = true;
@@ -1496,7 +1483,7 @@ void TripLegBuilder::Build(
           }
 
           // Set departure time from this transit stop if requested
-          if (controller.attributes.at(kNodeTransitPlatformInfoDepartureDateTime)) {
+          if (controller(kNodeTransitPlatformInfoDepartureDateTime)) {
             transit_platform_info->set_departure_date_time(dt);
           }
 
@@ -1526,7 +1513,7 @@ void TripLegBuilder::Build(
         block_id = 0;
 
         // Set assumed schedule if requested
-        if (controller.attributes.at(kNodeTransitPlatformInfoAssumedSchedule) && assumed_schedule) {
+        if (controller(kNodeTransitPlatformInfoAssumedSchedule) && assumed_schedule) {
           transit_platform_info->set_assumed_schedule(true);
         }
         assumed_schedule = false;
@@ -1625,12 +1612,12 @@ void TripLegBuilder::Build(
     }
 
     // Set begin shape index if requested
-    if (controller.attributes.at(kEdgeBeginShapeIndex)) {
+    if (controller(kEdgeBeginShapeIndex)) {
       trip_edge->set_begin_shape_index(begin_index);
     }
 
     // Set end shape index if requested
-    if (controller.attributes.at(kEdgeEndShapeIndex)) {
+    if (controller(kEdgeEndShapeIndex)) {
       trip_edge->set_end_shape_index(trip_shape.size() - 1);
     }
 
@@ -1729,13 +1716,13 @@ void TripLegBuilder::Build(
 
   // Add the last node
   auto* node = trip_path.add_node();
-  if (controller.attributes.at(kNodeaAdminIndex)) {
+  if (controller(kNodeaAdminIndex)) {
     auto* last_tile = graphreader.GetGraphTile(startnode);
     node->set_admin_index(
         GetAdminIndex(last_tile->admininfo(last_tile->node(startnode)->admin_index()), admin_info_map,
                       admin_info_list));
   }
-  if (controller.attributes.at(kNodeElapsedTime)) {
+  if (controller(kNodeElapsedTime)) {
     node->set_elapsed_time(elapsedtime);
   }
 
@@ -1746,11 +1733,11 @@ void TripLegBuilder::Build(
   SetBoundingBox(trip_path, trip_shape);
 
   // Set shape if requested
-  if (controller.attributes.at(kShape)) {
+  if (controller(kShape)) {
     trip_path.set_shape(encode<std::vector<PointLL>>(trip_shape));
   }
 
-  if (osmchangeset != 0 && controller.attributes.at(kOsmChangeset)) {
+  if (osmchangeset != 0 && controller(kOsmChangeset)) {
     trip_path.set_osm_changeset(osmchangeset);
   }
 }
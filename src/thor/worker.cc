@@ -56,9 +56,20 @@ namespace thor {
 
 thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
                              const std::shared_ptr<baldr::GraphReader>& graph_reader)
-    : mode(valhalla::sif::TravelMode::kPedestrian), matcher_factory(config, graph_reader),
+    : mode(valhalla::sif::TravelMode::kPedestrian),
+      bidir_astar(config.get<bool>("thor.radix_heap_queue", false)
+                      ? baldr::BucketQueueMode::kRadixHeap
+                      : baldr::BucketQueueMode::kDoubleBucket),
+      cch_query(config.get<size_t>("thor.cch_max_metrics", 4),
+                config.get<float>("thor.cch_metric_ttl", 0.0f),
+                config.get<float>("thor.cch_max_turn_cost_ratio", 0.1f)),
+      bucket_matrix(config.get<size_t>("thor.bucketmatrix_max_cache_size",
+                                       BucketMatrix::kDefaultMaxCacheSize),
+                    config.get<float>("thor.bucketmatrix_target_set_ttl", 300.0f)),
+      matcher_factory(config, graph_reader),
       reader(graph_reader), controller{},
-      long_request(config.get<float>("thor.logging.long_request")) {
+      long_request(config.get<float>("thor.logging.long_request")),
+      edge_cost_tables(config.get<bool>("thor.edge_cost_tables", false)) {
   // If we weren't provided with a graph reader make our own
   if (!reader)
     reader = matcher_factory.graphreader();
@@ -85,17 +96,96 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config,
     source_to_target_algorithm = TIME_DISTANCE_MATRIX;
   } else if (conf_algorithm == "costmatrix") {
     source_to_target_algorithm = COST_MATRIX;
+  } else if (conf_algorithm == "bucketmatrix") {
+    source_to_target_algorithm = BUCKET_MATRIX;
   } else {
     source_to_target_algorithm = SELECT_OPTIMAL;
   }
 
   max_timedep_distance =
       config.get<float>("service_limits.max_timedep_distance", kDefaultMaxTimeDependentDistance);
+
+  // Landmark tables for the A* heuristic of the route algorithms (ALT), opt in
+  if (config.get<bool>("thor.landmarks", false)) {
+    auto dir = config.get<std::string>("mjolnir.landmarks.dir",
+                                       config.get<std::string>("mjolnir.tile_dir") + "/landmarks");
+    std::shared_ptr<const baldr::Landmarks> landmarks(new baldr::Landmarks(dir));
+    if (landmarks->empty()) {
+      LOG_WARN("No landmark tables found in " + dir);
+    } else {
+      astar.set_landmarks(landmarks);
+      bidir_astar.set_landmarks(landmarks);
+      timedep_forward.set_landmarks(landmarks);
+      timedep_reverse.set_landmarks(landmarks);
+    }
+  }
+
+  // Contraction hierarchy overlay for auto routes, opt in
+  if (config.get<bool>("thor.cch", false)) {
+    auto file_name = config.get<std::string>("mjolnir.cch.file",
+                                             config.get<std::string>("mjolnir.tile_dir") +
+                                                 "/overlay.cch");
+    try {
+      std::shared_ptr<const baldr::CCHOverlay> overlay(new baldr::CCHOverlay(file_name));
+      // Customize metrics on their own thread unless asked not to
+      cch_query.set_overlay(overlay, config.get<bool>("thor.cch_customize_in_background", true)
+                                         ? config.get_child("mjolnir")
+                                         : boost::property_tree::ptree{});
+    } catch (const std::exception& e) {
+      LOG_WARN("No contraction hierarchy overlay: " + std::string(e.what()));
+    }
+  }
+
+  isochrone_threads = config.get<unsigned int>("thor.isochrone_max_threads", 1);
+
+  // Extra threads (each with their own graph reader) a cost matrix request may use
+  auto matrix_threads = config.get<unsigned int>("thor.costmatrix_max_threads", 1);
+  for (unsigned int i = 1; i < matrix_threads; ++i) {
+    matrix_readers.emplace_back(new baldr::GraphReader(config.get_child("mjolnir")));
+  }
 }
 
 thor_worker_t::~thor_worker_t() {
 }
 
+// log request if greater than X (ms) per unit of work
+void thor_worker_t::log_long_request(const Api& request,
+                                     const uint64_t id,
+                                     const double elapsed_time) const {
+  const auto& options = request.options();
+  double denominator = 0;
+  switch (options.action()) {
+    case Options::sources_to_targets:
+      denominator = options.sources_size() + options.targets_size();
+      break;
+    case Options::optimized_route:
+      denominator = std::max(options.sources_size(), options.targets_size());
+      break;
+    case Options::isochrone:
+      denominator = options.sources_size() * options.targets_size();
+      break;
+    case Options::route:
+    case Options::expansion:
+      denominator = options.locations_size();
+      break;
+    case Options::trace_route:
+    case Options::trace_attributes:
+      denominator = trace.size() / 1100;
+      break;
+    default:
+      return;
+  }
+  if (!options.do_not_track() && elapsed_time / denominator > long_request) {
+    LOG_WARN("thor::" + Options_Action_Enum_Name(options.action()) +
+             " request elapsed time (ms)::" + std::to_string(elapsed_time));
+    LOG_WARN("thor::" + Options_Action_Enum_Name(options.action()) +
+             " request exceeded threshold::" + std::to_string(id));
+    midgard::logging::Log("valhalla_thor_long_request_" +
+                              Options_Action_Enum_Name(options.action()),
+                          " [ANALYTICS] ");
+  }
+}
+
 #ifdef HAVE_HTTP
 prime_server::worker_t::result_t
 thor_worker_t::work(const std::list<zmq::message_t>& job,
@@ -115,42 +205,34 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
     service_worker_t::set_interrupt(interrupt_function);
 
     prime_server::worker_t::result_t result{true};
-    double denominator = 0;
     // do request specific processing
     switch (options.action()) {
       case Options::sources_to_targets:
         result = to_response_json(matrix(request), info, request);
-        denominator = options.sources_size() + options.targets_size();
         break;
       case Options::optimized_route: {
         optimized_route(request);
         result.messages.emplace_back(request.SerializeAsString());
-        denominator = std::max(options.sources_size(), options.targets_size());
         break;
       }
       case Options::isochrone:
         result = to_response_json(isochrones(request), info, request);
-        denominator = options.sources_size() * options.targets_size();
         break;
       case Options::route: {
         route(request);
         result.messages.emplace_back(request.SerializeAsString());
-        denominator = options.locations_size();
         break;
       }
       case Options::trace_route: {
         trace_route(request);
         result.messages.emplace_back(request.SerializeAsString());
-        denominator = trace.size() / 1100;
         break;
       }
       case Options::trace_attributes:
         result = to_response_json(trace_attributes(request), info, request);
-        denominator = trace.size() / 1100;
         break;
       case Options::expansion: {
         result = to_response_json(expansion(request), info, request);
-        denominator = options.locations_size();
         break;
       }
       default:
@@ -159,15 +241,7 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
 
     double elapsed_time =
         std::chrono::duration<float, std::milli>(std::chrono::system_clock::now() - s).count();
-    if (!options.do_not_track() && elapsed_time / denominator > long_request) {
-      LOG_WARN("thor::" + Options_Action_Enum_Name(options.action()) +
-               " request elapsed time (ms)::" + std::to_string(elapsed_time));
-      LOG_WARN("thor::" + Options_Action_Enum_Name(options.action()) +
-               " request exceeded threshold::" + std::to_string(info.id));
-      midgard::logging::Log("valhalla_thor_long_request_" +
-                                Options_Action_Enum_Name(options.action()),
-                            " [ANALYTICS] ");
-    }
+    log_long_request(request, info.id, elapsed_time);
 
     return result;
   } catch (const valhalla_exception_t& e) {
@@ -206,7 +280,12 @@ void run_service(const boost::property_tree::ptree& config) {
 // Get the costing options if in the config or get the empty default.
 // Creates the cost in the cost factory
 valhalla::sif::cost_ptr_t thor_worker_t::get_costing(const Costing costing, const Options& options) {
-  return factory.Create(costing, options);
+  auto cost = factory.Create(costing, options);
+  // Share the edge costs with other requests with the same costing options, opt in
+  if (edge_cost_tables) {
+    cost->UseEdgeCostTables(costing, options);
+  }
+  return cost;
 }
 
 std::string thor_worker_t::parse_costing(const Api& request) {
@@ -335,17 +414,17 @@ void thor_worker_t::parse_filter_attributes(const Api& request, bool is_strict_f
         if (is_strict_filter)
           controller.disable_all();
         for (const auto& filter_attribute : options.filter_attributes()) {
-          try {
-            controller.attributes.at(filter_attribute) = true;
-          } catch (...) { LOG_ERROR("Invalid filter attribute " + filter_attribute); }
+          if (!controller.set(filter_attribute, true)) {
+            LOG_ERROR("Invalid filter attribute " + filter_attribute);
+          }
         }
         break;
       }
       case (FilterAction::exclude): {
         for (const auto& filter_attribute : options.filter_attributes()) {
-          try {
-            controller.attributes.at(filter_attribute) = false;
-          } catch (...) { LOG_ERROR("Invalid filter attribute " + filter_attribute); }
+          if (!controller.set(filter_attribute, false)) {
+            LOG_ERROR("Invalid filter attribute " + filter_attribute);
+          }
         }
         break;
       }
@@ -356,15 +435,24 @@ void thor_worker_t::parse_filter_attributes(const Api& request, bool is_strict_f
 void thor_worker_t::cleanup() {
   astar.Clear();
   bidir_astar.Clear();
+  cch_query.Clear();
   timedep_forward.Clear();
   timedep_reverse.Clear();
   multi_modal_astar.Clear();
   trace.clear();
   isochrone_gen.Clear();
   matcher_factory.ClearFullCache();
+  // the request is done with its tiles, a shared tile cache can free what was evicted meanwhile
   if (reader->OverCommitted()) {
     reader->Trim();
   }
+  reader->Release();
+  for (auto& matrix_reader : matrix_readers) {
+    if (matrix_reader->OverCommitted()) {
+      matrix_reader->Trim();
+    }
+    matrix_reader->Release();
+  }
 }
 
 } // namespace thor
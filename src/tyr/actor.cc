@@ -1,10 +1,23 @@
 #include "tyr/actor.h"
+#include "baldr/json.h"
 #include "baldr/rapidjson_utils.h"
 #include "loki/worker.h"
+#include "midgard/logging.h"
 #include "odin/worker.h"
 #include "thor/worker.h"
 #include "tyr/serializers.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 using namespace valhalla;
 using namespace valhalla::loki;
 using namespace valhalla::thor;
@@ -17,6 +30,10 @@ struct actor_t::pimpl_t {
   pimpl_t(const boost::property_tree::ptree& config)
       : reader(new baldr::GraphReader(config.get_child("mjolnir"))), loki_worker(config, reader),
         thor_worker(config, reader), odin_worker(config) {
+    // Note which actions we support for error messages
+    for (const auto& kv : config.get_child("loki.actions")) {
+      action_str.append("'/" + kv.second.get_value<std::string>() + "' ");
+    }
   }
   void set_interrupts(const std::function<void()>& interrupt_function) {
     loki_worker.set_interrupt(interrupt_function);
@@ -32,6 +49,7 @@ struct actor_t::pimpl_t {
   loki::loki_worker_t loki_worker;
   thor::thor_worker_t thor_worker;
   odin_worker_t odin_worker;
+  std::string action_str;
 };
 
 actor_t::actor_t(const boost::property_tree::ptree& config, bool auto_cleanup)
@@ -224,5 +242,270 @@ std::string actor_t::expansion(const std::string& request_str,
   return json;
 }
 
+#ifdef HAVE_HTTP
+prime_server::worker_t::result_t actor_t::work(const std::list<zmq::message_t>& job,
+                                               void* request_info,
+                                               const std::function<void()>& interrupt) {
+  // get time for start of request
+  auto s = std::chrono::system_clock::now();
+  auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
+  LOG_INFO("Got Request " + std::to_string(info.id));
+  Api request;
+  // error code for anything unexpected, depends on the stage we got to like it would if each
+  // stage had its own worker
+  unsigned error_code = 199;
+  try {
+    // request parsing
+    auto http_request =
+        prime_server::http_request_t::from_string(static_cast<const char*>(job.front().data()),
+                                                  job.front().size());
+    ParseApi(http_request, request);
+    const auto& options = request.options();
+
+    // check there is a valid action
+    if (!options.has_action()) {
+      return jsonify_error({106, pimpl->action_str}, info, request);
+    }
+
+    // set the interrupts
+    pimpl->set_interrupts(interrupt);
+
+    // log the stages that take too long the way their own workers would, each stage is timed from
+    // the end of the one before it
+    auto elapsed_time = [&s]() {
+      auto e = std::chrono::system_clock::now();
+      std::chrono::duration<float, std::milli> elapsed = e - s;
+      s = e;
+      return elapsed.count();
+    };
+    auto loki_done = [this, &request, &info, &elapsed_time]() {
+      pimpl->loki_worker.log_long_request(request, info.id, elapsed_time());
+    };
+    auto thor_done = [this, &request, &info, &elapsed_time]() {
+      pimpl->thor_worker.log_long_request(request, info.id, elapsed_time());
+    };
+
+    // the stages which end in directions
+    auto narrate = [this, &request, &info, &error_code]() {
+      error_code = 299;
+      pimpl->odin_worker.narrate(request);
+      auto response = tyr::serializeDirections(request);
+      auto* to_response =
+          request.options().format() == Options::gpx ? to_response_xml : to_response_json;
+      return to_response(response, info, request);
+    };
+
+    // do request specific processing
+    prime_server::worker_t::result_t result{false};
+    switch (options.action()) {
+      case Options::route:
+        pimpl->loki_worker.route(request);
+        loki_done();
+        error_code = 499;
+        pimpl->thor_worker.route(request);
+        thor_done();
+        result = narrate();
+        break;
+      case Options::expansion:
+        pimpl->loki_worker.route(request);
+        loki_done();
+        error_code = 499;
+        result = to_response_json(pimpl->thor_worker.expansion(request), info, request);
+        thor_done();
+        break;
+      case Options::locate:
+        result = to_response_json(pimpl->loki_worker.locate(request), info, request);
+        loki_done();
+        break;
+      case Options::sources_to_targets:
+        pimpl->loki_worker.matrix(request);
+        loki_done();
+        error_code = 499;
+        result = to_response_json(pimpl->thor_worker.matrix(request), info, request);
+        thor_done();
+        break;
+      case Options::optimized_route:
+        pimpl->loki_worker.matrix(request);
+        loki_done();
+        error_code = 499;
+        pimpl->thor_worker.optimized_route(request);
+        thor_done();
+        result = narrate();
+        break;
+      case Options::isochrone:
+        pimpl->loki_worker.isochrones(request);
+        loki_done();
+        error_code = 499;
+        result = to_response_json(pimpl->thor_worker.isochrones(request), info, request);
+        thor_done();
+        break;
+      case Options::trace_route:
+        pimpl->loki_worker.trace(request);
+        loki_done();
+        error_code = 499;
+        pimpl->thor_worker.trace_route(request);
+        thor_done();
+        result = narrate();
+        break;
+      case Options::trace_attributes:
+        pimpl->loki_worker.trace(request);
+        loki_done();
+        error_code = 499;
+        result = to_response_json(pimpl->thor_worker.trace_attributes(request), info, request);
+        thor_done();
+        break;
+      case Options::height:
+        result = to_response_json(pimpl->loki_worker.height(request), info, request);
+        loki_done();
+        break;
+      case Options::transit_available:
+        result = to_response_json(pimpl->loki_worker.transit_available(request), info, request);
+        loki_done();
+        break;
+      default:
+        // apparently you wanted something that we figured we'd support but havent written yet
+        return jsonify_error({107}, info, request);
+    }
+    return result;
+  } catch (const valhalla_exception_t& e) {
+    valhalla::midgard::logging::Log("400::" + std::string(e.what()), " [ANALYTICS] ");
+    return jsonify_error(e, info, request);
+  } catch (const std::exception& e) {
+    valhalla::midgard::logging::Log("400::" + std::string(e.what()), " [ANALYTICS] ");
+    return jsonify_error({error_code, std::string(e.what())}, info, request);
+  }
+}
+
+void run_service(const boost::property_tree::ptree& config) {
+  // gets requests from the loki proxy
+  auto upstream_endpoint = config.get<std::string>("loki.service.proxy") + "_out";
+  // and always returns the results back to the server
+  auto loopback_endpoint = config.get<std::string>("httpd.service.loopback");
+  auto interrupt_endpoint = config.get<std::string>("httpd.service.interrupt");
+
+  // listen for requests
+  zmq::context_t context;
+  actor_t actor(config);
+  prime_server::worker_t worker(context, upstream_endpoint, "ipc:///dev/null", loopback_endpoint,
+                                interrupt_endpoint,
+                                std::bind(&actor_t::work, std::ref(actor), std::placeholders::_1,
+                                          std::placeholders::_2, std::placeholders::_3),
+                                std::bind(&actor_t::cleanup, std::ref(actor)));
+  worker.work();
+
+  // TODO: should we listen for SIGINT and terminate gracefully/exit(0)?
+}
+#endif
+
+namespace {
+
+// the state the workers of a batch share, guarded by the lock
+struct batch_t {
+  batch_t(std::istream& input, std::ostream& output, size_t window)
+      : input(input), output(output), window(window), read(0), written(0), done(false) {
+  }
+
+  // gets the next request to match, waiting while too many results are held back
+  bool next(std::string& request, size_t& index) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [this]() { return done || read - written < window; });
+    while (!done) {
+      if (!std::getline(input, request)) {
+        done = true;
+      } else if (request.find_first_not_of(" \t\r") != std::string::npos) {
+        index = read++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // hands back a result and writes out all of those that are next in line
+  void finish(size_t index, std::string&& result) {
+    std::unique_lock<std::mutex> lock(mutex);
+    results.emplace(index, std::move(result));
+    while (!results.empty() && results.begin()->first == written) {
+      output << results.begin()->second << '\n';
+      results.erase(results.begin());
+      ++written;
+    }
+    ready.notify_all();
+  }
+
+  std::istream& input;
+  std::ostream& output;
+  size_t window;
+  size_t read;
+  size_t written;
+  bool done;
+  std::map<size_t, std::string> results;
+  std::mutex mutex;
+  std::condition_variable ready;
+};
+
+std::string serialize_error(const valhalla_exception_t& exception) {
+  auto json_error = baldr::json::map({});
+  json_error->emplace("status", exception.http_message);
+  json_error->emplace("status_code", static_cast<uint64_t>(exception.http_code));
+  json_error->emplace("error", std::string(exception.message));
+  json_error->emplace("error_code", static_cast<uint64_t>(exception.code));
+  std::stringstream ss;
+  ss << *json_error;
+  return ss.str();
+}
+
+} // namespace
+
+size_t trace_attributes_batch(const boost::property_tree::ptree& config,
+                              std::istream& input,
+                              std::ostream& output,
+                              size_t concurrency) {
+  concurrency = std::max<size_t>(concurrency, 1);
+
+  // unless told otherwise the workers keep their tiles in one cache instead of one each
+  auto batch_config = config;
+  if (!batch_config.get_optional<bool>("mjolnir.global_synchronized_cache")) {
+    batch_config.put("mjolnir.global_synchronized_cache", concurrency > 1);
+  }
+
+  // a slow trace holds back the output of the ones after it, this bounds how many of them wait
+  batch_t batch(input, output, concurrency * 64);
+  std::vector<actor_t> actors;
+  for (size_t i = 0; i < concurrency; ++i) {
+    actors.emplace_back(batch_config, true);
+  }
+  auto work = [&batch](actor_t& actor) {
+    std::string request;
+    size_t index;
+    while (batch.next(request, index)) {
+      std::string result;
+      try {
+        result = actor.trace_attributes(request);
+      } catch (const valhalla_exception_t& e) {
+        LOG_WARN("Trace " + std::to_string(index) + " failed: " + e.what());
+        result = serialize_error(e);
+        actor.cleanup();
+      } catch (const std::exception& e) {
+        LOG_WARN("Trace " + std::to_string(index) + " failed: " + e.what());
+        result = serialize_error({499, std::string(e.what())});
+        actor.cleanup();
+      }
+      batch.finish(index, std::move(result));
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < concurrency; ++i) {
+    workers.emplace_back(work, std::ref(actors[i]));
+  }
+  work(actors.front());
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  output.flush();
+  return batch.read;
+}
+
 } // namespace tyr
 } // namespace valhalla
@@ -1,6 +1,4 @@
-#include <sstream>
-
-#include "baldr/json.h"
+#include "baldr/json_writer.h"
 #include "skadi/sample.h"
 #include "tyr/serializers.h"
 
@@ -10,48 +8,55 @@ using namespace valhalla::baldr;
 
 namespace {
 
-json::ArrayPtr serialize_range_height(const std::vector<float>& ranges,
-                                      const std::vector<double>& heights,
-                                      const double no_data_value) {
-  auto array = json::array({});
+void serialize_range_height(json::writer_t& writer,
+                            const std::vector<float>& ranges,
+                            const std::vector<double>& heights,
+                            const double no_data_value) {
+  writer.start_array("range_height");
   // for each posting
   auto range = ranges.cbegin();
 
   for (const auto height : heights) {
-    auto element = json::array({json::fp_t{*range, 0}});
+    writer.start_array();
+    writer(json::fp_t{*range, 0});
     if (height == no_data_value) {
-      element->push_back(nullptr);
+      writer(nullptr);
     } else {
-      element->push_back({json::fp_t{height, 0}});
+      writer(json::fp_t{height, 0});
     }
-    array->push_back(element);
+    writer.end_array();
     ++range;
   }
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_height(const std::vector<double>& heights, const double no_data_value) {
-  auto array = json::array({});
+void serialize_height(json::writer_t& writer,
+                      const std::vector<double>& heights,
+                      const double no_data_value) {
+  writer.start_array("height");
 
   for (const auto height : heights) {
     // add all heights's to an array
     if (height == no_data_value) {
-      array->push_back(nullptr);
+      writer(nullptr);
     } else {
-      array->push_back({json::fp_t{height, 0}});
+      writer(json::fp_t{height, 0});
     }
   }
 
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_shape(const google::protobuf::RepeatedPtrField<valhalla::Location>& shape) {
-  auto array = json::array({});
+void serialize_shape(json::writer_t& writer,
+                     const google::protobuf::RepeatedPtrField<valhalla::Location>& shape) {
+  writer.start_array("shape");
   for (const auto& p : shape) {
-    array->emplace_back(
-        json::map({{"lon", json::fp_t{p.ll().lng(), 6}}, {"lat", json::fp_t{p.ll().lat(), 6}}}));
+    writer.start_object();
+    writer("lon", json::fp_t{p.ll().lng(), 6});
+    writer("lat", json::fp_t{p.ll().lat(), 6});
+    writer.end_object();
   }
-  return array;
+  writer.end_array();
 }
 
 } // namespace
@@ -68,29 +73,28 @@ namespace tyr {
 std::string serializeHeight(const Api& request,
                             const std::vector<double>& heights,
                             const std::vector<float>& ranges) {
-  auto json = json::map({});
+  json::writer_t writer;
+  writer.start_object();
 
   // get the distances between the postings
   if (ranges.size()) {
-    json = json::map({{"range_height",
-                       serialize_range_height(ranges, heights, skadi::sample::get_no_data_value())}});
+    serialize_range_height(writer, ranges, heights, skadi::sample::get_no_data_value());
   } // just the postings
   else {
-    json = json::map({{"height", serialize_height(heights, skadi::sample::get_no_data_value())}});
+    serialize_height(writer, heights, skadi::sample::get_no_data_value());
   }
   // send back the shape as well
   if (request.options().has_encoded_polyline()) {
-    json->emplace("encoded_polyline", request.options().encoded_polyline());
+    writer("encoded_polyline", request.options().encoded_polyline());
   } else {
-    json->emplace("shape", serialize_shape(request.options().shape()));
+    serialize_shape(writer, request.options().shape());
   }
   if (request.options().has_id()) {
-    json->emplace("id", request.options().id());
+    writer("id", request.options().id());
   }
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  writer.end_object();
+  return writer.get();
 }
 } // namespace tyr
 } // namespace valhalla
@@ -1,5 +1,6 @@
 
 #include "baldr/json.h"
+#include "baldr/json_writer.h"
 #include "midgard/point2.h"
 #include "midgard/pointll.h"
 #include "tyr/serializers.h"
@@ -9,11 +10,25 @@
 #include <sstream>
 #include <utility>
 
-using namespace valhalla::baldr::json;
+using namespace valhalla::baldr;
 
 namespace {
 using rgba_t = std::tuple<float, float, float>;
+
+void serialize_point(json::writer_t& writer, double lng, double lat) {
+  writer.start_array();
+  writer(json::fp_t{lng, 6});
+  writer(json::fp_t{lat, 6});
+  writer.end_array();
+}
+
+template <class contour_t>
+void serialize_coordinates(json::writer_t& writer, const contour_t& contour) {
+  for (const auto& coord : contour) {
+    serialize_point(writer, coord.first, coord.second);
+  }
 }
+} // namespace
 
 namespace valhalla {
 namespace tyr {
@@ -25,9 +40,14 @@ serializeIsochrones(const Api& request,
                     bool polygons,
                     const std::unordered_map<float, std::string>& colors,
                     bool show_locations) {
+  // make the collection
+  json::writer_t writer;
+  writer.start_object();
+  writer("type", "FeatureCollection");
+  writer.start_array("features");
+
   // for each contour interval
   int i = 0;
-  auto features = array({});
   for (const auto& interval : grid_contours) {
     auto color_itr = colors.find(interval.first);
     // color was supplied
@@ -47,42 +67,39 @@ serializeIsochrones(const Api& request,
           << static_cast<int>(std::get<2>(color) * 255 + .5f);
     }
     ++i;
+    const auto color = hex.str();
 
     // for each feature on that interval
     for (const auto& feature : interval.second) {
-      // for each contour in that feature
-      auto geom = array({});
-      for (const auto& contour : feature) {
-        // make some geometry
-        auto coords = array({});
-        for (const auto& coord : contour) {
-          coords->push_back(array({fp_t{coord.first, 6}, fp_t{coord.second, 6}}));
-        }
-        // its either a ring
-        if (polygons) {
-          geom->emplace_back(coords);
-          // or a single line, if someone has more than one contour per feature they messed up
-        } else {
-          geom = coords;
+      // add a feature
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("geometry");
+      writer("type", polygons ? "Polygon" : "LineString");
+      writer.start_array("coordinates");
+      // its either rings
+      if (polygons) {
+        for (const auto& contour : feature) {
+          writer.start_array();
+          serialize_coordinates(writer, contour);
+          writer.end_array();
         }
+      } // or a single line, if someone has more than one contour per feature they messed up
+      else if (!feature.empty()) {
+        serialize_coordinates(writer, feature.back());
       }
-      // add a feature
-      features->emplace_back(map({
-          {"type", std::string("Feature")},
-          {"geometry", map({
-                           {"type", std::string(polygons ? "Polygon" : "LineString")},
-                           {"coordinates", geom},
-                       })},
-          {"properties", map({
-                             {"contour", static_cast<uint64_t>(interval.first)},
-                             {"color", hex.str()},            // lines
-                             {"fill", hex.str()},             // geojson.io polys
-                             {"fillColor", hex.str()},        // leaflet polys
-                             {"opacity", fp_t{.33f, 2}},      // lines
-                             {"fill-opacity", fp_t{.33f, 2}}, // geojson.io polys
-                             {"fillOpacity", fp_t{.33f, 2}},  // leaflet polys
-                         })},
-      }));
+      writer.end_array();
+      writer.end_object();
+      writer.start_object("properties");
+      writer("contour", static_cast<uint64_t>(interval.first));
+      writer("color", color);                      // lines
+      writer("fill", color);                       // geojson.io polys
+      writer("fillColor", color);                  // leaflet polys
+      writer("opacity", json::fp_t{.33f, 2});      // lines
+      writer("fill-opacity", json::fp_t{.33f, 2}); // geojson.io polys
+      writer("fillOpacity", json::fp_t{.33f, 2});  // leaflet polys
+      writer.end_object();
+      writer.end_object();
     }
   }
   // Add input and snapped locations to the geojson
@@ -90,49 +107,55 @@ serializeIsochrones(const Api& request,
     int idx = 0;
     for (const auto& location : request.options().locations()) {
       // first add all snapped points as MultiPoint feature per origin point
-      auto snapped_points_array = array({});
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("properties");
+      writer("type", "snapped");
+      writer("location_index", static_cast<uint64_t>(idx));
+      writer.end_object();
+      writer.start_object("geometry");
+      writer("type", "MultiPoint");
+      writer.start_array("coordinates");
       std::unordered_set<midgard::PointLL> snapped_points;
       for (const auto& path_edge : location.path_edges()) {
         const midgard::PointLL& snapped_current =
             midgard::PointLL(path_edge.ll().lng(), path_edge.ll().lat());
         // remove duplicates of path_edges in case the snapped object is a node
         if (snapped_points.insert(snapped_current).second) {
-          snapped_points_array->push_back(
-              array({fp_t{snapped_current.lng(), 6}, fp_t{snapped_current.lat(), 6}}));
+          serialize_point(writer, snapped_current.lng(), snapped_current.lat());
         }
       };
-      features->emplace_back(map(
-          {{"type", std::string("Feature")},
-           {"properties",
-            map({{"type", std::string("snapped")}, {"location_index", static_cast<uint64_t>(idx)}})},
-           {"geometry",
-            map({{"type", std::string("MultiPoint")}, {"coordinates", snapped_points_array}})}}));
+      writer.end_array();
+      writer.end_object();
+      writer.end_object();
 
       // then each user input point as separate Point feature
       const valhalla::LatLng& input_latlng = location.ll();
-      const auto input_array = array({fp_t{input_latlng.lng(), 6}, fp_t{input_latlng.lat(), 6}});
-      features->emplace_back(map(
-          {{"type", std::string("Feature")},
-           {"properties",
-            map({{"type", std::string("input")}, {"location_index", static_cast<uint64_t>(idx)}})},
-           {"geometry", map({{"type", std::string("Point")}, {"coordinates", input_array}})}}));
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("properties");
+      writer("type", "input");
+      writer("location_index", static_cast<uint64_t>(idx));
+      writer.end_object();
+      writer.start_object("geometry");
+      writer("type", "Point");
+      writer.start_array("coordinates");
+      writer(json::fp_t{input_latlng.lng(), 6});
+      writer(json::fp_t{input_latlng.lat(), 6});
+      writer.end_array();
+      writer.end_object();
+      writer.end_object();
       idx++;
     }
   }
-
-  // make the collection
-  auto feature_collection = map({
-      {"type", std::string("FeatureCollection")},
-      {"features", features},
-  });
+  writer.end_array();
 
   if (request.options().has_id()) {
-    feature_collection->emplace("id", request.options().id());
+    writer("id", request.options().id());
   }
 
-  std::stringstream ss;
-  ss << *feature_collection;
-  return ss.str();
+  writer.end_object();
+  return writer.get();
 }
 
 template std::string
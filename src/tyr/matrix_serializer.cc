@@ -1,6 +1,7 @@
 #include <cstdint>
 
 #include "baldr/json.h"
+#include "baldr/json_writer.h"
 #include "thor/costmatrix.h"
 #include "tyr/serializers.h"
 
@@ -9,65 +10,80 @@ using namespace valhalla::midgard;
 using namespace valhalla::baldr;
 using namespace valhalla::thor;
 
+namespace {
+
+// A rough size of a serialized matrix so the writer does not have to keep growing its buffer
+size_t reserve_size(const Options& options, size_t bytes_per_pair) {
+  return json::writer_t::kDefaultReserve +
+         options.sources_size() * options.targets_size() * bytes_per_pair;
+}
+
+} // namespace
+
 namespace osrm_serializers {
 
-json::ArrayPtr
-serialize_duration(const std::vector<TimeDistance>& tds, size_t start_td, const size_t td_count) {
-  auto time = json::array({});
+void serialize_duration(json::writer_t& writer,
+                        const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for time in matrix result
     if (tds[i].time != kMaxCost) {
-      time->emplace_back(static_cast<uint64_t>(tds[i].time));
+      writer(static_cast<uint64_t>(tds[i].time));
     } else {
-      time->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return time;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_distance(const std::vector<TimeDistance>& tds,
-                                  size_t start_td,
-                                  const size_t td_count,
-                                  const size_t source_index,
-                                  const size_t target_index,
-                                  double distance_scale) {
-  auto distance = json::array({});
+void serialize_distance(json::writer_t& writer,
+                        const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count,
+                        double distance_scale) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance in matrix result
     if (tds[i].time != kMaxCost) {
-      distance->emplace_back(json::fp_t{tds[i].dist * distance_scale, 3});
+      writer(json::fp_t{tds[i].dist * distance_scale, 3});
     } else {
-      distance->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return distance;
+  writer.end_array();
 }
 
 // Serialize route response in OSRM compatible format.
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  auto json = json::map({});
-  auto time = json::array({});
-  auto distance = json::array({});
+std::string serialize(const Api& request,
+                      const std::vector<TimeDistance>& time_distances,
+                      double distance_scale) {
   const auto& options = request.options();
+  json::writer_t writer(reserve_size(options, 16));
+  writer.start_object();
 
   // If here then the matrix succeeded. Set status code to OK and serialize
   // waypoints (locations).
-  json->emplace("code", std::string("Ok"));
-  json->emplace("sources", osrm::waypoints(options.sources()));
-  json->emplace("destinations", osrm::waypoints(options.targets()));
+  writer("code", "Ok");
+  writer("sources", osrm::waypoints(options.sources()));
+  writer("destinations", osrm::waypoints(options.targets()));
 
+  writer.start_array("durations");
+  for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
+    serialize_duration(writer, time_distances, source_index * options.targets_size(),
+                       options.targets_size());
+  }
+  writer.end_array();
+  writer.start_array("distances");
   for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-    time->emplace_back(serialize_duration(time_distances, source_index * options.targets_size(),
-                                          options.targets_size()));
-    distance->emplace_back(serialize_distance(time_distances, source_index * options.targets_size(),
-                                              options.targets_size(), source_index, 0,
-                                              distance_scale));
+    serialize_distance(writer, time_distances, source_index * options.targets_size(),
+                       options.targets_size(), distance_scale);
   }
-  json->emplace("durations", time);
-  json->emplace("distances", distance);
-  return json;
+  writer.end_array();
+
+  writer.end_object();
+  return writer.get();
 }
 } // namespace osrm_serializers
 
@@ -78,60 +94,72 @@ valhalla output looks like this:
 
 */
 
-json::ArrayPtr locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated) {
-  auto input_locs = json::array({});
+void locations(json::writer_t& writer,
+               const google::protobuf::RepeatedPtrField<valhalla::Location>& correlated) {
+  writer.start_array();
   for (size_t i = 0; i < correlated.size(); i++) {
-    input_locs->emplace_back(json::map({{"lat", json::fp_t{correlated.Get(i).ll().lat(), 6}},
-                                        {"lon", json::fp_t{correlated.Get(i).ll().lng(), 6}}}));
+    writer.start_object();
+    writer("lat", json::fp_t{correlated.Get(i).ll().lat(), 6});
+    writer("lon", json::fp_t{correlated.Get(i).ll().lng(), 6});
+    writer.end_object();
   }
-  return input_locs;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_row(const std::vector<TimeDistance>& tds,
-                             size_t start_td,
-                             const size_t td_count,
-                             const size_t source_index,
-                             const size_t target_index,
-                             double distance_scale) {
-  auto row = json::array({});
+void serialize_row(json::writer_t& writer,
+                   const std::vector<TimeDistance>& tds,
+                   size_t start_td,
+                   const size_t td_count,
+                   const size_t source_index,
+                   const size_t target_index,
+                   double distance_scale) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
+    writer.start_object();
+    writer("from_index", static_cast<uint64_t>(source_index));
+    writer("to_index", static_cast<uint64_t>(target_index + (i - start_td)));
     // check to make sure a route was found; if not, return null for distance & time in matrix
     // result
     if (tds[i].time != kMaxCost) {
-      row->emplace_back(json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                                   {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                                   {"time", static_cast<uint64_t>(tds[i].time)},
-                                   {"distance", json::fp_t{tds[i].dist * distance_scale, 3}}}));
+      writer("time", static_cast<uint64_t>(tds[i].time));
+      writer("distance", json::fp_t{tds[i].dist * distance_scale, 3});
     } else {
-      row->emplace_back(json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                                   {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                                   {"time", static_cast<std::nullptr_t>(nullptr)},
-                                   {"distance", static_cast<std::nullptr_t>(nullptr)}}));
+      writer("time", nullptr);
+      writer("distance", nullptr);
     }
+    writer.end_object();
   }
-  return row;
+  writer.end_array();
 }
 
-json::MapPtr serialize(const Api& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  json::ArrayPtr matrix = json::array({});
+std::string serialize(const Api& request,
+                      const std::vector<TimeDistance>& time_distances,
+                      double distance_scale) {
   const auto& options = request.options();
+  json::writer_t writer(reserve_size(options, 64));
+  writer.start_object();
+
+  writer.start_array("sources_to_targets");
   for (size_t source_index = 0; source_index < options.sources_size(); ++source_index) {
-    matrix->emplace_back(serialize_row(time_distances, source_index * options.targets_size(),
-                                       options.targets_size(), source_index, 0, distance_scale));
+    serialize_row(writer, time_distances, source_index * options.targets_size(),
+                  options.targets_size(), source_index, 0, distance_scale);
   }
-  auto json = json::map({
-      {"sources_to_targets", matrix},
-      {"units", Options_Units_Enum_Name(options.units())},
-  });
-  json->emplace("targets", json::array({locations(options.targets())}));
-  json->emplace("sources", json::array({locations(options.sources())}));
+  writer.end_array();
+  writer("units", Options_Units_Enum_Name(options.units()));
+
+  writer.start_array("targets");
+  locations(writer, options.targets());
+  writer.end_array();
+  writer.start_array("sources");
+  locations(writer, options.sources());
+  writer.end_array();
 
   if (options.has_id()) {
-    json->emplace("id", options.id());
+    writer("id", options.id());
   }
-  return json;
+
+  writer.end_object();
+  return writer.get();
 }
 } // namespace valhalla_serializers
 
@@ -141,14 +169,9 @@ namespace tyr {
 std::string serializeMatrix(const Api& request,
                             const std::vector<TimeDistance>& time_distances,
                             double distance_scale) {
-
-  auto json = request.options().format() == Options::osrm
-                  ? osrm_serializers::serialize(request, time_distances, distance_scale)
-                  : valhalla_serializers::serialize(request, time_distances, distance_scale);
-
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return request.options().format() == Options::osrm
+             ? osrm_serializers::serialize(request, time_distances, distance_scale)
+             : valhalla_serializers::serialize(request, time_distances, distance_scale);
 }
 
 } // namespace tyr
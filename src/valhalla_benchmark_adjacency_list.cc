@@ -1,9 +1,12 @@
 #include <boost/program_options.hpp>
 #include <cstdint>
+#include <ctime>
+#include <fstream>
 #include <iostream>
 #include <queue>
 #include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "config.h"
@@ -12,10 +15,13 @@
 #include "sif/edgelabel.h"
 
 #include "baldr/double_bucket_queue.h"
+#include "thor/edgestatus.h"
+#include "thor/pathalgorithm.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
 using namespace valhalla::sif;
+using namespace valhalla::thor;
 
 namespace bpo = boost::program_options;
 
@@ -106,6 +112,310 @@ int Benchmark(const uint32_t n, const float maxcost, const float bucketsize) {
   return 0;
 }
 
+namespace {
+
+// The edge status as it was before the tile slot table and pooled arrays, kept to
+// compare against: one hash lookup per call and an array allocated per tile per search
+class MapEdgeStatus {
+public:
+  ~MapEdgeStatus() {
+    clear();
+  }
+  void clear() {
+    for (auto& iter : edgestatus_) {
+      delete[] iter.second;
+    }
+    edgestatus_.clear();
+  }
+  EdgeStatusInfo Get(const GraphId& edgeid) const {
+    const auto p = edgestatus_.find(edgeid.tile_value());
+    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+  }
+  EdgeStatusInfo* GetPtr(const GraphId& edgeid, const GraphTile* tile) {
+    const auto p = edgestatus_.find(edgeid.tile_value());
+    if (p != edgestatus_.end()) {
+      return &p->second[edgeid.id()];
+    }
+    auto inserted = edgestatus_.emplace(edgeid.tile_value(),
+                                        new EdgeStatusInfo[tile->header()->directededgecount()]);
+    return &(inserted.first->second)[edgeid.id()];
+  }
+  void Set(const GraphId& edgeid, const EdgeSet set, const uint32_t index, const GraphTile* tile) {
+    GetPtr(edgeid, tile)[0] = {set, index};
+  }
+
+private:
+  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+};
+
+struct BenchmarkTile : public GraphTile {
+  BenchmarkTile(GraphTileHeader* header) {
+    header_ = header;
+  }
+};
+
+/**
+ * Runs a number of fake searches against an edge status. Each search wanders
+ * over neighbouring tiles and, like the path algorithms, gets a pointer to the
+ * status of the edges leaving a node, checks each of them and labels them.
+ * @return milliseconds spent
+ */
+template <typename edge_status_t>
+uint32_t EdgeStatusBenchmark(edge_status_t& edgestatus,
+                             const std::vector<GraphId>& nodes,
+                             const uint32_t searches,
+                             const GraphTile* tile,
+                             uint64_t& checksum) {
+  std::clock_t start = std::clock();
+  for (uint32_t s = 0; s < searches; ++s) {
+    uint32_t index = 0;
+    for (const auto& node : nodes) {
+      EdgeStatusInfo* es = edgestatus.GetPtr(node, tile);
+      for (uint32_t i = 0; i < 8; ++i, ++es) {
+        if (es->set() == EdgeSet::kPermanent) {
+          continue;
+        }
+        GraphId edgeid(node.tileid(), node.level(), node.id() + i);
+        if (es->set() != EdgeSet::kTemporary) {
+          edgestatus.Set(edgeid, EdgeSet::kTemporary, index++, tile);
+        }
+      }
+      // opposing edge lookup in a neighbouring tile as done by the bidirectional search
+      checksum += edgestatus.Get(GraphId(node.tileid() + 1, node.level(), node.id())).index();
+      edgestatus.Set(node, EdgeSet::kPermanent, index, tile);
+    }
+    edgestatus.clear();
+  }
+  return (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+}
+
+/**
+ * Benchmark of the edge status used by the path algorithms against the hash map
+ * based implementation it replaced.
+ */
+int EdgeStatusBenchmark(const uint32_t n, const uint32_t tilecount, const uint32_t searches) {
+  // A random walk over a row of tiles and the edges within them so that consecutive
+  // nodes tend to share a tile and be close in it, as the expansion of a search does
+  const uint32_t kEdgesPerTile = 100000;
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<uint32_t> step(0, 99);
+  std::uniform_int_distribution<int32_t> offset(-500, 500);
+  std::vector<GraphId> nodes;
+  uint32_t tileid = tilecount / 2;
+  int32_t edgeid = kEdgesPerTile / 2;
+  for (uint32_t i = 0; i < n; ++i) {
+    uint32_t r = step(gen);
+    if (r < 3 && tileid + 1 < tilecount) {
+      ++tileid;
+    } else if (r < 6 && tileid > 0) {
+      --tileid;
+    }
+    edgeid = std::min(std::max(edgeid + offset(gen), 0), static_cast<int32_t>(kEdgesPerTile - 9));
+    nodes.emplace_back(tileid, r < 10 ? 1 : 2, edgeid);
+  }
+
+  GraphTileHeader header;
+  header.set_directededgecount(kEdgesPerTile);
+  BenchmarkTile tile(&header);
+
+  uint64_t checksum1 = 0, checksum2 = 0;
+  MapEdgeStatus map_edgestatus;
+  uint32_t ms = EdgeStatusBenchmark(map_edgestatus, nodes, searches, &tile, checksum1);
+  LOG_INFO("Hash map edge status: " + std::to_string(searches) + " searches of " +
+           std::to_string(n) + " nodes in " + std::to_string(ms) + " ms");
+
+  EdgeStatus edgestatus;
+  ms = EdgeStatusBenchmark(edgestatus, nodes, searches, &tile, checksum2);
+  LOG_INFO("Tile slot edge status: " + std::to_string(searches) + " searches of " +
+           std::to_string(n) + " nodes in " + std::to_string(ms) + " ms");
+
+  if (checksum1 != checksum2) {
+    LOG_ERROR("Edge status results differ");
+  }
+  return 0;
+}
+
+// One operation a search did on its adjacency list
+struct QueueOp {
+  enum Type : uint8_t { kAdd, kDecrease, kPop };
+  Type type;
+  uint32_t label;
+  float cost;
+};
+
+/**
+ * Loads an adjacency list trace. Each line is one operation of a search:
+ * "a <label> <sortcost>" adds a new edge label with the given sort cost,
+ * "d <label> <sortcost>" decreases the sort cost of a label and "p" pops.
+ */
+std::vector<QueueOp> LoadTrace(const std::string& file) {
+  std::ifstream in(file);
+  if (!in) {
+    throw std::runtime_error("Could not open trace " + file);
+  }
+  std::vector<QueueOp> trace;
+  std::string op;
+  while (in >> op) {
+    if (op == "p") {
+      trace.push_back({QueueOp::kPop, kInvalidLabel, 0.0f});
+    } else {
+      QueueOp o{op == "d" ? QueueOp::kDecrease : QueueOp::kAdd, 0, 0.0f};
+      in >> o.label >> o.cost;
+      trace.push_back(o);
+    }
+  }
+  return trace;
+}
+
+/**
+ * Records the adjacency list operations of a Dijkstra search over a grid of
+ * nodes with random edge costs, expanding outward from the center until the
+ * whole grid is settled. Costs grow far past the low level bucket range so
+ * the overflow gets re-bucketed many times, as on long routes.
+ */
+std::vector<QueueOp> GridTrace(const uint32_t size) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<uint32_t> edgecost(1, 100);
+  const uint32_t n = size * size;
+  std::vector<float> cost(n, std::numeric_limits<float>::max());
+  std::vector<uint32_t> label(n, kInvalidLabel);
+  std::vector<bool> settled(n, false);
+  std::vector<QueueOp> trace;
+
+  // Exact search with a binary heap to decide the order, skipping stale entries
+  using entry_t = std::pair<float, uint32_t>;
+  std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> heap;
+  uint32_t labels = 0;
+  uint32_t origin = n / 2 + size / 2;
+  cost[origin] = 0.0f;
+  label[origin] = labels++;
+  trace.push_back({QueueOp::kAdd, label[origin], 0.0f});
+  heap.emplace(0.0f, origin);
+  while (!heap.empty()) {
+    auto top = heap.top();
+    heap.pop();
+    uint32_t node = top.second;
+    if (settled[node] || top.first > cost[node]) {
+      continue;
+    }
+    settled[node] = true;
+    trace.push_back({QueueOp::kPop, label[node], cost[node]});
+
+    uint32_t x = node % size, y = node / size;
+    uint32_t neighbors[] = {x > 0 ? node - 1 : kInvalidLabel,
+                            x + 1 < size ? node + 1 : kInvalidLabel,
+                            y > 0 ? node - size : kInvalidLabel,
+                            y + 1 < size ? node + size : kInvalidLabel};
+    for (auto next : neighbors) {
+      if (next == kInvalidLabel || settled[next]) {
+        continue;
+      }
+      float c = cost[node] + edgecost(gen);
+      if (c < cost[next]) {
+        if (label[next] == kInvalidLabel) {
+          label[next] = labels++;
+          trace.push_back({QueueOp::kAdd, label[next], c});
+        } else {
+          trace.push_back({QueueOp::kDecrease, label[next], c});
+        }
+        cost[next] = c;
+        heap.emplace(c, next);
+      }
+    }
+  }
+  return trace;
+}
+
+/**
+ * Replays a trace against an adjacency list the way the path algorithms use
+ * it: labels are appended to an edge label vector, decreased labels are
+ * updated after the queue and popped labels are copied out.
+ * @return the sum of the popped sort costs
+ */
+template <typename add_t, typename decrease_t, typename pop_t>
+double ReplayTrace(const std::vector<QueueOp>& trace,
+                   std::vector<EdgeLabel>& edgelabels,
+                   const add_t& add,
+                   const decrease_t& decrease,
+                   const pop_t& pop) {
+  double total = 0.0;
+  for (const auto& op : trace) {
+    if (op.type == QueueOp::kAdd) {
+      EdgeLabel el;
+      el.SetSortCost(op.cost);
+      edgelabels.push_back(std::move(el));
+      add(op.label);
+    } else if (op.type == QueueOp::kDecrease) {
+      decrease(op.label, op.cost);
+      edgelabels[op.label].SetSortCost(op.cost);
+    } else {
+      uint32_t idx = pop();
+      if (idx == kInvalidLabel) {
+        break;
+      }
+      EdgeLabel el = edgelabels[idx];
+      total += el.sortcost();
+    }
+  }
+  return total;
+}
+
+/**
+ * Benchmark of the templated bucket queue, in both its modes, against the
+ * double bucket queue on a trace of adjacency list operations. Every run
+ * replays the trace a number of times like consecutive requests would. The
+ * double bucket queue is constructed per search as the path algorithms did,
+ * the templated queue is reset so it reuses its storage.
+ */
+int TraceBenchmark(const std::vector<QueueOp>& trace,
+                   const uint32_t bucketsize,
+                   const float range,
+                   const uint32_t searches) {
+  std::vector<EdgeLabel> edgelabels;
+  const auto edgecost = [&edgelabels](const uint32_t label) { return edgelabels[label].sortcost(); };
+
+  std::clock_t start = std::clock();
+  double total1 = 0.0;
+  for (uint32_t s = 0; s < searches; ++s) {
+    edgelabels.clear();
+    DoubleBucketQueue adjlist(0, range, bucketsize, edgecost);
+    total1 += ReplayTrace(
+        trace, edgelabels, [&adjlist](uint32_t label) { adjlist.add(label); },
+        [&adjlist](uint32_t label, float cost) { adjlist.decrease(label, cost); },
+        [&adjlist]() { return adjlist.pop(); });
+  }
+  uint32_t ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  LOG_INFO("Double bucket queue: " + std::to_string(searches) + " replays of " +
+           std::to_string(trace.size()) + " operations in " + std::to_string(ms) + " ms");
+
+  for (auto mode : {BucketQueueMode::kDoubleBucket, BucketQueueMode::kRadixHeap}) {
+    BucketQueue<std::vector<EdgeLabel>> adjlist(mode);
+    start = std::clock();
+    double total2 = 0.0;
+    for (uint32_t s = 0; s < searches; ++s) {
+      edgelabels.clear();
+      adjlist.reset(0, range, bucketsize, &edgelabels);
+      total2 += ReplayTrace(
+          trace, edgelabels, [&adjlist](uint32_t label) { adjlist.add(label); },
+          [&adjlist](uint32_t label, float cost) { adjlist.decrease(label, cost); },
+          [&adjlist]() { return adjlist.pop(); });
+    }
+    ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+    LOG_INFO(std::string(mode == BucketQueueMode::kRadixHeap ? "Radix heap" : "Templated bucket") +
+             " queue: " + std::to_string(searches) + " replays of " + std::to_string(trace.size()) +
+             " operations in " + std::to_string(ms) + " ms");
+
+    // Every popped label is the same, only the order within a bucket may differ
+    if (std::abs(total1 - total2) > 1e-6 * total1) {
+      LOG_ERROR("Popped sort costs differ: " + std::to_string(total1) + " vs " +
+                std::to_string(total2));
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
 
   bpo::options_description options(
@@ -114,12 +424,25 @@ int main(int argc, char* argv[]) {
       " Usage: adjlistbenchmark [options]\n"
       "\n"
       "adjlistbenchmark is benchmark comparing performance of an STL priority_queue"
-      "to the approximate double bucket adjacency list class supplied with Valhalla."
+      "to the approximate double bucket adjacency list class supplied with Valhalla. It also "
+      "compares the edge status used by the path algorithms to a hash map based one and replays "
+      "a trace of adjacency list operations against the templated bucket queue and its radix "
+      "heap mode."
       "\n"
       "\n");
 
-  options.add_options()("help,h", "Print this help message.")("version,v",
-                                                              "Print the version of this software.");
+  std::string trace_file;
+  uint32_t bucketsize, grid_size;
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "trace,t", boost::program_options::value<std::string>(&trace_file),
+      "Adjacency list trace to replay, one operation per line: \"a <label> <sortcost>\" to add, "
+      "\"d <label> <sortcost>\" to decrease and \"p\" to pop. Defaults to the trace of a "
+      "search over a grid.")("bucketsize,b",
+                             boost::program_options::value<uint32_t>(&bucketsize)->default_value(1),
+                             "Bucket size (the costing unit size) used to replay the trace.")(
+      "grid,g", boost::program_options::value<uint32_t>(&grid_size)->default_value(700),
+      "Number of nodes along each side of the grid searched when no trace is given.");
 
   bpo::variables_map vm;
   try {
@@ -144,6 +467,18 @@ int main(int argc, char* argv[]) {
 
   // Benchmark with count, maxcost, and bucketsize
   Benchmark(1000000, 50000, 1);
+
+  // Benchmark edge status with node count, tile count and number of searches
+  EdgeStatusBenchmark(1000000, 64, 10);
+
+  // Benchmark adjacency lists on a trace with the bucket count of the path algorithms
+  try {
+    auto trace = trace_file.empty() ? GridTrace(grid_size) : LoadTrace(trace_file);
+    TraceBenchmark(trace, bucketsize, kBucketCount * bucketsize, 10);
+  } catch (const std::exception& e) {
+    LOG_ERROR(e.what());
+    return EXIT_FAILURE;
+  }
   LOG_INFO("Done Benchmark!");
 
   return EXIT_SUCCESS;
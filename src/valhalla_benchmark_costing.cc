@@ -0,0 +1,231 @@
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/rapidjson_utils.h"
+#include "loki/worker.h"
+#include "midgard/logging.h"
+#include "sif/autocost.h"
+#include "sif/bicyclecost.h"
+#include "sif/pedestriancost.h"
+#include "sif/truckcost.h"
+#include "thor/bidirectional_astar.h"
+#include "worker.h"
+
+#include <valhalla/proto/api.pb.h>
+
+#include "config.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// A costing that costs exactly like cost_t but isn't one as far as sif::DispatchCost can tell,
+// so the path algorithms call its methods virtually as they do for custom costings
+template <typename cost_t> class Virtual : public cost_t {
+public:
+  using cost_t::cost_t;
+};
+
+// What one run of the route set took
+struct Run {
+  uint64_t routes = 0;
+  double seconds = 0.0;
+  std::vector<float> costs;
+};
+
+/**
+ * Runs every leg of the routes through bidirectional A*.
+ * @return the time and cost of each leg
+ */
+Run Benchmark(BidirectionalAStar& algorithm,
+              GraphReader& reader,
+              const std::vector<Api>& routes,
+              const std::shared_ptr<DynamicCost>& costing) {
+  std::shared_ptr<DynamicCost> mode_costing[4];
+  mode_costing[static_cast<uint32_t>(costing->travel_mode())] = costing;
+  Run run;
+  for (const auto& route : routes) {
+    const auto& options = route.options();
+    for (int i = 0; i + 1 < options.locations_size(); ++i) {
+      valhalla::Location origin = options.locations(i);
+      valhalla::Location destination = options.locations(i + 1);
+      auto start = std::chrono::steady_clock::now();
+      auto paths = algorithm.GetBestPath(origin, destination, reader, mode_costing,
+                                         costing->travel_mode(), options);
+      run.seconds +=
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      algorithm.Clear();
+      ++run.routes;
+      run.costs.push_back(paths.empty() || paths.front().empty()
+                              ? -1.0f
+                              : paths.front().back().elapsed_cost);
+    }
+  }
+  return run;
+}
+
+/**
+ * Creates the costing of the routes twice, once as what the costing factory makes and once
+ * hidden behind a subclass so the path algorithm can't specialize for it.
+ * @return false if the costing has no specialization to compare against
+ */
+bool CreateCostings(const Options& options,
+                    std::shared_ptr<DynamicCost>& specialized,
+                    std::shared_ptr<DynamicCost>& fallback) {
+  switch (options.costing()) {
+    case Costing::auto_:
+      specialized = std::make_shared<AutoCost>(options.costing(), options);
+      fallback = std::make_shared<Virtual<AutoCost>>(options.costing(), options);
+      return true;
+    case Costing::truck:
+      specialized = std::make_shared<TruckCost>(options.costing(), options);
+      fallback = std::make_shared<Virtual<TruckCost>>(options.costing(), options);
+      return true;
+    case Costing::pedestrian:
+      specialized = std::make_shared<PedestrianCost>(options.costing(), options);
+      fallback = std::make_shared<Virtual<PedestrianCost>>(options.costing(), options);
+      return true;
+    case Costing::bicycle:
+      specialized = std::make_shared<BicycleCost>(options.costing(), options);
+      fallback = std::make_shared<Virtual<BicycleCost>>(options.costing(), options);
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  std::string config_file, routes_file;
+  uint32_t iterations;
+
+  bpo::options_description options(
+      "valhalla " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_costing [options]\n"
+      "\n"
+      "valhalla_benchmark_costing measures what binding the costing to its concrete type does "
+      "for the edge expansion of the path algorithms. It runs a fixed set of routes with "
+      "bidirectional A* using the auto, truck, pedestrian or bicycle costing, whose methods the "
+      "expansion calls directly, and again with a subclass of the same costing, whose methods it "
+      "calls virtually like those of any other costing. It reports the time each takes and how "
+      "many route costs differ, which should be none. The routes file holds one route request "
+      "per line, for example "
+      "{\"locations\":[{\"lat\":40.73,\"lon\":-73.99},{\"lat\":40.75,\"lon\":-73.98}],"
+      "\"costing\":\"auto\"}. All routes must use the same costing."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "config,c", bpo::value<std::string>(&config_file)->required(),
+      "Path to the json configuration file.")("routes,r",
+                                              bpo::value<std::string>(&routes_file)->required(),
+                                              "File with one route request per line.")(
+      "iterations,i", bpo::value<uint32_t>(&iterations)->default_value(3),
+      "Number of times to run the routes with each costing, the fastest run is reported.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    if (vm.count("help")) {
+      std::cout << options << "\n";
+      return EXIT_SUCCESS;
+    }
+    if (vm.count("version")) {
+      std::cout << "valhalla_benchmark_costing " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree config;
+  rapidjson::read_json(config_file, config);
+
+  // find the locations of the routes in the graph
+  loki::loki_worker_t loki_worker(config);
+  std::vector<Api> routes;
+  std::ifstream file(routes_file);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    Api request;
+    try {
+      ParseApi(line, Options::route, request);
+      loki_worker.route(request);
+    } catch (const std::exception& e) {
+      LOG_WARN("Skipping route " + line + ": " + e.what());
+      continue;
+    }
+    if (!routes.empty() && request.options().costing() != routes.front().options().costing()) {
+      LOG_ERROR("All routes must use the same costing");
+      return EXIT_FAILURE;
+    }
+    routes.emplace_back(std::move(request));
+  }
+  if (routes.empty()) {
+    LOG_ERROR("No routes in " + routes_file);
+    return EXIT_FAILURE;
+  }
+
+  std::shared_ptr<DynamicCost> specialized, fallback;
+  if (!CreateCostings(routes.front().options(), specialized, fallback)) {
+    LOG_ERROR("The routes must use the auto, truck, pedestrian or bicycle costing");
+    return EXIT_FAILURE;
+  }
+
+  // warm the tile cache so every run reads the same tiles from memory
+  GraphReader reader(config.get_child("mjolnir"));
+  BidirectionalAStar algorithm;
+  Benchmark(algorithm, reader, routes, specialized);
+
+  // alternate the two so neither gets a warmer cache, keep the fastest run of each
+  Run direct, indirect;
+  for (uint32_t i = 0; i < std::max<uint32_t>(iterations, 1); ++i) {
+    auto run = Benchmark(algorithm, reader, routes, specialized);
+    if (i == 0 || run.seconds < direct.seconds) {
+      direct = std::move(run);
+    }
+    run = Benchmark(algorithm, reader, routes, fallback);
+    if (i == 0 || run.seconds < indirect.seconds) {
+      indirect = std::move(run);
+    }
+  }
+
+  size_t different = 0;
+  for (size_t i = 0; i < direct.costs.size(); ++i) {
+    different += std::abs(direct.costs[i] - indirect.costs[i]) > 0.001f;
+  }
+
+  LOG_INFO(std::to_string(direct.routes) + " routes with bidirectional A*");
+  LOG_INFO("virtual calls: " + std::to_string(indirect.seconds) + " s");
+  LOG_INFO("specialized: " + std::to_string(direct.seconds) + " s (" +
+           std::to_string(indirect.seconds / direct.seconds) + "x)");
+  LOG_INFO(std::to_string(different) + " routes with a different cost");
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "baldr/json.h"
+#include "baldr/json_writer.h"
+#include "config.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// bytes currently allocated and the most there were since the last reset
+std::atomic<size_t> allocated(0);
+std::atomic<size_t> peak(0);
+
+// the size of each allocation is kept in front of it so it can be taken off again when freed
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+void* allocate(size_t size) {
+  auto* block = static_cast<char*>(std::malloc(size + kHeader));
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  auto now = allocated += size;
+  auto most = peak.load();
+  while (now > most && !peak.compare_exchange_weak(most, now)) {
+  }
+  return block + kHeader;
+}
+
+void deallocate(void* ptr) {
+  if (ptr) {
+    auto* block = static_cast<char*>(ptr) - kHeader;
+    allocated -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+  }
+}
+
+// A cell of a matrix, as the serializers see it
+struct Cell {
+  uint32_t time;
+  float dist;
+};
+
+// The same response a valhalla format matrix has, built as a tree then printed
+std::string SerializeTree(const std::vector<Cell>& cells, size_t sources, size_t targets) {
+  auto matrix = json::array({});
+  for (size_t s = 0; s < sources; ++s) {
+    auto row = json::array({});
+    for (size_t t = 0; t < targets; ++t) {
+      const auto& cell = cells[s * targets + t];
+      row->emplace_back(json::map({
+          {"from_index", static_cast<uint64_t>(s)},
+          {"to_index", static_cast<uint64_t>(t)},
+          {"time", static_cast<uint64_t>(cell.time)},
+          {"distance", json::fp_t{cell.dist, 3}},
+      }));
+    }
+    matrix->emplace_back(row);
+  }
+  auto json = json::map({{"sources_to_targets", matrix}, {"units", std::string("kilometers")}});
+  std::stringstream ss;
+  ss << *json;
+  return ss.str();
+}
+
+// The same response written as it is produced
+std::string SerializeWriter(const std::vector<Cell>& cells, size_t sources, size_t targets) {
+  json::writer_t writer(json::writer_t::kDefaultReserve + sources * targets * 64);
+  writer.start_object();
+  writer.start_array("sources_to_targets");
+  for (size_t s = 0; s < sources; ++s) {
+    writer.start_array();
+    for (size_t t = 0; t < targets; ++t) {
+      const auto& cell = cells[s * targets + t];
+      writer.start_object();
+      writer("from_index", static_cast<uint64_t>(s));
+      writer("to_index", static_cast<uint64_t>(t));
+      writer("time", static_cast<uint64_t>(cell.time));
+      writer("distance", json::fp_t{cell.dist, 3});
+      writer.end_object();
+    }
+    writer.end_array();
+  }
+  writer.end_array();
+  writer("units", "kilometers");
+  writer.end_object();
+  return writer.get();
+}
+
+/**
+ * Serializes the matrix a few times with the given serializer and logs the best time, the peak
+ * bytes allocated while serializing and the size of the output.
+ */
+void Benchmark(const std::string& name,
+               const std::function<std::string()>& serialize,
+               size_t iterations) {
+  double best = std::numeric_limits<double>::max();
+  size_t most = 0, length = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    peak = allocated.load();
+    auto before = allocated.load();
+    auto start = std::chrono::steady_clock::now();
+    length = serialize().size();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                              .count());
+    most = std::max(most, peak.load() - before);
+  }
+  LOG_INFO(name + " " + std::to_string(best * 1000) + " ms, peak " +
+           std::to_string(most / (1024 * 1024)) + " MB, " + std::to_string(length) + " bytes");
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  return allocate(size);
+}
+void* operator new[](size_t size) {
+  return allocate(size);
+}
+void operator delete(void* ptr) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+  deallocate(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+
+int main(int argc, char* argv[]) {
+  size_t locations, iterations;
+
+  bpo::options_description options(
+      "valhalla " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_json [options]\n"
+      "\n"
+      "valhalla_benchmark_json measures the time and the peak memory it takes to serialize a "
+      "many to many matrix response, once by building a json tree and printing it and once by "
+      "writing the json as it is produced."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "locations,l", boost::program_options::value<size_t>(&locations)->default_value(1000),
+      "Number of sources and of targets in the matrix.")(
+      "iterations,i", boost::program_options::value<size_t>(&iterations)->default_value(3),
+      "Number of times to serialize the matrix, the best one is reported.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_json " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  // random times and distances
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<uint32_t> time(0, 36000);
+  std::vector<Cell> cells(locations * locations);
+  for (auto& cell : cells) {
+    cell.time = time(gen);
+    cell.dist = cell.time / 45.f;
+  }
+
+  LOG_INFO(std::to_string(locations) + "x" + std::to_string(locations) + " matrix");
+  iterations = std::max<size_t>(iterations, 1);
+  Benchmark("tree", [&]() { return SerializeTree(cells, locations, locations); }, iterations);
+  Benchmark("writer", [&]() { return SerializeWriter(cells, locations, locations); }, iterations);
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "baldr/landmarks.h"
+#include "baldr/rapidjson_utils.h"
+#include "loki/worker.h"
+#include "midgard/logging.h"
+#include "sif/costfactory.h"
+#include "thor/astar.h"
+#include "thor/bidirectional_astar.h"
+#include "thor/timedep.h"
+#include "worker.h"
+
+#include <valhalla/proto/api.pb.h>
+
+#include "config.h"
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// Departure (or arrival) time used by the time dependent algorithms when a route has none
+const std::string kDefaultDateTime = "2019-11-04T08:00";
+
+// What one run of the route set took
+struct Run {
+  uint64_t settled = 0;
+  uint64_t routes = 0;
+  double seconds = 0.0;
+  std::vector<float> costs;
+};
+
+/**
+ * Runs every leg of the routes through the algorithm.
+ * @return the settled edge count, time and cost of each leg
+ */
+Run Benchmark(PathAlgorithm& algorithm,
+              GraphReader& reader,
+              const std::vector<Api>& routes,
+              const std::shared_ptr<DynamicCost>* mode_costing,
+              const TravelMode mode) {
+  Run run;
+  algorithm.set_track_expansion([&run](GraphReader&, const char*, GraphId, const char* status,
+                                       bool) { run.settled += strcmp(status, "s") == 0; });
+  for (const auto& route : routes) {
+    const auto& options = route.options();
+    for (int i = 0; i + 1 < options.locations_size(); ++i) {
+      valhalla::Location origin = options.locations(i);
+      valhalla::Location destination = options.locations(i + 1);
+      if (!origin.has_date_time()) {
+        origin.set_date_time(kDefaultDateTime);
+      }
+      if (!destination.has_date_time()) {
+        destination.set_date_time(kDefaultDateTime);
+      }
+      auto start = std::chrono::steady_clock::now();
+      auto paths = algorithm.GetBestPath(origin, destination, reader, mode_costing, mode, options);
+      run.seconds +=
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      algorithm.Clear();
+      ++run.routes;
+      run.costs.push_back(paths.empty() || paths.front().empty()
+                              ? -1.0f
+                              : paths.front().back().elapsed_cost);
+    }
+  }
+  algorithm.set_track_expansion(nullptr);
+  return run;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  std::string config_file, routes_file, algorithm_name, landmarks_dir;
+
+  bpo::options_description options(
+      "valhalla " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_landmarks [options]\n"
+      "\n"
+      "valhalla_benchmark_landmarks measures what the landmark tables built by the landmarks "
+      "stage of valhalla_build_tiles do for a route algorithm. It runs a fixed set of routes "
+      "with the straight line A* heuristic and again with the landmark (ALT) heuristic and "
+      "reports the number of edges each settles, the time taken and how many route costs "
+      "differ. The routes file holds one route request per line, for example "
+      "{\"locations\":[{\"lat\":40.73,\"lon\":-73.99},{\"lat\":40.75,\"lon\":-73.98}],"
+      "\"costing\":\"auto\"}. All routes must use the same costing."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "config,c", bpo::value<std::string>(&config_file)->required(),
+      "Path to the json configuration file.")("routes,r",
+                                              bpo::value<std::string>(&routes_file)->required(),
+                                              "File with one route request per line.")(
+      "algorithm,a", bpo::value<std::string>(&algorithm_name)->default_value("bidirectional"),
+      "One of astar, bidirectional, timedep_forward or timedep_reverse.")(
+      "landmarks,l", bpo::value<std::string>(&landmarks_dir),
+      "Directory of the landmark tables, mjolnir.landmarks.dir by default.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    if (vm.count("help")) {
+      std::cout << options << "\n";
+      return EXIT_SUCCESS;
+    }
+    if (vm.count("version")) {
+      std::cout << "valhalla_benchmark_landmarks " << VALHALLA_VERSION << "\n";
+      return EXIT_SUCCESS;
+    }
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  boost::property_tree::ptree config;
+  rapidjson::read_json(config_file, config);
+  if (landmarks_dir.empty()) {
+    landmarks_dir = config.get<std::string>("mjolnir.landmarks.dir",
+                                            config.get<std::string>("mjolnir.tile_dir") +
+                                                "/landmarks");
+  }
+  std::shared_ptr<const Landmarks> landmarks(new Landmarks(landmarks_dir));
+  if (landmarks->empty()) {
+    LOG_ERROR("No landmark tables in " + landmarks_dir);
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<PathAlgorithm> algorithm;
+  if (algorithm_name == "astar") {
+    algorithm.reset(new AStarPathAlgorithm());
+  } else if (algorithm_name == "bidirectional") {
+    algorithm.reset(new BidirectionalAStar());
+  } else if (algorithm_name == "timedep_forward") {
+    algorithm.reset(new TimeDepForward());
+  } else if (algorithm_name == "timedep_reverse") {
+    algorithm.reset(new TimeDepReverse());
+  } else {
+    LOG_ERROR("Unknown algorithm " + algorithm_name);
+    return EXIT_FAILURE;
+  }
+
+  // find the locations of the routes in the graph
+  loki::loki_worker_t loki_worker(config);
+  std::vector<Api> routes;
+  std::ifstream file(routes_file);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    Api request;
+    try {
+      ParseApi(line, Options::route, request);
+      loki_worker.route(request);
+    } catch (const std::exception& e) {
+      LOG_WARN("Skipping route " + line + ": " + e.what());
+      continue;
+    }
+    if (!routes.empty() && request.options().costing() != routes.front().options().costing()) {
+      LOG_ERROR("All routes must use the same costing");
+      return EXIT_FAILURE;
+    }
+    routes.emplace_back(std::move(request));
+  }
+  if (routes.empty()) {
+    LOG_ERROR("No routes in " + routes_file);
+    return EXIT_FAILURE;
+  }
+
+  CostFactory<DynamicCost> factory;
+  factory.RegisterStandardCostingModels();
+  auto costing = factory.Create(routes.front().options().costing(), routes.front().options());
+  auto mode = costing->travel_mode();
+  std::shared_ptr<DynamicCost> mode_costing[4];
+  mode_costing[static_cast<uint32_t>(mode)] = costing;
+  if (landmarks->get(costing->access_mode()) == nullptr) {
+    LOG_ERROR("No landmark table for the costing of the routes in " + landmarks_dir);
+    return EXIT_FAILURE;
+  }
+
+  // warm the tile cache so both runs read the same tiles from memory
+  GraphReader reader(config.get_child("mjolnir"));
+  Benchmark(*algorithm, reader, routes, mode_costing, mode);
+
+  auto plain = Benchmark(*algorithm, reader, routes, mode_costing, mode);
+  algorithm->set_landmarks(landmarks);
+  auto alt = Benchmark(*algorithm, reader, routes, mode_costing, mode);
+
+  size_t different = 0;
+  for (size_t i = 0; i < plain.costs.size(); ++i) {
+    different += std::abs(plain.costs[i] - alt.costs[i]) > 0.01f * std::abs(plain.costs[i]);
+  }
+
+  LOG_INFO(std::to_string(plain.routes) + " routes with " + algorithm_name);
+  LOG_INFO("straight line: " + std::to_string(plain.settled) + " edges settled in " +
+           std::to_string(plain.seconds) + " s");
+  LOG_INFO("landmarks: " + std::to_string(alt.settled) + " edges settled (" +
+           std::to_string(100.0 * (1.0 - static_cast<double>(alt.settled) /
+                                             std::max<uint64_t>(plain.settled, 1))) +
+           "% fewer) in " + std::to_string(alt.seconds) + " s (" +
+           std::to_string(plain.seconds / alt.seconds) + "x)");
+  LOG_INFO(std::to_string(different) + " routes with a cost more than 1% apart");
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <future>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <thread>
@@ -26,6 +27,7 @@ boost::filesystem::path config_file_path;
 size_t threads =
     std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
 size_t batch = 1;
+size_t search_threads = 1;
 bool extrema = false;
 size_t isolated = 0;
 size_t radius = 0;
@@ -97,6 +99,9 @@ bool ParseArguments(int argc, char* argv[]) {
       "threads,t", boost::program_options::value<size_t>(&threads),
       "Concurrency to use.")("batch,b", boost::program_options::value<size_t>(&batch),
                              "Number of locations to group together per search")(
+      "search-threads,s", boost::program_options::value<size_t>(&search_threads),
+      "Number of threads each search uses, each extra one with its own graph reader. Compare the "
+      "timings with 1 to see what searching a batch of locations concurrently does")(
       "extrema,e", boost::program_options::value<bool>(&extrema),
       "Show the input locations of the extrema for a given statistic")(
       "reach,i", boost::program_options::value<size_t>(&isolated),
@@ -149,16 +154,23 @@ bool ParseArguments(int argc, char* argv[]) {
 void work(const boost::property_tree::ptree& config, std::promise<results_t>& promise) {
   // lambda to do the current job
   valhalla::baldr::GraphReader reader(config.get_child("mjolnir"));
-  auto search = [&reader](const job_t& job) {
+  std::vector<std::shared_ptr<valhalla::baldr::GraphReader>> helper_readers;
+  for (size_t i = 1; i < search_threads; ++i) {
+    helper_readers.emplace_back(new valhalla::baldr::GraphReader(config.get_child("mjolnir")));
+  }
+  auto search = [&reader, &helper_readers](const job_t& job) {
     // so that we dont benefit from cache coherency
     reader.Clear();
+    for (auto& helper_reader : helper_readers) {
+      helper_reader->Clear();
+    }
     std::pair<result_t, result_t> result;
     bool cached = false;
     for (auto* r : {&result.first, &result.second}) {
       auto start = std::chrono::high_resolution_clock::now();
       try {
         // TODO: actually save the result
-        auto result = valhalla::loki::Search(job, reader);
+        auto result = valhalla::loki::Search(job, reader, nullptr, helper_readers);
         auto end = std::chrono::high_resolution_clock::now();
         (*r) = result_t{std::chrono::duration_cast<std::chrono::milliseconds>(end - start), true, job,
                         cached};
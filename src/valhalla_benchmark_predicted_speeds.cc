@@ -0,0 +1,159 @@
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "baldr/graphid.h"
+#include "baldr/predictedspeeds.h"
+#include "config.h"
+#include "midgard/constants.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// A lookup made by a search: a directed edge and the seconds of the week it is reached at
+struct Lookup {
+  uint32_t idx;
+  uint32_t seconds;
+};
+
+/**
+ * Runs the lookups through the given speed function.
+ * @return the number of lookups per second
+ */
+double Benchmark(const std::function<float(const Lookup&)>& speed,
+                 const std::vector<Lookup>& lookups,
+                 float& checksum) {
+  checksum = 0.0f;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto& lookup : lookups) {
+    checksum += speed(lookup);
+  }
+  auto elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return lookups.size() / elapsed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t edge_count, lookup_count;
+
+  bpo::options_description options(
+      "valhalla " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_predicted_speeds [options]\n"
+      "\n"
+      "valhalla_benchmark_predicted_speeds measures how fast predicted speeds are decoded. It "
+      "compares the plain DCT-III loop to the vectorized one this build uses and to the "
+      "vectorized one behind the decoded speed cache a search keeps. The lookups mimic a "
+      "search: nearby edges reached a few times each around the same time of the week."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "edges,e", boost::program_options::value<size_t>(&edge_count)->default_value(100000),
+      "Number of edges with a speed profile.")("lookups,l",
+                                               boost::program_options::value<size_t>(
+                                                   &lookup_count)
+                                                   ->default_value(10000000),
+                                               "Number of speed lookups.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_predicted_speeds " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  // random profiles for the edges, laid out the way they are in a tile
+  edge_count = std::max<size_t>(edge_count, 1);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int16_t> coefficient(-2000, 2000);
+  std::vector<int16_t> profiles(edge_count * kCoefficientCount);
+  for (auto& c : profiles) {
+    c = coefficient(gen);
+  }
+  std::vector<uint32_t> offsets(edge_count);
+  for (size_t i = 0; i < edge_count; ++i) {
+    offsets[i] = i * kCoefficientCount;
+  }
+  PredictedSpeeds speeds;
+  speeds.set_offset(offsets.data());
+  speeds.set_profiles(profiles.data());
+
+  // a search moves slowly through the edges and the time of the week, each
+  // edge is looked up a few times (from other edges or the other direction)
+  std::vector<Lookup> lookups;
+  lookups.reserve(lookup_count);
+  std::uniform_int_distribution<uint32_t> near(0, 63);
+  for (size_t i = 0; i < lookup_count; ++i) {
+    uint32_t idx = (i / 4 + near(gen)) % edge_count;
+    uint32_t seconds = (28800 + i / 100) % kSecondsPerWeek;
+    lookups.push_back({idx, seconds});
+  }
+
+  // touch the cos table so that building it is not measured
+  BucketCosTable::GetInstance();
+
+  float scalar_sum, vector_sum, cached_sum;
+  auto scalar = Benchmark(
+      [&](const Lookup& l) {
+        const float* b = BucketCosTable::GetInstance().get(l.seconds / kSpeedBucketSizeSeconds);
+        return decode_speed_scalar(profiles.data() + offsets[l.idx], b) * kSpeedNormalization;
+      },
+      lookups, scalar_sum);
+
+  auto vectorized = Benchmark([&](const Lookup& l) { return speeds.speed(l.idx, l.seconds); },
+                              lookups, vector_sum);
+
+  DecodedSpeedCache cache;
+  auto cached = Benchmark(
+      [&](const Lookup& l) {
+        GraphId edgeid(0, 0, l.idx);
+        uint32_t bucket = l.seconds / kSpeedBucketSizeSeconds;
+        float speed;
+        if (!cache.get(edgeid, bucket, speed)) {
+          speed = speeds.speed(l.idx, l.seconds);
+          cache.put(edgeid, bucket, speed);
+        }
+        return speed;
+      },
+      lookups, cached_sum);
+
+  LOG_INFO("scalar " + std::to_string(static_cast<uint64_t>(scalar)) + " lookups/s");
+  LOG_INFO("vectorized " + std::to_string(static_cast<uint64_t>(vectorized)) + " lookups/s (" +
+           std::to_string(vectorized / scalar) + "x)");
+  LOG_INFO("vectorized and cached " + std::to_string(static_cast<uint64_t>(cached)) +
+           " lookups/s (" + std::to_string(cached / scalar) + "x)");
+  LOG_INFO("checksums " + std::to_string(scalar_sum) + " " + std::to_string(vector_sum) + " " +
+           std::to_string(cached_sum));
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "config.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// Produces a tile cache for one benchmark thread
+using cache_maker_t = std::function<std::unique_ptr<TileCache>()>;
+
+/**
+ * Runs lookups of random (but cached) tiles from the given number of threads, each of
+ * which gets its own handle on the shared cache the same way a GraphReader would.
+ * @return the number of lookups per second across all threads
+ */
+double Benchmark(const cache_maker_t& make_cache,
+                 const std::vector<GraphId>& tiles,
+                 const size_t thread_count,
+                 const size_t lookups) {
+  std::vector<std::unique_ptr<TileCache>> caches;
+  for (size_t i = 0; i < thread_count; ++i) {
+    caches.emplace_back(make_cache());
+  }
+
+  // warm the cache up front so that we are only measuring hits
+  GraphTile tile;
+  for (const auto& id : tiles) {
+    caches.front()->Put(id, tile, 1);
+  }
+
+  std::vector<std::thread> threads;
+  std::vector<size_t> hits(thread_count, 0);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&caches, &tiles, &hits, i, lookups]() {
+      std::mt19937 gen(i);
+      std::uniform_int_distribution<size_t> dist(0, tiles.size() - 1);
+      const auto& cache = caches[i];
+      size_t found = 0;
+      for (size_t j = 0; j < lookups; ++j) {
+        found += cache->Get(tiles[dist(gen)]) != nullptr;
+      }
+      hits[i] = found;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  for (size_t i = 0; i < thread_count; ++i) {
+    if (hits[i] != lookups) {
+      LOG_ERROR("Thread " + std::to_string(i) + " missed " + std::to_string(lookups - hits[i]) +
+                " lookups");
+    }
+  }
+  return (thread_count * lookups) / elapsed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t max_threads, tile_count, lookups;
+
+  bpo::options_description options(
+      "valhalla " VALHALLA_VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_tile_cache [options]\n"
+      "\n"
+      "valhalla_benchmark_tile_cache measures the hit throughput of the tile cache shared "
+      "between threads (mjolnir.global_synchronized_cache) as the number of threads grows. It "
+      "compares a mutex synchronized cache to the sharded lock free one."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "threads,t",
+      boost::program_options::value<size_t>(&max_threads)
+          ->default_value(std::thread::hardware_concurrency()),
+      "Maximum number of threads to benchmark with, doubles from 1 up to this.")(
+      "tiles", boost::program_options::value<size_t>(&tile_count)->default_value(4096),
+      "Number of tiles in the cache.")("lookups,l",
+                                       boost::program_options::value<size_t>(&lookups)
+                                           ->default_value(1000000),
+                                       "Number of lookups per thread.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_tile_cache " << VALHALLA_VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  // some tile ids spread over all the levels
+  std::vector<GraphId> tiles;
+  for (size_t i = 0; i < tile_count; ++i) {
+    tiles.emplace_back(static_cast<uint32_t>(i / 3), static_cast<uint32_t>(i % 3), 0);
+  }
+  max_threads = std::max<size_t>(max_threads, 1);
+
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    // a fresh pair of caches per run so one run can't warm up the other
+    std::mutex mutex;
+    SimpleTileCache simple(tiles.size());
+    auto synchronized = Benchmark(
+        [&simple, &mutex]() { return std::make_unique<SynchronizedTileCache>(simple, mutex); },
+        tiles, threads, lookups);
+
+    auto sharded_cache = std::make_shared<ShardedTileCache>(tiles.size(),
+                                                            ShardedTileCache::MemoryLimitControl::SOFT);
+    auto sharded = Benchmark(
+        [&sharded_cache]() { return std::make_unique<ShardedTileCacheReader>(sharded_cache); },
+        tiles, threads, lookups);
+
+    LOG_INFO(std::to_string(threads) + " thread(s): synchronized " +
+             std::to_string(static_cast<uint64_t>(synchronized)) + " hits/s, sharded " +
+             std::to_string(static_cast<uint64_t>(sharded)) + " hits/s (" +
+             std::to_string(sharded / synchronized) + "x)");
+  }
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
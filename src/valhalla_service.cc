@@ -21,6 +21,7 @@ using namespace prime_server;
 #include "loki/worker.h"
 #include "odin/worker.h"
 #include "thor/worker.h"
+#include "tyr/actor.h"
 
 int main(int argc, char** argv) {
 
@@ -42,6 +43,7 @@ int main(int argc, char** argv) {
   std::string loki_proxy = config.get<std::string>("loki.service.proxy");
   std::string thor_proxy = config.get<std::string>("thor.service.proxy");
   std::string odin_proxy = config.get<std::string>("odin.service.proxy");
+  bool pipeline = config.get<bool>("httpd.service.pipeline", false);
   // TODO: add multipoint accumulator worker
 
   // check the server endpoint
@@ -76,34 +78,47 @@ int main(int argc, char** argv) {
       std::thread(std::bind(&http_server_t::serve, http_server_t(context, listen, loki_proxy + "_in",
                                                                  loopback, interrupt, true)));
 
-  // loki layer
-  std::thread loki_proxy_thread(
-      std::bind(&proxy_t::forward, proxy_t(context, loki_proxy + "_in", loki_proxy + "_out")));
-  loki_proxy_thread.detach();
-  std::list<std::thread> loki_worker_threads;
-  for (size_t i = 0; i < worker_concurrency; ++i) {
-    loki_worker_threads.emplace_back(valhalla::loki::run_service, config);
-    loki_worker_threads.back().detach();
-  }
+  // each worker takes requests through all of the stages itself, so the loki proxy is the only
+  // one we need
+  if (pipeline) {
+    std::thread loki_proxy_thread(
+        std::bind(&proxy_t::forward, proxy_t(context, loki_proxy + "_in", loki_proxy + "_out")));
+    loki_proxy_thread.detach();
+    std::list<std::thread> pipeline_worker_threads;
+    for (size_t i = 0; i < worker_concurrency; ++i) {
+      pipeline_worker_threads.emplace_back(valhalla::tyr::run_service, config);
+      pipeline_worker_threads.back().detach();
+    }
+  } else {
+    // loki layer
+    std::thread loki_proxy_thread(
+        std::bind(&proxy_t::forward, proxy_t(context, loki_proxy + "_in", loki_proxy + "_out")));
+    loki_proxy_thread.detach();
+    std::list<std::thread> loki_worker_threads;
+    for (size_t i = 0; i < worker_concurrency; ++i) {
+      loki_worker_threads.emplace_back(valhalla::loki::run_service, config);
+      loki_worker_threads.back().detach();
+    }
 
-  // thor layer
-  std::thread thor_proxy_thread(
-      std::bind(&proxy_t::forward, proxy_t(context, thor_proxy + "_in", thor_proxy + "_out")));
-  thor_proxy_thread.detach();
-  std::list<std::thread> thor_worker_threads;
-  for (size_t i = 0; i < worker_concurrency; ++i) {
-    thor_worker_threads.emplace_back(valhalla::thor::run_service, config);
-    thor_worker_threads.back().detach();
-  }
+    // thor layer
+    std::thread thor_proxy_thread(
+        std::bind(&proxy_t::forward, proxy_t(context, thor_proxy + "_in", thor_proxy + "_out")));
+    thor_proxy_thread.detach();
+    std::list<std::thread> thor_worker_threads;
+    for (size_t i = 0; i < worker_concurrency; ++i) {
+      thor_worker_threads.emplace_back(valhalla::thor::run_service, config);
+      thor_worker_threads.back().detach();
+    }
 
-  // odin layer
-  std::thread odin_proxy_thread(
-      std::bind(&proxy_t::forward, proxy_t(context, odin_proxy + "_in", odin_proxy + "_out")));
-  odin_proxy_thread.detach();
-  std::list<std::thread> odin_worker_threads;
-  for (size_t i = 0; i < worker_concurrency; ++i) {
-    odin_worker_threads.emplace_back(valhalla::odin::run_service, config);
-    odin_worker_threads.back().detach();
+    // odin layer
+    std::thread odin_proxy_thread(
+        std::bind(&proxy_t::forward, proxy_t(context, odin_proxy + "_in", odin_proxy + "_out")));
+    odin_proxy_thread.detach();
+    std::list<std::thread> odin_worker_threads;
+    for (size_t i = 0; i < worker_concurrency; ++i) {
+      odin_worker_threads.emplace_back(valhalla::odin::run_service, config);
+      odin_worker_threads.back().detach();
+    }
   }
 
   // TODO: add multipoint accumulator
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "baldr/rapidjson_utils.h"
 #include <boost/property_tree/ptree.hpp>
@@ -122,6 +126,56 @@ TEST_F(ActorInterrupt, TraceAttributes) {
                test_exception_t);
 }
 
+TEST(Actor, TraceAttributesBatch) {
+  auto conf = make_conf();
+  std::vector<std::string> requests{
+      R"({"shape":[{"lat":40.546115,"lon":-76.385076},
+          {"lat":40.544232,"lon":-76.385752}],"costing":"auto","shape_match":"map_snap"})",
+      R"({"shape":[{"lat":40.544232,"lon":-76.385752},
+          {"lat":40.546115,"lon":-76.385076}],"costing":"auto","shape_match":"map_snap"})",
+      R"({"shape":[{"lat":40.546115,"lon":-76.385076}],"costing":"auto","shape_match":"map_snap"})",
+      R"({"shape":[{"lat":40.546115,"lon":-76.385076},
+          {"lat":40.544232,"lon":-76.385752}],"costing":"auto","shape_match":"walk_or_snap"})",
+  };
+  // one request per line
+  for (auto& request : requests) {
+    request.erase(std::remove(request.begin(), request.end(), '\n'), request.end());
+  }
+
+  // the same answers one at a time
+  tyr::actor_t actor(conf, true);
+  std::vector<std::string> expected;
+  for (const auto& request : requests) {
+    try {
+      expected.push_back(actor.trace_attributes(request));
+    } catch (const std::exception& e) {
+      expected.push_back(e.what());
+    }
+  }
+
+  // several copies of them in one stream with some blank lines mixed in
+  std::stringstream input;
+  for (size_t i = 0; i < 25; ++i) {
+    input << requests[i % requests.size()] << "\n" << (i % 7 == 0 ? "\n" : "");
+  }
+  std::stringstream output;
+  EXPECT_EQ(tyr::trace_attributes_batch(conf, input, output, 3), 25);
+
+  std::string line;
+  size_t i = 0;
+  for (; std::getline(output, line); ++i) {
+    const auto& answer = expected[i % requests.size()];
+    if (i % requests.size() == 2) {
+      // a single point is not a trace
+      EXPECT_NE(line.find("error_code"), std::string::npos) << line;
+      EXPECT_NE(line.find(answer), std::string::npos) << line;
+    } else {
+      EXPECT_EQ(line, answer);
+    }
+  }
+  EXPECT_EQ(i, 25);
+}
+
 // TODO: test the rest of them
 
 } // namespace
@@ -0,0 +1,143 @@
+#include "test.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "baldr/rapidjson_utils.h"
+#include "midgard/logging.h"
+#include "tyr/actor.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <prime_server/http_protocol.hpp>
+#include <prime_server/prime_server.hpp>
+
+using namespace prime_server;
+using namespace valhalla;
+using namespace valhalla::midgard;
+
+namespace {
+
+// What the actor logged with a custom directive, like the [ANALYTICS] lines
+std::mutex logged_lock;
+std::vector<std::string> logged;
+
+class capture_logger_t : public logging::Logger {
+public:
+  capture_logger_t(const logging::LoggingConfig& config) : logging::Logger(config) {
+  }
+  virtual void Log(const std::string& message, const logging::LogLevel) override {
+    Log(message, std::string(" [LEVEL] "));
+  }
+  virtual void Log(const std::string& message, const std::string& custom_directive) override {
+    std::lock_guard<std::mutex> guard(logged_lock);
+    logged.push_back(custom_directive + message);
+  }
+};
+
+bool capture_logger_registered =
+    logging::RegisterLogger("capture", [](const logging::LoggingConfig& config) {
+      logging::Logger* logger = new capture_logger_t(config);
+      return logger;
+    });
+
+bool was_logged(const std::string& message) {
+  std::lock_guard<std::mutex> guard(logged_lock);
+  return std::any_of(logged.begin(), logged.end(), [&message](const std::string& line) {
+    return line.find(message) != std::string::npos;
+  });
+}
+
+boost::property_tree::ptree make_conf(const float long_request) {
+  std::stringstream ss;
+  ss << R"({
+    "mjolnir":{"tile_dir":"test/data/utrecht_tiles", "concurrency": 1},
+    "loki":{
+      "actions":["route","sources_to_targets"],
+      "logging":{"long_request": )"
+     << long_request << R"(},
+      "service_defaults":{"minimum_reachability": 50,"radius": 0,"search_cutoff": 35000, "node_snap_tolerance": 5, "street_side_tolerance": 5, "heading_tolerance": 60}
+    },
+    "thor":{"logging":{"long_request": )"
+     << long_request << R"(}},
+    "odin":{"logging":{"long_request": )"
+     << long_request << R"(}},
+    "skadi":{"actons":["height"],"logging":{"long_request": 5}},
+    "meili":{"customizable": ["turn_penalty_factor","max_route_distance_factor","max_route_time_factor","search_radius"],
+             "mode":"auto","grid":{"cache_size":100240,"size":500},
+             "default":{"beta":3,"breakage_distance":2000,"geometry":false,"gps_accuracy":5.0,"interpolation_distance":10,
+             "max_route_distance_factor":5,"max_route_time_factor":5,"max_search_radius":200,"route":true,
+             "search_radius":15.0,"sigma_z":4.07,"turn_penalty_factor":200}},
+    "service_limits": {
+      "auto": {"max_distance": 5000000.0, "max_locations": 20,"max_matrix_distance": 400000.0,"max_matrix_locations": 50},
+      "isochrone": {"max_contours": 4,"max_distance": 25000.0,"max_locations": 1,"max_time": 120},
+      "max_avoid_locations": 50,"max_radius": 200,"max_reachability": 100,"max_alternates":2,
+      "skadi": {"max_shape": 750000,"min_resample": 10.0},
+      "trace": {"max_distance": 200000.0,"max_gps_accuracy": 100.0,"max_search_radius": 100,"max_shape": 16000,"max_best_paths":4,"max_best_paths_shape":100}
+    }
+  })";
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(ss, pt);
+  return pt;
+}
+
+// Run a request through every stage of the actor like valhalla_service does in pipeline mode
+std::string work(tyr::actor_t& actor, const std::string& path) {
+  auto request = http_request_t(GET, path).to_string();
+  std::list<zmq::message_t> messages;
+  messages.emplace_back(
+      zmq::message_t(static_cast<void*>(&request[0]), request.size(), [](void*, void*) {}));
+  http_request_info_t request_info{};
+  auto result = actor.work(messages, &request_info, []() {});
+  EXPECT_FALSE(result.intermediate) << "The pipeline answers every request itself";
+  actor.cleanup();
+  return result.messages.front();
+}
+
+const std::string route =
+    R"(/route?json={"locations":[{"lat":52.09015,"lon":5.06362},{"lat":52.111276,"lon":5.089717}],"costing":"auto"})";
+const std::string matrix =
+    R"(/sources_to_targets?json={"sources":[{"lat":52.09015,"lon":5.06362}],"targets":[{"lat":52.111276,"lon":5.089717}],"costing":"auto"})";
+
+TEST(ActorService, test_pipeline) {
+  logging::Configure({{"type", "capture"}});
+  tyr::actor_t actor(make_conf(100000.0f));
+
+  // the stages pass the request along and the last one answers
+  auto response = work(actor, route);
+  EXPECT_NE(response.find("200 OK"), std::string::npos) << response;
+  EXPECT_NE(response.find("\"trip\""), std::string::npos) << response;
+  response = work(actor, matrix);
+  EXPECT_NE(response.find("200 OK"), std::string::npos) << response;
+  EXPECT_NE(response.find("\"sources_to_targets\""), std::string::npos) << response;
+
+  // failures come back as errors of the stage they happened in
+  response = work(actor, R"(/route?json={"locations":[{"lat":52.09015,"lon":5.06362}]})");
+  EXPECT_NE(response.find("400"), std::string::npos) << response;
+
+  // nothing took long enough to be logged
+  EXPECT_FALSE(was_logged("valhalla_loki_long_request"));
+  EXPECT_FALSE(was_logged("valhalla_thor_long_request"));
+}
+
+TEST(ActorService, test_pipeline_long_requests) {
+  logging::Configure({{"type", "capture"}});
+  tyr::actor_t actor(make_conf(0.0f));
+
+  // every stage logs its long requests the way its own worker would
+  work(actor, route);
+  EXPECT_TRUE(was_logged("valhalla_loki_long_request"));
+  EXPECT_TRUE(was_logged("valhalla_thor_long_request_route"));
+  work(actor, matrix);
+  EXPECT_TRUE(was_logged("valhalla_thor_long_request_sources_to_targets"));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+#include "mjolnir/admin.h"
+
+#include <cmath>
+#include <random>
+
+#include "test.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+multi_polygon_type from_wkt(const std::string& wkt) {
+  multi_polygon_type multi_poly;
+  boost::geometry::read_wkt(wkt, multi_poly);
+  return multi_poly;
+}
+
+// a few overlapping polygons around the tile [0, 0.25] x [0, 0.25], like the timezones of a tile
+std::unordered_multimap<uint32_t, multi_polygon_type> polys() {
+  return {
+      // a big one
+      {1, from_wkt("MULTIPOLYGON(((-10 -10,-10 10,10 10,10 -10,-10 -10)))")},
+      // a concave one crossing the tile
+      {2, from_wkt("MULTIPOLYGON(((0.1 -1,0.1 0.2,-1 0.2,-1 0.3,0.2 0.3,0.2 -1,0.1 -1)))")},
+      // one in two pieces, one inside of the tile and one far away
+      {3, from_wkt("MULTIPOLYGON(((0.01 0.01,0.01 0.05,0.05 0.05,0.05 0.01,0.01 0.01)),"
+                   "((5 5,5 6,6 6,6 5,5 5)))")},
+      // and one outside of the tile
+      {4, from_wkt("MULTIPOLYGON(((1 1,1 2,2 2,2 1,1 1)))")},
+  };
+}
+
+TEST(MultiPolyIndex, SameAsScanning) {
+  auto tile_polys = polys();
+  AABB2<PointLL> tile(0, 0, 0.25, 0.25);
+  MultiPolyIndex index(tile_polys, tile);
+  EXPECT_EQ(index.size(), tile_polys.size());
+
+  // points in the tile, on its edges and well outside of it all have to find the same polygon
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> coord(-0.5, 1.5);
+  std::vector<PointLL> points{{0, 0},        {0.25, 0.25}, {0.1, 0.1},  {0.15, 0.25},
+                              {0.03, 0.03},  {0.01, 0.01}, {0.1, -0.5}, {1.5, 1.5},
+                              {5.5, 5.5},    {20, 20},     {0.25, 0},   {0.15, 0.2}};
+  for (int i = 0; i < 1000; ++i) {
+    points.emplace_back(coord(gen), coord(gen));
+  }
+  for (const auto& point : points) {
+    EXPECT_EQ(GetMultiPolyId(index, point), GetMultiPolyId(tile_polys, point))
+        << point.lng() << "," << point.lat();
+  }
+}
+
+TEST(MultiPolyIndex, Covering) {
+  std::unordered_multimap<uint32_t, multi_polygon_type> tile_polys{
+      {7, from_wkt("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)))")},
+  };
+  MultiPolyIndex index(tile_polys, AABB2<PointLL>(0, 0, 0.25, 0.25));
+  EXPECT_EQ(index.Covering({0.1, 0.1}), std::vector<uint32_t>{7});
+  // outside of the clipped part but still in the polygon
+  EXPECT_EQ(index.Covering({0.9, 0.9}), std::vector<uint32_t>{7});
+  EXPECT_TRUE(index.Covering({2, 2}).empty());
+  EXPECT_EQ(GetMultiPolyId(index, {2, 2}), 0);
+
+  // nothing to find in an empty index
+  MultiPolyIndex empty;
+  EXPECT_EQ(empty.size(), 0);
+  EXPECT_EQ(GetMultiPolyId(empty, {0.1, 0.1}), 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -2,6 +2,8 @@
 #include "thor/attributes_controller.h"
 #include "config.h"
 
+#include <stdexcept>
+
 #include "test.h"
 
 using namespace std;
@@ -9,14 +11,20 @@ using namespace valhalla::thor;
 
 namespace {
 
+void TryDefaultAttributes(const AttributesController& controller) {
+  for (const auto& pair : AttributesController::kDefaultAttributes) {
+    EXPECT_EQ(controller(pair.first), pair.second) << ("Incorrect default value for " + pair.first);
+  }
+}
+
 TEST(AttrController, TestCtorDefautAttributes) {
   AttributesController controller;
-  EXPECT_EQ(controller.attributes, AttributesController::kDefaultAttributes);
+  TryDefaultAttributes(controller);
 }
 
 void TryArgCtor(size_t expected_size) {
   AttributesController controller;
-  EXPECT_EQ(controller.attributes, AttributesController::kDefaultAttributes);
+  TryDefaultAttributes(controller);
   EXPECT_EQ(controller.attributes.size(), expected_size);
 }
 
@@ -27,9 +35,9 @@ TEST(AttrController, TestArgCtor) {
 void TryDisableAll() {
   AttributesController controller;
   controller.disable_all();
-  for (auto& pair : controller.attributes) {
-    // If any pair value is true then throw error
-    EXPECT_FALSE(pair.second) << ("Incorrect disable_all value for " + pair.first);
+  for (auto& pair : AttributesController::kDefaultAttributes) {
+    // If any attribute is still enabled then throw error
+    EXPECT_FALSE(controller(pair.first)) << ("Incorrect disable_all value for " + pair.first);
   }
 }
 
@@ -55,15 +63,15 @@ TEST(AttrController, TestNodeAttributeEnabled) {
   TryCategoryAttributeEnabled(controller, kNodeCategory, false);
 
   // Test one node enabled
-  controller.attributes.at(kNodeType) = true;
+  controller.set(kNodeType, true);
   TryCategoryAttributeEnabled(controller, kNodeCategory, true);
 
   // Test some node enabled
-  controller.attributes.at(kNodeType) = false;
-  controller.attributes.at(kNodeIntersectingEdgeBeginHeading) = true;
-  controller.attributes.at(kNodeTransitPlatformInfoType) = true;
-  controller.attributes.at(kNodeElapsedTime) = true;
-  controller.attributes.at(kNodeFork) = true;
+  controller.set(kNodeType, false);
+  controller.set(kNodeIntersectingEdgeBeginHeading, true);
+  controller.set(kNodeTransitPlatformInfoType, true);
+  controller.set(kNodeElapsedTime, true);
+  controller.set(kNodeFork, true);
   TryCategoryAttributeEnabled(controller, kNodeCategory, true);
 }
 
@@ -78,17 +86,34 @@ TEST(AttrController, TestAdminAttributeEnabled) {
   TryCategoryAttributeEnabled(controller, kAdminCategory, false);
 
   // Test one admin enabled
-  controller.attributes.at(kAdminCountryCode) = true;
+  controller.set(kAdminCountryCode, true);
   TryCategoryAttributeEnabled(controller, kAdminCategory, true);
 
   // Test some admin enabled
-  controller.attributes.at(kAdminCountryCode) = false;
-  controller.attributes.at(kAdminCountryText) = true;
-  controller.attributes.at(kAdminStateCode) = false;
-  controller.attributes.at(kAdminStateText) = true;
+  controller.set(kAdminCountryCode, false);
+  controller.set(kAdminCountryText, true);
+  controller.set(kAdminStateCode, false);
+  controller.set(kAdminStateText, true);
   TryCategoryAttributeEnabled(controller, kAdminCategory, true);
 }
 
+TEST(AttrController, TestSetByName) {
+  AttributesController controller;
+  controller.disable_all();
+
+  // names from requests and keys get to the same attribute
+  EXPECT_TRUE(controller.set("edge.names", true));
+  EXPECT_TRUE(controller(kEdgeNames));
+  EXPECT_TRUE(controller("edge.names"));
+  controller.set(kEdgeNames, false);
+  EXPECT_FALSE(controller("edge.names"));
+
+  // unknown names are left alone
+  EXPECT_FALSE(controller.set("edge.not_an_attribute", true));
+  EXPECT_FALSE(controller.attributes.any());
+  EXPECT_THROW(controller("edge.not_an_attribute"), std::out_of_range);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
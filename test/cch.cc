@@ -0,0 +1,300 @@
+#include "test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baldr/cchoverlay.h"
+#include "baldr/rapidjson_utils.h"
+#include "loki/worker.h"
+#include "mjolnir/cchbuilder.h"
+#include "sif/autocost.h"
+#include "thor/bidirectional_astar.h"
+#include "thor/cch.h"
+#include "tyr/actor.h"
+#include "worker.h"
+#include <boost/property_tree/ptree.hpp>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+boost::property_tree::ptree json_to_pt(const std::string& json) {
+  std::stringstream ss;
+  ss << json;
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(ss, pt);
+  return pt;
+}
+
+const std::string kOverlay = "test/data/utrecht_tiles/overlay.cch";
+
+boost::property_tree::ptree make_conf(const bool cch,
+                                      const float max_turn_cost_ratio = 0.1f,
+                                      const bool background = false) {
+  return json_to_pt(R"({
+    "mjolnir":{"tile_dir":"test/data/utrecht_tiles", "concurrency": 1,
+               "cch":{"build": true, "file": ")" +
+                    kOverlay + R"("}},
+    "loki":{
+      "actions":["route"],
+      "logging":{"long_request": 100},
+      "service_defaults":{"minimum_reachability": 50,"radius": 0,"search_cutoff": 35000, "node_snap_tolerance": 5, "street_side_tolerance": 5, "heading_tolerance": 60}
+    },
+    "thor":{"logging":{"long_request": 110}, "cch": )" +
+                    std::string(cch ? "true" : "false") + R"(, "cch_max_turn_cost_ratio": )" +
+                    std::to_string(max_turn_cost_ratio) + R"(, "cch_customize_in_background": )" +
+                    std::string(background ? "true" : "false") + R"(},
+    "odin":{"logging":{"long_request": 110}},
+    "skadi":{"actons":["height"],"logging":{"long_request": 5}},
+    "meili":{"customizable": ["turn_penalty_factor","max_route_distance_factor","max_route_time_factor","search_radius"],
+             "mode":"auto","grid":{"cache_size":100240,"size":500},
+             "default":{"beta":3,"breakage_distance":2000,"geometry":false,"gps_accuracy":5.0,"interpolation_distance":10,
+             "max_route_distance_factor":5,"max_route_time_factor":5,"max_search_radius":200,"route":true,
+             "search_radius":15.0,"sigma_z":4.07,"turn_penalty_factor":200}},
+    "service_limits": {
+      "auto": {"max_distance": 5000000.0, "max_locations": 20,"max_matrix_distance": 400000.0,"max_matrix_locations": 50},
+      "isochrone": {"max_contours": 4,"max_distance": 25000.0,"max_locations": 1,"max_time": 120},
+      "max_avoid_locations": 50,"max_radius": 200,"max_reachability": 100,"max_alternates":2,
+      "skadi": {"max_shape": 750000,"min_resample": 10.0},
+      "trace": {"max_distance": 200000.0,"max_gps_accuracy": 100.0,"max_search_radius": 100,"max_shape": 16000,"max_best_paths":4,"max_best_paths_shape":100}
+    }
+  })");
+}
+
+TEST(CCH, Overlay) {
+  // a triangle a-b-c where contracting a needs no shortcut and a lone node d
+  const std::string file_name = "triangle.cch";
+  std::vector<CCHTile> tiles = {{GraphId(1, 2, 0).tile_value(), 0, 4, 0}};
+  std::vector<uint32_t> vertices = {0, 1, 2, CCHOverlay::kNoVertex};
+  std::vector<uint32_t> first_arcs = {0, 2, 3, 3};
+  std::vector<uint32_t> heads = {1, 2, 2};
+  std::vector<uint32_t> first_edges = {0, 2, 3, 4};
+  std::vector<CCHEdge> edges(4);
+  edges[0].edgeid = GraphId(1, 2, 0).value;
+  edges[1].edgeid = GraphId(1, 2, 5).value;
+  edges[1].down = true;
+  edges[2].edgeid = GraphId(1, 2, 1).value;
+  edges[3].edgeid = GraphId(1, 2, 3).value;
+  CCHOverlay::Write(file_name, kAutoAccess, tiles, vertices, first_arcs, heads, first_edges, edges);
+
+  CCHOverlay overlay(file_name);
+  EXPECT_EQ(overlay.access(), kAutoAccess);
+  EXPECT_EQ(overlay.vertex_count(), 3);
+  EXPECT_EQ(overlay.arc_count(), 3);
+  EXPECT_EQ(overlay.edge_count(), 4);
+  EXPECT_EQ(overlay.vertex(GraphId(1, 2, 2)), 2);
+  EXPECT_EQ(overlay.vertex(GraphId(1, 2, 3)), CCHOverlay::kNoVertex);
+  EXPECT_EQ(overlay.vertex(GraphId(1, 2, 4)), CCHOverlay::kNoVertex);
+  EXPECT_EQ(overlay.vertex(GraphId(2, 2, 0)), CCHOverlay::kNoVertex);
+  EXPECT_EQ(overlay.parent(0), 1);
+  EXPECT_EQ(overlay.parent(2), CCHOverlay::kNoVertex);
+  EXPECT_EQ(overlay.arc(0, 2), 1);
+  EXPECT_EQ(overlay.arc(1, 0), CCHOverlay::kNoArc);
+  EXPECT_EQ(overlay.last_edge(0) - overlay.first_edge(0), 2);
+  EXPECT_TRUE(overlay.edge(overlay.first_edge(0) + 1).down);
+  EXPECT_EQ(GraphId(overlay.edge(overlay.first_edge(2)).edgeid), GraphId(1, 2, 3));
+  std::remove(file_name.c_str());
+}
+
+TEST(CCH, Build) {
+  CCHBuilder::Build(make_conf(false));
+  CCHOverlay overlay(kOverlay);
+  ASSERT_GT(overlay.vertex_count(), 0);
+
+  // arcs go up, sorted, and the higher neighbors of a vertex are connected to each other
+  size_t edges = 0;
+  for (uint32_t v = 0; v < overlay.vertex_count(); ++v) {
+    for (uint32_t a = overlay.first_arc(v); a < overlay.last_arc(v); ++a) {
+      ASSERT_GT(overlay.head(a), v);
+      if (a > overlay.first_arc(v)) {
+        ASSERT_GT(overlay.head(a), overlay.head(a - 1));
+      }
+      for (uint32_t b = a + 1; b < overlay.last_arc(v); ++b) {
+        ASSERT_NE(overlay.arc(overlay.head(a), overlay.head(b)), CCHOverlay::kNoArc);
+      }
+      edges += overlay.last_edge(a) - overlay.first_edge(a);
+    }
+  }
+  EXPECT_EQ(edges, overlay.edge_count());
+}
+
+const std::vector<std::string> requests = {
+    R"({"locations":[{"lat":52.09015,"lon":5.06362},{"lat":52.111276,"lon":5.089717}],"costing":"auto"})",
+    R"({"locations":[{"lat":52.048267,"lon":5.074825},{"lat":52.106126,"lon":5.101497}],"costing":"auto"})",
+    R"({"locations":[{"lat":52.103948,"lon":5.06813},{"lat":52.072534,"lon":5.125980}],"costing":"auto"})",
+    R"({"locations":[{"lat":52.094273,"lon":5.075254},{"lat":52.078937,"lon":5.115321}],"costing":"auto"})",
+};
+
+void compare_routes(tyr::actor_t& astar, tyr::actor_t& cch, const float tolerance) {
+  for (const auto& request : requests) {
+    auto expected = json_to_pt(astar.route(request));
+    auto actual = json_to_pt(cch.route(request));
+    float expected_time = expected.get<float>("trip.summary.time");
+    float actual_time = actual.get<float>("trip.summary.time");
+    EXPECT_LE(actual_time, expected_time * (1.0f + tolerance)) << request;
+    EXPECT_GT(actual_time, expected_time * 0.8f) << request;
+    astar.cleanup();
+    cch.cleanup();
+  }
+}
+
+TEST(CCH, Routes) {
+  // without any turn cost allowed the overlay isn't used at all
+  tyr::actor_t astar(make_conf(false), true);
+  tyr::actor_t cch_off(make_conf(true, 0.0f), true);
+  compare_routes(astar, cch_off, 0.0f);
+
+  // paths with turn costs are at most that much worse than the best path
+  tyr::actor_t cch(make_conf(true), true);
+  compare_routes(astar, cch, 0.1f);
+}
+
+// The paths of both algorithms between the locations of a request, with the edge scores left out
+// so their costs are only those of the path
+std::pair<std::vector<thor::PathInfo>, std::vector<thor::PathInfo>>
+get_paths(loki::loki_worker_t& loki_worker,
+          baldr::GraphReader& reader,
+          thor::CCHQuery& cch,
+          const std::string& json) {
+  Api request;
+  ParseApi(json, Options::route, request);
+  loki_worker.route(request);
+  for (auto& location : *request.mutable_options()->mutable_locations()) {
+    for (auto& edge : *location.mutable_path_edges()) {
+      edge.set_distance(0);
+    }
+  }
+  const auto mode = sif::TravelMode::kDrive;
+  std::shared_ptr<sif::DynamicCost> mode_costing[4];
+  mode_costing[static_cast<uint32_t>(mode)] =
+      sif::CreateAutoCost(request.options().costing(), request.options());
+
+  auto origin = request.options().locations(0);
+  auto destination = request.options().locations(1);
+  thor::BidirectionalAStar astar;
+  auto best = astar.GetBestPath(origin, destination, reader, mode_costing, mode).front();
+  origin = request.options().locations(0);
+  destination = request.options().locations(1);
+  auto paths = cch.GetBestPath(origin, destination, reader, mode_costing, mode, request.options());
+  cch.Clear();
+  return {best, paths.empty() ? std::vector<thor::PathInfo>{} : paths.front()};
+}
+
+TEST(CCH, TurnCostBound) {
+  auto conf = make_conf(true);
+  loki::loki_worker_t loki_worker(conf);
+  baldr::GraphReader reader(conf.get_child("mjolnir"));
+  std::shared_ptr<const CCHOverlay> overlay(new CCHOverlay(kOverlay));
+
+  // with the default ratio the overlay answers and its paths stay within the bound
+  const float ratio = 0.1f;
+  thor::CCHQuery cch(4, 0.0f, ratio);
+  cch.set_overlay(overlay);
+  size_t answered = 0;
+  for (const auto& request : requests) {
+    auto paths = get_paths(loki_worker, reader, cch, request);
+    ASSERT_FALSE(paths.first.empty()) << request;
+    if (paths.second.empty()) {
+      continue;
+    }
+    ++answered;
+    EXPECT_LE(paths.second.back().elapsed_cost,
+              paths.first.back().elapsed_cost * (1.0f + ratio) + 0.01f)
+        << request;
+  }
+  EXPECT_GT(answered, 0u);
+
+  // with no turn cost allowed it answers nothing
+  thor::CCHQuery cch_off(4, 0.0f, 0.0f);
+  cch_off.set_overlay(overlay);
+  for (const auto& request : requests) {
+    EXPECT_TRUE(get_paths(loki_worker, reader, cch_off, request).second.empty()) << request;
+  }
+}
+
+TEST(CCH, Customizer) {
+  auto conf = make_conf(true);
+  std::shared_ptr<const CCHOverlay> overlay(new CCHOverlay(kOverlay));
+  Api request;
+  ParseApi(requests.front(), Options::route, request);
+  const auto& options = request.options();
+
+  {
+    // one customization at a time is queued, asking for the same one again joins it
+    thor::CCHCustomizer customizer(overlay, conf.get_child("mjolnir"), 1);
+    auto metric = customizer.Customize("a", options);
+    ASSERT_TRUE(metric.valid());
+    auto again = customizer.Customize("a", options);
+    EXPECT_FALSE(customizer.Customize("b", options).valid());
+    ASSERT_NE(metric.get(), nullptr);
+    EXPECT_EQ(again.valid() ? again.get() : metric.get(), metric.get());
+
+    // once it is done there is room for another
+    EXPECT_TRUE(customizer.Customize("b", options).valid());
+  }
+
+  // the queued customizations are given up when the customizer goes away
+  std::vector<thor::CCHCustomizer::metric_future_t> metrics;
+  {
+    thor::CCHCustomizer customizer(overlay, conf.get_child("mjolnir"), 3);
+    for (const auto* key : {"a", "b", "c"}) {
+      metrics.push_back(customizer.Customize(key, options));
+    }
+  }
+  for (auto& metric : metrics) {
+    ASSERT_TRUE(metric.valid());
+    EXPECT_EQ(metric.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  }
+  EXPECT_EQ(metrics.back().get(), nullptr);
+
+  // workers routing on the same overlay file share their customizer
+  auto shared = thor::CCHCustomizer::get(overlay, conf.get_child("mjolnir"), 4);
+  EXPECT_EQ(thor::CCHCustomizer::get(overlay, conf.get_child("mjolnir"), 4), shared);
+}
+
+TEST(CCH, SameEdge) {
+  tyr::actor_t astar(make_conf(false), true);
+  tyr::actor_t cch(make_conf(true, 1.0f), true);
+
+  // both ends on the same edge are left to bidirectional A*, with a u-turn or without
+  for (const auto& request : std::vector<std::string>{
+           R"({"locations":[{"lat":52.09015,"lon":5.06362},{"lat":52.09020,"lon":5.06375}],"costing":"auto"})",
+           R"({"locations":[{"lat":52.09020,"lon":5.06375},{"lat":52.09015,"lon":5.06362}],"costing":"auto"})",
+       }) {
+    auto expected = json_to_pt(astar.route(request));
+    auto actual = json_to_pt(cch.route(request));
+    EXPECT_EQ(actual.get<float>("trip.summary.time"), expected.get<float>("trip.summary.time"))
+        << request;
+    EXPECT_EQ(actual.get<float>("trip.summary.length"), expected.get<float>("trip.summary.length"))
+        << request;
+    astar.cleanup();
+    cch.cleanup();
+  }
+}
+
+TEST(CCH, Background) {
+  tyr::actor_t astar(make_conf(false), true);
+  tyr::actor_t cch(make_conf(true, 0.1f, true), true);
+
+  // routes use bidirectional A* until the metric is customized and the overlay after
+  const auto& request = requests.front();
+  auto expected = json_to_pt(astar.route(request)).get<float>("trip.summary.time");
+  astar.cleanup();
+  EXPECT_EQ(json_to_pt(cch.route(request)).get<float>("trip.summary.time"), expected);
+  cch.cleanup();
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  EXPECT_LE(json_to_pt(cch.route(request)).get<float>("trip.summary.time"), expected * 1.1f);
+  cch.cleanup();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <unordered_set>
 #include <vector>
 
 #include "test.h"
@@ -83,13 +84,27 @@ TEST(DoubleBucketQueue, TestClear) {
    }
 */
 
-void TryRemove(DoubleBucketQueue& dbqueue, size_t num_to_remove, const std::vector<float>& costs) {
+// Label for the templated queue which, like a float, converts to its cost
+struct TestLabel {
+  TestLabel(const float c) : cost(c) {
+  }
+  float sortcost() const {
+    return cost;
+  }
+  operator float() const {
+    return cost;
+  }
+  float cost;
+};
+
+template <typename queue_t, typename costs_t>
+void TryRemove(queue_t& dbqueue, size_t num_to_remove, const costs_t& costs) {
   auto previous_cost = -std::numeric_limits<float>::infinity();
   for (size_t i = 0; i < num_to_remove; ++i) {
     const auto top = dbqueue.pop();
     EXPECT_NE(top, kInvalidLabel) << "TryAddRemove: expected " + std::to_string(num_to_remove) +
                                          " labels to remove";
-    const auto cost = costs[top];
+    const float cost = costs[top];
     EXPECT_LE(previous_cost, cost) << "TryAddRemove: expected order test failed";
     previous_cost = cost;
   }
@@ -100,8 +115,9 @@ void TryRemove(DoubleBucketQueue& dbqueue, size_t num_to_remove, const std::vect
   }
 }
 
-void TrySimulation(DoubleBucketQueue& dbqueue,
-                   std::vector<float>& costs,
+template <typename queue_t, typename costs_t>
+void TrySimulation(queue_t& dbqueue,
+                   costs_t& costs,
                    size_t loop_count,
                    size_t expansion_size,
                    size_t max_increment_cost) {
@@ -119,10 +135,10 @@ void TrySimulation(DoubleBucketQueue& dbqueue,
       break;
     }
 
-    const auto min_cost = costs[key];
+    const float min_cost = costs[key];
     // Must be the minimal one among the tracked labels
     for (auto k : addedLabels) {
-      EXPECT_LE(min_cost, costs[k]) << "Simulation: minimal cost expected";
+      EXPECT_LE(min_cost, static_cast<float>(costs[k])) << "Simulation: minimal cost expected";
     }
     addedLabels.erase(key);
 
@@ -131,7 +147,7 @@ void TrySimulation(DoubleBucketQueue& dbqueue,
       if (i % 2 == 0 && !addedLabels.empty()) {
         // Decrease cost
         const auto idx = *std::next(addedLabels.begin(), test::rand01(gen) * addedLabels.size());
-        if (newcost < costs[idx]) {
+        if (newcost < static_cast<float>(costs[idx])) {
           dbqueue.decrease(idx, newcost);
           costs[idx] = newcost;
           // todo: why commented??
@@ -183,6 +199,83 @@ TEST(DoubleBucketQueue, TestSimulation) {
   }
 }
 
+void TryBucketQueueAddRemove(BucketQueueMode mode) {
+  std::vector<uint32_t> costs = {67,  325, 25,  466,   1000, 100005,
+                                 758, 167, 258, 16442, 278,  111111000};
+  std::vector<uint32_t> expectedorder = costs;
+  std::sort(expectedorder.begin(), expectedorder.end());
+
+  // Run twice to check the queue is reusable after it runs empty and is reset
+  std::vector<TestLabel> labels;
+  BucketQueue<std::vector<TestLabel>> queue(mode);
+  for (int pass = 0; pass < 2; ++pass) {
+    labels.clear();
+    queue.reset(0, 10000, 5, &labels);
+    uint32_t i = 0;
+    for (auto cost : costs) {
+      labels.emplace_back(cost);
+      queue.add(i++);
+    }
+    for (auto expected : expectedorder) {
+      uint32_t labelindex = queue.pop();
+      ASSERT_NE(labelindex, kInvalidLabel);
+      EXPECT_EQ(labels[labelindex].sortcost(), expected) << "expected order test failed";
+    }
+    EXPECT_EQ(queue.pop(), kInvalidLabel);
+  }
+
+  // Clear drops everything that was added
+  for (uint32_t i = 0; i < labels.size(); ++i) {
+    queue.add(i);
+  }
+  queue.clear();
+  EXPECT_EQ(queue.pop(), kInvalidLabel) << "failed to return invalid edge index after clear";
+}
+
+TEST(BucketQueue, TestInvalidConstruction) {
+  std::vector<TestLabel> labels;
+  BucketQueue<std::vector<TestLabel>> queue;
+  EXPECT_THROW(queue.reset(0, 10000, 0, &labels), runtime_error)
+      << "Invalid bucket size not caught";
+  EXPECT_THROW(queue.reset(0, 0.0f, 1, &labels), runtime_error) << "Invalid cost range not caught";
+}
+
+TEST(BucketQueue, TestAddRemove) {
+  TryBucketQueueAddRemove(BucketQueueMode::kDoubleBucket);
+}
+
+TEST(BucketQueue, TestRadixAddRemove) {
+  TryBucketQueueAddRemove(BucketQueueMode::kRadixHeap);
+}
+
+TEST(BucketQueue, TestSimulation) {
+  for (auto mode : {BucketQueueMode::kDoubleBucket, BucketQueueMode::kRadixHeap}) {
+    // Radix keys are quantized by the bucket size rather than the range so
+    // it needs unit buckets to pop in exact order
+    uint32_t bucketsize = mode == BucketQueueMode::kRadixHeap ? 1 : 100000;
+
+    // One queue for all runs so that its storage is reused
+    std::vector<TestLabel> costs;
+    BucketQueue<std::vector<TestLabel>> queue(mode);
+
+    queue.reset(0, 1, bucketsize, &costs);
+    TrySimulation(queue, costs, 1000, 10, 1000);
+
+    costs.clear();
+    queue.reset(0, 1, bucketsize, &costs);
+    TrySimulation(queue, costs, 222, 40, 100);
+
+    costs.clear();
+    queue.reset(0, 1, bucketsize, &costs);
+    TrySimulation(queue, costs, 333, 60, 100);
+
+    // Wide cost range with a small bucket size
+    costs.clear();
+    queue.reset(0, 100, 1, &costs);
+    TrySimulation(queue, costs, 2000, 20, 100000);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,151 @@
+#include "test.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "baldr/edgecosttable.h"
+#include "baldr/rapidjson_utils.h"
+#include "tyr/actor.h"
+#include <boost/property_tree/ptree.hpp>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+namespace {
+
+boost::property_tree::ptree json_to_pt(const std::string& json) {
+  std::stringstream ss;
+  ss << json;
+  boost::property_tree::ptree pt;
+  rapidjson::read_json(ss, pt);
+  return pt;
+}
+
+boost::property_tree::ptree make_conf(const bool edge_cost_tables) {
+  return json_to_pt(R"({
+    "mjolnir":{"tile_dir":"test/data/utrecht_tiles", "concurrency": 1},
+    "loki":{
+      "actions":["route","sources_to_targets"],
+      "logging":{"long_request": 100},
+      "service_defaults":{"minimum_reachability": 50,"radius": 0,"search_cutoff": 35000, "node_snap_tolerance": 5, "street_side_tolerance": 5, "heading_tolerance": 60}
+    },
+    "thor":{"logging":{"long_request": 110}, "source_to_target_algorithm": "costmatrix",
+            "edge_cost_tables": )" +
+                    std::string(edge_cost_tables ? "true" : "false") + R"(},
+    "odin":{"logging":{"long_request": 110}},
+    "skadi":{"actons":["height"],"logging":{"long_request": 5}},
+    "meili":{"customizable": ["turn_penalty_factor","max_route_distance_factor","max_route_time_factor","search_radius"],
+             "mode":"auto","grid":{"cache_size":100240,"size":500},
+             "default":{"beta":3,"breakage_distance":2000,"geometry":false,"gps_accuracy":5.0,"interpolation_distance":10,
+             "max_route_distance_factor":5,"max_route_time_factor":5,"max_search_radius":200,"route":true,
+             "search_radius":15.0,"sigma_z":4.07,"turn_penalty_factor":200}},
+    "service_limits": {
+      "auto": {"max_distance": 5000000.0, "max_locations": 20,"max_matrix_distance": 400000.0,"max_matrix_locations": 50},
+      "isochrone": {"max_contours": 4,"max_distance": 25000.0,"max_locations": 1,"max_time": 120},
+      "max_avoid_locations": 50,"max_radius": 200,"max_reachability": 100,"max_alternates":2,
+      "skadi": {"max_shape": 750000,"min_resample": 10.0},
+      "trace": {"max_distance": 200000.0,"max_gps_accuracy": 100.0,"max_search_radius": 100,"max_shape": 16000,"max_best_paths":4,"max_best_paths_shape":100}
+    }
+  })");
+}
+
+TEST(EdgeCostTables, Table) {
+  EdgeCostTable table(42, 70);
+  table.set(0, 1.5f, 2.5f, true, false);
+  table.set(65, 3.f, 4.f, false, true);
+  EXPECT_EQ(table.key(), 42);
+  EXPECT_EQ(table.cost(0), 1.5f);
+  EXPECT_EQ(table.secs(0), 2.5f);
+  EXPECT_TRUE(table.allowed(0));
+  EXPECT_FALSE(table.timed(0));
+  EXPECT_EQ(table.cost(65), 3.f);
+  EXPECT_EQ(table.secs(65), 4.f);
+  EXPECT_FALSE(table.allowed(65));
+  EXPECT_TRUE(table.timed(65));
+  EXPECT_FALSE(table.allowed(64));
+}
+
+TEST(EdgeCostTables, Slots) {
+  EdgeCostTables tables;
+  EXPECT_EQ(tables.find(2), nullptr);
+  EXPECT_FALSE(tables.full());
+
+  // adding a key twice keeps the first table
+  const EdgeCostTable* first = tables.add(std::unique_ptr<EdgeCostTable>(new EdgeCostTable(2, 1)));
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(tables.add(std::unique_ptr<EdgeCostTable>(new EdgeCostTable(2, 1))), first);
+  EXPECT_EQ(tables.find(2), first);
+
+  for (uint64_t key = 4; key < 2 * (EdgeCostTables::kMaxTables + 1); key += 2) {
+    tables.add(std::unique_ptr<EdgeCostTable>(new EdgeCostTable(key, 1)));
+  }
+  EXPECT_TRUE(tables.full());
+  EXPECT_EQ(tables.add(std::unique_ptr<EdgeCostTable>(new EdgeCostTable(100, 1))), nullptr);
+  EXPECT_EQ(tables.find(100), nullptr);
+  EXPECT_NE(tables.find(2 * EdgeCostTables::kMaxTables), nullptr);
+}
+
+TEST(EdgeCostTables, Keys) {
+  // each options string gets its own key, the same one every time
+  auto a = EdgeCostTables::key("1{\"use_highways\":0.2}");
+  auto b = EdgeCostTables::key("1{\"use_highways\":0.3}");
+  EXPECT_NE(a, 0);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(EdgeCostTables::key("1{\"use_highways\":0.2}"), a);
+  EXPECT_EQ(a & 1, 0);
+  EXPECT_EQ(b & 1, 0);
+}
+
+TEST(EdgeCostTables, SameResults) {
+  tyr::actor_t computed(make_conf(false), true);
+  tyr::actor_t tabled(make_conf(true), true);
+
+  // run twice so the second run reads the tables the first one built
+  const std::vector<std::string> routes = {
+      R"({"locations":[{"lat":52.09015,"lon":5.06362},{"lat":52.111276,"lon":5.089717}],"costing":"auto"})",
+      R"({"locations":[{"lat":52.048267,"lon":5.074825},{"lat":52.106126,"lon":5.101497}],"costing":"auto"})",
+      R"({"locations":[{"lat":52.103948,"lon":5.06813},{"lat":52.072534,"lon":5.125980}],"costing":"auto","costing_options":{"auto":{"use_highways":0.2}}})",
+  };
+  for (int run = 0; run < 2; ++run) {
+    for (const auto& request : routes) {
+      auto expected = json_to_pt(computed.route(request));
+      auto actual = json_to_pt(tabled.route(request));
+      EXPECT_NEAR(actual.get<float>("trip.summary.time"), expected.get<float>("trip.summary.time"),
+                  0.01f)
+          << request;
+      EXPECT_NEAR(actual.get<float>("trip.summary.length"),
+                  expected.get<float>("trip.summary.length"), 0.001f)
+          << request;
+      computed.cleanup();
+      tabled.cleanup();
+    }
+  }
+
+  const std::string matrix =
+      R"({"sources":[{"lat":52.09015,"lon":5.06362},{"lat":52.048267,"lon":5.074825}],
+          "targets":[{"lat":52.111276,"lon":5.089717},{"lat":52.106126,"lon":5.101497}],
+          "costing":"auto"})";
+  for (int run = 0; run < 2; ++run) {
+    auto expected = json_to_pt(computed.matrix(matrix));
+    auto actual = json_to_pt(tabled.matrix(matrix));
+    auto expected_row = expected.get_child("sources_to_targets").begin();
+    for (const auto& row : actual.get_child("sources_to_targets")) {
+      auto expected_cell = expected_row->second.begin();
+      for (const auto& cell : row.second) {
+        EXPECT_EQ(cell.second.get<float>("time"), expected_cell->second.get<float>("time"));
+        ++expected_cell;
+      }
+      ++expected_row;
+    }
+    computed.cleanup();
+    tabled.cleanup();
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
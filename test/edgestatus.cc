@@ -66,6 +66,45 @@ TEST(EdgeStatus, TestStatus) {
   TryGet(edgestatus, GraphId(555, 3, 1), EdgeSet::kUnreachedOrReset);
 }
 
+TEST(EdgeStatus, TestManyTilesAndReuse) {
+  EdgeStatus edgestatus;
+
+  GraphTileHeader header;
+  header.set_directededgecount(1000);
+  test_tile tt;
+  tt.header_ = &header;
+  const GraphTile* tile = &tt;
+
+  // Enough tiles to grow the tile table a few times
+  for (int pass = 0; pass < 2; ++pass) {
+    for (uint32_t t = 0; t < 500; ++t) {
+      edgestatus.Set(GraphId(t, t % 3, t), EdgeSet::kTemporary, t, tile);
+    }
+    for (uint32_t t = 0; t < 500; ++t) {
+      edgestatus.Update(GraphId(t, t % 3, t), EdgeSet::kPermanent);
+    }
+    for (uint32_t t = 0; t < 500; ++t) {
+      EdgeStatusInfo r = edgestatus.Get(GraphId(t, t % 3, t));
+      EXPECT_EQ(r.set(), EdgeSet::kPermanent);
+      EXPECT_EQ(r.index(), t);
+      // Edges of the tile that were never set are unreached, also when reusing an array
+      TryGet(edgestatus, GraphId(t, t % 3, (t + 1) % 1000), EdgeSet::kUnreachedOrReset);
+    }
+    TryGet(edgestatus, GraphId(600, 0, 0), EdgeSet::kUnreachedOrReset);
+
+    // Pointers to sequential edges of a tile
+    EdgeStatusInfo* ptr = edgestatus.GetPtr(GraphId(7, 1, 0), tile);
+    EXPECT_EQ(ptr[7].set(), EdgeSet::kPermanent);
+    EXPECT_EQ(ptr[8].set(), EdgeSet::kUnreachedOrReset);
+
+    edgestatus.clear();
+    for (uint32_t t = 0; t < 500; ++t) {
+      TryGet(edgestatus, GraphId(t, t % 3, t), EdgeSet::kUnreachedOrReset);
+    }
+    EXPECT_THROW(edgestatus.Update(GraphId(1, 1, 1), EdgeSet::kPermanent), std::runtime_error);
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -4,8 +4,20 @@
 #include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
 
+#include <algorithm>
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "midgard/sequence.h"
 
 #include "test.h"
 
@@ -871,6 +883,293 @@ TEST(CacheLruSoft, TrimOnExactlyFullCache) {
   CheckGraphTile(cache.Get(tile2_id), tile2_id, tile2_size);
 }
 
+TEST(ShardedCache, PutGetClear) {
+  ShardedTileCache cache(1000, ShardedTileCache::MemoryLimitControl::SOFT, 4);
+  cache.Reserve(100);
+
+  // enough tiles to make the shard tables grow
+  for (uint32_t i = 0; i < 200; ++i) {
+    GraphId id(i, 2, 0);
+    CheckGraphTile(cache.Put(id, TestGraphTile(id, i), 5), id, i);
+  }
+  EXPECT_FALSE(cache.OverCommitted());
+  for (uint32_t i = 0; i < 200; ++i) {
+    GraphId id(i, 2, 0);
+    EXPECT_TRUE(cache.Contains(id));
+    CheckGraphTile(cache.Get(id), id, i);
+  }
+  EXPECT_FALSE(cache.Contains({200, 2, 0}));
+  EXPECT_EQ(cache.Get({200, 2, 0}), nullptr);
+
+  // putting it again hands back the tile that is already there
+  GraphId id(10, 2, 0);
+  EXPECT_EQ(cache.Put(id, TestGraphTile(id, 123), 5), cache.Get(id));
+  CheckGraphTile(cache.Get(id), id, 10);
+
+  cache.Put({300, 2, 0}, TestGraphTile({300, 2, 0}, 300), 5);
+  EXPECT_TRUE(cache.OverCommitted());
+
+  cache.Clear();
+  EXPECT_FALSE(cache.OverCommitted());
+  for (uint32_t i = 0; i < 200; ++i) {
+    EXPECT_FALSE(cache.Contains({i, 2, 0}));
+  }
+}
+
+TEST(ShardedCache, InsertSingleItemBiggerThanCacheSize) {
+  ShardedTileCache cache(100, ShardedTileCache::MemoryLimitControl::HARD);
+  GraphId id(10, 1, 0);
+  EXPECT_THROW(cache.Put(id, TestGraphTile(id, 101), 101), std::runtime_error);
+}
+
+TEST(ShardedCache, HardControlNeverOvercommits) {
+  ShardedTileCache cache(1000, ShardedTileCache::MemoryLimitControl::HARD, 4);
+  for (uint32_t i = 0; i < 500; ++i) {
+    GraphId id(i, 2, 0);
+    CheckGraphTile(cache.Put(id, TestGraphTile(id, i), 10), id, i);
+    EXPECT_FALSE(cache.OverCommitted());
+  }
+
+  // the most recent one is always there
+  EXPECT_TRUE(cache.Contains({499, 2, 0}));
+  size_t count = 0;
+  for (uint32_t i = 0; i < 500; ++i) {
+    count += cache.Contains({i, 2, 0});
+  }
+  EXPECT_LE(count, 100);
+  EXPECT_GT(count, 0);
+}
+
+TEST(ShardedCache, SoftControlTrim) {
+  ShardedTileCache cache(1000, ShardedTileCache::MemoryLimitControl::SOFT, 4);
+  for (uint32_t i = 0; i < 200; ++i) {
+    GraphId id(i, 2, 0);
+    cache.Put(id, TestGraphTile(id, i), 10);
+  }
+  EXPECT_TRUE(cache.OverCommitted());
+
+  cache.Trim();
+  EXPECT_FALSE(cache.OverCommitted());
+  size_t count = 0;
+  for (uint32_t i = 0; i < 200; ++i) {
+    count += cache.Contains({i, 2, 0});
+  }
+  EXPECT_LE(count, 100);
+  EXPECT_GT(count, 0);
+}
+
+TEST(ShardedCache, EvictedTilesOutliveReaders) {
+  auto cache = std::make_shared<ShardedTileCache>(100, ShardedTileCache::MemoryLimitControl::SOFT);
+  ShardedTileCacheReader reader1(cache);
+  ShardedTileCacheReader reader2(cache);
+
+  GraphId id(10, 1, 0);
+  const GraphTile* tile = reader1.Put(id, TestGraphTile(id, 60), 60);
+
+  // the other reader clears the cache but reader1 still holds the tile
+  reader2.Clear();
+  EXPECT_FALSE(reader1.Contains(id));
+  CheckGraphTile(tile, id, 60);
+  EXPECT_FALSE(reader1.OverCommitted());
+
+  // retired memory still counts against the cache until reader1 lets go of it
+  GraphId id2(20, 1, 0);
+  reader2.Put(id2, TestGraphTile(id2, 60), 60);
+  EXPECT_TRUE(reader2.OverCommitted());
+  CheckGraphTile(tile, id, 60);
+
+  // once reader1 is done with its tiles the retired one can go
+  reader1.Trim();
+  EXPECT_TRUE(reader2.Contains(id2));
+  EXPECT_FALSE(reader2.OverCommitted());
+}
+
+TEST(ShardedCache, IdleReadersDontPinEvictedTiles) {
+  auto cache = std::make_shared<ShardedTileCache>(100, ShardedTileCache::MemoryLimitControl::SOFT);
+  ShardedTileCacheReader worker(cache);
+  // a reader that never got a tile and one that is done with the tiles of its request
+  ShardedTileCacheReader idle(cache);
+  ShardedTileCacheReader done(cache);
+  GraphId id(10, 1, 0);
+  done.Put(id, TestGraphTile(id, 60), 60);
+  done.Release();
+
+  // neither of them keeps what the worker evicts alive
+  GraphId id2(20, 1, 0);
+  worker.Put(id2, TestGraphTile(id2, 60), 60);
+  EXPECT_TRUE(worker.OverCommitted());
+  worker.Trim();
+  EXPECT_FALSE(worker.OverCommitted());
+
+  // but once the reader gets a tile again it holds on to what is evicted from then on
+  GraphId id3(30, 1, 0);
+  const GraphTile* tile = done.Get(id2);
+  if (!tile) {
+    tile = done.Put(id2, TestGraphTile(id2, 60), 60);
+  }
+  worker.Put(id3, TestGraphTile(id3, 60), 60);
+  worker.Clear();
+  EXPECT_TRUE(worker.OverCommitted());
+  CheckGraphTile(tile, id2, 60);
+  done.Release();
+  worker.Trim();
+  EXPECT_FALSE(worker.OverCommitted());
+}
+
+TEST(ShardedCache, ConcurrentReaders) {
+  auto cache = std::make_shared<ShardedTileCache>(2000, ShardedTileCache::MemoryLimitControl::HARD);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> failures(0);
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([cache, t, &failures]() {
+      ShardedTileCacheReader reader(cache);
+      for (uint32_t i = 0; i < 20000; ++i) {
+        GraphId id((i * 7 + t) % 300, 2, 0);
+        const GraphTile* tile = reader.Get(id);
+        if (!tile) {
+          tile = reader.Put(id, TestGraphTile(id, id.tileid()), 10);
+        }
+        failures += tile->header()->graphid() != id;
+        if (i % 1000 == 0) {
+          reader.Trim();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+
+  // with all the readers gone whatever is still retired can be reclaimed
+  cache->Trim();
+  EXPECT_FALSE(cache->OverCommitted());
+}
+
+const std::string utrecht_tiles = "test/data/utrecht_tiles";
+const std::string utrecht_extract = "test/data/utrecht_tiles.tar";
+
+// Tar up the utrecht tiles, one entry per tile file like valhalla_build_extract does
+void write_tile_extract() {
+  std::ofstream file(utrecht_extract, std::ios::binary | std::ios::trunc);
+  for (boost::filesystem::recursive_directory_iterator i(utrecht_tiles), end; i != end; ++i) {
+    if (i->path().extension() != ".gph") {
+      continue;
+    }
+    std::ifstream tile_file(i->path().string(), std::ios::binary);
+    std::vector<char> tile((std::istreambuf_iterator<char>(tile_file)),
+                           std::istreambuf_iterator<char>());
+
+    valhalla::midgard::tar::header_t entry{};
+    auto name = i->path().string().substr(utrecht_tiles.size() + 1);
+    std::strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+    std::snprintf(entry.mode, sizeof(entry.mode), "%07o", 0644);
+    std::snprintf(entry.uid, sizeof(entry.uid), "%07o", 0);
+    std::snprintf(entry.gid, sizeof(entry.gid), "%07o", 0);
+    std::snprintf(entry.size, sizeof(entry.size), "%011o", static_cast<unsigned>(tile.size()));
+    std::snprintf(entry.mtime, sizeof(entry.mtime), "%011o", 0);
+    entry.typeflag = '0';
+    std::memcpy(entry.magic, "ustar", 6);
+    std::memcpy(entry.version, "00", 2);
+    std::memset(entry.chksum, ' ', sizeof(entry.chksum));
+    unsigned sum = 0;
+    for (size_t j = 0; j < sizeof(entry); ++j) {
+      sum += reinterpret_cast<const unsigned char*>(&entry)[j];
+    }
+    std::snprintf(entry.chksum, sizeof(entry.chksum), "%06o", sum);
+
+    // the tile padded out to whole blocks
+    tile.resize((tile.size() + sizeof(entry) - 1) / sizeof(entry) * sizeof(entry));
+    file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    file.write(tile.data(), tile.size());
+  }
+  // and the two empty blocks ending the tar
+  std::vector<char> blank(2 * sizeof(valhalla::midgard::tar::header_t), 0);
+  file.write(blank.data(), blank.size());
+}
+
+// Everything the reader gives back for the tiles of the extract: the tile bytes and, for each
+// edge, its names and where it ends, looked up through the reader
+std::string read_extract(GraphReader& reader) {
+  auto tile_set = reader.GetTileSet();
+  std::vector<GraphId> tile_ids(tile_set.begin(), tile_set.end());
+  std::sort(tile_ids.begin(), tile_ids.end());
+  std::stringstream ss;
+  for (const auto& tile_id : tile_ids) {
+    const GraphTile* tile = reader.GetGraphTile(tile_id);
+    if (!tile) {
+      ss << "missing " << tile_id << '\n';
+      continue;
+    }
+    ss << std::string(reinterpret_cast<const char*>(tile->header()), tile->header()->end_offset());
+    for (uint32_t i = 0; i < tile->header()->directededgecount(); ++i) {
+      const DirectedEdge* edge = tile->directededge(i);
+      for (const auto& name : tile->GetNames(edge->edgeinfo_offset())) {
+        ss << name << ';';
+      }
+      const GraphTile* end_tile = reader.GetGraphTile(edge->endnode());
+      if (end_tile) {
+        auto ll = end_tile->get_node_ll(edge->endnode());
+        ss << ll.lng() << ',' << ll.lat();
+      }
+      ss << '\n';
+    }
+  }
+  return ss.str();
+}
+
+// Read the extract with or without the views in a process of its own, the extract is only
+// loaded once per process, and leave what was read in a file
+void read_extract_to_file(const bool use_views, const std::string& file_name) {
+  boost::property_tree::ptree pt;
+  pt.put("tile_extract", utrecht_extract);
+  pt.put("use_tile_extract_views", use_views);
+  GraphReader reader(pt);
+  auto read = read_extract(reader);
+
+  // the views are handed out as they are and outlive clearing the cache
+  const GraphTile* tile = reader.GetGraphTile(*reader.GetTileSet().begin());
+  if (use_views) {
+    reader.Clear();
+    if (tile != reader.GetGraphTile(*reader.GetTileSet().begin()) || reader.OverCommitted()) {
+      std::exit(2);
+    }
+  }
+
+  // only the tiles that are freed with the cache keep edge costs
+  if ((tile->edge_costs() == nullptr) != use_views) {
+    std::exit(3);
+  }
+  std::ofstream(file_name, std::ios::binary | std::ios::trunc) << read;
+  std::exit(0);
+}
+
+TEST(GraphReader, TileExtractViews) {
+  // each death test child runs in a fresh process so it loads the extract itself
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  write_tile_extract();
+
+  const std::string default_file = "test/data/utrecht_extract_default.txt";
+  const std::string views_file = "test/data/utrecht_extract_views.txt";
+  EXPECT_EXIT(read_extract_to_file(false, default_file), ::testing::ExitedWithCode(0), "");
+  EXPECT_EXIT(read_extract_to_file(true, views_file), ::testing::ExitedWithCode(0), "");
+
+  // reading straight from the mapping gives back the same graph as going through the cache
+  std::ifstream default_stream(default_file, std::ios::binary);
+  std::ifstream views_stream(views_file, std::ios::binary);
+  std::string default_read((std::istreambuf_iterator<char>(default_stream)),
+                           std::istreambuf_iterator<char>());
+  std::string views_read((std::istreambuf_iterator<char>(views_stream)),
+                         std::istreambuf_iterator<char>());
+  EXPECT_FALSE(default_read.empty());
+  EXPECT_EQ(default_read.find("missing"), std::string::npos);
+  EXPECT_TRUE(default_read == views_read);
+
+  boost::filesystem::remove(default_file);
+  boost::filesystem::remove(views_file);
+  boost::filesystem::remove(utrecht_extract);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -66,6 +66,40 @@ TEST(GriddedData, Basic) {
   std::cout << "]}";*/
 }
 
+TEST(GriddedData, LargeGrid) {
+  // a grid big enough to be scanned in bands, distance from the center in meters
+  AABB2<PointLL> box{-0.5, -0.5, 0.5, 0.5};
+  GriddedData<PointLL> g(box, 0.002, std::numeric_limits<float>::max());
+  Tiles<PointLL> t(box, 0.002);
+  PointLL center(0, 0);
+  for (int32_t id = 0; id < static_cast<int32_t>(t.TileCount()); ++id) {
+    auto b = t.Base(id);
+    g.SetIfLessThan(id, center.Distance(b));
+  }
+
+  // with no generalization every contour is one ring, cut across every band it crosses
+  std::vector<float> iso_markers{10000, 20000, 30000, 40000, 50000};
+  auto contours = g.GenerateContours(iso_markers, true, 1.f, 0.f, 4);
+  ASSERT_EQ(contours.size(), iso_markers.size());
+
+  // the threads only split the work, the contours are the same
+  auto serial = g.GenerateContours(iso_markers, true, 1.f, 0.f);
+  ASSERT_EQ(serial.size(), contours.size());
+  for (auto a = serial.begin(), b = contours.begin(); a != serial.end(); ++a, ++b) {
+    EXPECT_EQ(a->second, b->second) << "Contour " << a->first;
+  }
+  for (const auto& collection : contours) {
+    ASSERT_EQ(collection.second.size(), 1u);
+    ASSERT_EQ(collection.second.front().size(), 1u) << "Contour " << collection.first;
+    const auto& ring = collection.second.front().front();
+    ASSERT_EQ(ring.front(), ring.back());
+    // contours of a cone are circles, give or take the size of a cell
+    for (const auto& p : ring) {
+      EXPECT_NEAR(center.Distance(p), collection.first, 200) << "Contour " << collection.first;
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,98 @@
+#include "mjolnir/util.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "test.h"
+
+#if !defined(VALHALLA_SOURCE_DIR)
+#define VALHALLA_SOURCE_DIR
+#endif
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+const std::string base_dir = "test/data/hierarchy_base_tiles";
+
+boost::property_tree::ptree make_conf(const std::string& tile_dir, const unsigned int concurrency) {
+  boost::property_tree::ptree conf;
+  conf.put("mjolnir.tile_dir", tile_dir);
+  conf.put("mjolnir.concurrency", concurrency);
+  conf.put("mjolnir.hierarchy", true);
+  conf.put("mjolnir.shortcuts", true);
+  conf.put("mjolnir.logging.type", "");
+  return conf;
+}
+
+// Copy the base tiles so every run forms its hierarchy from the same input
+void copy_tiles(const std::string& from, const std::string& to) {
+  boost::filesystem::remove_all(to);
+  for (boost::filesystem::recursive_directory_iterator i(from), end; i != end; ++i) {
+    auto path = to + '/' + i->path().string().substr(from.size());
+    if (boost::filesystem::is_directory(i->path())) {
+      boost::filesystem::create_directories(path);
+    } else {
+      boost::filesystem::copy_file(i->path(), path);
+    }
+  }
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Form the hierarchy and the shortcuts of the base tiles with some number of threads
+std::string build(const unsigned int concurrency) {
+  auto tile_dir = "test/data/hierarchy_tiles_" + std::to_string(concurrency);
+  copy_tiles(base_dir, tile_dir);
+  EXPECT_TRUE(build_tile_set(make_conf(tile_dir, concurrency), {}, BuildStage::kHierarchy,
+                             BuildStage::kShortcuts));
+  return tile_dir;
+}
+
+TEST(HierarchyBuilder, SameTilesForAnyConcurrency) {
+  // base tiles, covering a few tiles of each level
+  boost::filesystem::remove_all(base_dir);
+  ASSERT_TRUE(build_tile_set(make_conf(base_dir, 1),
+                             {VALHALLA_SOURCE_DIR "test/data/liechtenstein-latest.osm.pbf"},
+                             BuildStage::kInitialize, BuildStage::kBss));
+
+  auto serial_dir = build(1);
+  auto threaded_dir = build(4);
+
+  // every tile formed by the threads is byte for byte the serial one
+  size_t tiles = 0;
+  for (boost::filesystem::recursive_directory_iterator i(serial_dir), end; i != end; ++i) {
+    if (i->path().extension() != ".gph") {
+      continue;
+    }
+    auto threaded = threaded_dir + '/' + i->path().string().substr(serial_dir.size());
+    ASSERT_TRUE(boost::filesystem::exists(threaded)) << threaded;
+    EXPECT_TRUE(read_file(i->path().string()) == read_file(threaded)) << threaded;
+    ++tiles;
+  }
+  EXPECT_GT(tiles, 1u);
+
+  // and the threads did not form any other tile
+  size_t threaded_tiles = 0;
+  for (boost::filesystem::recursive_directory_iterator i(threaded_dir), end; i != end; ++i) {
+    threaded_tiles += i->path().extension() == ".gph";
+  }
+  EXPECT_EQ(threaded_tiles, tiles);
+
+  for (const auto& dir : {base_dir, serial_dir, threaded_dir}) {
+    boost::filesystem::remove_all(dir);
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,4 +1,5 @@
 #include "baldr/json.h"
+#include "baldr/json_writer.h"
 #include "baldr/rapidjson_utils.h"
 
 #include <cstdint>
@@ -74,6 +75,40 @@ TEST(JSON, Serialize) {
   EXPECT_EQ(res, ans) << "Wrong json";
 }
 
+TEST(JSON, Writer) {
+  using namespace std;
+  using namespace valhalla::baldr;
+  // arrays keep their order so the tree and the writer have to print exactly the same thing
+  auto tree = json::array({json::fp_t{40.744377, 3}, json::fp_t{-73.990433, 6}, json::fp_t{0.5, 0},
+                           uint64_t(2875622111), int64_t(-9), bool(true), nullptr,
+                           string("\"\t\r\n\\\a"), json::map({{"key", string("value")}})});
+  stringstream answer;
+  answer << *tree;
+
+  json::writer_t writer;
+  writer.start_array();
+  writer(json::fp_t{40.744377, 3});
+  writer(json::fp_t{-73.990433, 6});
+  writer(json::fp_t{0.5, 0});
+  writer(uint64_t(2875622111));
+  writer(int64_t(-9));
+  writer(true);
+  writer(nullptr);
+  writer(string("\"\t\r\n\\\a"));
+  writer.start_object();
+  writer("key", "value");
+  writer.end_object();
+  writer.end_array();
+  EXPECT_EQ(writer.get(), answer.str());
+
+  // and pieces of a tree can be written as they are
+  json::writer_t pieces;
+  pieces.start_object();
+  pieces("tree", json::Value(tree));
+  pieces.end_object();
+  EXPECT_EQ(pieces.get(), "{\"tree\":" + answer.str() + "}");
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
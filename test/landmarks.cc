@@ -0,0 +1,108 @@
+#include "baldr/landmarks.h"
+#include "thor/astarheuristic.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "test.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+using namespace valhalla::thor;
+
+namespace {
+
+constexpr uint32_t kUnreached = LandmarkTable::kUnreached;
+
+// A line of 4 nodes, 100m apart, with a and b in one tile and c and d in another. Landmarks at
+// both ends, the edge between b and c only goes from b to c
+const GraphId a(1, 2, 0), b(1, 2, 1), c(2, 2, 0), d(2, 2, 1);
+
+std::string write_table() {
+  std::string file_name = "line.landmarks";
+  std::vector<LandmarkTile> tiles = {{GraphId(1, 2, 0).tile_value(), 0, 2, 0},
+                                     {GraphId(2, 2, 0).tile_value(), 2, 2, 0}};
+  // per node: from a, from d, to a, to d
+  std::vector<uint32_t> rows = {0,   kUnreached, 0,          300, //
+                                100, kUnreached, 100,        200, //
+                                200, 100,        kUnreached, 100, //
+                                300, 0,          kUnreached, 0};
+  LandmarkTable::Write(file_name, kAutoAccess, {a, d}, tiles, rows);
+  return file_name;
+}
+
+TEST(Landmarks, Table) {
+  auto file_name = write_table();
+  LandmarkTable table(file_name);
+  EXPECT_EQ(table.access(), kAutoAccess);
+  EXPECT_EQ(table.landmark_count(), 2);
+  EXPECT_EQ(table.node_count(), 4);
+  EXPECT_EQ(table.landmarks(), std::vector<GraphId>({a, d}));
+
+  // rows by tile and id, nothing for nodes that are not in the table
+  ASSERT_NE(table.distances(c), nullptr);
+  EXPECT_EQ(table.distances(c)[0], 200);
+  EXPECT_EQ(table.distances(c)[1], 100);
+  EXPECT_EQ(table.distances(d)[2], kUnreached);
+  EXPECT_EQ(table.distances(GraphId(3, 2, 0)), nullptr);
+  EXPECT_EQ(table.distances(GraphId(1, 2, 2)), nullptr);
+
+  // on a line the bounds are exact, unreached landmarks say nothing
+  EXPECT_EQ(table.LowerBound(table.distances(a), table.distances(d)), 300);
+  EXPECT_EQ(table.LowerBound(table.distances(b), table.distances(c)), 100);
+  EXPECT_EQ(table.LowerBound(table.distances(d), table.distances(b)), 0);
+  EXPECT_EQ(table.LowerBound(table.distances(b), table.distances(b)), 0);
+  std::remove(file_name.c_str());
+}
+
+TEST(Landmarks, Truncated) {
+  auto file_name = write_table();
+  {
+    std::ofstream file(file_name, std::ios::binary | std::ios::app);
+    file.write("junk", 4);
+  }
+  EXPECT_THROW(LandmarkTable table(file_name), std::runtime_error);
+  std::remove(file_name.c_str());
+}
+
+TEST(Landmarks, Heuristic) {
+  auto file_name = write_table();
+  LandmarkTable table(file_name);
+
+  // straight line distances are much shorter than the 300m along the line
+  PointLL destination(0.0, 0.0), near(0.0, 0.0001);
+  AStarHeuristic heuristic;
+  heuristic.Init(destination, 2.0f);
+  float dist;
+  float straight = heuristic.Get(near, a, dist);
+  EXPECT_NEAR(straight, dist * 2.0f, 0.001f);
+
+  // heading for d the bound from a is the full line, coming from d (reverse) there is none
+  heuristic.InitLandmarks(&table, {d}, false);
+  EXPECT_NEAR(heuristic.Get(near, a, dist), 600.0f, 0.001f);
+  EXPECT_NEAR(heuristic.Get(near, c, dist), 200.0f, 0.001f);
+  EXPECT_NEAR(dist * 2.0f, straight, 0.001f) << "dist stays the straight line distance";
+  heuristic.InitLandmarks(&table, {d}, true);
+  EXPECT_NEAR(heuristic.Get(near, a, dist), straight, 0.001f);
+
+  // the closest target decides, nodes without a row and targets without a row fall back
+  heuristic.InitLandmarks(&table, {d, c}, false);
+  EXPECT_NEAR(heuristic.LandmarkDistance(a), 200.0f, 0.001f);
+  EXPECT_NEAR(heuristic.LandmarkDistance(GraphId(3, 2, 0)), 0.0f, 0.001f);
+  heuristic.InitLandmarks(&table, {d, GraphId(3, 2, 0)}, false);
+  EXPECT_NEAR(heuristic.Get(near, a, dist), straight, 0.001f);
+
+  // a new destination drops the landmarks
+  heuristic.InitLandmarks(&table, {d}, false);
+  heuristic.Init(destination, 2.0f);
+  EXPECT_NEAR(heuristic.Get(near, a, dist), straight, 0.001f);
+  std::remove(file_name.c_str());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+#include "test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "baldr/graphconstants.h"
+#include "baldr/graphid.h"
+#include "baldr/graphreader.h"
+#include "baldr/graphtile.h"
+#include "baldr/traffictile.h"
+#include "midgard/sequence.h"
+#include "sif/autocost.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+const std::string tile_dir = "test/data/utrecht_tiles";
+const std::string traffic_extract = "test/data/utrecht_traffic.tar";
+
+// fixture traffic tile 0/003/196.gph, the first edge has a predicted speed of 23 kph at
+// kConstrainedFlowSecondOfDay
+const GraphId edge_id("0/3196/0");
+constexpr uint32_t kPredictedSpeed = 23;
+
+// Offset of the live speed of an edge in the traffic extract
+size_t speed_offset(const uint32_t idx) {
+  return sizeof(tar::header_t) + sizeof(TrafficTileHeader) + idx * sizeof(TrafficSpeed);
+}
+
+// Write a tar holding an (empty) traffic tile for the graph tile, the way the
+// process keeping the traffic up to date would lay it out
+void write_traffic_extract(const GraphId& tile_id, const uint32_t directed_edge_count) {
+  std::vector<char> traffic(sizeof(TrafficTileHeader) + directed_edge_count * sizeof(TrafficSpeed));
+  TrafficTileHeader header{tile_id.value, 1600000000, directed_edge_count, 0};
+  std::memcpy(traffic.data(), &header, sizeof(header));
+
+  tar::header_t entry{};
+  std::strncpy(entry.name, GraphTile::FileSuffix(tile_id).c_str(), sizeof(entry.name) - 1);
+  std::snprintf(entry.mode, sizeof(entry.mode), "%07o", 0644);
+  std::snprintf(entry.uid, sizeof(entry.uid), "%07o", 0);
+  std::snprintf(entry.gid, sizeof(entry.gid), "%07o", 0);
+  std::snprintf(entry.size, sizeof(entry.size), "%011o", static_cast<unsigned>(traffic.size()));
+  std::snprintf(entry.mtime, sizeof(entry.mtime), "%011o", 0);
+  entry.typeflag = '0';
+  std::memcpy(entry.magic, "ustar", 6);
+  std::memcpy(entry.version, "00", 2);
+  std::memset(entry.chksum, ' ', sizeof(entry.chksum));
+  unsigned sum = 0;
+  for (size_t i = 0; i < sizeof(entry); ++i) {
+    sum += reinterpret_cast<const unsigned char*>(&entry)[i];
+  }
+  std::snprintf(entry.chksum, sizeof(entry.chksum), "%06o", sum);
+
+  // the entry padded out to whole blocks and then the two empty blocks ending the tar
+  traffic.resize((traffic.size() + sizeof(entry) - 1) / sizeof(entry) * sizeof(entry) +
+                 2 * sizeof(entry));
+  std::ofstream file(traffic_extract, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  file.write(traffic.data(), traffic.size());
+}
+
+// Write a live speed in place, as another process would
+void write_speed(const uint32_t idx, const uint32_t kph) {
+  TrafficSpeed speed{};
+  speed.speed = kph;
+  std::fstream file(traffic_extract, std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(speed_offset(idx));
+  file.write(reinterpret_cast<const char*>(&speed), sizeof(speed));
+}
+
+TEST(LiveTraffic, test_get_speed) {
+  // make the extract before any reader is made, the extract is loaded once
+  GraphTile graph_tile(tile_dir, edge_id);
+  ASSERT_NE(graph_tile.header(), nullptr);
+  write_traffic_extract(edge_id.Tile_Base(), graph_tile.header()->directededgecount());
+  write_speed(edge_id.id(), 55);
+
+  boost::property_tree::ptree config;
+  config.put("tile_dir", tile_dir);
+  config.put("traffic_extract", traffic_extract);
+  GraphReader reader(config);
+  auto tile = reader.GetGraphTile(edge_id);
+  ASSERT_NE(tile, nullptr);
+  ASSERT_FALSE(tile->traffic_tile().empty());
+  auto de = tile->directededge(edge_id);
+  uint8_t mask = kPredictedFlowMask | kCurrentFlowMask;
+
+  // the live speed is used at the start of the request
+  uint8_t flow_sources;
+  EXPECT_EQ(tile->GetSpeed(de, mask, kConstrainedFlowSecondOfDay, &flow_sources), 55);
+  EXPECT_TRUE(flow_sources & kCurrentFlowMask);
+
+  // but only when asked for
+  EXPECT_EQ(tile->GetSpeed(de, kPredictedFlowMask, kConstrainedFlowSecondOfDay, &flow_sources),
+            kPredictedSpeed);
+  EXPECT_FALSE(flow_sources & kCurrentFlowMask);
+
+  // it fades into the predicted speed later on in the route
+  EXPECT_EQ(tile->GetSpeed(de, mask, kConstrainedFlowSecondOfDay, &flow_sources,
+                           kLiveSpeedFadeSeconds / 2),
+            (55 + kPredictedSpeed) / 2);
+  EXPECT_TRUE(flow_sources & kCurrentFlowMask);
+  EXPECT_TRUE(flow_sources & kPredictedFlowMask);
+  EXPECT_EQ(tile->GetSpeed(de, mask, kConstrainedFlowSecondOfDay, &flow_sources,
+                           kLiveSpeedFadeSeconds),
+            kPredictedSpeed);
+  EXPECT_FALSE(flow_sources & kCurrentFlowMask);
+
+  // edges without a live speed use the others
+  auto other = tile->directededge(edge_id.id() + 1);
+  EXPECT_EQ(tile->GetSpeed(other, mask, kConstrainedFlowSecondOfDay),
+            tile->GetSpeed(other, kPredictedFlowMask, kConstrainedFlowSecondOfDay));
+
+  // updates reach the tile that is already loaded
+  write_speed(edge_id.id(), 12);
+  EXPECT_EQ(tile->GetSpeed(de, mask, kConstrainedFlowSecondOfDay), 12);
+  write_speed(edge_id.id(), kUnknownTrafficSpeed);
+  EXPECT_EQ(tile->GetSpeed(de, mask, kConstrainedFlowSecondOfDay), kPredictedSpeed);
+}
+
+// Auto costing using all the speed types
+sif::cost_ptr_t make_costing(const Options::DateTimeType date_time_type) {
+  Options options;
+  options.set_date_time_type(date_time_type);
+  const rapidjson::Document doc;
+  sif::ParseAutoCostOptions(doc, "/costing_options/auto", options.add_costing_options());
+  options.mutable_costing_options(static_cast<int>(Costing::auto_))
+      ->set_flow_mask(kDefaultFlowMask);
+  return sif::CreateAutoCost(Costing::auto_, options);
+}
+
+TEST(LiveTraffic, test_costing_fade) {
+  // runs after test_get_speed, the extract is still there
+  write_speed(edge_id.id(), 55);
+  boost::property_tree::ptree config;
+  config.put("tile_dir", tile_dir);
+  config.put("traffic_extract", traffic_extract);
+  GraphReader reader(config);
+  auto tile = reader.GetGraphTile(edge_id);
+  ASSERT_NE(tile, nullptr);
+  ASSERT_FALSE(tile->traffic_tile().empty());
+  auto de = tile->directededge(edge_id);
+
+  // searches without a time are for now, they take the live speed
+  auto costing = make_costing(Options::current);
+  float live = costing->EdgeCost(de, tile, kInvalidSecondsOfWeek).secs;
+
+  // the further the edge is in time from the start of the search the slower the predicted speed
+  // makes it, until only the predicted speed is left
+  const uint32_t start = kConstrainedFlowSecondOfDay;
+  costing->set_start_time(start);
+  EXPECT_EQ(costing->EdgeCost(de, tile, start).secs, live);
+  float half = costing->EdgeCost(de, tile, start + kLiveSpeedFadeSeconds / 2).secs;
+  float faded = costing->EdgeCost(de, tile, start + kLiveSpeedFadeSeconds).secs;
+  EXPECT_GT(half, live);
+  EXPECT_GT(faded, half);
+
+  // reverse searches go back in time from the start
+  EXPECT_GT(costing->EdgeCost(de, tile, start - kLiveSpeedFadeSeconds / 2).secs, live);
+
+  // requests leaving at a given time never use the live speed
+  auto later = make_costing(Options::depart_at);
+  later->set_start_time(start);
+  EXPECT_EQ(later->EdgeCost(de, tile, start + kLiveSpeedFadeSeconds).secs, faded);
+  EXPECT_GT(later->EdgeCost(de, tile, start).secs, live);
+  write_speed(edge_id.id(), kUnknownTrafficSpeed);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,4 +1,5 @@
 // -*- mode: c++ -*-
+#include <memory>
 #include <string>
 
 #include "baldr/rapidjson_utils.h"
@@ -203,6 +204,93 @@ TEST(MapMatcherFactory, TestMapMatcher) {
   delete pedestrian_matcher;
 }
 
+TEST(MapMatcherFactory, TestSharedGridCache) {
+  ptree root;
+  rapidjson::read_json(VALHALLA_SOURCE_DIR "test/valhalla.json", root);
+
+  // Factories reading the same tiles share their candidate grids
+  meili::MapMatcherFactory factory(root);
+  meili::MapMatcherFactory other_factory(root);
+  Options options;
+  create_costing_options(options);
+  std::unique_ptr<meili::MapMatcher> matcher(factory.Create(Costing::auto_, options));
+  std::unique_ptr<meili::MapMatcher> other_matcher(other_factory.Create(Costing::auto_, options));
+  const auto& query = dynamic_cast<const meili::CandidateGridQuery&>(matcher->candidatequery());
+  const auto& other_query =
+      dynamic_cast<const meili::CandidateGridQuery&>(other_matcher->candidatequery());
+  EXPECT_NE(&query, &other_query);
+  EXPECT_EQ(query.grid_cache(), other_query.grid_cache())
+      << "grid cache should be shared among factories";
+
+  // But not with factories reading other tiles
+  const auto tile_dir = root.get<std::string>("mjolnir.tile_dir");
+  root.put("mjolnir.tile_dir", "test/data/some_other_tiles");
+  meili::MapMatcherFactory another_factory(root);
+  std::unique_ptr<meili::MapMatcher> another_matcher(
+      another_factory.Create(Costing::auto_, options));
+  const auto& another_query =
+      dynamic_cast<const meili::CandidateGridQuery&>(another_matcher->candidatequery());
+  EXPECT_NE(query.grid_cache(), another_query.grid_cache());
+
+  // The first factory sizes the shared cache, the later ones do not resize it
+  root.put("mjolnir.tile_dir", tile_dir);
+  root.put("meili.grid.cache_size", 8);
+  meili::MapMatcherFactory resized_factory(root);
+  EXPECT_EQ(query.grid_cache()->max_grids(), 64u);
+
+  // Clearing a factory keeps the grids the others share
+  auto grid = std::make_shared<meili::CandidateGridCache::grid_t>(
+      midgard::AABB2<midgard::PointLL>(0, 0, 1, 1), 0.1f, 0.1f);
+  query.grid_cache()->Put(1, 0.1f, 0.1f, grid);
+  factory.ClearCache();
+  EXPECT_EQ(other_query.grid_cache()->size(), 1u);
+
+  // But a factory alone with its grids drops them
+  another_query.grid_cache()->Put(1, 0.1f, 0.1f, grid);
+  another_factory.ClearCache();
+  EXPECT_EQ(another_query.grid_cache()->size(), 0u);
+}
+
+TEST(MapMatcherFactory, TestGridCache) {
+  meili::CandidateGridCache cache(2);
+  auto make_grid = []() {
+    auto grid = std::make_shared<meili::CandidateGridCache::grid_t>(
+        midgard::AABB2<midgard::PointLL>(0, 0, 1, 1), 0.1f, 0.1f);
+    grid->AddLineSegment(baldr::GraphId(1, 2, 3), {{0.05, 0.05}, {0.95, 0.95}});
+    return grid;
+  };
+
+  EXPECT_EQ(cache.Get(1, 0.1f, 0.1f), nullptr);
+  auto grid = cache.Put(1, 0.1f, 0.1f, make_grid());
+  EXPECT_EQ(cache.Get(1, 0.1f, 0.1f), grid);
+
+  // The cell size is part of the key
+  EXPECT_EQ(cache.Get(1, 0.2f, 0.2f), nullptr);
+
+  // A grid added by another thread first wins
+  EXPECT_EQ(cache.Put(1, 0.1f, 0.1f, make_grid()), grid);
+
+  // The least recently used grid is dropped but lives on while in use
+  cache.Put(2, 0.1f, 0.1f, make_grid());
+  cache.Get(1, 0.1f, 0.1f);
+  cache.Put(3, 0.1f, 0.1f, make_grid());
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.Get(2, 0.1f, 0.1f), nullptr);
+  EXPECT_EQ(cache.Get(1, 0.1f, 0.1f), grid);
+  EXPECT_FALSE(grid->Query(midgard::AABB2<midgard::PointLL>(0, 0, 1, 1)).empty());
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.hits, 3);
+  EXPECT_EQ(stats.misses, 3);
+  EXPECT_EQ(stats.grids, 2);
+  EXPECT_GE(stats.memory, 2 * sizeof(meili::CandidateGridCache::grid_t));
+  EXPECT_FLOAT_EQ(stats.hit_rate(), 0.5f);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.stats().memory, 0);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -1,7 +1,9 @@
 #include "test.h"
 
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "baldr/rapidjson_utils.h"
@@ -10,6 +12,7 @@
 #include "loki/worker.h"
 #include "midgard/logging.h"
 #include "sif/dynamiccost.h"
+#include "thor/bucketmatrix.h"
 #include "thor/costmatrix.h"
 #include "thor/timedistancematrix.h"
 #include "thor/worker.h"
@@ -301,6 +304,182 @@ TEST(Matrix, test_matrix) {
   }
 }
 
+struct test_bucket_matrix : public BucketMatrix {
+  using BucketMatrix::BucketMatrix;
+  using BucketMatrix::BucketEntry;
+  using BucketMatrix::cache_size_;
+  using BucketMatrix::target_sets_;
+};
+
+TEST(Matrix, test_bucket_matrix) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+
+  cost_ptr_t costing = CreateSimpleCost(request.options());
+
+  // The second run reuses the target selection phase of the first
+  test_bucket_matrix bucket_matrix;
+  for (int run = 0; run < 2; ++run) {
+    auto results = bucket_matrix.SourceToTarget(request.options().sources(),
+                                                request.options().targets(), reader, &costing,
+                                                TravelMode::kDrive, 400000.0, "simple");
+    ASSERT_EQ(results.size(), matrix_answers.size());
+    for (uint32_t i = 0; i < results.size(); ++i) {
+      EXPECT_NEAR(results[i].dist, matrix_answers[i].dist, kThreshold)
+          << "result " + std::to_string(i) + "'s distance is not close enough" +
+                 " to expected value for BucketMatrix";
+
+      EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold)
+          << "result " + std::to_string(i) + "'s time is not close enough" +
+                 " to expected value for BucketMatrix";
+    }
+    EXPECT_EQ(bucket_matrix.target_sets_.size(), 1);
+  }
+
+  // Other costing options need their own target selection phase
+  bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                               &costing, TravelMode::kDrive, 400000.0, "other");
+  EXPECT_EQ(bucket_matrix.target_sets_.size(), 2);
+
+  // The backward searches stop at the cost threshold of the max matrix distance
+  bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                               &costing, TravelMode::kDrive, 1000.0, "simple");
+  ASSERT_EQ(bucket_matrix.target_sets_.size(), 3);
+  const auto& bounded = bucket_matrix.target_sets_.front().label_counts;
+  const auto& unbounded = bucket_matrix.target_sets_.back().label_counts;
+  ASSERT_EQ(bounded.size(), unbounded.size());
+  for (size_t target = 0; target < bounded.size(); ++target) {
+    EXPECT_LT(bounded[target], unbounded[target]);
+  }
+}
+
+TEST(Matrix, test_bucket_matrix_ttl) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  cost_ptr_t costing = CreateSimpleCost(request.options());
+
+  // Target sets older than the time to live are selected again
+  test_bucket_matrix bucket_matrix(BucketMatrix::kDefaultMaxCacheSize, 0.5f);
+  bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                               &costing, TravelMode::kDrive, 400000.0, "simple");
+  auto selected = bucket_matrix.target_sets_.front().selected;
+  bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                               &costing, TravelMode::kDrive, 400000.0, "simple");
+  EXPECT_EQ(bucket_matrix.target_sets_.front().selected, selected);
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  auto results = bucket_matrix.SourceToTarget(request.options().sources(),
+                                              request.options().targets(), reader, &costing,
+                                              TravelMode::kDrive, 400000.0, "simple");
+  EXPECT_EQ(bucket_matrix.target_sets_.size(), 1);
+  EXPECT_GT(bucket_matrix.target_sets_.front().selected, selected);
+  ASSERT_EQ(results.size(), matrix_answers.size());
+  for (uint32_t i = 0; i < results.size(); ++i) {
+    EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold);
+  }
+}
+
+TEST(Matrix, test_bucket_matrix_cache_size) {
+  loki_worker_t loki_worker(config);
+
+  Api request;
+  ParseApi(test_request, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  cost_ptr_t costing = CreateSimpleCost(request.options());
+
+  // The cache keeps track of the bytes of its target sets
+  test_bucket_matrix bucket_matrix;
+  bucket_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                               &costing, TravelMode::kDrive, 400000.0, "simple");
+  ASSERT_EQ(bucket_matrix.target_sets_.size(), 1);
+  const size_t size = bucket_matrix.target_sets_.front().size;
+  EXPECT_GT(size, bucket_matrix.target_sets_.front().buckets.size() *
+                      sizeof(test_bucket_matrix::BucketEntry));
+  EXPECT_EQ(bucket_matrix.cache_size_, size);
+  bucket_matrix.ClearCache();
+  EXPECT_EQ(bucket_matrix.cache_size_, 0);
+
+  // Target sets are evicted by size rather than count
+  test_bucket_matrix bounded_matrix(size + size / 2);
+  bounded_matrix.SourceToTarget(request.options().sources(), request.options().targets(), reader,
+                                &costing, TravelMode::kDrive, 400000.0, "simple");
+  auto results = bounded_matrix.SourceToTarget(request.options().sources(),
+                                               request.options().targets(), reader, &costing,
+                                               TravelMode::kDrive, 400000.0, "other");
+  ASSERT_EQ(bounded_matrix.target_sets_.size(), 1);
+  EXPECT_EQ(bounded_matrix.cache_size_, bounded_matrix.target_sets_.front().size);
+  ASSERT_EQ(results.size(), matrix_answers.size());
+  for (uint32_t i = 0; i < results.size(); ++i) {
+    EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold);
+  }
+
+  // A target set larger than the cache is only used by its own request
+  test_bucket_matrix tiny_matrix(1);
+  results = tiny_matrix.SourceToTarget(request.options().sources(), request.options().targets(),
+                                       reader, &costing, TravelMode::kDrive, 400000.0, "simple");
+  EXPECT_TRUE(tiny_matrix.target_sets_.empty());
+  EXPECT_EQ(tiny_matrix.cache_size_, 0);
+  ASSERT_EQ(results.size(), matrix_answers.size());
+  for (uint32_t i = 0; i < results.size(); ++i) {
+    EXPECT_NEAR(results[i].time, matrix_answers[i].time, kThreshold);
+  }
+}
+
+TEST(Matrix, test_matrix_parallel) {
+  // Enough locations for the searches to be spread over helper threads
+  std::string locations;
+  for (int i = 0; i < 16; ++i) {
+    locations += std::string(i ? "," : "") + R"({"lat":)" + std::to_string(52.094 + (i % 4) * 0.005) +
+                 R"(,"lon":)" + std::to_string(5.068 + (i / 4) * 0.01) + "}";
+  }
+  const auto request_json = R"({"sources":[)" + locations + R"(],"targets":[)" + locations +
+                            R"(],"costing":"auto"})";
+
+  loki_worker_t loki_worker(config);
+  Api request;
+  ParseApi(request_json, Options::sources_to_targets, request);
+  loki_worker.matrix(request);
+  adjust_scores(*request.mutable_options());
+
+  GraphReader reader(config.get_child("mjolnir"));
+  std::vector<std::shared_ptr<GraphReader>> helper_readers;
+  for (int i = 0; i < 3; ++i) {
+    helper_readers.emplace_back(new GraphReader(config.get_child("mjolnir")));
+  }
+  cost_ptr_t costing = CreateSimpleCost(request.options());
+
+  CostMatrix serial_matrix;
+  auto serial = serial_matrix.SourceToTarget(request.options().sources(),
+                                             request.options().targets(), reader, &costing,
+                                             TravelMode::kDrive, 400000.0);
+  // Run it twice to make sure the matrix is reusable
+  CostMatrix parallel_matrix;
+  for (int run = 0; run < 2; ++run) {
+    auto parallel = parallel_matrix.SourceToTarget(request.options().sources(),
+                                                   request.options().targets(), reader, &costing,
+                                                   TravelMode::kDrive, 400000.0, helper_readers);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (uint32_t i = 0; i < serial.size(); ++i) {
+      EXPECT_EQ(serial[i].dist, parallel[i].dist) << "result " + std::to_string(i) + "'s distance";
+      EXPECT_EQ(serial[i].time, parallel[i].time) << "result " + std::to_string(i) + "'s time";
+    }
+  }
+}
+
 // TODO: it was commented before. Why?
 TEST(Matrix, DISABLED_test_matrix_osrm) {
   loki_worker_t loki_worker(config);
@@ -2,7 +2,9 @@
 #include <boost/archive/iterators/binary_from_base64.hpp>
 #include <boost/archive/iterators/transform_width.hpp>
 
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "baldr/predictedspeeds.h"
 #include "midgard/util.h"
@@ -228,6 +230,60 @@ TEST(PredicteSpeeds, test_negative_speeds) {
   }
 }
 
+TEST(PredicteSpeeds, test_vectorized_decoding) {
+  // Profiles with large coefficients of both signs so that differences in
+  // the order of summation would show
+  std::vector<int16_t> coefficients((kCoefficientCount + 1) * 3);
+  for (uint32_t i = 0; i < coefficients.size(); ++i) {
+    coefficients[i] = static_cast<int16_t>((i * 7919) % 4001) - 2000;
+  }
+
+  // Every bucket of every profile, the profiles are not 16 byte aligned
+  for (uint32_t p = 0; p < 3; ++p) {
+    const int16_t* c = coefficients.data() + p * (kCoefficientCount + 1);
+    for (uint32_t bucket = 0; bucket < kBucketsPerWeek; ++bucket) {
+      const float* b = BucketCosTable::GetInstance().get(bucket);
+      float expected = decode_speed_scalar(c, b);
+      EXPECT_NEAR(decode_speed(c, b), expected, 1e-5f * std::abs(expected) + 1e-2f);
+    }
+  }
+}
+
+TEST(PredicteSpeeds, test_decoded_speed_cache) {
+  DecodedSpeedCache cache;
+  float speed = -1.0f;
+  GraphId edge(3196, 0, 12);
+  EXPECT_FALSE(cache.get(edge, 7, speed));
+
+  cache.put(edge, 7, 42.5f);
+  EXPECT_TRUE(cache.get(edge, 7, speed));
+  EXPECT_EQ(speed, 42.5f);
+
+  // Other buckets and other edges are not found
+  EXPECT_FALSE(cache.get(edge, 8, speed));
+  EXPECT_FALSE(cache.get(GraphId(3196, 0, 13), 7, speed));
+  EXPECT_FALSE(cache.get(GraphId(3196, 1, 12), 7, speed));
+
+  // An entry is replaced by another one in the same slot, more entries than
+  // there are slots will wrap around
+  for (uint32_t i = 0; i < kDecodedSpeedCacheSize * 2; ++i) {
+    cache.put(GraphId(1, 2, i), i % kBucketsPerWeek, static_cast<float>(i));
+  }
+  uint32_t hits = 0;
+  for (uint32_t i = 0; i < kDecodedSpeedCacheSize * 2; ++i) {
+    if (cache.get(GraphId(1, 2, i), i % kBucketsPerWeek, speed)) {
+      EXPECT_EQ(speed, static_cast<float>(i));
+      ++hits;
+    }
+  }
+  EXPECT_GT(hits, 0);
+  EXPECT_LE(hits, kDecodedSpeedCacheSize);
+
+  cache.clear();
+  EXPECT_FALSE(cache.get(GraphId(1, 2, kDecodedSpeedCacheSize * 2 - 1),
+                         (kDecodedSpeedCacheSize * 2 - 1) % kBucketsPerWeek, speed));
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -8,6 +8,8 @@
 #include <cmath>
 #include <fstream>
 #include <list>
+#include <thread>
+#include <vector>
 
 #include "test.h"
 
@@ -103,6 +105,66 @@ TEST(Sample, getgz) {
   _get("test/data/samplegz");
 };
 
+TEST(Sample, get_all_grouped_by_tile) {
+  // postings alternating between tiles come back in the order they were asked for
+  skadi::sample s("test/data/samplegz", 0);
+  std::vector<std::pair<double, double>> postings = {
+      {-76.537011, 40.723872}, {0.5, 0.5},   {-76.537011, 40.726872}, {200.0, 200.0},
+      {-76.537011, 40.729872}, {-76.9, 40.0}, {0.5, 0.5},             {-76.503915, 40.678783}};
+  auto heights = s.get_all(postings);
+  ASSERT_EQ(heights.size(), postings.size());
+  for (size_t i = 0; i < postings.size(); ++i) {
+    EXPECT_EQ(heights[i], s.get(postings[i])) << "Wrong height for posting " << i;
+  }
+  EXPECT_EQ(heights[1], skadi::sample::get_no_data_value());
+  EXPECT_EQ(heights[3], skadi::sample::get_no_data_value());
+  EXPECT_NEAR(heights[7], 490, 1.0);
+}
+
+TEST(Sample, batched_matches_single) {
+  // enough postings for a few batches and a partial one, crossing into other tiles and
+  // landing on the last row and column of the tile
+  skadi::sample s("test/data/sample");
+  std::vector<std::pair<double, double>> postings;
+  for (int i = 0; i < 1000; ++i) {
+    postings.emplace_back(-76.537011 + i * 1e-7, 40.72 + i * 2e-5);
+  }
+  postings.emplace_back(-76.0 - 1e-9, 40.5);
+  postings.emplace_back(-76.5, 40.0);
+  postings.emplace_back(-76.0 - 1e-9, 40.0);
+  auto heights = s.get_all(postings);
+  ASSERT_EQ(heights.size(), postings.size());
+  for (size_t i = 0; i < postings.size(); ++i) {
+    EXPECT_DOUBLE_EQ(heights[i], s.get(postings[i])) << "Wrong height for posting " << i;
+  }
+}
+
+TEST(Sample, shared_between_threads) {
+  // a cache of a single decompressed tile shared by threads all sampling it
+  skadi::sample s("test/data/samplegz", 0);
+  std::list<std::pair<double, double>> postings = {{-76.537011, 40.723872},
+                                                   {-76.537011, 40.726872},
+                                                   {-76.537011, 40.729872},
+                                                   {-76.537011, 40.732872},
+                                                   {-76.537011, 40.735872}};
+  auto expected = s.get_all(postings);
+  std::vector<std::vector<double>> heights(4);
+  std::vector<std::thread> threads;
+  for (auto& h : heights) {
+    threads.emplace_back([&s, &postings, &h]() {
+      for (int i = 0; i < 10; ++i) {
+        h = s.get_all(postings);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& h : heights) {
+    EXPECT_EQ(h, expected);
+  }
+}
+
 struct testable_sample_t : public skadi::sample {
   testable_sample_t(const std::string& dir) : sample(dir) {
     {
@@ -3,7 +3,9 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include "baldr/graphid.h"
 #include "baldr/graphreader.h"
@@ -385,6 +387,41 @@ TEST(Search, test_search_cutoff) {
   search(x, 2, 0);
 }
 
+TEST(Search, test_helper_threads) {
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", tile_dir);
+  GraphReader reader(conf);
+  std::vector<std::shared_ptr<GraphReader>> helper_readers;
+  for (int i = 0; i < 3; ++i) {
+    helper_readers.emplace_back(new GraphReader(conf));
+  }
+
+  // enough locations sharing the bins to split them between the threads, some with a radius and
+  // a reach so that they have several candidates to check
+  std::vector<Location> locations;
+  for (int i = 0; i < 48; ++i) {
+    PointLL ll(.005 + .04 * (i % 8) / 8, .005 + .04 * (i / 8) / 6);
+    locations.emplace_back(ll, Location::StopType::BREAK, i % 6, i % 6, (i % 4) * 500);
+  }
+
+  const auto expected = Search(locations, reader);
+  const auto actual = Search(locations, reader, nullptr, helper_readers);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (const auto& location : locations) {
+    const auto& e = expected.at(location);
+    const auto& a = actual.at(location);
+    EXPECT_TRUE(a == e);
+    ASSERT_EQ(a.edges.size(), e.edges.size());
+    for (size_t i = 0; i < e.edges.size(); ++i) {
+      EXPECT_EQ(a.edges[i].id, e.edges[i].id);
+      EXPECT_EQ(a.edges[i].percent_along, e.edges[i].percent_along);
+      EXPECT_EQ(a.edges[i].outbound_reach, e.edges[i].outbound_reach);
+      EXPECT_EQ(a.edges[i].inbound_reach, e.edges[i].inbound_reach);
+    }
+    EXPECT_EQ(a.filtered_edges.size(), e.filtered_edges.size());
+  }
+}
+
 } // namespace
 
 // Setup and tearown will be called only once for the entire suite121
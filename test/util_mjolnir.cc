@@ -0,0 +1,52 @@
+#include "mjolnir/util.h"
+
+#include "baldr/graphtile.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "test.h"
+
+using namespace valhalla;
+using valhalla::baldr::GraphId;
+
+namespace {
+
+void write_tile(const std::string& tile_dir, const GraphId& tile_id, const size_t size) {
+  auto fullpath = tile_dir + '/' + baldr::GraphTile::FileSuffix(tile_id);
+  boost::filesystem::create_directories(boost::filesystem::path(fullpath).parent_path());
+  std::ofstream file(fullpath, std::ios::binary | std::ios::trunc);
+  file << std::string(size, '\0');
+}
+
+TEST(UtilMjolnir, CostOrderedTileQueue) {
+  std::string tile_dir = "test/data/cost_ordered_tiles";
+  boost::filesystem::remove_all(tile_dir);
+
+  // tiles of different sizes, some of them the same size and one not on disk
+  GraphId small(1, 2, 0), big(2, 2, 0), same_a(3, 2, 0), same_b(4, 2, 0), missing(5, 2, 0),
+      local(6, 1, 0);
+  write_tile(tile_dir, small, 10);
+  write_tile(tile_dir, big, 1000);
+  write_tile(tile_dir, same_b, 100);
+  write_tile(tile_dir, same_a, 100);
+  write_tile(tile_dir, local, 500);
+
+  // the biggest tiles come first, ties go by id and tiles without a file come last
+  auto tilequeue =
+      mjolnir::CostOrderedTileQueue(tile_dir, {missing, same_b, small, local, big, same_a});
+  std::deque<GraphId> expected{big, local, same_a, same_b, small, missing};
+  EXPECT_EQ(tilequeue, expected);
+
+  // an empty set of tiles gives an empty queue
+  EXPECT_TRUE(mjolnir::CostOrderedTileQueue(tile_dir, {}).empty());
+
+  boost::filesystem::remove_all(tile_dir);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
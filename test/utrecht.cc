@@ -1,7 +1,11 @@
 #include "midgard/sequence.h"
 #include "mjolnir/osmnode.h"
+#include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfgraphparser.h"
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
+#include <map>
 
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -195,6 +199,121 @@ TEST(Utrecht, TestBus) {
   EXPECT_TRUE(way_33648196.bike_backward());
 }
 
+// Records every callback it gets, in the order it gets them
+struct recorder_t : public OSMPBF::Callback {
+  std::vector<std::pair<char, uint64_t>> calls;
+  std::hash<std::string> hasher;
+  size_t digest = 0;
+
+  void add(const char type, const uint64_t osmid, const std::string& data) {
+    calls.emplace_back(type, osmid);
+    digest ^= hasher(data) + 0x9e3779b9 + (digest << 6) + (digest >> 2);
+  }
+  static std::string to_string(const OSMPBF::Tags& tags) {
+    std::map<std::string, std::string> sorted(tags.begin(), tags.end());
+    std::string data;
+    for (const auto& tag : sorted) {
+      data += tag.first + '=' + tag.second + ';';
+    }
+    return data;
+  }
+  void node_callback(const uint64_t osmid,
+                     const double lng,
+                     const double lat,
+                     const OSMPBF::Tags& tags) override {
+    add('n', osmid, std::to_string(lng) + ',' + std::to_string(lat) + to_string(tags));
+  }
+  void way_callback(const uint64_t osmid,
+                    const OSMPBF::Tags& tags,
+                    const std::vector<uint64_t>& nodes) override {
+    std::string data = to_string(tags);
+    for (const auto node : nodes) {
+      data += std::to_string(node) + ',';
+    }
+    add('w', osmid, data);
+  }
+  void relation_callback(const uint64_t osmid,
+                         const OSMPBF::Tags& tags,
+                         const std::vector<OSMPBF::Member>& members) override {
+    std::string data = to_string(tags);
+    for (const auto& member : members) {
+      data += std::to_string(member.member_type) + ':' + std::to_string(member.member_id) + ':' +
+              member.role + ',';
+    }
+    add('r', osmid, data);
+  }
+  void changeset_callback(const uint64_t changeset_id) override {
+    add('c', changeset_id, "");
+  }
+};
+
+recorder_t record(const unsigned int threads) {
+  std::ifstream file(VALHALLA_SOURCE_DIR "test/data/utrecht_netherlands.osm.pbf",
+                     std::ios::in | std::ios::binary);
+  recorder_t recorder;
+  OSMPBF::Parser::parse(file,
+                        static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
+                                                      OSMPBF::Interest::WAYS |
+                                                      OSMPBF::Interest::RELATIONS),
+                        recorder, threads);
+  return recorder;
+}
+
+TEST(Utrecht, TestThreadedDecoding) {
+  // the threads decode the blocks but the callbacks still come in file order
+  auto serial = record(1);
+  auto threaded = record(4);
+  ASSERT_FALSE(serial.calls.empty());
+  EXPECT_EQ(threaded.calls, serial.calls);
+  EXPECT_EQ(threaded.digest, serial.digest);
+
+  // which is all the nodes, then all the ways and then all the relations
+  auto rank = [](const std::pair<char, uint64_t>& call) {
+    return call.first == 'n' ? 0 : call.first == 'w' ? 1 : 2;
+  };
+  EXPECT_TRUE(std::is_sorted(serial.calls.begin(), serial.calls.end(),
+                             [&rank](const std::pair<char, uint64_t>& a,
+                                     const std::pair<char, uint64_t>& b) {
+                               return rank(a) < rank(b);
+                             }));
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST(Utrecht, TestThreadedParse) {
+  // parsing with threads writes the same files as parsing without them
+  std::vector<std::vector<std::string>> files;
+  std::vector<OSMData> osmdata;
+  for (const unsigned int concurrency : {1, 4}) {
+    boost::property_tree::ptree conf;
+    conf.put<std::string>("mjolnir.tile_dir", "test/data/parser_tiles");
+    conf.put<unsigned int>("mjolnir.concurrency", concurrency);
+    auto suffix = "_utrecht_" + std::to_string(concurrency) + ".bin";
+    files.push_back({"test_ways" + suffix, "test_way_nodes" + suffix, "test_access" + suffix,
+                     "test_from_complex_restrictions" + suffix,
+                     "test_to_complex_restrictions" + suffix, "test_bss_nodes" + suffix});
+    osmdata.push_back(
+        PBFGraphParser::Parse(conf.get_child("mjolnir"),
+                              {VALHALLA_SOURCE_DIR "test/data/utrecht_netherlands.osm.pbf"},
+                              files.back()[0], files.back()[1], files.back()[2], files.back()[3],
+                              files.back()[4], files.back()[5]));
+  }
+
+  EXPECT_EQ(osmdata[0].osm_node_count, osmdata[1].osm_node_count);
+  EXPECT_EQ(osmdata[0].osm_way_count, osmdata[1].osm_way_count);
+  EXPECT_EQ(osmdata[0].osm_way_node_count, osmdata[1].osm_way_node_count);
+  EXPECT_EQ(osmdata[0].node_count, osmdata[1].node_count);
+  EXPECT_EQ(osmdata[0].edge_count, osmdata[1].edge_count);
+  for (size_t i = 0; i < files[0].size(); ++i) {
+    EXPECT_TRUE(read_file(files[0][i]) == read_file(files[1][i])) << files[1][i];
+    boost::filesystem::remove(files[0][i]);
+    boost::filesystem::remove(files[1][i]);
+  }
+}
+
 // Setup and tearown will be called only once for the entire suite
 class UtrecthTestSuiteEnv : public ::testing::Environment {
 public:
@@ -0,0 +1,226 @@
+#ifndef VALHALLA_BALDR_CCHOVERLAY_H_
+#define VALHALLA_BALDR_CCHOVERLAY_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace baldr {
+
+// Start of a contraction hierarchy overlay file
+struct CCHHeader {
+  char magic[8];         // kCCHMagic
+  uint32_t version;      // kCCHVersion
+  uint32_t access;       // Access mode of the edges in the overlay
+  uint32_t tile_count;   // Number of tiles with nodes in the overlay
+  uint32_t vertex_count; // Number of vertices
+  uint64_t node_count;   // Number of graph nodes
+  uint64_t arc_count;    // Number of (upward) arcs
+  uint64_t edge_count;   // Number of directed edges the arcs are made of
+};
+
+// Where the nodes of a graph tile are in the vertex list of an overlay
+struct CCHTile {
+  uint64_t tile;       // Tile value (level and tile id) of the tile
+  uint64_t first_row;  // Row of the first node of the tile
+  uint32_t node_count; // Number of nodes in the tile
+  uint32_t spare;
+};
+
+// A directed edge between the two vertices of an arc
+struct CCHEdge {
+  uint64_t edgeid : 46; // Directed edge Id
+  uint64_t down : 1;    // The edge goes from the higher vertex of the arc to the lower one
+  uint64_t spare : 17;
+};
+
+constexpr char kCCHMagic[8] = {'v', 'a', 'l', 'h', 'c', 'c', 'h', '\0'};
+constexpr uint32_t kCCHVersion = 1;
+
+/**
+ * The metric independent part of a customizable contraction hierarchy (CCH, Dibbelt, Strasser
+ * and Wagner) over the road network of one access mode.
+ *
+ * Every graph node is a vertex, the nodes of an intersection on the different hierarchy levels
+ * being the same vertex. Vertices are numbered by their rank in a nested dissection order and
+ * each is connected to the higher ranked vertices it shares an edge with, or would share a
+ * shortcut with once all the lower ranked vertices are contracted. The arcs are stored upward
+ * only: an arc of vertex v to vertex u (v < u) stands for both directions between them and
+ * lists the directed edges between the two vertices, if any. Which of them are usable and at
+ * what cost is left to a metric, so the overlay is built once and customized in seconds for any
+ * costing options or traffic.
+ *
+ * The file is a CCHHeader, tile_count CCHTiles, edge_count CCHEdges, the vertex of each graph
+ * node (kNoVertex for nodes without edges of the access mode), the first arc of each vertex and
+ * one past the last arc, the higher vertex of each arc and the first edge of each arc and one
+ * past the last edge. The arcs of a vertex are sorted by the vertex they lead to. The file is
+ * memory mapped so processes serving the same overlay share it.
+ */
+class CCHOverlay {
+public:
+  static constexpr uint32_t kNoVertex = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t kNoArc = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Maps the overlay in the file.
+   * @param file_name  the overlay
+   * @throws std::runtime_error if the file can't be read or isn't an overlay
+   */
+  explicit CCHOverlay(const std::string& file_name);
+
+  /**
+   * Writes an overlay to a file.
+   * @param file_name   the file to write
+   * @param access      the access mode of the edges
+   * @param tiles       the tiles in the order their nodes are in
+   * @param vertices    the vertex of each node
+   * @param first_arcs  the first arc of each vertex and one past the last arc
+   * @param heads       the higher vertex of each arc
+   * @param first_edges the first edge of each arc and one past the last edge
+   * @param edges       the directed edges of the arcs
+   */
+  static void Write(const std::string& file_name,
+                    const uint32_t access,
+                    const std::vector<CCHTile>& tiles,
+                    const std::vector<uint32_t>& vertices,
+                    const std::vector<uint32_t>& first_arcs,
+                    const std::vector<uint32_t>& heads,
+                    const std::vector<uint32_t>& first_edges,
+                    const std::vector<CCHEdge>& edges);
+
+  /**
+   * @return the access mode of the edges in the overlay
+   */
+  uint32_t access() const {
+    return header_->access;
+  }
+
+  /**
+   * @return the number of vertices
+   */
+  uint32_t vertex_count() const {
+    return header_->vertex_count;
+  }
+
+  /**
+   * @return the number of arcs
+   */
+  uint32_t arc_count() const {
+    return header_->arc_count;
+  }
+
+  /**
+   * @return the number of directed edges of the arcs
+   */
+  uint32_t edge_count() const {
+    return header_->edge_count;
+  }
+
+  /**
+   * Get the vertex of a graph node.
+   * @param  node  the node
+   * @return the vertex, kNoVertex if the node is not in the overlay
+   */
+  uint32_t vertex(const GraphId& node) const {
+    auto tile = tiles_.find(node.tile_value());
+    if (tile == tiles_.cend() || node.id() >= tile->second.second) {
+      return kNoVertex;
+    }
+    return vertices_[tile->second.first + node.id()];
+  }
+
+  /**
+   * @param  vertex  a vertex
+   * @return the first arc of the vertex, the arcs of a vertex are contiguous
+   */
+  uint32_t first_arc(const uint32_t vertex) const {
+    return first_arcs_[vertex];
+  }
+
+  /**
+   * @param  vertex  a vertex
+   * @return one past the last arc of the vertex
+   */
+  uint32_t last_arc(const uint32_t vertex) const {
+    return first_arcs_[vertex + 1];
+  }
+
+  /**
+   * @param  arc  an arc
+   * @return the higher vertex the arc leads to
+   */
+  uint32_t head(const uint32_t arc) const {
+    return heads_[arc];
+  }
+
+  /**
+   * Get the parent of a vertex in the elimination tree, the lowest vertex it has an arc to.
+   * The higher vertices a search from a vertex reaches are all on its path to the root.
+   * @param  vertex  a vertex
+   * @return the parent, kNoVertex for a root
+   */
+  uint32_t parent(const uint32_t vertex) const {
+    return first_arcs_[vertex] == first_arcs_[vertex + 1] ? kNoVertex : heads_[first_arcs_[vertex]];
+  }
+
+  /**
+   * Find the arc between two vertices.
+   * @param  lower   the lower vertex
+   * @param  higher  the higher vertex
+   * @return the arc, kNoArc if there is none
+   */
+  uint32_t arc(const uint32_t lower, const uint32_t higher) const {
+    const uint32_t* first = heads_ + first_arcs_[lower];
+    const uint32_t* last = heads_ + first_arcs_[lower + 1];
+    const uint32_t* found = std::lower_bound(first, last, higher);
+    return found == last || *found != higher ? kNoArc : found - heads_;
+  }
+
+  /**
+   * @param  arc  an arc
+   * @return the first directed edge of the arc, the edges of an arc are contiguous
+   */
+  uint32_t first_edge(const uint32_t arc) const {
+    return first_edges_[arc];
+  }
+
+  /**
+   * @param  arc  an arc
+   * @return one past the last directed edge of the arc
+   */
+  uint32_t last_edge(const uint32_t arc) const {
+    return first_edges_[arc + 1];
+  }
+
+  /**
+   * @param  index  index of a directed edge of an arc
+   * @return the directed edge
+   */
+  const CCHEdge& edge(const uint32_t index) const {
+    return edges_[index];
+  }
+
+protected:
+  midgard::mem_map<char> mm_;
+  const CCHHeader* header_;
+  const CCHEdge* edges_;
+  const uint32_t* vertices_;
+  const uint32_t* first_arcs_;
+  const uint32_t* heads_;
+  const uint32_t* first_edges_;
+  // tile value to the first row and node count of the tile
+  std::unordered_map<uint32_t, std::pair<uint64_t, uint32_t>> tiles_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_CCHOVERLAY_H_
@@ -4,9 +4,16 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
 #include <valhalla/midgard/util.h>
 #include <vector>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace valhalla {
 namespace baldr {
 
@@ -252,6 +259,356 @@ private:
   }
 };
 
+/**
+ * How a BucketQueue orders its labels.
+ */
+enum class BucketQueueMode : uint8_t {
+  kDoubleBucket = 0, // Low-level buckets over a cost range plus an overflow bucket
+  kRadixHeap = 1     // Monotone radix heap, no cost range so nothing is ever re-bucketed
+};
+
+/**
+ * Templated variant of the DoubleBucketQueue which reads sort costs straight
+ * from the label container (labels[index].sortcost()) rather than through a
+ * LabelCost functor, so the cost lookup inlines.
+ *
+ * Buckets are intrusive doubly linked lists threaded through a per-label
+ * arena, so adding, moving (decrease) and removing labels never allocates
+ * once the arena has grown to the size of the label container. The arena and
+ * the bucket heads are kept when the queue is reset for a new query, which
+ * makes a long lived queue (e.g. a member of a path algorithm) allocation
+ * free across queries.
+ *
+ * In radix heap mode costs are quantized by the bucket size and labels are
+ * kept in 33 buckets keyed on the highest bit in which their cost differs
+ * from the last popped cost. This has no cost range at all, so searches with
+ * very wide cost ranges never rescan an overflow bucket; each label moves at
+ * most 32 times. Like the double bucket mode it requires costs that do not go
+ * below the last popped cost, costs that do are treated as the last popped
+ * cost.
+ */
+template <typename label_container_t> class BucketQueue {
+public:
+  /**
+   * Constructor. The queue must be reset with a cost range and label
+   * container before it is used.
+   * @param  mode  How the queue orders its labels.
+   */
+  BucketQueue(const BucketQueueMode mode = BucketQueueMode::kDoubleBucket)
+      : mode_(mode), labels_(nullptr), bucketrange_(0.0f), bucketsize_(1.0f), inv_(1.0f),
+        mincost_(0.0f), maxcost_(0.0f), currentcost_(0.0f), current_(0), overflow_(0),
+        last_(0) {
+  }
+
+  /**
+   * Resets the queue for a new query given a minimum cost, a range of costs
+   * held within the bucket sort, and a bucket size. Existing storage is kept.
+   * @param mincost    Minimum cost. Used to create the initial range for
+   *                   bucket sorting.
+   * @param range      Cost range for low-level buckets. Unused in radix mode.
+   * @param bucketsize Bucket size (range of costs within same bucket).
+   *                   Must be an integer value.
+   * @param labels     Label container the label indexes refer to. Must
+   *                   outlive the queue or the next reset.
+   */
+  void reset(const float mincost,
+             const float range,
+             const uint32_t bucketsize,
+             const label_container_t* labels) {
+    // We need at least a bucketsize of 1 or more
+    if (bucketsize < 1) {
+      throw std::runtime_error("Bucketsize must be 1 or greater");
+    }
+
+    // We need at least a bucketrange of something larger than 0
+    if (range <= 0.f) {
+      throw std::runtime_error("Bucketrange must be greater than 0");
+    }
+
+    labels_ = labels;
+    bucketsize_ = static_cast<float>(bucketsize);
+    inv_ = 1.0f / bucketsize_;
+    if (mode_ == BucketQueueMode::kRadixHeap) {
+      mincost_ = mincost;
+      last_ = 0;
+      last_ = key(mincost_);
+      heads_.assign(kRadixBuckets, kInvalidLabel);
+      return;
+    }
+
+    // Adjust min cost to be the start of a bucket
+    uint32_t c = static_cast<uint32_t>(mincost);
+    currentcost_ = (c - (c % bucketsize));
+    mincost_ = currentcost_;
+    bucketrange_ = range;
+    maxcost_ = mincost_ + bucketrange_;
+
+    // The low-level buckets followed by the overflow bucket
+    overflow_ = static_cast<uint32_t>(range / bucketsize_) + 1;
+    heads_.assign(overflow_ + 1, kInvalidLabel);
+    current_ = 0;
+  }
+
+  /**
+   * Clear all labels from the queue. Storage is kept for the next query.
+   */
+  void clear() {
+    std::fill(heads_.begin(), heads_.end(), kInvalidLabel);
+    current_ = 0;
+    currentcost_ = mincost_;
+    last_ = 0;
+    last_ = key(mincost_);
+  }
+
+  /**
+   * Adds a label index to the queue. The label must already be in the label
+   * container with its sort cost set.
+   * @param   label  Label index to add to the queue.
+   */
+  void add(const uint32_t label) {
+    if (label >= nodes_.size()) {
+      nodes_.resize(std::max<size_t>(label + 1, nodes_.size() * 2));
+    }
+    float c = cost(label);
+    link(label, get_bucket(c), c);
+  }
+
+  /**
+   * The specified label index now has a smaller cost. Moves it to the bucket
+   * of the new cost if that differs from its current bucket. This may be
+   * called before or after the sort cost in the label container is updated,
+   * the queue keeps its own copy of the cost.
+   * @param  label        Label index to reorder.
+   * @param  newcost      New sort cost.
+   */
+  void decrease(const uint32_t label, const float newcost) {
+    uint32_t bucket = get_bucket(newcost);
+    if (nodes_[label].bucket != bucket) {
+      unlink(label);
+      link(label, bucket, newcost);
+    } else {
+      nodes_[label].cost = newcost;
+    }
+  }
+
+  /**
+   * Removes the lowest cost label index from the queue.
+   * @return  Returns the label index of the lowest cost label. Returns
+   *          kInvalidLabel if the queue is empty.
+   */
+  uint32_t pop() {
+    if (mode_ == BucketQueueMode::kRadixHeap) {
+      if (heads_[0] == kInvalidLabel && !redistribute()) {
+        return kInvalidLabel;
+      }
+    } else if (empty()) {
+      // Move labels from the overflow bucket to the low level buckets if any
+      if (heads_[overflow_] == kInvalidLabel) {
+        // Leave current bucket on the last bucket in case the queue is used again
+        current_ = overflow_ - 1;
+        return kInvalidLabel;
+      }
+      empty_overflow();
+      if (empty()) {
+        return kInvalidLabel;
+      }
+    }
+
+    // Return label from lowest non-empty bucket
+    uint32_t label = heads_[mode_ == BucketQueueMode::kRadixHeap ? 0 : current_];
+    unlink(label);
+    return label;
+  }
+
+private:
+  // Bucket membership and sort cost of a label, stored in the arena by label
+  // index. Keeping the cost here means moving labels between buckets never
+  // touches the label container
+  struct node_t {
+    uint32_t next;
+    uint32_t prev;
+    uint32_t bucket;
+    float cost;
+  };
+
+  // Keys up to 32 bits differ from the last popped key in one of 32 bits, plus
+  // the bucket holding the keys equal to it
+  static constexpr uint32_t kRadixBuckets = 33;
+
+  BucketQueueMode mode_;
+  const label_container_t* labels_;
+
+  float bucketrange_; // Total range of costs in lower level buckets
+  float bucketsize_;  // Bucket size (range of costs in same bucket)
+  float inv_;         // 1/bucketsize (so we can avoid division)
+  float mincost_;     // Minimum cost within the low level buckets
+  float maxcost_;     // Above this goes into overflow bucket
+  float currentcost_; // Current cost
+  uint32_t current_;  // Current low level bucket
+  uint32_t overflow_; // Index of the overflow bucket
+  uint32_t last_;     // Last popped key (radix mode)
+
+  // First label of each bucket and the arena of per label links
+  std::vector<uint32_t> heads_;
+  std::vector<node_t> nodes_;
+
+  float cost(const uint32_t label) const {
+    return (*labels_)[label].sortcost();
+  }
+
+  /**
+   * Returns the quantized cost used as key in radix mode, never less than
+   * the last popped key.
+   */
+  uint32_t key(const float cost) const {
+    float k = cost * inv_;
+    if (k >= static_cast<float>(std::numeric_limits<uint32_t>::max())) {
+      return std::numeric_limits<uint32_t>::max();
+    }
+    return std::max(last_, k > 0.0f ? static_cast<uint32_t>(k) : 0u);
+  }
+
+  /**
+   * Returns the radix bucket for a key: 0 if it equals the last popped key,
+   * otherwise one more than the highest bit in which it differs from it.
+   */
+  uint32_t radix_bucket(const uint32_t key) const {
+    if (key == last_) {
+      return 0;
+    }
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanReverse(&bit, key ^ last_);
+    return bit + 1;
+#else
+    return 32 - __builtin_clz(key ^ last_);
+#endif
+  }
+
+  /**
+   * Returns the bucket given the cost.
+   * @param  cost  Cost.
+   * @return Returns the bucket that the cost lies within.
+   */
+  uint32_t get_bucket(const float cost) const {
+    if (mode_ == BucketQueueMode::kRadixHeap) {
+      return radix_bucket(key(cost));
+    }
+    return (cost < currentcost_)
+               ? current_
+               : (cost < maxcost_) ? static_cast<uint32_t>((cost - mincost_) * inv_) : overflow_;
+  }
+
+  void link(const uint32_t label, const uint32_t bucket, const float cost) {
+    node_t& node = nodes_[label];
+    node.bucket = bucket;
+    node.cost = cost;
+    node.prev = kInvalidLabel;
+    node.next = heads_[bucket];
+    if (node.next != kInvalidLabel) {
+      nodes_[node.next].prev = label;
+    }
+    heads_[bucket] = label;
+  }
+
+  void unlink(const uint32_t label) {
+    const node_t& node = nodes_[label];
+    if (node.prev != kInvalidLabel) {
+      nodes_[node.prev].next = node.next;
+    } else {
+      heads_[node.bucket] = node.next;
+    }
+    if (node.next != kInvalidLabel) {
+      nodes_[node.next].prev = node.prev;
+    }
+  }
+
+  /**
+   * Increments current_ in the low-level buckets until a non-empty bucket is
+   * found.
+   * @return  Returns true if the low-level buckets are all empty.
+   */
+  bool empty() {
+    while (current_ < overflow_ && heads_[current_] == kInvalidLabel) {
+      current_++;
+      currentcost_ += bucketsize_;
+    }
+    return current_ == overflow_;
+  }
+
+  /**
+   * Empties the overflow bucket by placing the label indexes into the
+   * low level buckets.
+   */
+  void empty_overflow() {
+    // Get the minimum label so we can figure out where the new range should be
+    float min = std::numeric_limits<float>::max();
+    for (uint32_t label = heads_[overflow_]; label != kInvalidLabel; label = nodes_[label].next) {
+      min = std::min(min, nodes_[label].cost);
+    }
+
+    // Adjust cost range so smallest element is in the low level buckets
+    mincost_ += (std::floor((min - mincost_) / bucketrange_)) * bucketrange_;
+
+    // Avoid precision issues
+    if (mincost_ > min) {
+      mincost_ -= bucketrange_;
+    } else if (mincost_ + bucketrange_ < min) {
+      mincost_ += bucketrange_;
+    }
+    maxcost_ = mincost_ + bucketrange_;
+
+    // Move elements within the range from overflow to buckets
+    uint32_t label = heads_[overflow_];
+    while (label != kInvalidLabel) {
+      uint32_t next = nodes_[label].next;
+      float c = nodes_[label].cost;
+      if (c < maxcost_) {
+        unlink(label);
+        link(label, static_cast<uint32_t>((c - mincost_) * inv_), c);
+      }
+      label = next;
+    }
+
+    // Reset current cost and bucket to beginning of low level buckets
+    currentcost_ = mincost_;
+    current_ = 0;
+  }
+
+  /**
+   * Radix mode: makes the smallest key in the lowest non-empty bucket the
+   * last popped key and redistributes that bucket, which moves every label
+   * with that key into bucket 0.
+   * @return  Returns false if the queue is empty.
+   */
+  bool redistribute() {
+    uint32_t bucket = 1;
+    while (bucket < kRadixBuckets && heads_[bucket] == kInvalidLabel) {
+      bucket++;
+    }
+    if (bucket == kRadixBuckets) {
+      return false;
+    }
+
+    uint32_t min = std::numeric_limits<uint32_t>::max();
+    for (uint32_t label = heads_[bucket]; label != kInvalidLabel; label = nodes_[label].next) {
+      min = std::min(min, key(nodes_[label].cost));
+    }
+    last_ = min;
+
+    // Every label in the bucket goes to a lower bucket
+    uint32_t label = heads_[bucket];
+    heads_[bucket] = kInvalidLabel;
+    while (label != kInvalidLabel) {
+      uint32_t next = nodes_[label].next;
+      float c = nodes_[label].cost;
+      link(label, radix_bucket(key(c)), c);
+      label = next;
+    }
+    return true;
+  }
+};
+
 } // namespace baldr
 } // namespace valhalla
 
@@ -0,0 +1,204 @@
+#ifndef VALHALLA_BALDR_EDGECOSTTABLE_H_
+#define VALHALLA_BALDR_EDGECOSTTABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Costs of all the directed edges of a graph tile for one costing and its options, and which of
+ * them the costing can use regardless of where it comes from. A costing builds the table the
+ * first time it costs an edge of the tile and the table stays with the tile, so later requests
+ * with the same options read the costs rather than compute them again.
+ */
+class EdgeCostTable {
+public:
+  /**
+   * Constructor.
+   * @param  key         Costing and options the costs are for.
+   * @param  edge_count  Number of directed edges in the tile.
+   */
+  EdgeCostTable(const uint64_t key, const uint32_t edge_count)
+      : key_(key), costs_(edge_count * 2), allowed_((edge_count + 63) / 64),
+        timed_((edge_count + 63) / 64) {
+  }
+
+  /**
+   * Get the costing and options the costs are for.
+   * @return  Returns the key the costing made the table with.
+   */
+  uint64_t key() const {
+    return key_;
+  }
+
+  /**
+   * Set the cost of a directed edge.
+   * @param  idx      Directed edge index within the tile.
+   * @param  cost     Cost to traverse the edge.
+   * @param  secs     Seconds to traverse the edge.
+   * @param  allowed  Can the costing use the edge at all.
+   * @param  timed    Does the edge have time based access restrictions.
+   */
+  void set(const uint32_t idx,
+           const float cost,
+           const float secs,
+           const bool allowed,
+           const bool timed) {
+    costs_[idx * 2] = cost;
+    costs_[idx * 2 + 1] = secs;
+    if (allowed) {
+      allowed_[idx / 64] |= 1ull << (idx % 64);
+    }
+    if (timed) {
+      timed_[idx / 64] |= 1ull << (idx % 64);
+    }
+  }
+
+  /**
+   * @param  idx  Directed edge index within the tile.
+   * @return  Returns the cost to traverse the edge.
+   */
+  float cost(const uint32_t idx) const {
+    return costs_[idx * 2];
+  }
+
+  /**
+   * @param  idx  Directed edge index within the tile.
+   * @return  Returns the seconds to traverse the edge.
+   */
+  float secs(const uint32_t idx) const {
+    return costs_[idx * 2 + 1];
+  }
+
+  /**
+   * @param  idx  Directed edge index within the tile.
+   * @return  Returns true if the costing can use the edge at all.
+   */
+  bool allowed(const uint32_t idx) const {
+    return allowed_[idx / 64] & (1ull << (idx % 64));
+  }
+
+  /**
+   * @param  idx  Directed edge index within the tile.
+   * @return  Returns true if the edge has time based access restrictions.
+   */
+  bool timed(const uint32_t idx) const {
+    return timed_[idx / 64] & (1ull << (idx % 64));
+  }
+
+protected:
+  uint64_t key_;
+  std::vector<float> costs_;      // Cost and seconds of each edge, interleaved
+  std::vector<uint64_t> allowed_; // One bit per edge
+  std::vector<uint64_t> timed_;   // One bit per edge
+};
+
+/**
+ * The edge cost tables of a graph tile, a few of them so the most used costing options of a
+ * service each get one. Searches on several threads can share the tile, so tables are found
+ * without taking a lock and are only ever added, never replaced, until the tile is freed.
+ */
+class EdgeCostTables {
+public:
+  static constexpr uint32_t kMaxTables = 4;
+  // Number of distinct costing options the process hands out keys for
+  static constexpr uint32_t kMaxKeys = 1024;
+
+  /**
+   * Get the key of the tables for a costing and its options. Every distinct options string gets
+   * its own key for the life of the process, so two sets of options never share a table.
+   * @param  options  Costing and its serialized options.
+   * @return Returns the key, an even number so the lowest bit is free for the costing. 0 once
+   *         kMaxKeys sets of options have keys, requests with new options then use no tables.
+   */
+  static uint64_t key(const std::string& options) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, uint64_t> keys;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = keys.find(options);
+    if (found != keys.end()) {
+      return found->second;
+    }
+    if (keys.size() >= kMaxKeys) {
+      return 0;
+    }
+    uint64_t key = (keys.size() + 1) << 1;
+    keys.emplace(options, key);
+    return key;
+  }
+
+  EdgeCostTables() {
+    for (auto& table : tables_) {
+      table.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~EdgeCostTables() {
+    for (auto& table : tables_) {
+      delete table.load(std::memory_order_relaxed);
+    }
+  }
+
+  EdgeCostTables(const EdgeCostTables&) = delete;
+  EdgeCostTables& operator=(const EdgeCostTables&) = delete;
+
+  /**
+   * Find the table for a costing and its options.
+   * @param  key  Costing and options the costs are for.
+   * @return  Returns the table, nullptr if there is none yet.
+   */
+  const EdgeCostTable* find(const uint64_t key) const {
+    for (const auto& slot : tables_) {
+      const EdgeCostTable* table = slot.load(std::memory_order_acquire);
+      if (table == nullptr) {
+        return nullptr;
+      }
+      if (table->key() == key) {
+        return table;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Are all the slots taken. Costings with options that have no table then cost the edges of
+   * the tile as usual rather than build a table that can't be added.
+   * @return  Returns true if no more tables can be added.
+   */
+  bool full() const {
+    return tables_[kMaxTables - 1].load(std::memory_order_acquire) != nullptr;
+  }
+
+  /**
+   * Add a table unless another search already added one with its key.
+   * @param  table  The table.
+   * @return  Returns the table for the key, nullptr if all the slots are taken by other keys.
+   */
+  const EdgeCostTable* add(std::unique_ptr<EdgeCostTable> table) {
+    for (auto& slot : tables_) {
+      const EdgeCostTable* expected = nullptr;
+      if (slot.compare_exchange_strong(expected, table.get(), std::memory_order_acq_rel)) {
+        return table.release();
+      }
+      if (expected->key() == table->key()) {
+        return expected;
+      }
+    }
+    return nullptr;
+  }
+
+protected:
+  std::atomic<const EdgeCostTable*> tables_[kMaxTables];
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_EDGECOSTTABLE_H_
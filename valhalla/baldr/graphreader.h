@@ -1,10 +1,16 @@
 #ifndef VALHALLA_BALDR_GRAPHREADER_H_
 #define VALHALLA_BALDR_GRAPHREADER_H_
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <limits>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 #include <valhalla/baldr/curler.h>
@@ -71,6 +77,13 @@ public:
    *  Some implementations may simply clear the entire cache
    */
   virtual void Trim() = 0;
+
+  /**
+   * Lets the cache know the owner holds none of the tiles it got from it anymore, e.g. at
+   * the end of a request. Caches shared with other readers can then free what was evicted.
+   */
+  virtual void Release() {
+  }
 };
 
 /**
@@ -309,6 +322,304 @@ private:
   std::mutex& mutex_ref_;
 };
 
+/**
+ * Thread-safe tile cache meant to be shared by many GraphReaders. Tiles are spread over
+ * a number of shards, each of which keeps an open addressing table of atomic entry
+ * pointers. Lookups (Get/Contains) never take a lock, only Put and eviction lock a
+ * single shard. Eviction uses the CLOCK approximation of LRU so that a hit only has to
+ * set a flag rather than reorder a list.
+ *
+ * Evicted tiles are not freed right away. They are retired and only deleted once every
+ * active reader has passed a quiescent point (see Quiesce) after the eviction. This
+ * means a worker can keep using the tiles it got from the cache until it says it is
+ * done with them, regardless of what the other workers trigger in the meantime. Readers
+ * that hold no tiles (see Idle) don't keep anything alive, so a reader that sits unused
+ * doesn't stop the others from freeing memory. When no reader is active retired tiles are
+ * released at the next Put, Trim or Clear.
+ */
+class ShardedTileCache : public TileCache {
+public:
+  enum class MemoryLimitControl {
+    SOFT, // no eviction is done by the cache; should be triggered by clients
+    HARD, // strict memory control on every Put operation
+  };
+
+  /**
+   * Constructor.
+   * @param max_size     maximum size of the cache
+   * @param mem_control  strategy our cache will use to control its memory
+   * @param shard_count  number of shards, rounded up to a power of 2
+   */
+  ShardedTileCache(size_t max_size, MemoryLimitControl mem_control, size_t shard_count = 64);
+
+  /**
+   * Destructor.
+   */
+  ~ShardedTileCache() override;
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache. If the tile is already cached the
+   * existing copy is returned instead, so concurrent loads of a tile converge.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large. Tiles which were evicted but are still
+   * waiting on a reader to quiesce count towards the size of the cache.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Evicts the least recently used tiles until the cache fits its limit.
+   */
+  void Trim() override;
+
+  /**
+   * Registers a reader of the cache, idle until it quiesces.
+   * @return the id of the reader to use with Quiesce, Idle and UnregisterReader
+   */
+  size_t RegisterReader();
+
+  /**
+   * Unregisters a reader, it must not use any of the tiles it got from the cache anymore.
+   * @param reader  id of the reader as returned by RegisterReader
+   */
+  void UnregisterReader(size_t reader);
+
+  /**
+   * Marks a quiescent point of a reader, ie. it no longer holds any of the tile pointers
+   * it got from the cache before this call.
+   * @param reader  id of the reader as returned by RegisterReader
+   */
+  void Quiesce(size_t reader);
+
+  /**
+   * Marks a reader as holding none of the tile pointers it got from the cache, tiles evicted
+   * from then on are not kept alive for it. It has to quiesce before it gets tiles again.
+   * @param reader  id of the reader as returned by RegisterReader
+   */
+  void Idle(size_t reader);
+
+protected:
+  struct Entry {
+    Entry(const GraphId& id, const GraphTile& tile, size_t size)
+        : id(id), tile(tile), size(size), referenced(true) {
+    }
+    GraphId id;
+    GraphTile tile;
+    size_t size;
+    mutable std::atomic<bool> referenced;
+  };
+
+  // Open addressing table of entries, only ever replaced as a whole
+  struct Table {
+    explicit Table(size_t capacity);
+    size_t mask;
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::atomic<Table*> table{nullptr};
+    size_t live = 0;       // number of entries in the table
+    size_t tombstones = 0; // number of removed entries still occupying a slot
+    size_t hand = 0;       // position of the CLOCK hand in the table
+    std::vector<std::pair<uint64_t, Entry*>> retired_entries;
+    std::vector<std::pair<uint64_t, Table*>> retired_tables;
+  };
+
+  /**
+   * Finds the entry for a tile inside a shard without locking.
+   * @param shard  the shard to look into
+   * @param graphid  the graphid of the tile
+   * @return the entry or nullptr if the tile is not cached
+   */
+  const Entry* Find(const Shard& shard, const GraphId& graphid) const;
+
+  /**
+   * Rebuilds the shard table with the given capacity, the old table is retired.
+   * Must be called with the shard locked.
+   * @param shard  the shard to rebuild
+   * @param capacity  number of slots of the new table
+   */
+  void Rebuild(Shard& shard, size_t capacity);
+
+  /**
+   * Evicts entries from one shard following the CLOCK policy until either the given
+   * amount of bytes was freed or the shard has nothing left to evict.
+   * Must be called with the shard locked.
+   * @param shard  the shard to evict from
+   * @param bytes  size in bytes to evict from the shard
+   * @return bytes evicted from the shard
+   */
+  size_t Evict(Shard& shard, size_t bytes);
+
+  /**
+   * Evicts entries across all shards until the cache fits required_size more bytes.
+   * @param required_size  size in bytes that should be free in the cache
+   */
+  void TrimToFit(size_t required_size);
+
+  /**
+   * Deletes the retired entries and tables of a shard that no reader can still see.
+   * Must be called with the shard locked.
+   * @param shard  the shard to reclaim
+   */
+  void Reclaim(Shard& shard);
+
+  /**
+   * @return the smallest epoch any registered reader may still be looking at
+   */
+  uint64_t MinReaderEpoch() const;
+
+  static Entry* Tombstone() {
+    return reinterpret_cast<Entry*>(uintptr_t(1));
+  }
+
+  Shard& shard(const GraphId& graphid) const {
+    return shards_[Hash(graphid) & shard_mask_];
+  }
+
+  static uint64_t Hash(const GraphId& graphid) {
+    // murmur3 finalizer, tile ids are sequential so they need some mixing
+    uint64_t h = graphid.value;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  std::unique_ptr<Shard[]> shards_;
+  size_t shard_mask_;
+  std::atomic<size_t> shard_capacity_;
+
+  // Bytes held by cached tiles and by evicted tiles waiting to be reclaimed
+  std::atomic<size_t> cache_size_;
+  std::atomic<size_t> retired_size_;
+  size_t max_cache_size_;
+  MemoryLimitControl mem_control_;
+
+  // Where the next eviction across shards starts so all shards age evenly
+  std::atomic<size_t> shard_hand_;
+
+  // Epoch based reclamation, every retired item is stamped with the epoch it was
+  // retired in and a reader slot holds the epoch of its last quiescent point, kIdleReader
+  // when the reader holds no tiles and 0 when the slot is free
+  static constexpr uint64_t kIdleReader = std::numeric_limits<uint64_t>::max();
+  std::atomic<uint64_t> epoch_;
+  mutable std::mutex readers_mutex_;
+  std::deque<std::atomic<uint64_t>> readers_;
+};
+
+/**
+ * Per GraphReader handle on a ShardedTileCache. Registers itself as a reader of the
+ * shared cache, quiesces when it first hands out a tile and goes idle whenever the owner
+ * trims, clears or releases its cache, which is the point at which the tile pointers it
+ * handed out were invalidated anyway. A reader that isn't used keeps no evicted tiles alive.
+ * It is thread-safe.
+ */
+class ShardedTileCacheReader : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param cache  the shared cache to read from
+   */
+  ShardedTileCacheReader(const std::shared_ptr<ShardedTileCache>& cache);
+
+  /**
+   * Destructor.
+   */
+  ~ShardedTileCacheReader() override;
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   *  Does its best to reduce the cache size to remove overcommitted state.
+   */
+  void Trim() override;
+
+  /**
+   * Goes idle, the owner holds none of the tiles it got from the cache anymore.
+   */
+  void Release() override;
+
+private:
+  // Quiesce before handing out the first tile since going idle
+  void Activate() const;
+
+  std::shared_ptr<ShardedTileCache> cache_;
+  size_t reader_;
+  mutable std::atomic<bool> active_;
+};
+
 /**
  * Creates tile caches.
  */
@@ -400,6 +711,15 @@ public:
     cache_->Trim();
   }
 
+  /**
+   * Lets the tile cache know none of the tiles this reader handed out are used anymore, e.g.
+   * at the end of a request. A cache shared with other readers then no longer keeps the
+   * tiles evicted from it alive for this one.
+   */
+  void Release() {
+    cache_->Release();
+  }
+
   /**
    * Returns the maximum number of threads that can
    * use the reader concurrently without blocking
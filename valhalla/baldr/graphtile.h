@@ -8,6 +8,7 @@
 #include <valhalla/baldr/curler.h>
 #include <valhalla/baldr/datetime.h>
 #include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/edgecosttable.h>
 #include <valhalla/baldr/edgeinfo.h>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/baldr/graphid.h>
@@ -18,6 +19,7 @@
 #include <valhalla/baldr/predictedspeeds.h>
 #include <valhalla/baldr/sign.h>
 #include <valhalla/baldr/signinfo.h>
+#include <valhalla/baldr/traffictile.h>
 #include <valhalla/baldr/transitdeparture.h>
 #include <valhalla/baldr/transitroute.h>
 #include <valhalla/baldr/transitschedule.h>
@@ -180,6 +182,30 @@ public:
         " directededgecount= " + std::to_string(header_->directededgecount()));
   }
 
+  /**
+   * Get the index of a directed edge within the tile.
+   * @param  de  Directed edge of this tile.
+   * @return Returns the index of the directed edge.
+   */
+  uint32_t directededge_index(const DirectedEdge* de) const {
+    return de - directededges_;
+  }
+
+  /**
+   * Does a directed edge lie in the directed edges of this tile. Tiles of different graph
+   * readers or of neighboring ids are elsewhere in memory, so use this before relying on
+   * directededge_index for an edge that may come from another tile.
+   * @param  de  Directed edge.
+   * @return Returns true if the edge is one of the directed edges of this tile.
+   */
+  bool has_directededge(const DirectedEdge* de) const {
+    auto address = reinterpret_cast<uintptr_t>(de);
+    auto first = reinterpret_cast<uintptr_t>(directededges_);
+    return address >= first &&
+           address < first + header_->directededgecount() * sizeof(DirectedEdge) &&
+           (address - first) % sizeof(DirectedEdge) == 0;
+  }
+
   /**
    * Get a pointer to a edge.
    * @param  idx  Index of the directed edge within the current tile.
@@ -475,77 +501,79 @@ public:
   /**
    * Convenience method to get the speed for an edge given the directed
    * edge and a time (seconds since start of the week).
-   * @param  de            Directed edge information.
-   * @param  traffic_mask  A mask denoting which types of traffic data should be used to get the speed
-   * @param  seconds       Seconds of the week since midnight (ie Monday morning). Defaults to noon
-   *                       Monday. Note that for free and constrained flow there is no concept of a
-   *                       week so we modulus the time to day based seconds
-   * @param  flow_sources  Which speed sources were used in this speed calculation. Optional pointer,
-   *                       if nullptr is passed in flow_sources does nothing.
+   * @param  de                Directed edge information.
+   * @param  traffic_mask      A mask denoting which types of traffic data should be used to get
+   *                           the speed
+   * @param  seconds           Seconds of the week since midnight (ie Monday morning). Defaults to
+   *                           noon Monday. Note that for free and constrained flow there is no
+   *                           concept of a week so we modulus the time to day based seconds
+   * @param  flow_sources      Which speed sources were used in this speed calculation. Optional
+   *                           pointer, if nullptr is passed in flow_sources does nothing.
+   * @param  seconds_from_now  Seconds from the start of the request to the edge. The live speed
+   *                           fades into the other speeds over kLiveSpeedFadeSeconds.
+   * @param  speed_cache       Decoded predicted speeds of the search. Optional, if nullptr is
+   *                           passed in predicted speeds are decoded every time.
    * @return Returns the speed for the edge.
    */
   inline uint32_t GetSpeed(const DirectedEdge* de,
                            uint8_t flow_mask = kConstrainedFlowMask,
                            uint32_t seconds = kInvalidSecondsOfWeek,
-                           uint8_t* flow_sources = nullptr) const {
+                           uint8_t* flow_sources = nullptr,
+                           uint32_t seconds_from_now = 0,
+                           DecodedSpeedCache* speed_cache = nullptr) const {
     // if they dont want source info we bind it to a temp and no one will miss it
     uint8_t temp_sources;
     if (!flow_sources)
       flow_sources = &temp_sources;
     *flow_sources = kNoFlowMask;
 
-    // TODO: current with coefficient based on distance in time from start of route
-
-    // use predicted speed if a time was passed in, the predicted speed layer was requested, and if
-    // the edge has predicted speed
-    auto invalid_time = seconds == kInvalidSecondsOfWeek;
-    if (!invalid_time && (flow_mask & kPredictedFlowMask) && de->has_predicted_speed()) {
-      seconds %= midgard::kSecondsPerWeek;
-      uint32_t idx = de - directededges_;
-      float speed = predictedspeeds_.speed(idx, seconds);
-      if (valid_speed(speed)) {
-        *flow_sources |= kPredictedFlowMask;
-        return static_cast<uint32_t>(speed + .5f);
+    // use the live speed if the current flow layer was requested and the edge has one. the further
+    // the edge is from the start of the request the more it is blended with the other speeds
+    if ((flow_mask & kCurrentFlowMask) && seconds_from_now < kLiveSpeedFadeSeconds) {
+      auto live = traffic_tile_.speed(de - directededges_);
+      if (live.valid()) {
+        *flow_sources |= kCurrentFlowMask;
+        if (seconds_from_now == 0) {
+          return live.speed;
+        }
+        float live_weight = 1.0f - static_cast<float>(seconds_from_now) / kLiveSpeedFadeSeconds;
+        uint32_t speed = GetStoredSpeed(de, flow_mask, seconds, flow_sources, speed_cache);
+        return static_cast<uint32_t>(live_weight * live.speed + (1.0f - live_weight) * speed + .5f);
       }
-#ifdef LOGGING_LEVEL_TRACE
-      else
-        LOG_TRACE("Predicted speed = " + std::to_string(speed) + " for edge index: " +
-                  std::to_string(idx) + " of tile: " + std::to_string(header_->graphid()));
-#endif
     }
+    return GetStoredSpeed(de, flow_mask, seconds, flow_sources, speed_cache);
+  }
 
-    // fallback to constrained if time of week is within 7am to 7pm (or if no time was passed in) and
-    // if the edge has constrained speed
-    seconds %= midgard::kSecondsPerDay;
-    auto is_daytime = (25200 < seconds && seconds < 68400);
-    if ((invalid_time || is_daytime) && (flow_mask & kConstrainedFlowMask) &&
-        valid_speed(de->constrained_flow_speed())) {
-      *flow_sources |= kConstrainedFlowMask;
-      return de->constrained_flow_speed();
-    }
-#ifdef LOGGING_LEVEL_TRACE
-    else if (de->constrained_flow_speed() != 0)
-      LOG_TRACE("Constrained flow speed = " + std::to_string(de->constrained_flow_speed()) +
-                " for edge index: " + std::to_string(de - directededges_) +
-                " of tile: " + std::to_string(header_->graphid()));
-#endif
+  /**
+   * Get the live traffic speeds of the tile.
+   * @return  Returns the live traffic, empty if there is none for the tile.
+   */
+  const TrafficTile& traffic_tile() const {
+    return traffic_tile_;
+  }
 
-    // fallback to freeflow if time of week is not within 7am to 7pm (or if no time was passed in) and
-    // the edge has freeflow speed
-    if ((invalid_time || !is_daytime) && (flow_mask & kFreeFlowMask) &&
-        valid_speed(de->free_flow_speed())) {
-      *flow_sources |= kFreeFlowMask;
-      return de->free_flow_speed();
-    }
-#ifdef LOGGING_LEVEL_TRACE
-    else if (de->free_flow_speed() != 0)
-      LOG_TRACE("Freeflow speed = " + std::to_string(de->constrained_flow_speed()) +
-                " for edge index: " + std::to_string(de - directededges_) +
-                " of tile: " + std::to_string(header_->graphid()));
-#endif
+  /**
+   * Set the live traffic speeds of the tile.
+   * @param  traffic_tile  Live traffic speeds for the directed edges of this tile.
+   */
+  void set_traffic_tile(const TrafficTile& traffic_tile) {
+    traffic_tile_ = traffic_tile;
+  }
 
-    // Fallback further to specified or derived speed
-    return de->speed();
+  /**
+   * Get the edge cost tables costings keep with the tile. They are freed along with the tile.
+   * @return  Returns the tables, nullptr for a tile without data or without edge costs.
+   */
+  EdgeCostTables* edge_costs() const {
+    return edge_costs_.get();
+  }
+
+  /**
+   * Keep no edge cost tables with the tile, for tiles that are never freed and so would keep
+   * their tables for the life of the process outside of any cache limit.
+   */
+  void drop_edge_costs() {
+    edge_costs_.reset();
   }
 
   /**
@@ -655,6 +683,12 @@ protected:
   // Predicted speeds
   PredictedSpeeds predictedspeeds_;
 
+  // Live traffic speeds, updated in place by another process
+  TrafficTile traffic_tile_;
+
+  // Edge costs of the costings that expanded the tile, shared by the copies of the tile
+  std::shared_ptr<EdgeCostTables> edge_costs_;
+
   // Map of stop one stops in this tile.
   std::unordered_map<std::string, GraphId> stop_one_stops;
 
@@ -664,6 +698,84 @@ protected:
   // Map of operator one stops in this tile.
   std::unordered_map<std::string, std::list<GraphId>> oper_one_stops;
 
+  /**
+   * Get the speed for an edge from the speeds stored in the tile at build time
+   * (predicted, constrained and free flow) or the edge itself.
+   * @param  de            Directed edge information.
+   * @param  flow_mask     A mask denoting which types of traffic data should be used
+   * @param  seconds       Seconds of the week since midnight
+   * @param  flow_sources  Which speed sources were used, added to
+   * @param  speed_cache   Decoded predicted speeds of the search, may be nullptr
+   * @return Returns the speed for the edge.
+   */
+  inline uint32_t GetStoredSpeed(const DirectedEdge* de,
+                                 uint8_t flow_mask,
+                                 uint32_t seconds,
+                                 uint8_t* flow_sources,
+                                 DecodedSpeedCache* speed_cache) const {
+    // use predicted speed if a time was passed in, the predicted speed layer was requested, and if
+    // the edge has predicted speed
+    auto invalid_time = seconds == kInvalidSecondsOfWeek;
+    if (!invalid_time && (flow_mask & kPredictedFlowMask) && de->has_predicted_speed()) {
+      seconds %= midgard::kSecondsPerWeek;
+      uint32_t idx = de - directededges_;
+      float speed;
+      if (speed_cache == nullptr) {
+        speed = predictedspeeds_.speed(idx, seconds);
+      } else {
+        GraphId edgeid = header_->graphid();
+        edgeid.set_id(idx);
+        uint32_t bucket = seconds / kSpeedBucketSizeSeconds;
+        if (!speed_cache->get(edgeid, bucket, speed)) {
+          speed = predictedspeeds_.speed(idx, seconds);
+          speed_cache->put(edgeid, bucket, speed);
+        }
+      }
+      if (valid_speed(speed)) {
+        *flow_sources |= kPredictedFlowMask;
+        return static_cast<uint32_t>(speed + .5f);
+      }
+#ifdef LOGGING_LEVEL_TRACE
+      else
+        LOG_TRACE("Predicted speed = " + std::to_string(speed) + " for edge index: " +
+                  std::to_string(idx) + " of tile: " + std::to_string(header_->graphid()));
+#endif
+    }
+
+    // fallback to constrained if time of week is within 7am to 7pm (or if no time was passed in) and
+    // if the edge has constrained speed
+    seconds %= midgard::kSecondsPerDay;
+    auto is_daytime = (25200 < seconds && seconds < 68400);
+    if ((invalid_time || is_daytime) && (flow_mask & kConstrainedFlowMask) &&
+        valid_speed(de->constrained_flow_speed())) {
+      *flow_sources |= kConstrainedFlowMask;
+      return de->constrained_flow_speed();
+    }
+#ifdef LOGGING_LEVEL_TRACE
+    else if (de->constrained_flow_speed() != 0)
+      LOG_TRACE("Constrained flow speed = " + std::to_string(de->constrained_flow_speed()) +
+                " for edge index: " + std::to_string(de - directededges_) +
+                " of tile: " + std::to_string(header_->graphid()));
+#endif
+
+    // fallback to freeflow if time of week is not within 7am to 7pm (or if no time was passed in) and
+    // the edge has freeflow speed
+    if ((invalid_time || !is_daytime) && (flow_mask & kFreeFlowMask) &&
+        valid_speed(de->free_flow_speed())) {
+      *flow_sources |= kFreeFlowMask;
+      return de->free_flow_speed();
+    }
+#ifdef LOGGING_LEVEL_TRACE
+    else if (de->free_flow_speed() != 0)
+      LOG_TRACE("Freeflow speed = " + std::to_string(de->constrained_flow_speed()) +
+                " for edge index: " + std::to_string(de - directededges_) +
+                " of tile: " + std::to_string(header_->graphid()));
+#endif
+
+    // Fallback further to specified or derived speed
+    return de->speed();
+  }
+
   /**
    * Set pointers to internal tile data structures.
    * @param  graphid    Graph Id for the tile.
@@ -0,0 +1,181 @@
+#ifndef VALHALLA_BALDR_JSON_WRITER_H_
+#define VALHALLA_BALDR_JSON_WRITER_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include <boost/variant.hpp>
+
+#include <valhalla/baldr/json.h>
+#include <valhalla/baldr/rapidjson_utils.h>
+
+namespace valhalla {
+namespace baldr {
+namespace json {
+
+/**
+ * Writes json straight into a buffer as it is produced rather than building up a tree of Jmap and
+ * Jarray first. Large responses (matrices, isochrones, heights) are made of millions of values and
+ * the tree costs a few allocations for each of them. Values are written the same way the tree
+ * would print them, in particular fp_t keeps its fixed number of decimal places.
+ *
+ * Calls must nest properly: inside an object use the key/value overloads, inside an array or at
+ * the top level the value only ones.
+ */
+class writer_t {
+public:
+  /**
+   * @param reserve  the number of bytes to reserve for the output up front
+   */
+  explicit writer_t(size_t reserve = kDefaultReserve)
+      : buffer_(nullptr, reserve), writer_(buffer_) {
+  }
+
+  writer_t(const writer_t&) = delete;
+  writer_t& operator=(const writer_t&) = delete;
+
+  // objects and arrays, either as a value or as the value of a key of the enclosing object
+  void start_object() {
+    writer_.StartObject();
+  }
+  void start_object(const std::string& key) {
+    write_key(key);
+    writer_.StartObject();
+  }
+  void end_object() {
+    writer_.EndObject();
+  }
+  void start_array() {
+    writer_.StartArray();
+  }
+  void start_array(const std::string& key) {
+    write_key(key);
+    writer_.StartArray();
+  }
+  void end_array() {
+    writer_.EndArray();
+  }
+
+  // values
+  void operator()(const std::string& value) {
+    writer_.String(value.c_str(), static_cast<rapidjson::SizeType>(value.size()));
+  }
+  void operator()(const char* value) {
+    writer_.String(value);
+  }
+  void operator()(bool value) {
+    writer_.Bool(value);
+  }
+  void operator()(std::nullptr_t) {
+    writer_.Null();
+  }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                          !std::is_same<T, bool>::value>::type
+  operator()(T value) {
+    writer_.Uint64(value);
+  }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+  operator()(T value) {
+    writer_.Int64(value);
+  }
+  // doubles need a precision, use fp_t
+  template <typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type operator()(T value) = delete;
+  void operator()(const fp_t& value) {
+    // non finite values are not numbers in json so they go out as strings like the tree does
+    int length = std::snprintf(number_, sizeof(number_), "%.*Lf", static_cast<int>(value.precision),
+                               value.value);
+    if (length < 0 || length >= static_cast<int>(sizeof(number_))) {
+      // far too big to be useful but say the same thing the tree would
+      std::ostringstream stream;
+      stream << value;
+      auto number = stream.str();
+      writer_.RawValue(number.c_str(), number.size(), rapidjson::kNumberType);
+    } else if (std::isfinite(value.value)) {
+      writer_.RawValue(number_, length, rapidjson::kNumberType);
+    } else {
+      writer_.String(number_, length);
+    }
+  }
+  // a piece of a json tree, for the parts of a response that are shared with the tree serializers
+  void operator()(const Value& value) {
+    tree_visitor_t visitor(*this);
+    value.apply_visitor(visitor);
+  }
+
+  // key value pairs within an object
+  template <typename T> void operator()(const std::string& key, const T& value) {
+    write_key(key);
+    (*this)(value);
+  }
+
+  /**
+   * @return the json written so far
+   */
+  std::string get() const {
+    return std::string(buffer_.GetString(), buffer_.GetSize());
+  }
+
+  /**
+   * @return the number of bytes written so far
+   */
+  size_t size() const {
+    return buffer_.GetSize();
+  }
+
+  static constexpr size_t kDefaultReserve = 64 * 1024;
+
+protected:
+  void write_key(const std::string& key) {
+    writer_.Key(key.c_str(), static_cast<rapidjson::SizeType>(key.size()));
+  }
+
+  // writes the parts of a tree
+  struct tree_visitor_t : public boost::static_visitor<> {
+    explicit tree_visitor_t(writer_t& writer) : writer(writer) {
+    }
+    template <typename T> void operator()(const T& value) const {
+      writer(value);
+    }
+    void operator()(const MapPtr& map) const {
+      if (!map) {
+        writer(nullptr);
+        return;
+      }
+      writer.start_object();
+      for (const auto& key_value : *map) {
+        writer.write_key(key_value.first);
+        key_value.second.apply_visitor(*this);
+      }
+      writer.end_object();
+    }
+    void operator()(const ArrayPtr& array) const {
+      if (!array) {
+        writer(nullptr);
+        return;
+      }
+      writer.start_array();
+      for (const auto& element : *array) {
+        element.apply_visitor(*this);
+      }
+      writer.end_array();
+    }
+    writer_t& writer;
+  };
+
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+  char number_[64];
+};
+
+} // namespace json
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_JSON_WRITER_H_
@@ -0,0 +1,192 @@
+#ifndef VALHALLA_BALDR_LANDMARKS_H_
+#define VALHALLA_BALDR_LANDMARKS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphconstants.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace baldr {
+
+// The costings landmark tables can be built for, each one is stored in <name>.landmarks and
+// holds the network distances over the edges the access mode of the costing may use
+const std::vector<std::pair<std::string, uint32_t>> kLandmarkCostings = {
+    {"auto", kAutoAccess},           {"pedestrian", kPedestrianAccess},
+    {"bicycle", kBicycleAccess},     {"truck", kTruckAccess},
+    {"taxi", kTaxiAccess},           {"bus", kBusAccess},
+    {"hov", kHOVAccess},             {"wheelchair", kWheelchairAccess},
+    {"motor_scooter", kMopedAccess}, {"motorcycle", kMotorcycleAccess},
+};
+
+// Start of a landmark table file
+struct LandmarkHeader {
+  char magic[8];           // kLandmarkMagic
+  uint32_t version;        // kLandmarkVersion
+  uint32_t access;         // Access mode the distances were computed for
+  uint32_t landmark_count; // Number of landmarks
+  uint32_t tile_count;     // Number of tiles with nodes in the table
+  uint64_t node_count;     // Number of nodes (rows) in the table
+};
+
+// Where the nodes of a graph tile are in a landmark table
+struct LandmarkTile {
+  uint64_t tile;       // Tile value (level and tile id) of the tile
+  uint64_t first_row;  // Row of the first node of the tile
+  uint32_t node_count; // Number of nodes in the tile
+  uint32_t spare;
+};
+
+constexpr char kLandmarkMagic[8] = {'v', 'a', 'l', 'h', 'l', 'm', 'k', '\0'};
+constexpr uint32_t kLandmarkVersion = 1;
+
+/**
+ * Network distances (meters) between a few landmark nodes and every node of the graph for one
+ * access mode. By the triangle inequality they give a lower bound on the distance between any
+ * two nodes which is usually far tighter than the straight line distance, see ALT (A*,
+ * landmarks, triangle inequality) by Goldberg and Harrelson.
+ *
+ * The file is a LandmarkHeader, tile_count LandmarkTiles, landmark_count landmark GraphId values
+ * and then a row per node. A row holds landmark_count distances from each landmark to the node
+ * followed by landmark_count distances from the node to each landmark, kUnreached where there is
+ * no path. The file is memory mapped so processes serving the same tables share them.
+ */
+class LandmarkTable {
+public:
+  static constexpr uint32_t kUnreached = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Maps the table in the file.
+   * @param file_name  the landmark table
+   * @throws std::runtime_error if the file can't be read or isn't a landmark table
+   */
+  explicit LandmarkTable(const std::string& file_name);
+
+  /**
+   * Writes a table to a file.
+   * @param file_name  the file to write
+   * @param access     the access mode the distances were computed for
+   * @param landmarks  the landmark nodes
+   * @param tiles      the tiles in the order their rows are in
+   * @param rows       2 * landmarks.size() distances per node
+   */
+  static void Write(const std::string& file_name,
+                    const uint32_t access,
+                    const std::vector<GraphId>& landmarks,
+                    const std::vector<LandmarkTile>& tiles,
+                    const std::vector<uint32_t>& rows);
+
+  /**
+   * @return the access mode the distances were computed for
+   */
+  uint32_t access() const {
+    return header_->access;
+  }
+
+  /**
+   * @return the number of landmarks
+   */
+  uint32_t landmark_count() const {
+    return header_->landmark_count;
+  }
+
+  /**
+   * @return the number of nodes in the table
+   */
+  uint64_t node_count() const {
+    return header_->node_count;
+  }
+
+  /**
+   * @return the landmark nodes
+   */
+  std::vector<GraphId> landmarks() const;
+
+  /**
+   * Get the row of a node.
+   * @param  node  the node
+   * @return the distances from the landmarks to the node followed by the distances from the node
+   *         to the landmarks, nullptr if the node is not in the table
+   */
+  const uint32_t* distances(const GraphId& node) const {
+    auto tile = tiles_.find(node.tile_value());
+    if (tile == tiles_.cend() || node.id() >= tile->second.second) {
+      return nullptr;
+    }
+    return rows_ + (tile->second.first + node.id()) * 2 * header_->landmark_count;
+  }
+
+  /**
+   * Lower bound on the network distance from one node to another. For each landmark L the
+   * distance from a to b is at least d(L,b) - d(L,a) and d(a,L) - d(b,L).
+   * @param  from  the row of the node the path starts at
+   * @param  to    the row of the node the path ends at
+   * @return the lower bound in meters, 0 if the landmarks say nothing
+   */
+  uint32_t LowerBound(const uint32_t* from, const uint32_t* to) const {
+    int64_t bound = 0;
+    const uint32_t count = header_->landmark_count;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (from[i] != kUnreached && to[i] != kUnreached) {
+        bound = std::max(bound, static_cast<int64_t>(to[i]) - from[i]);
+      }
+    }
+    for (uint32_t i = count; i < 2 * count; ++i) {
+      if (from[i] != kUnreached && to[i] != kUnreached) {
+        bound = std::max(bound, static_cast<int64_t>(from[i]) - to[i]);
+      }
+    }
+    return static_cast<uint32_t>(bound);
+  }
+
+protected:
+  midgard::mem_map<char> mm_;
+  const LandmarkHeader* header_;
+  const uint32_t* rows_;
+  // tile value to the first row and node count of the tile
+  std::unordered_map<uint32_t, std::pair<uint64_t, uint32_t>> tiles_;
+};
+
+/**
+ * The landmark tables in a directory, by access mode.
+ */
+class Landmarks {
+public:
+  /**
+   * Loads the tables of the known costings (kLandmarkCostings) found in the directory.
+   * @param dir  the directory the landmark tables were built into
+   */
+  explicit Landmarks(const std::string& dir);
+
+  /**
+   * @param  access  the access mode of a costing
+   * @return the table for the access mode, nullptr if there is none
+   */
+  const LandmarkTable* get(const uint32_t access) const {
+    auto table = tables_.find(access);
+    return table == tables_.cend() ? nullptr : table->second.get();
+  }
+
+  /**
+   * @return true if no tables were found
+   */
+  bool empty() const {
+    return tables_.empty();
+  }
+
+protected:
+  std::unordered_map<uint32_t, std::unique_ptr<LandmarkTable>> tables_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_LANDMARKS_H_
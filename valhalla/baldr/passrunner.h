@@ -0,0 +1,80 @@
+#ifndef VALHALLA_BALDR_PASSRUNNER_H_
+#define VALHALLA_BALDR_PASSRUNNER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <valhalla/baldr/graphreader.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Runs passes of tasks on the calling thread plus a set of helper threads, each
+ * with its own graph reader. The helpers are started once per request and wait
+ * for the next pass in between, since a request may run thousands of short passes.
+ */
+class PassRunner {
+public:
+  using task_t = std::function<void(GraphReader&, const uint32_t)>;
+
+  /**
+   * Constructor. Starts a helper thread per helper reader.
+   * @param  reader          Graph reader of the calling thread.
+   * @param  helper_readers  Graph readers of the helper threads.
+   */
+  PassRunner(GraphReader& reader, const std::vector<std::shared_ptr<GraphReader>>& helper_readers);
+
+  /**
+   * Destructor. Stops and joins the helper threads.
+   */
+  ~PassRunner();
+
+  PassRunner(const PassRunner&) = delete;
+  PassRunner& operator=(const PassRunner&) = delete;
+
+  /**
+   * Runs the task for each index below count, spread over the threads, and
+   * returns once all of them are done. Rethrows the first exception a task threw.
+   * @param  count  Number of tasks.
+   * @param  task   Task taking the graph reader of the thread running it and its index.
+   */
+  void Run(const uint32_t count, const task_t& task);
+
+  /**
+   * Get the number of threads running the tasks, including the calling thread.
+   * @return Returns the number of threads.
+   */
+  size_t thread_count() const {
+    return threads_.size() + 1;
+  }
+
+private:
+  void Work(GraphReader& reader);
+  void Help(GraphReader& reader);
+
+  GraphReader& reader_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const task_t* task_;
+  uint32_t count_;
+  std::atomic<uint32_t> next_;
+  size_t running_;
+  uint64_t pass_;
+  bool stop_;
+  std::exception_ptr error_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_PASSRUNNER_H_
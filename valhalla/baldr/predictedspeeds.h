@@ -1,9 +1,17 @@
 #ifndef VALHALLA_BALDR_PREDICTEDSPEEDS_H_
 #define VALHALLA_BALDR_PREDICTEDSPEEDS_H_
 
+#include <valhalla/baldr/graphid.h>
 #include <valhalla/midgard/util.h>
+#include <algorithm>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace valhalla {
 namespace baldr {
 
@@ -60,6 +68,62 @@ private:
   float table_[kCosBucketTableSize];
 };
 
+/**
+ * DCT-III dot product of the compressed speed profile of an edge with the cos
+ * values of a bucket, without the speed normalization. Plain loop used where
+ * there is no vector instruction set to use and to check the vectorized one.
+ * @param  coefficients  Compressed speed profile (kCoefficientCount values).
+ * @param  b             Precomputed cos values of the bucket.
+ */
+inline float decode_speed_scalar(const int16_t* coefficients, const float* b) {
+  float speed = *coefficients * k1OverSqrt2;
+  ++coefficients;
+  ++b;
+  for (uint32_t k = 1; k < kCoefficientCount; ++k, ++coefficients, ++b) {
+    speed += *coefficients * *b;
+  }
+  return speed;
+}
+
+/**
+ * DCT-III dot product of the compressed speed profile of an edge with the cos
+ * values of a bucket, using AVX2 when the build targets it and otherwise SSE2,
+ * which every x86-64 cpu has. The first cos value of every bucket is
+ * cos(0) = 1 so all the terms are summed the same way and the first one is
+ * scaled by 1 / sqrt(2) afterwards.
+ * @param  coefficients  Compressed speed profile (kCoefficientCount values).
+ * @param  b             Precomputed cos values of the bucket.
+ */
+inline float decode_speed(const int16_t* coefficients, const float* b) {
+  static_assert(kCoefficientCount % 8 == 0, "Coefficients must fill whole vectors");
+#if defined(__AVX2__)
+  __m256 sum = _mm256_setzero_ps();
+  for (uint32_t k = 0; k < kCoefficientCount; k += 8) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + k));
+    __m256 cf = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(c));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(cf, _mm256_loadu_ps(b + k)));
+  }
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+#elif defined(__SSE2__)
+  // sign extend by putting each coefficient in the upper half of a 32 bit lane and shifting down
+  __m128 sum4 = _mm_setzero_ps();
+  for (uint32_t k = 0; k < kCoefficientCount; k += 8) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + k));
+    __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16));
+    __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16));
+    sum4 = _mm_add_ps(sum4, _mm_mul_ps(lo, _mm_loadu_ps(b + k)));
+    sum4 = _mm_add_ps(sum4, _mm_mul_ps(hi, _mm_loadu_ps(b + k + 4)));
+  }
+#else
+  return decode_speed_scalar(coefficients, b);
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+  return _mm_cvtss_f32(sum4) + *coefficients * (k1OverSqrt2 - 1.0f);
+#endif
+}
+
 /**
  * Class to access predicted speed information within a tile.
  */
@@ -104,13 +168,7 @@ public:
     const float* b = BucketCosTable::GetInstance().get(seconds_of_week / kSpeedBucketSizeSeconds);
 
     // DCT-III with speed normalization
-    float speed = *coefficients * k1OverSqrt2;
-    ++coefficients;
-    ++b;
-    for (uint32_t k = 1; k < kCoefficientCount; ++k, ++coefficients, ++b) {
-      speed += *coefficients * *b;
-    }
-    return speed * kSpeedNormalization;
+    return decode_speed(coefficients, b) * kSpeedNormalization;
   }
 
 protected:
@@ -119,6 +177,88 @@ protected:
   const int16_t* profiles_; // Compressed speed profiles
 };
 
+// Number of entries of a decoded speed cache
+constexpr uint32_t kDecodedSpeedCacheBits = 12;
+constexpr uint32_t kDecodedSpeedCacheSize = 1 << kDecodedSpeedCacheBits;
+
+/**
+ * Small cache of decoded predicted speeds keyed by directed edge and 5 minute
+ * bucket. A search tends to decode the speed of the same edge at the same
+ * time of the week over and over (the edge is reached from several
+ * predecessors, or by the forward and reverse searches) so each search keeps
+ * one of these. It is direct mapped: an entry is simply replaced by the next
+ * edge and bucket landing in the same slot. It is not thread safe.
+ */
+class DecodedSpeedCache {
+public:
+  /**
+   * Constructor. The entries are only allocated once a speed is added, so
+   * searches that never decode a speed do not pay for the cache.
+   */
+  DecodedSpeedCache() = default;
+
+  /**
+   * Get a decoded speed.
+   * @param  edgeid  Directed edge Id.
+   * @param  bucket  5 minute bucket of the week.
+   * @param  speed   Set to the cached speed if there is one.
+   * @return Returns true if the speed was in the cache.
+   */
+  bool get(const GraphId& edgeid, const uint32_t bucket, float& speed) const {
+    if (entries_.empty()) {
+      return false;
+    }
+    const uint64_t key = make_key(edgeid, bucket);
+    const Entry& entry = entries_[slot(key)];
+    if (entry.key != key) {
+      return false;
+    }
+    speed = entry.speed;
+    return true;
+  }
+
+  /**
+   * Add a decoded speed, replacing whatever was in its slot.
+   * @param  edgeid  Directed edge Id.
+   * @param  bucket  5 minute bucket of the week.
+   * @param  speed   Decoded speed.
+   */
+  void put(const GraphId& edgeid, const uint32_t bucket, const float speed) {
+    if (entries_.empty()) {
+      entries_.resize(kDecodedSpeedCacheSize, {kInvalidKey, 0.0f});
+    }
+    const uint64_t key = make_key(edgeid, bucket);
+    entries_[slot(key)] = {key, speed};
+  }
+
+  /**
+   * Remove all the cached speeds.
+   */
+  void clear() {
+    std::fill(entries_.begin(), entries_.end(), Entry{kInvalidKey, 0.0f});
+  }
+
+protected:
+  static constexpr uint64_t kInvalidKey = ~uint64_t(0);
+
+  struct Entry {
+    uint64_t key;
+    float speed;
+  };
+
+  // Edge Ids use the lower 46 bits and there are fewer than 2048 buckets
+  static uint64_t make_key(const GraphId& edgeid, const uint32_t bucket) {
+    return (edgeid.value << 11) | bucket;
+  }
+
+  // Fibonacci hashing so that nearby edges and buckets spread over the slots
+  static uint32_t slot(const uint64_t key) {
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - kDecodedSpeedCacheBits));
+  }
+
+  std::vector<Entry> entries_;
+};
+
 } // namespace baldr
 } // namespace valhalla
 
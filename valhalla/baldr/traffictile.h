@@ -0,0 +1,130 @@
+#ifndef VALHALLA_BALDR_TRAFFICTILE_H_
+#define VALHALLA_BALDR_TRAFFICTILE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace valhalla {
+namespace baldr {
+
+// Live speeds are blended into the other speeds of an edge for this long after
+// the start of a request, from there on they are not used at all
+constexpr uint32_t kLiveSpeedFadeSeconds = 3600;
+
+// A live speed of 0 means there is no live speed for the edge
+constexpr uint32_t kUnknownTrafficSpeed = 0;
+
+/**
+ * Live speed of a directed edge. It is 32 bits so that the process updating
+ * the traffic tiles can write it in place with a single aligned store, readers
+ * never see a partly written speed.
+ */
+struct TrafficSpeed {
+  uint32_t speed : 8;  // Speed in kph
+  uint32_t spare : 24; // Not used yet, keep 0
+
+  bool valid() const {
+    return speed != kUnknownTrafficSpeed;
+  }
+};
+static_assert(sizeof(TrafficSpeed) == sizeof(uint32_t), "TrafficSpeed must be 32 bits");
+
+/**
+ * Header of a live traffic tile. It is followed by one TrafficSpeed per
+ * directed edge of the graph tile with the same id, in directed edge order.
+ */
+struct TrafficTileHeader {
+  uint64_t tile_id;             // Graph Id of the tile
+  uint64_t last_update;         // Time of the last update (seconds since epoch)
+  uint32_t directed_edge_count; // Number of speeds that follow
+  uint32_t spare;               // Not used yet, keep 0
+};
+
+/**
+ * Live traffic speeds of the directed edges of a graph tile. The speeds live
+ * in memory that is shared with another process which updates them in place,
+ * so they are read through volatile pointers and an update is seen by the
+ * very next lookup without reloading any tile.
+ */
+class TrafficTile {
+public:
+  /**
+   * Constructor for a tile without live traffic.
+   */
+  TrafficTile() : header_(nullptr), speeds_(nullptr) {
+  }
+
+  /**
+   * Constructor given the memory of a traffic tile.
+   * @param  ptr   Pointer to the start of the traffic tile.
+   * @param  size  Size in bytes of the traffic tile.
+   */
+  TrafficTile(char* ptr, const size_t size) {
+    if (size < sizeof(TrafficTileHeader)) {
+      throw std::runtime_error("Traffic tile of " + std::to_string(size) +
+                               " bytes is smaller than its header");
+    }
+    header_ = reinterpret_cast<volatile TrafficTileHeader*>(ptr);
+    speeds_ = reinterpret_cast<volatile uint32_t*>(ptr + sizeof(TrafficTileHeader));
+    if (size < sizeof(TrafficTileHeader) + header_->directed_edge_count * sizeof(TrafficSpeed)) {
+      throw std::runtime_error("Traffic tile of " + std::to_string(size) +
+                               " bytes is too small for " +
+                               std::to_string(header_->directed_edge_count) + " speeds");
+    }
+  }
+
+  /**
+   * Is there live traffic for the tile.
+   * @return  Returns true if there are no live speeds.
+   */
+  bool empty() const {
+    return header_ == nullptr;
+  }
+
+  /**
+   * Get the time of the last update.
+   * @return  Returns the seconds since epoch written by the updating process.
+   */
+  uint64_t last_update() const {
+    return header_ ? header_->last_update : 0;
+  }
+
+  /**
+   * Get the live speed of a directed edge.
+   * @param  idx  Directed edge index within the tile.
+   * @return  Returns the live speed, which is not valid if there is none.
+   */
+  TrafficSpeed speed(const uint32_t idx) const {
+    TrafficSpeed speed{};
+    if (header_ != nullptr && idx < header_->directed_edge_count) {
+      uint32_t word = speeds_[idx];
+      std::memcpy(&speed, &word, sizeof(speed));
+    }
+    return speed;
+  }
+
+  /**
+   * Set the live speed of a directed edge in place, as a single store.
+   * @param  idx    Directed edge index within the tile.
+   * @param  speed  Live speed.
+   */
+  void set_speed(const uint32_t idx, const TrafficSpeed speed) {
+    if (header_ == nullptr || idx >= header_->directed_edge_count) {
+      throw std::runtime_error("Traffic tile has no speed at index " + std::to_string(idx));
+    }
+    uint32_t word;
+    std::memcpy(&word, &speed, sizeof(word));
+    speeds_[idx] = word;
+  }
+
+protected:
+  volatile TrafficTileHeader* header_;
+  volatile uint32_t* speeds_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_TRAFFICTILE_H_
@@ -9,6 +9,8 @@
 #include <valhalla/sif/dynamiccost.h>
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 namespace valhalla {
 namespace loki {
@@ -22,13 +24,17 @@ namespace loki {
  * proper cache
  * @param edge_filter    a costing object by which we can determine which portions of the graph are
  *                       accessable and therefor potential candidates
+ * @param helper_readers graph readers of extra threads to project the locations and check the
+ *                       reach of their candidates with, one thread per reader. the results are
+ *                       the same as without them
  * @return pathLocations the correlated data with in the tile that matches the inputs. If a
  * projection is not found, it will not have any entry in the returned value.
  */
 std::unordered_map<baldr::Location, baldr::PathLocation>
 Search(const std::vector<baldr::Location>& locations,
        baldr::GraphReader& reader,
-       const sif::DynamicCost* costing = nullptr);
+       const sif::DynamicCost* costing = nullptr,
+       const std::vector<std::shared_ptr<baldr::GraphReader>>& helper_readers = {});
 
 } // namespace loki
 } // namespace valhalla
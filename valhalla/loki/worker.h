@@ -44,6 +44,14 @@ public:
   std::string height(Api& request);
   std::string transit_available(Api& request);
 
+  /**
+   * Log a request that took longer than loki.logging.long_request milliseconds per location.
+   * @param  request       The request.
+   * @param  id            Id of the request in the logs.
+   * @param  elapsed_time  Milliseconds loki spent on the request.
+   */
+  void log_long_request(const Api& request, const uint64_t id, const float elapsed_time) const;
+
 protected:
   void parse_locations(
       google::protobuf::RepeatedPtrField<valhalla::Location>* locations,
@@ -64,6 +72,8 @@ protected:
   sif::CostFactory<sif::DynamicCost> factory;
   sif::cost_ptr_t costing;
   std::shared_ptr<baldr::GraphReader> reader;
+  // Graph readers of the extra threads searching the locations of matrices and routes
+  std::vector<std::shared_ptr<baldr::GraphReader>> search_readers;
   std::shared_ptr<baldr::connectivity_map_t> connectivity_map;
   std::string action_str;
   std::unordered_map<std::string, size_t> max_locations;
@@ -4,7 +4,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -51,11 +56,129 @@ protected:
   baldr::GraphReader& reader_;
 };
 
-class CandidateGridQuery final : public CandidateQuery {
+/**
+ * Size bounded cache of candidate grids, one per bin of a local graph tile and
+ * cell size, least recently used grids are dropped first. It is thread-safe so
+ * that the matchers of all the workers in a process can share the grids of the
+ * busy tiles instead of each building their own. Grids are handed out as shared
+ * pointers, a grid that is dropped while in use lives on until it is released.
+ */
+class CandidateGridCache {
 public:
   using grid_t = GridRangeQuery<baldr::GraphId, midgard::PointLL>;
+  using grid_ptr_t = std::shared_ptr<const grid_t>;
+
+  // Counters of the cache, for monitoring
+  struct Stats {
+    uint64_t hits;   // Lookups that found a grid
+    uint64_t misses; // Lookups that had to build a grid
+    size_t grids;    // Grids in the cache
+    size_t memory;   // Approximate bytes used by the grids in the cache
+
+    float hit_rate() const {
+      return hits + misses > 0 ? static_cast<float>(hits) / (hits + misses) : 0.f;
+    }
+  };
+
+  /**
+   * Constructor.
+   * @param  max_grids  Maximum number of grids to keep, at least one is kept.
+   */
+  CandidateGridCache(size_t max_grids);
+
+  /**
+   * Get a cached grid, marking it as most recently used.
+   * @param  bin_id       Bin of the local level tiles.
+   * @param  cell_width   Width of the grid cells.
+   * @param  cell_height  Height of the grid cells.
+   * @return Returns the grid or nullptr if it is not in the cache.
+   */
+  grid_ptr_t Get(int32_t bin_id, float cell_width, float cell_height) const;
+
+  /**
+   * Add a grid, dropping the least recently used ones if the cache is full.
+   * @param  bin_id       Bin of the local level tiles.
+   * @param  cell_width   Width of the grid cells.
+   * @param  cell_height  Height of the grid cells.
+   * @param  grid         The grid.
+   * @return Returns the cached grid, which is another thread's if it added one first.
+   */
+  grid_ptr_t Put(int32_t bin_id, float cell_width, float cell_height, grid_ptr_t grid);
+
+  /**
+   * Drop all the grids. The counters of hits and misses are kept.
+   */
+  void Clear();
+
+  /**
+   * @return Returns the number of grids in the cache.
+   */
+  size_t size() const;
+
+  /**
+   * @return Returns the maximum number of grids the cache keeps.
+   */
+  size_t max_grids() const {
+    return max_grids_;
+  }
+
+  /**
+   * @return Returns the counters of the cache.
+   */
+  Stats stats() const;
+
+protected:
+  struct Key {
+    int32_t bin_id;
+    float cell_width;
+    float cell_height;
+
+    bool operator==(const Key& other) const {
+      return bin_id == other.bin_id && cell_width == other.cell_width &&
+             cell_height == other.cell_height;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t seed = std::hash<int32_t>()(key.bin_id);
+      seed ^= std::hash<float>()(key.cell_width) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      seed ^= std::hash<float>()(key.cell_height) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      return seed;
+    }
+  };
+
+  struct Entry {
+    Key key;
+    grid_ptr_t grid;
+    size_t memory;
+  };
+
+  size_t max_grids_;
+  mutable std::mutex mutex_;
+  mutable std::list<Entry> grids_; // Most recently used first
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  size_t memory_;
+  mutable uint64_t hits_;
+  mutable uint64_t misses_;
+};
 
-  CandidateGridQuery(baldr::GraphReader& reader, float cell_width, float cell_height);
+class CandidateGridQuery final : public CandidateQuery {
+public:
+  using grid_t = CandidateGridCache::grid_t;
+
+  /**
+   * Constructor.
+   * @param  reader       Graph reader used to build the grids.
+   * @param  cell_width   Width of the grid cells.
+   * @param  cell_height  Height of the grid cells.
+   * @param  cache        Grid cache, possibly shared with other queries on the same
+   *                      graph. If none is given the query keeps its own.
+   */
+  CandidateGridQuery(baldr::GraphReader& reader,
+                     float cell_width,
+                     float cell_height,
+                     const std::shared_ptr<CandidateGridCache>& cache = {});
 
   ~CandidateGridQuery();
 
@@ -63,20 +186,24 @@ public:
                                          float sq_search_radius,
                                          sif::EdgeFilter filter) const override;
 
-  std::unordered_map<baldr::GraphId, grid_t>::size_type size() const {
-    return grid_cache_.size();
+  size_t size() const {
+    return grid_cache_->size();
   }
 
   void Clear() {
-    grid_cache_.clear();
+    grid_cache_->Clear();
+  }
+
+  const std::shared_ptr<CandidateGridCache>& grid_cache() const {
+    return grid_cache_;
   }
 
 private:
   // Get a grid for a specified bin within a tile. Tile support for
   // graph tiles and bins is provided to go between bin Ids and tile Ids.
-  const grid_t* GetGrid(const int32_t bin_id,
-                        const midgard::Tiles<midgard::PointLL>& tiles,
-                        const midgard::Tiles<midgard::PointLL>& bins) const;
+  CandidateGridCache::grid_ptr_t GetGrid(const int32_t bin_id,
+                                         const midgard::Tiles<midgard::PointLL>& tiles,
+                                         const midgard::Tiles<midgard::PointLL>& bins) const;
 
   std::unordered_set<baldr::GraphId> RangeQuery(const midgard::AABB2<midgard::PointLL>& range) const;
 
@@ -86,7 +213,7 @@ private:
   float cell_height_;
 
   // Grid cache - cached per "bin" within a graph tile
-  mutable std::unordered_map<int32_t, grid_t> grid_cache_;
+  std::shared_ptr<CandidateGridCache> grid_cache_;
 };
 
 } // namespace meili
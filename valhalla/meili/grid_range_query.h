@@ -86,6 +86,24 @@ public:
     AddLineSegment(item, segment.a(), segment.b());
   }
 
+  // Approximate number of bytes the grid uses
+  size_t MemoryUsage() const {
+    size_t bytes = sizeof(*this);
+#ifdef GRID_USE_VECTOR
+    bytes += items_.capacity() * sizeof(std::vector<item_t>);
+    for (const auto& items : items_) {
+      bytes += items.capacity() * sizeof(item_t);
+    }
+#else
+    bytes += items_.bucket_count() * sizeof(void*);
+    for (const auto& items : items_) {
+      // the node holds the key, the vector and a pointer to the next node
+      bytes += sizeof(items) + sizeof(void*) + items.second.capacity() * sizeof(item_t);
+    }
+#endif
+    return bytes;
+  }
+
   // Query all items that intersects with the range
   std::unordered_set<item_t> Query(const midgard::AABB2<coord_t>& range) const {
     int mincol, minrow, maxcol, maxrow;
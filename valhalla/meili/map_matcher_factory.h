@@ -45,8 +45,13 @@ public:
 
   void ClearFullCache();
 
+  // Clears the tile cache, and the candidate grids unless another factory shares them
   void ClearCache();
 
+  // Counters of the candidate grid cache, which is shared by all the factories of
+  // the process that read the same tiles
+  CandidateGridCache::Stats grid_cache_stats() const;
+
   static constexpr size_t kModeCostingCount = 8;
 
 private:
@@ -61,8 +66,6 @@ private:
   sif::CostFactory<sif::DynamicCost> cost_factory_;
 
   std::shared_ptr<CandidateGridQuery> candidatequery_;
-
-  float max_grid_cache_size_;
 };
 
 } // namespace meili
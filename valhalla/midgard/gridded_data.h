@@ -78,7 +78,7 @@ public:
     return data_;
   }
 
-  using contour_t = std::list<coord_t>;
+  using contour_t = std::vector<coord_t>;
   using feature_t = std::list<contour_t>;
   using contours_t =
       std::map<float, std::list<feature_t>, std::function<bool(const float, const float)>>;
@@ -97,13 +97,17 @@ public:
    * @param generalize           Generalization factor in meters. A special value
    *                             kOptimalGeneralization will let the method choose
    *                             an optimal generalization factor based on grid size.
+   * @param threads              maximum number of threads to use, including the calling one.
+   *                             large grids are scanned in bands of rows and the contours are
+   *                             cleaned up independently, both spread over the threads
    *
    * @return contour line geometries with the larger intervals first (for rendering purposes)
    */
   contours_t GenerateContours(const std::vector<float>& contour_intervals,
                               const bool rings_only = false,
                               const float denoise = 1.f,
-                              const float generalize = 200.f) const;
+                              const float generalize = 200.f,
+                              const unsigned int threads = 1) const;
 
 protected:
   float max_value_;         // Maximum value stored in the tile
@@ -2,13 +2,17 @@
 #define VALHALLA_MJOLNIR_ADMIN_H_
 
 #include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/index/rtree.hpp>
 #include <boost/geometry/io/wkt/wkt.hpp>
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 #include <cstdint>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/pointll.h>
@@ -24,6 +28,52 @@ namespace mjolnir {
 typedef boost::geometry::model::d2::point_xy<double> point_type;
 typedef boost::geometry::model::polygon<point_type> polygon_type;
 typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+typedef boost::geometry::model::box<point_type> box_type;
+
+/**
+ * The admin or timezone polygons of a tile behind an r-tree. When the index is made each polygon
+ * is clipped to the tile, with a small margin, so that a lookup only tests the few polygons whose
+ * bounding box holds the point and only the part of them that is within the tile. Points outside
+ * of the tile fall back to testing the whole polygons.
+ */
+class MultiPolyIndex {
+public:
+  MultiPolyIndex() = default;
+
+  /**
+   * @param  polys   the polygons by id, they must outlive the index
+   * @param  aabb    bb of the tile
+   */
+  MultiPolyIndex(const std::unordered_multimap<uint32_t, multi_polygon_type>& polys,
+                 const AABB2<PointLL>& aabb);
+
+  /**
+   * Get the ids of the polygons that cover the point, in the order they are in the map the
+   * index was made from.
+   * @param  ll     point that needs to be checked.
+   */
+  std::vector<uint32_t> Covering(const PointLL& ll) const;
+
+  /**
+   * @return the number of polygons in the index
+   */
+  size_t size() const {
+    return polys_.size();
+  }
+
+  // margin in degrees around the tile that the polygons are clipped to
+  static constexpr double kClipMargin = 0.01;
+
+protected:
+  typedef std::pair<box_type, uint32_t> value_type;
+
+  // the pieces of each polygon within the tile, the polygon they came from is parts_[i].first
+  std::vector<std::pair<uint32_t, polygon_type>> parts_;
+  boost::geometry::index::rtree<value_type, boost::geometry::index::quadratic<16>> rtree_;
+  // the whole polygons in the order of the map, for points outside of the clip box
+  std::vector<std::pair<uint32_t, const multi_polygon_type*>> polys_;
+  box_type clip_;
+};
 
 /**
  * Get the dbhandle of a sqlite db.  Used for timezones and admins DBs.
@@ -51,6 +101,23 @@ uint32_t GetMultiPolyId(const std::unordered_multimap<uint32_t, multi_polygon_ty
 uint32_t GetMultiPolyId(const std::unordered_multimap<uint32_t, multi_polygon_type>& polys,
                         const PointLL& ll);
 
+/**
+ * Get the polygon index using the spatial index of a tile's polys.  Same as above, the id of a
+ * state is preferred over that of a country.
+ * @param  polys      spatial index of the polys.
+ * @param  ll         point that needs to be checked.
+ * @param  graphtile  graphtilebuilder that is used to determine if we are a country poly or not.
+ */
+uint32_t
+GetMultiPolyId(const MultiPolyIndex& polys, const PointLL& ll, GraphTileBuilder& graphtile);
+
+/**
+ * Get the polygon index using the spatial index of a tile's polys.
+ * @param  polys      spatial index of the polys.
+ * @param  ll         point that needs to be checked.
+ */
+uint32_t GetMultiPolyId(const MultiPolyIndex& polys, const PointLL& ll);
+
 /**
  * Get the timezone polys from the db
  * @param  db_handle    sqlite3 db handle
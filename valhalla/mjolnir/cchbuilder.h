@@ -0,0 +1,24 @@
+#ifndef VALHALLA_MJOLNIR_CCHBUILDER_H
+#define VALHALLA_MJOLNIR_CCHBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to build the contraction hierarchy overlay (see baldr/cchoverlay.h) thor customizes
+ * and routes auto requests on. Only built when mjolnir.cch.build is set.
+ */
+class CCHBuilder {
+public:
+  /**
+   * Order the vertices by nested dissection and contract them into the overlay.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_CCHBUILDER_H
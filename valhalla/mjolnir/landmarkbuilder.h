@@ -0,0 +1,25 @@
+#ifndef VALHALLA_MJOLNIR_LANDMARKBUILDER_H
+#define VALHALLA_MJOLNIR_LANDMARKBUILDER_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <cstdint>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Class used to build the landmark tables (see baldr/landmarks.h) thor uses for its ALT
+ * heuristic. Builds one table for each costing listed in mjolnir.landmarks.costings.
+ */
+class LandmarkBuilder {
+public:
+  /**
+   * Pick the landmarks and compute the distances between them and every node of the graph.
+   */
+  static void Build(const boost::property_tree::ptree& pt);
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_LANDMARKBUILDER_H
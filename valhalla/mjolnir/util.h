@@ -2,11 +2,15 @@
 #define VALHALLA_MJOLNIR_UTIL_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <deque>
 #include <list>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <valhalla/baldr/graphid.h>
 #include <valhalla/midgard/pointll.h>
 
 namespace valhalla {
@@ -28,7 +32,9 @@ enum class BuildStage : int8_t {
   kRestrictions = 9,
   kElevation = 10,
   kValidate = 11,
-  kCleanup = 12
+  kLandmarks = 12,
+  kCCH = 13,
+  kCleanup = 14
 };
 
 // Convert string to BuildStage
@@ -46,6 +52,8 @@ inline BuildStage string_to_buildstage(const std::string& s) {
        {"restrictions", BuildStage::kRestrictions},
        {"elevation", BuildStage::kElevation},
        {"validate", BuildStage::kValidate},
+       {"landmarks", BuildStage::kLandmarks},
+       {"cch", BuildStage::kCCH},
        {"cleanup", BuildStage::kCleanup}};
 
   auto i = stringToBuildStage.find(s);
@@ -67,6 +75,8 @@ inline std::string to_string(BuildStage stg) {
        {static_cast<int8_t>(BuildStage::kRestrictions), "restrictions"},
        {static_cast<int8_t>(BuildStage::kElevation), "elevation"},
        {static_cast<int8_t>(BuildStage::kValidate), "validate"},
+       {static_cast<int8_t>(BuildStage::kLandmarks), "landmarks"},
+       {static_cast<int8_t>(BuildStage::kCCH), "cch"},
        {static_cast<int8_t>(BuildStage::kCleanup), "cleanup"}};
 
   auto i = BuildStageStrings.find(static_cast<int8_t>(stg));
@@ -105,6 +115,50 @@ bool shapes_match(const std::vector<midgard::PointLL>& shape1,
  */
 uint32_t compute_curvature(const std::list<midgard::PointLL>& shape);
 
+/**
+ * Get a queue of tiles to work from, ordered so the tiles that take the most
+ * work are taken first. Threads pulling from the queue then start on the dense
+ * tiles and the small tiles at the end even out when they finish. The size of
+ * the tile file is used as the cost of a tile, it mostly follows the number of
+ * edges in it. Tiles of the same size are ordered by id.
+ * @param  tile_dir  Tile directory
+ * @param  tiles     Tiles to queue
+ * @return the queue of tiles
+ */
+std::deque<baldr::GraphId> CostOrderedTileQueue(const std::string& tile_dir,
+                                                const std::unordered_set<baldr::GraphId>& tiles);
+
+/**
+ * Keeps track of the tiles a worker thread takes off of a shared queue and of
+ * how long it has been busy. It is logged when the thread is done so we can
+ * see how well the work was balanced between the threads.
+ */
+class WorkerTimer {
+public:
+  /**
+   * Starts timing a worker thread.
+   * @param  stage  Name of the build stage to log with
+   */
+  WorkerTimer(const std::string& stage);
+
+  /**
+   * Logs the tiles done and the time taken by the thread.
+   */
+  ~WorkerTimer();
+
+  /**
+   * Count a finished tile.
+   * @param  cost  Estimated cost of the tile
+   */
+  void AddTile(const size_t cost = 0);
+
+protected:
+  std::string stage_;
+  size_t tiles_;
+  size_t cost_;
+  std::chrono::steady_clock::time_point start_;
+};
+
 /**
  * Build an entire valhalla tileset give a config file and some input pbfs. The
  * tile building process is split into stages. This method allows either the entire
@@ -14,12 +14,14 @@
 #include <valhalla/baldr/rapidjson_utils.h>
 #include <valhalla/baldr/timedomain.h>
 #include <valhalla/baldr/transitdeparture.h>
+#include <valhalla/midgard/constants.h>
 #include <valhalla/proto/options.pb.h>
 #include <valhalla/sif/costconstants.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/sif/hierarchylimits.h>
 #include <valhalla/thor/edgestatus.h>
 
+#include <algorithm>
 #include <memory>
 #include <third_party/rapidjson/include/rapidjson/document.h>
 #include <unordered_map>
@@ -657,6 +659,27 @@ public:
     return flow_mask_;
   }
 
+  /**
+   * Keep the edge costs of the tiles this costing expands with the tiles (see
+   * baldr::EdgeCostTable) and read them from there, so later requests with the same costing
+   * options don't compute them again. Only searches without a time use the tables. Costings
+   * that don't support them ignore this.
+   * @param  costing  The costing type.
+   * @param  options  Request options, their costing options select the tables.
+   */
+  void UseEdgeCostTables(const Costing costing, const Options& options);
+
+  /**
+   * Set the time of the week the search using this costing starts at: the departure of forward
+   * searches and the arrival of reverse ones. When the request leaves now the live traffic
+   * speeds fade into the other speeds the further an edge is in time from the start, otherwise
+   * searches with a time don't use them.
+   * @param  seconds_of_week  Start time of the search, seconds since the start of the week.
+   */
+  void set_start_time(const uint32_t seconds_of_week) {
+    start_seconds_of_week_ = seconds_of_week;
+  }
+
 protected:
   // Algorithm pass
   uint32_t pass_;
@@ -695,6 +718,85 @@ protected:
   // A mask which determines which flow data the costing should use from the tile
   uint8_t flow_mask_;
 
+  // Does the request leave now and when does the search start (kInvalidSecondsOfWeek if unset)
+  bool leaves_now_;
+  uint32_t start_seconds_of_week_;
+
+  // Edge cost tables of the tiles for this costing and its options, 0 if it doesn't use them.
+  // The lowest bit tells the tables for searches with and without a time of day apart.
+  uint64_t edge_cost_key_;
+
+  // Tells the decoded speed caches of the threads using this costing apart from those of others
+  uint64_t speed_cache_id_;
+
+  /**
+   * Get the predicted speeds the calling thread decoded with this costing. Searches share
+   * their costing between threads (CostMatrix) so each thread keeps its own cache, which
+   * starts over when the thread moves on to another costing.
+   * @return Returns the cache of the thread.
+   */
+  baldr::DecodedSpeedCache* speed_cache() const {
+    thread_local baldr::DecodedSpeedCache cache;
+    thread_local uint64_t cache_id = 0;
+    if (cache_id != speed_cache_id_) {
+      cache.clear();
+      cache_id = speed_cache_id_;
+    }
+    return &cache;
+  }
+
+  /**
+   * Get the seconds from the start of the search to the time an edge is costed at, for fading
+   * the live traffic speeds.
+   * @param  seconds  Time of week the edge is costed at.
+   * @return Returns the seconds from the start, 0 for searches without a time (they are for now)
+   *         and kLiveSpeedFadeSeconds if live speeds shouldn't be used at all.
+   */
+  uint32_t seconds_from_now(const uint32_t seconds) const {
+    if (seconds == baldr::kInvalidSecondsOfWeek) {
+      return 0;
+    }
+    if (!leaves_now_ || start_seconds_of_week_ == baldr::kInvalidSecondsOfWeek) {
+      return baldr::kLiveSpeedFadeSeconds;
+    }
+    // either way round the start of the week, reverse searches go back in time
+    uint32_t diff = seconds > start_seconds_of_week_ ? seconds - start_seconds_of_week_
+                                                     : start_seconds_of_week_ - seconds;
+    return std::min(diff, midgard::kSecondsPerWeek - diff);
+  }
+
+  /**
+   * Get the key of the edge cost table of a tile for this costing.
+   * @param  tile     The tile.
+   * @param  seconds  Time of week the edge costs are for.
+   * @return Returns 0 if the costing doesn't use the tables or the costs of the tile depend on
+   *         more than the costing options, the time of week or live traffic.
+   */
+  uint64_t EdgeCostKey(const baldr::GraphTile* tile, const uint32_t seconds) const {
+    if (edge_cost_key_ == 0 || tile->edge_costs() == nullptr ||
+        (seconds != baldr::kInvalidSecondsOfWeek &&
+         seconds != baldr::kConstrainedFlowSecondOfDay) ||
+        ((flow_mask_ & baldr::kCurrentFlowMask) && !tile->traffic_tile().empty())) {
+      return 0;
+    }
+    return edge_cost_key_ | (seconds == baldr::kConstrainedFlowSecondOfDay);
+  }
+
+  /**
+   * Find an edge cost table of a tile for this costing for the edge access, which is the same
+   * in the tables with and without a time of day.
+   * @param  tile  The tile.
+   * @return Returns the table, nullptr if there is none.
+   */
+  const baldr::EdgeCostTable* FindEdgeCostTable(const baldr::GraphTile* tile) const {
+    uint64_t key = EdgeCostKey(tile, baldr::kInvalidSecondsOfWeek);
+    if (key == 0) {
+      return nullptr;
+    }
+    const baldr::EdgeCostTable* table = tile->edge_costs()->find(key);
+    return table != nullptr ? table : tile->edge_costs()->find(key | 1);
+  }
+
   /**
    * Get the base transition costs (and ferry factor) from the costing options.
    * @param costing_options Protocol buffer of costing options.
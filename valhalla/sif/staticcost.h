@@ -0,0 +1,128 @@
+#ifndef VALHALLA_SIF_STATICCOST_H_
+#define VALHALLA_SIF_STATICCOST_H_
+
+#include <typeinfo>
+#include <utility>
+
+#include <valhalla/sif/autocost.h>
+#include <valhalla/sif/bicyclecost.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/pedestriancost.h>
+#include <valhalla/sif/truckcost.h>
+
+namespace valhalla {
+namespace sif {
+
+/**
+ * The costing methods the path algorithms call for every edge they expand, bound at compile
+ * time to the concrete costing type so the calls are inlined into the expansion loop rather
+ * than going through the vtable. Everything else is reached through operator-> as usual.
+ * StaticCost<DynamicCost> is the fallback that calls them virtually.
+ */
+template <typename cost_t> class StaticCost {
+public:
+  /**
+   * Constructor.
+   * @param  costing  The costing, its dynamic type must be exactly cost_t.
+   */
+  explicit StaticCost(const DynamicCost& costing) : costing_(static_cast<const cost_t&>(costing)) {
+  }
+
+  template <typename... args_t> bool Allowed(args_t&&... args) const {
+    return costing_.cost_t::Allowed(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> bool AllowedReverse(args_t&&... args) const {
+    return costing_.cost_t::AllowedReverse(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> Cost EdgeCost(args_t&&... args) const {
+    return costing_.cost_t::EdgeCost(std::forward<args_t>(args)...);
+  }
+
+  // The overload without a time is only on DynamicCost, hidden by the ones of cost_t
+  Cost EdgeCost(const baldr::DirectedEdge* edge, const baldr::GraphTile* tile) const {
+    return costing_.cost_t::EdgeCost(edge, tile, baldr::kInvalidSecondsOfWeek);
+  }
+
+  template <typename... args_t> Cost TransitionCost(args_t&&... args) const {
+    return costing_.cost_t::TransitionCost(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> Cost TransitionCostReverse(args_t&&... args) const {
+    return costing_.cost_t::TransitionCostReverse(std::forward<args_t>(args)...);
+  }
+
+  const cost_t* operator->() const {
+    return &costing_;
+  }
+
+private:
+  const cost_t& costing_;
+};
+
+template <> class StaticCost<DynamicCost> {
+public:
+  explicit StaticCost(const DynamicCost& costing) : costing_(costing) {
+  }
+
+  template <typename... args_t> bool Allowed(args_t&&... args) const {
+    return costing_.Allowed(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> bool AllowedReverse(args_t&&... args) const {
+    return costing_.AllowedReverse(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> Cost EdgeCost(args_t&&... args) const {
+    return costing_.EdgeCost(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> Cost TransitionCost(args_t&&... args) const {
+    return costing_.TransitionCost(std::forward<args_t>(args)...);
+  }
+
+  template <typename... args_t> Cost TransitionCostReverse(args_t&&... args) const {
+    return costing_.TransitionCostReverse(std::forward<args_t>(args)...);
+  }
+
+  const DynamicCost* operator->() const {
+    return &costing_;
+  }
+
+private:
+  const DynamicCost& costing_;
+};
+
+/**
+ * Calls a function with the StaticCost of a costing. Auto, truck, pedestrian and bicycle costings
+ * get their own instantiation of the function. Costings derived from them (auto_shorter, bus,
+ * hov, taxi...) and anything else registered with the CostFactory get the virtual fallback.
+ * Meant to be called once per request around the search loop, not per edge.
+ * @param  costing   The costing of the request.
+ * @param  function  Function taking a StaticCost of any costing type.
+ * @return Returns what the function returns.
+ */
+template <typename function_t>
+auto DispatchCost(const DynamicCost& costing, function_t&& function)
+    -> decltype(function(StaticCost<DynamicCost>(costing))) {
+  const std::type_info& type = typeid(costing);
+  if (type == typeid(AutoCost)) {
+    return function(StaticCost<AutoCost>(costing));
+  }
+  if (type == typeid(TruckCost)) {
+    return function(StaticCost<TruckCost>(costing));
+  }
+  if (type == typeid(PedestrianCost)) {
+    return function(StaticCost<PedestrianCost>(costing));
+  }
+  if (type == typeid(BicycleCost)) {
+    return function(StaticCost<BicycleCost>(costing));
+  }
+  return function(StaticCost<DynamicCost>(costing));
+}
+
+} // namespace sif
+} // namespace valhalla
+
+#endif // VALHALLA_SIF_STATICCOST_H_
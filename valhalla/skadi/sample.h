@@ -2,7 +2,9 @@
 #define __VALHALLA_SAMPLE_H__
 
 #include <cstdint>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -13,6 +15,14 @@
 namespace valhalla {
 namespace skadi {
 
+// default memory limit for decompressed tiles, about 20 tiles
+constexpr size_t kDefaultMaxUnzippedBytes = 512 * 1024 * 1024;
+
+/**
+ * Samples heights from a directory of srtmgl1 tiles. It is safe to sample from
+ * several threads at once: compressed tiles are decompressed into a bounded
+ * LRU cache which all the threads share.
+ */
 class sample {
 public:
   // non-default-constructable and non-copyable
@@ -24,9 +34,12 @@ public:
 
   /**
    * Constructor
-   * @param data_source  directory name of the datasource from which to sample
+   * @param data_source         directory name of the datasource from which to sample
+   * @param max_unzipped_bytes  memory limit of the decompressed tiles cache. at least one tile
+   *                            is always kept and tiles still being sampled by some thread
+   *                            stay in memory until that thread is done with them
    */
-  sample(const std::string& data_source);
+  sample(const std::string& data_source, size_t max_unzipped_bytes = kDefaultMaxUnzippedBytes);
 
   /**
    * Get a single sample from the datasource
@@ -35,7 +48,8 @@ public:
   template <class coord_t> double get(const coord_t& coord) const;
 
   /**
-   * Get multiple samples from the datasource
+   * Get multiple samples from the datasource. The postings are grouped by tile
+   * so that each tile is looked up (and decompressed) once per call
    * @param coords  the list of postings at which to sample the datasource
    */
   template <class coords_t> std::vector<double> get_all(const coords_t& coords) const;
@@ -46,11 +60,30 @@ public:
   static double get_no_data_value();
 
 protected:
+  // decompressed tile data, shared with the threads sampling it
+  using unzipped_t = std::shared_ptr<const std::vector<int16_t>>;
+
   /**
    * @param  index  the index of the data tile being requested
-   * @return the array of data or nullptr if there was none
+   * @return the array of data or nullptr if there was none. it keeps decompressed
+   *         data alive until released, even once it has left the cache
+   */
+  std::shared_ptr<const int16_t> source(uint16_t index) const;
+
+  /**
+   * @param  index  the index of the data tile
+   * @return the decompressed tile if it is cached, marking it most recently used
    */
-  const int16_t* source(uint16_t index) const;
+  unzipped_t get_unzipped(uint16_t index) const;
+
+  /**
+   * adds a decompressed tile to the cache, evicting the least recently used
+   * tiles if the cache is over its memory limit
+   * @param  index     the index of the data tile
+   * @param  unzipped  the decompressed tile
+   * @return the cached tile, which is another thread's if it got there first
+   */
+  unzipped_t put_unzipped(uint16_t index, unzipped_t unzipped) const;
 
   enum class format_t { UNKNOWN = 0, GZIP = 1, RAW = 3 };
   /**
@@ -66,9 +99,13 @@ protected:
   // using memory maps
   mutable std::vector<std::pair<format_t, midgard::mem_map<char>>> mapped_cache;
 
-  // TODO: make an LRU
-  using unzipped_t = std::pair<int16_t, std::vector<int16_t>>;
-  mutable unzipped_t unzipped_cache;
+  // decompressed tiles, most recently used first, and where each is in that list
+  mutable std::list<std::pair<uint16_t, unzipped_t>> unzipped_cache;
+  mutable std::unordered_map<uint16_t, decltype(unzipped_cache)::iterator> unzipped_index;
+  size_t max_unzipped_tiles;
+
+  // guards the caches, it is a pointer so that samples can still be moved
+  std::unique_ptr<std::mutex> cache_lock;
 
   std::string data_source;
 };
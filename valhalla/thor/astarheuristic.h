@@ -1,6 +1,11 @@
 #ifndef VALHALLA_THOR_ASTARHEURISTIC_H_
 #define VALHALLA_THOR_ASTARHEURISTIC_H_
 
+#include <algorithm>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/landmarks.h>
 #include <valhalla/midgard/distanceapproximator.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -17,7 +22,7 @@ public:
   /**
    * Constructor.
    */
-  AStarHeuristic() : costfactor_(1.0f), distapprox_({}) {
+  AStarHeuristic() : costfactor_(1.0f), distapprox_({}), landmarks_(nullptr), reverse_(false) {
   }
 
   /**
@@ -33,6 +38,38 @@ public:
   void Init(const midgard::PointLL& ll, const float factor) {
     distapprox_.SetTestPoint(ll);
     costfactor_ = factor;
+    landmarks_ = nullptr;
+    targets_.clear();
+  }
+
+  /**
+   * Also use the network distance lower bounds of a landmark table (ALT) for the nodes passed
+   * to Get. They are never less than the straight line distance and usually a good deal more,
+   * which keeps the search from expanding into dead ends and around barriers. Call after Init.
+   * @param  landmarks  Landmark table for the access mode of the costing.
+   * @param  targets    Nodes every path to the destination goes through (for a forward search
+   *                    the start nodes of the destination edges, for a reverse search the end
+   *                    nodes of the origin edges).
+   * @param  reverse    True if the search runs from the destination to the origin.
+   */
+  void InitLandmarks(const baldr::LandmarkTable* landmarks,
+                     const std::vector<baldr::GraphId>& targets,
+                     const bool reverse) {
+    landmarks_ = landmarks;
+    reverse_ = reverse;
+    targets_.clear();
+    if (landmarks_ == nullptr) {
+      return;
+    }
+    for (const auto& target : targets) {
+      // without the distances of every target there is no bound at all
+      const uint32_t* distances = landmarks_->distances(target);
+      if (distances == nullptr) {
+        targets_.clear();
+        return;
+      }
+      targets_.push_back(distances);
+    }
   }
 
   /**
@@ -77,10 +114,51 @@ public:
     return dist * costfactor_;
   }
 
+  /**
+   * Get the A* heuristic given the lat,lng of a node, using the landmark lower bound for the
+   * node when it is tighter than the straight line distance. Also return the straight line
+   * distance via an argument.
+   * @param   ll    Lat,lng of the node.
+   * @param   node  The node.
+   * @param   dist  Distance (meters) to the destination.
+   * @return  Returns an estimate of the cost to the destination.
+   *          For A* shortest path this MUST UNDERESTIMATE the true cost.
+   */
+  float Get(const midgard::PointLL& ll, const baldr::GraphId& node, float& dist) const {
+    dist = sqrtf(distapprox_.DistanceSquared(ll));
+    if (targets_.empty()) {
+      return dist * costfactor_;
+    }
+    return std::max(dist, LandmarkDistance(node)) * costfactor_;
+  }
+
+  /**
+   * Lower bound on the network distance from the node to the destination (from the origin to the
+   * node in reverse) given by the landmarks.
+   * @param   node  The node.
+   * @return  Returns the distance (meters), 0 if the landmarks don't bound it.
+   */
+  float LandmarkDistance(const baldr::GraphId& node) const {
+    const uint32_t* distances = targets_.empty() ? nullptr : landmarks_->distances(node);
+    if (distances == nullptr) {
+      return 0.0f;
+    }
+    // the path goes through one of the targets so it is at least the smallest of their bounds
+    uint32_t bound = baldr::LandmarkTable::kUnreached;
+    for (const uint32_t* target : targets_) {
+      bound = std::min(bound, reverse_ ? landmarks_->LowerBound(target, distances)
+                                       : landmarks_->LowerBound(distances, target));
+    }
+    return static_cast<float>(bound);
+  }
+
 private:
   midgard::DistanceApproximator distapprox_; // Distance approximation
   float costfactor_;                         // Cost factor - ensures the cost estimate
                                              // underestimates the true cost.
+  const baldr::LandmarkTable* landmarks_;    // Landmark table (ALT), if any
+  std::vector<const uint32_t*> targets_;     // Landmark distances of the targets
+  bool reverse_;                             // Bound the distance from the targets
 };
 
 } // namespace thor
@@ -1,132 +1,157 @@
 #ifndef VALHALLA_THOR_ATTRIBUTES_CONTROLLER_H_
 #define VALHALLA_THOR_ATTRIBUTES_CONTROLLER_H_
 
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 
 namespace valhalla {
 namespace thor {
 
+/**
+ * An attribute that can be included in or excluded from a response. Besides the name used for
+ * it in requests each attribute has its own bit in the AttributesController, so checking one
+ * while building a trip leg is a bit test rather than a lookup by name.
+ */
+struct AttributeKey {
+  const char* name;
+  uint8_t bit;
+
+  operator std::string() const {
+    return name;
+  }
+};
+
 // Edge keys
-const std::string kEdgeNames = "edge.names";
-const std::string kEdgeLength = "edge.length";
-const std::string kEdgeSpeed = "edge.speed";
-const std::string kEdgeRoadClass = "edge.road_class";
-const std::string kEdgeBeginHeading = "edge.begin_heading";
-const std::string kEdgeEndHeading = "edge.end_heading";
-const std::string kEdgeBeginShapeIndex = "edge.begin_shape_index";
-const std::string kEdgeEndShapeIndex = "edge.end_shape_index";
-const std::string kEdgeTraversability = "edge.traversability";
-const std::string kEdgeUse = "edge.use";
-const std::string kEdgeToll = "edge.toll";
-const std::string kEdgeUnpaved = "edge.unpaved";
-const std::string kEdgeTunnel = "edge.tunnel";
-const std::string kEdgeBridge = "edge.bridge";
-const std::string kEdgeRoundabout = "edge.roundabout";
-const std::string kEdgeInternalIntersection = "edge.internal_intersection";
-const std::string kEdgeDriveOnRight = "edge.drive_on_right";
-const std::string kEdgeSurface = "edge.surface";
-const std::string kEdgeSignExitNumber = "edge.sign.exit_number";
-const std::string kEdgeSignExitBranch = "edge.sign.exit_branch";
-const std::string kEdgeSignExitToward = "edge.sign.exit_toward";
-const std::string kEdgeSignExitName = "edge.sign.exit_name";
-const std::string kEdgeSignGuideBranch = "edge.sign.guide_branch";
-const std::string kEdgeSignGuideToward = "edge.sign.guide_toward";
-const std::string kEdgeSignJunctionName = "edge.sign.junction_name";
-const std::string kEdgeSignGuidanceViewJunction = "edge.sign.guidance_view_junction";
-const std::string kEdgeTravelMode = "edge.travel_mode";
-const std::string kEdgeVehicleType = "edge.vehicle_type";
-const std::string kEdgePedestrianType = "edge.pedestrian_type";
-const std::string kEdgeBicycleType = "edge.bicycle_type";
-const std::string kEdgeTransitType = "edge.transit_type";
-const std::string kEdgeTransitRouteInfoOnestopId = "edge.transit_route_info.onestop_id";
-const std::string kEdgeTransitRouteInfoBlockId = "edge.transit_route_info.block_id";
-const std::string kEdgeTransitRouteInfoTripId = "edge.transit_route_info.trip_id";
-const std::string kEdgeTransitRouteInfoShortName = "edge.transit_route_info.short_name";
-const std::string kEdgeTransitRouteInfoLongName = "edge.transit_route_info.long_name";
-const std::string kEdgeTransitRouteInfoHeadsign = "edge.transit_route_info.headsign";
-const std::string kEdgeTransitRouteInfoColor = "edge.transit_route_info.color";
-const std::string kEdgeTransitRouteInfoTextColor = "edge.transit_route_info.text_color";
-const std::string kEdgeTransitRouteInfoDescription = "edge.transit_route_info.description";
-const std::string kEdgeTransitRouteInfoOperatorOnestopId =
-    "edge.transit_route_info.operator_onestop_id";
-const std::string kEdgeTransitRouteInfoOperatorName = "edge.transit_route_info.operator_name";
-const std::string kEdgeTransitRouteInfoOperatorUrl = "edge.transit_route_info.operator_url";
-const std::string kEdgeId = "edge.id";
-const std::string kEdgeWayId = "edge.way_id";
-const std::string kEdgeWeightedGrade = "edge.weighted_grade";
-const std::string kEdgeMaxUpwardGrade = "edge.max_upward_grade";
-const std::string kEdgeMaxDownwardGrade = "edge.max_downward_grade";
-const std::string kEdgeMeanElevation = "edge.mean_elevation";
-const std::string kEdgeLaneCount = "edge.lane_count";
-const std::string kEdgeLaneConnectivity = "edge.lane_connectivity";
-const std::string kEdgeCycleLane = "edge.cycle_lane";
-const std::string kEdgeBicycleNetwork = "edge.bicycle_network";
-const std::string kEdgeSidewalk = "edge.sidewalk";
-const std::string kEdgeDensity = "edge.density";
-const std::string kEdgeSpeedLimit = "edge.speed_limit";
-const std::string kEdgeTruckSpeed = "edge.truck_speed";
-const std::string kEdgeTruckRoute = "edge.truck_route";
+constexpr AttributeKey kEdgeNames{"edge.names", 0};
+constexpr AttributeKey kEdgeLength{"edge.length", 1};
+constexpr AttributeKey kEdgeSpeed{"edge.speed", 2};
+constexpr AttributeKey kEdgeRoadClass{"edge.road_class", 3};
+constexpr AttributeKey kEdgeBeginHeading{"edge.begin_heading", 4};
+constexpr AttributeKey kEdgeEndHeading{"edge.end_heading", 5};
+constexpr AttributeKey kEdgeBeginShapeIndex{"edge.begin_shape_index", 6};
+constexpr AttributeKey kEdgeEndShapeIndex{"edge.end_shape_index", 7};
+constexpr AttributeKey kEdgeTraversability{"edge.traversability", 8};
+constexpr AttributeKey kEdgeUse{"edge.use", 9};
+constexpr AttributeKey kEdgeToll{"edge.toll", 10};
+constexpr AttributeKey kEdgeUnpaved{"edge.unpaved", 11};
+constexpr AttributeKey kEdgeTunnel{"edge.tunnel", 12};
+constexpr AttributeKey kEdgeBridge{"edge.bridge", 13};
+constexpr AttributeKey kEdgeRoundabout{"edge.roundabout", 14};
+constexpr AttributeKey kEdgeInternalIntersection{"edge.internal_intersection", 15};
+constexpr AttributeKey kEdgeDriveOnRight{"edge.drive_on_right", 16};
+constexpr AttributeKey kEdgeSurface{"edge.surface", 17};
+constexpr AttributeKey kEdgeSignExitNumber{"edge.sign.exit_number", 18};
+constexpr AttributeKey kEdgeSignExitBranch{"edge.sign.exit_branch", 19};
+constexpr AttributeKey kEdgeSignExitToward{"edge.sign.exit_toward", 20};
+constexpr AttributeKey kEdgeSignExitName{"edge.sign.exit_name", 21};
+constexpr AttributeKey kEdgeSignGuideBranch{"edge.sign.guide_branch", 22};
+constexpr AttributeKey kEdgeSignGuideToward{"edge.sign.guide_toward", 23};
+constexpr AttributeKey kEdgeSignJunctionName{"edge.sign.junction_name", 24};
+constexpr AttributeKey kEdgeSignGuidanceViewJunction{"edge.sign.guidance_view_junction", 25};
+constexpr AttributeKey kEdgeTravelMode{"edge.travel_mode", 26};
+constexpr AttributeKey kEdgeVehicleType{"edge.vehicle_type", 27};
+constexpr AttributeKey kEdgePedestrianType{"edge.pedestrian_type", 28};
+constexpr AttributeKey kEdgeBicycleType{"edge.bicycle_type", 29};
+constexpr AttributeKey kEdgeTransitType{"edge.transit_type", 30};
+constexpr AttributeKey kEdgeTransitRouteInfoOnestopId{"edge.transit_route_info.onestop_id", 31};
+constexpr AttributeKey kEdgeTransitRouteInfoBlockId{"edge.transit_route_info.block_id", 32};
+constexpr AttributeKey kEdgeTransitRouteInfoTripId{"edge.transit_route_info.trip_id", 33};
+constexpr AttributeKey kEdgeTransitRouteInfoShortName{"edge.transit_route_info.short_name", 34};
+constexpr AttributeKey kEdgeTransitRouteInfoLongName{"edge.transit_route_info.long_name", 35};
+constexpr AttributeKey kEdgeTransitRouteInfoHeadsign{"edge.transit_route_info.headsign", 36};
+constexpr AttributeKey kEdgeTransitRouteInfoColor{"edge.transit_route_info.color", 37};
+constexpr AttributeKey kEdgeTransitRouteInfoTextColor{"edge.transit_route_info.text_color", 38};
+constexpr AttributeKey kEdgeTransitRouteInfoDescription{"edge.transit_route_info.description", 39};
+constexpr AttributeKey kEdgeTransitRouteInfoOperatorOnestopId{
+    "edge.transit_route_info.operator_onestop_id", 40};
+constexpr AttributeKey kEdgeTransitRouteInfoOperatorName{
+    "edge.transit_route_info.operator_name", 41};
+constexpr AttributeKey kEdgeTransitRouteInfoOperatorUrl{"edge.transit_route_info.operator_url", 42};
+constexpr AttributeKey kEdgeId{"edge.id", 43};
+constexpr AttributeKey kEdgeWayId{"edge.way_id", 44};
+constexpr AttributeKey kEdgeWeightedGrade{"edge.weighted_grade", 45};
+constexpr AttributeKey kEdgeMaxUpwardGrade{"edge.max_upward_grade", 46};
+constexpr AttributeKey kEdgeMaxDownwardGrade{"edge.max_downward_grade", 47};
+constexpr AttributeKey kEdgeMeanElevation{"edge.mean_elevation", 48};
+constexpr AttributeKey kEdgeLaneCount{"edge.lane_count", 49};
+constexpr AttributeKey kEdgeLaneConnectivity{"edge.lane_connectivity", 50};
+constexpr AttributeKey kEdgeCycleLane{"edge.cycle_lane", 51};
+constexpr AttributeKey kEdgeBicycleNetwork{"edge.bicycle_network", 52};
+constexpr AttributeKey kEdgeSidewalk{"edge.sidewalk", 53};
+constexpr AttributeKey kEdgeDensity{"edge.density", 54};
+constexpr AttributeKey kEdgeSpeedLimit{"edge.speed_limit", 55};
+constexpr AttributeKey kEdgeTruckSpeed{"edge.truck_speed", 56};
+constexpr AttributeKey kEdgeTruckRoute{"edge.truck_route", 57};
 
 // Node keys
-const std::string kNodeIntersectingEdgeBeginHeading = "node.intersecting_edge.begin_heading";
-const std::string kNodeIntersectingEdgeFromEdgeNameConsistency =
-    "node.intersecting_edge.from_edge_name_consistency";
-const std::string kNodeIntersectingEdgeToEdgeNameConsistency =
-    "node.intersecting_edge.to_edge_name_consistency";
-const std::string kNodeIntersectingEdgeDriveability = "node.intersecting_edge.driveability";
-const std::string kNodeIntersectingEdgeCyclability = "node.intersecting_edge.cyclability";
-const std::string kNodeIntersectingEdgeWalkability = "node.intersecting_edge.walkability";
-const std::string kNodeIntersectingEdgeUse = "node.intersecting_edge.use";
-const std::string kNodeIntersectingEdgeRoadClass = "node.intersecting_edge.road_class";
-const std::string kNodeElapsedTime = "node.elapsed_time";
-const std::string kNodeaAdminIndex = "node.admin_index";
-const std::string kNodeType = "node.type";
-const std::string kNodeFork = "node.fork";
-const std::string kNodeTransitPlatformInfoType = "node.transit_platform_info.type";
-const std::string kNodeTransitPlatformInfoOnestopId = "node.transit_platform_info.onestop_id";
-const std::string kNodeTransitPlatformInfoName = "node.transit_platform_info.name";
-const std::string kNodeTransitPlatformInfoStationOnestopId =
-    "node.transit_platform_info.station_onestop_id";
-const std::string kNodeTransitPlatformInfoStationName = "node.transit_platform_info.station_name";
-const std::string kNodeTransitPlatformInfoArrivalDateTime =
-    "node.transit_platform_info.arrival_date_time";
-const std::string kNodeTransitPlatformInfoDepartureDateTime =
-    "node.transit_platform_info.departure_date_time";
-const std::string kNodeTransitPlatformInfoIsParentStop = "node.transit_platform_info.is_parent_stop";
-const std::string kNodeTransitPlatformInfoAssumedSchedule =
-    "node.transit_platform_info.assumed_schedule";
-const std::string kNodeTransitPlatformInfoLatLon = "node.transit_platform_info.lat_lon";
-const std::string kNodeTransitStationInfoOnestopId = "node.transit_station_info.onestop_id";
-const std::string kNodeTransitStationInfoName = "node.transit_station_info.name";
-const std::string kNodeTransitStationInfoLatLon = "node.transit_station_info.lat_lon";
-const std::string kNodeTransitEgressInfoOnestopId = "node.transit_egress_info.onestop_id";
-const std::string kNodeTransitEgressInfoName = "node.transit_egress_info.name";
-const std::string kNodeTransitEgressInfoLatLon = "node.transit_egress_info.lat_lon";
-const std::string kNodeTimeZone = "node.time_zone";
-const std::string kNodeTransitionTime = "node.transition_time";
+constexpr AttributeKey kNodeIntersectingEdgeBeginHeading{
+    "node.intersecting_edge.begin_heading", 58};
+constexpr AttributeKey kNodeIntersectingEdgeFromEdgeNameConsistency{
+    "node.intersecting_edge.from_edge_name_consistency", 59};
+constexpr AttributeKey kNodeIntersectingEdgeToEdgeNameConsistency{
+    "node.intersecting_edge.to_edge_name_consistency", 60};
+constexpr AttributeKey kNodeIntersectingEdgeDriveability{"node.intersecting_edge.driveability", 61};
+constexpr AttributeKey kNodeIntersectingEdgeCyclability{"node.intersecting_edge.cyclability", 62};
+constexpr AttributeKey kNodeIntersectingEdgeWalkability{"node.intersecting_edge.walkability", 63};
+constexpr AttributeKey kNodeIntersectingEdgeUse{"node.intersecting_edge.use", 64};
+constexpr AttributeKey kNodeIntersectingEdgeRoadClass{"node.intersecting_edge.road_class", 65};
+constexpr AttributeKey kNodeElapsedTime{"node.elapsed_time", 66};
+constexpr AttributeKey kNodeaAdminIndex{"node.admin_index", 67};
+constexpr AttributeKey kNodeType{"node.type", 68};
+constexpr AttributeKey kNodeFork{"node.fork", 69};
+constexpr AttributeKey kNodeTransitPlatformInfoType{"node.transit_platform_info.type", 70};
+constexpr AttributeKey kNodeTransitPlatformInfoOnestopId{
+    "node.transit_platform_info.onestop_id", 71};
+constexpr AttributeKey kNodeTransitPlatformInfoName{"node.transit_platform_info.name", 72};
+constexpr AttributeKey kNodeTransitPlatformInfoStationOnestopId{
+    "node.transit_platform_info.station_onestop_id", 73};
+constexpr AttributeKey kNodeTransitPlatformInfoStationName{
+    "node.transit_platform_info.station_name", 74};
+constexpr AttributeKey kNodeTransitPlatformInfoArrivalDateTime{
+    "node.transit_platform_info.arrival_date_time", 75};
+constexpr AttributeKey kNodeTransitPlatformInfoDepartureDateTime{
+    "node.transit_platform_info.departure_date_time", 76};
+constexpr AttributeKey kNodeTransitPlatformInfoIsParentStop{
+    "node.transit_platform_info.is_parent_stop", 77};
+constexpr AttributeKey kNodeTransitPlatformInfoAssumedSchedule{
+    "node.transit_platform_info.assumed_schedule", 78};
+constexpr AttributeKey kNodeTransitPlatformInfoLatLon{"node.transit_platform_info.lat_lon", 79};
+constexpr AttributeKey kNodeTransitStationInfoOnestopId{"node.transit_station_info.onestop_id", 80};
+constexpr AttributeKey kNodeTransitStationInfoName{"node.transit_station_info.name", 81};
+constexpr AttributeKey kNodeTransitStationInfoLatLon{"node.transit_station_info.lat_lon", 82};
+constexpr AttributeKey kNodeTransitEgressInfoOnestopId{"node.transit_egress_info.onestop_id", 83};
+constexpr AttributeKey kNodeTransitEgressInfoName{"node.transit_egress_info.name", 84};
+constexpr AttributeKey kNodeTransitEgressInfoLatLon{"node.transit_egress_info.lat_lon", 85};
+constexpr AttributeKey kNodeTimeZone{"node.time_zone", 86};
+constexpr AttributeKey kNodeTransitionTime{"node.transition_time", 87};
 
 // Top level: osm changeset, admin list, and full shape keys
-const std::string kOsmChangeset = "osm_changeset";
-const std::string kAdminCountryCode = "admin.country_code";
-const std::string kAdminCountryText = "admin.country_text";
-const std::string kAdminStateCode = "admin.state_code";
-const std::string kAdminStateText = "admin.state_text";
-const std::string kShape = "shape";
-const std::string kMatchedPoint = "matched.point";
-const std::string kMatchedType = "matched.type";
-const std::string kMatchedEdgeIndex = "matched.edge_index";
-const std::string kMatchedBeginRouteDiscontinuity = "matched.begin_route_discontinuity";
-const std::string kMatchedEndRouteDiscontinuity = "matched.end_route_discontinuity";
-const std::string kMatchedDistanceAlongEdge = "matched.distance_along_edge";
-const std::string kMatchedDistanceFromTracePoint = "matched.distance_from_trace_point";
-const std::string kConfidenceScore = "confidence_score";
-const std::string kRawScore = "raw_score";
+constexpr AttributeKey kOsmChangeset{"osm_changeset", 88};
+constexpr AttributeKey kAdminCountryCode{"admin.country_code", 89};
+constexpr AttributeKey kAdminCountryText{"admin.country_text", 90};
+constexpr AttributeKey kAdminStateCode{"admin.state_code", 91};
+constexpr AttributeKey kAdminStateText{"admin.state_text", 92};
+constexpr AttributeKey kShape{"shape", 93};
+constexpr AttributeKey kMatchedPoint{"matched.point", 94};
+constexpr AttributeKey kMatchedType{"matched.type", 95};
+constexpr AttributeKey kMatchedEdgeIndex{"matched.edge_index", 96};
+constexpr AttributeKey kMatchedBeginRouteDiscontinuity{"matched.begin_route_discontinuity", 97};
+constexpr AttributeKey kMatchedEndRouteDiscontinuity{"matched.end_route_discontinuity", 98};
+constexpr AttributeKey kMatchedDistanceAlongEdge{"matched.distance_along_edge", 99};
+constexpr AttributeKey kMatchedDistanceFromTracePoint{"matched.distance_from_trace_point", 100};
+constexpr AttributeKey kConfidenceScore{"confidence_score", 101};
+constexpr AttributeKey kRawScore{"raw_score", 102};
 
 // Per-shape attributes
-const std::string kShapeAttributesTime = "shape_attributes.time";
-const std::string kShapeAttributesLength = "shape_attributes.length";
-const std::string kShapeAttributesSpeed = "shape_attributes.speed";
+constexpr AttributeKey kShapeAttributesTime{"shape_attributes.time", 103};
+constexpr AttributeKey kShapeAttributesLength{"shape_attributes.length", 104};
+constexpr AttributeKey kShapeAttributesSpeed{"shape_attributes.speed", 105};
+
+// The number of keys above, they use the bits [0, kAttributeCount)
+constexpr size_t kAttributeCount = 106;
 
 // Categories
 const std::string kNodeCategory = "node.";
@@ -159,7 +184,33 @@ struct AttributesController {
    */
   bool category_attribute_enabled(const std::string& category) const;
 
-  std::unordered_map<std::string, bool> attributes;
+  /**
+   * Returns true if the attribute is enabled, false otherwise.
+   */
+  bool operator()(const AttributeKey& key) const {
+    return attributes[key.bit];
+  }
+
+  /**
+   * Returns true if the attribute with the given name is enabled, false otherwise.
+   * @throws std::out_of_range if there is no attribute with that name
+   */
+  bool operator()(const std::string& name) const;
+
+  /**
+   * Enable or disable an attribute.
+   */
+  void set(const AttributeKey& key, bool enabled) {
+    attributes[key.bit] = enabled;
+  }
+
+  /**
+   * Enable or disable the attribute with the given name, as they come in requests.
+   * @return false if there is no attribute with that name
+   */
+  bool set(const std::string& name, bool enabled);
+
+  std::bitset<kAttributeCount> attributes;
 };
 
 } // namespace thor
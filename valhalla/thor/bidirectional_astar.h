@@ -12,6 +12,7 @@
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/sif/hierarchylimits.h>
+#include <valhalla/sif/staticcost.h>
 #include <valhalla/thor/astarheuristic.h>
 #include <valhalla/thor/edgestatus.h>
 #include <valhalla/thor/pathalgorithm.h>
@@ -42,8 +43,10 @@ class BidirectionalAStar : public PathAlgorithm {
 public:
   /**
    * Constructor.
+   * @param  queue_mode  How the adjacency lists order their edge labels.
    */
-  BidirectionalAStar();
+  BidirectionalAStar(
+      const baldr::BucketQueueMode queue_mode = baldr::BucketQueueMode::kDoubleBucket);
 
   /**
    * Destructor
@@ -100,9 +103,10 @@ protected:
   std::vector<sif::BDEdgeLabel> edgelabels_forward_;
   std::vector<sif::BDEdgeLabel> edgelabels_reverse_;
 
-  // Adjacency list - approximate double bucket sort
-  std::shared_ptr<baldr::DoubleBucketQueue> adjacencylist_forward_;
-  std::shared_ptr<baldr::DoubleBucketQueue> adjacencylist_reverse_;
+  // Adjacency list - approximate double bucket sort (or radix heap). Kept
+  // across requests so their storage is reused
+  baldr::BucketQueue<std::vector<sif::BDEdgeLabel>> adjacencylist_forward_;
+  baldr::BucketQueue<std::vector<sif::BDEdgeLabel>> adjacencylist_reverse_;
 
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_forward_;
@@ -120,16 +124,34 @@ protected:
    */
   void Init(const midgard::PointLL& origll, const midgard::PointLL& destll);
 
+  /**
+   * Run the forward and reverse searches until they have met and the threshold is reached.
+   * Instantiated per costing type (see sif::DispatchCost) so the costing calls of the
+   * expansion are inlined.
+   * @param  costing      The costing of the request.
+   * @param  graphreader  Graph tile reader.
+   * @param  options      Request options.
+   * @return Returns the path infos, empty if there is no path.
+   */
+  template <typename cost_t>
+  std::vector<std::vector<PathInfo>> Search(const sif::StaticCost<cost_t> costing,
+                                            baldr::GraphReader& graphreader,
+                                            const Options& options);
+
   /**
    * Expand from the node along the forward search path.
    */
-  bool ExpandForward(baldr::GraphReader& graphreader,
+  template <typename cost_t>
+  bool ExpandForward(const sif::StaticCost<cost_t> costing,
+                     baldr::GraphReader& graphreader,
                      const baldr::GraphId& node,
                      sif::BDEdgeLabel& pred,
                      const uint32_t pred_idx,
                      const bool from_transition);
   // Private helper function for `ExpandForward`
-  bool ExpandForwardInner(baldr::GraphReader& graphreader,
+  template <typename cost_t>
+  bool ExpandForwardInner(const sif::StaticCost<cost_t> costing,
+                          baldr::GraphReader& graphreader,
                           const sif::BDEdgeLabel& pred,
                           const baldr::NodeInfo* nodeinfo,
                           const uint32_t pred_idx,
@@ -140,7 +162,9 @@ protected:
   /**
    * Expand from the node along the reverse search path.
    */
-  bool ExpandReverse(baldr::GraphReader& graphreader,
+  template <typename cost_t>
+  bool ExpandReverse(const sif::StaticCost<cost_t> costing,
+                     baldr::GraphReader& graphreader,
                      const baldr::GraphId& node,
                      sif::BDEdgeLabel& pred,
                      const uint32_t pred_idx,
@@ -148,7 +172,9 @@ protected:
                      const bool from_transition);
 
   // Private helper function for `ExpandReverse`
-  bool ExpandReverseInner(baldr::GraphReader& graphreader,
+  template <typename cost_t>
+  bool ExpandReverseInner(const sif::StaticCost<cost_t> costing,
+                          baldr::GraphReader& graphreader,
                           const sif::BDEdgeLabel& pred,
                           const baldr::DirectedEdge* opp_pred_edge,
                           const baldr::NodeInfo* nodeinfo,
@@ -0,0 +1,176 @@
+#ifndef VALHALLA_THOR_BUCKETMATRIX_H_
+#define VALHALLA_THOR_BUCKETMATRIX_H_
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/proto/tripcommon.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgelabel.h>
+#include <valhalla/thor/costmatrix.h>
+#include <valhalla/thor/edgestatus.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Class to compute cost (cost + time + distance) matrices among locations
+ * for sets of targets that are used over and over (e.g. a fleet of depots).
+ * Like the CostMatrix it connects forward searches from the sources to
+ * backward searches from the targets, using the hierarchy levels and
+ * shortcut edges the same way. The difference is in how the work is split:
+ * the backward search of every target is run to completion up front (the
+ * target selection phase) and its reached edges act as buckets which the
+ * forward searches scan. Each source then costs a single forward search
+ * rather than being interleaved with the targets.
+ *
+ * The target selection phase only depends on the target edges, the costing
+ * and the cost threshold, so target sets are kept (most recently used first)
+ * and reused by later requests with the same key. Every edge a backward
+ * search reached has a bucket entry, so the cache is bounded by the bytes of
+ * the target sets rather than their number. The speeds of the graph change
+ * with live traffic, so a target set is only reused for the target set time
+ * to live and selected again after that.
+ *
+ * Like those of the CostMatrix, the backward searches stop at the cost
+ * threshold of the max matrix distance, and give up like the forward
+ * searches after kMaxMatrixIterations edges.
+ */
+class BucketMatrix : public CostMatrix {
+public:
+  static constexpr size_t kDefaultMaxCacheSize = 128 * 1024 * 1024;
+
+  /**
+   * Constructor.
+   * @param  max_cache_size  Bytes of target selection phases to keep for
+   *                         later requests. A target set larger than this is
+   *                         only used for the request that selected it.
+   * @param  target_set_ttl  Seconds a target selection phase is reused for,
+   *                         0 to keep it until it is evicted.
+   */
+  BucketMatrix(const size_t max_cache_size = kDefaultMaxCacheSize,
+               const float target_set_ttl = 0.0f);
+
+  /**
+   * Forms a time distance matrix from the set of source locations
+   * to the set of target locations.
+   * @param  source_location_list  List of source/origin locations.
+   * @param  target_location_list  List of target/destination locations.
+   * @param  graphreader           Graph reader for accessing routing graph.
+   * @param  mode_costing          Costing methods.
+   * @param  mode                  Travel mode to use.
+   * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @param  costing_key           Identifies the costing options, target sets are
+   *                               only reused by requests with the same key.
+   * @return time/distance from origin index to all other locations
+   * @throws valhalla_exception_t 430 if a search exceeds the max iterations
+   */
+  std::vector<TimeDistance>
+  SourceToTarget(const google::protobuf::RepeatedPtrField<valhalla::Location>& source_location_list,
+                 const google::protobuf::RepeatedPtrField<valhalla::Location>& target_location_list,
+                 baldr::GraphReader& graphreader,
+                 const std::shared_ptr<sif::DynamicCost>* mode_costing,
+                 const sif::TravelMode mode,
+                 const float max_matrix_distance,
+                 const std::string& costing_key);
+
+  /**
+   * Drops all cached target selection phases.
+   */
+  void ClearCache();
+
+protected:
+  // What a forward search settling an edge needs to connect to a target
+  // whose backward search reached the opposing edge
+  struct BucketEntry {
+    uint32_t target;
+    bool origin;       // The opposing edge is one of the target's own edges
+    float cost;        // Cost from the end of the opposing edge on to the target
+    float secs;        // Seconds from the end of the opposing edge on to the target
+    uint32_t distance; // Distance from the end of the opposing edge on to the target
+
+    // Only used for origin edges, where the connection lies within one edge:
+    // the label's seconds, its transition cost and seconds (which hold the
+    // edge cost and length) and path distance
+    float origin_secs;
+    float origin_transition_cost;
+    float origin_transition_secs;
+    uint32_t origin_distance;
+  };
+
+  // Result of the target selection phase: the buckets of the edges reached
+  // by the backward searches of the targets, the size of each search and
+  // the approximate bytes it all takes
+  struct TargetSet {
+    std::string key;
+    std::chrono::steady_clock::time_point selected;
+    std::unordered_map<baldr::GraphId, std::vector<BucketEntry>> buckets;
+    std::vector<uint32_t> label_counts;
+    size_t size;
+  };
+
+  size_t max_cache_size_;
+  float target_set_ttl_;
+
+  // Target selection phases, most recently used first, and their total
+  // size. The first one is used by the request being computed
+  std::list<TargetSet> target_sets_;
+  size_t cache_size_;
+
+  /**
+   * Drops the least recently used target sets until the cache fits in its
+   * max size, keeping at least the given number of them.
+   * @param  keep  Number of most recently used target sets to keep.
+   */
+  void Trim(const size_t keep);
+
+  /**
+   * Get the number of edge labels of the backward search of a target.
+   * @param  target  Target index.
+   */
+  size_t TargetLabelCount(const uint32_t target) const override;
+
+  /**
+   * Check if the edge on the forward search connects to the bucket of a
+   * target at its opposing edge.
+   * @param  source  Source index.
+   * @param  pred    Edge label of the predecessor.
+   * @param  n       Iteration counter.
+   */
+  void CheckForwardConnections(const uint32_t source,
+                               const sif::BDEdgeLabel& pred,
+                               const uint32_t n) override;
+
+  /**
+   * Runs the backward search of each target until it is exhausted or
+   * exceeds the cost threshold, and keeps the edges it reached as buckets.
+   * Throws valhalla_exception_t 430 if a search exceeds the max iterations.
+   * @param  graphreader   Graph reader for accessing routing graph.
+   * @param  targets       List of target locations.
+   * @param  target_set    Target set to fill in.
+   */
+  void SelectTargets(baldr::GraphReader& graphreader,
+                     const google::protobuf::RepeatedPtrField<valhalla::Location>& targets,
+                     TargetSet& target_set);
+
+  /**
+   * Runs the forward search of a source until it is exhausted, exceeds the
+   * cost threshold or has been continued long enough after reaching all
+   * targets.
+   * @param  source       Index of the source location.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void SweepSource(const uint32_t source, baldr::GraphReader& graphreader);
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_BUCKETMATRIX_H_
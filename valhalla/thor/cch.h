@@ -0,0 +1,365 @@
+#ifndef VALHALLA_THOR_CCH_H_
+#define VALHALLA_THOR_CCH_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/cchoverlay.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/pathalgorithm.h>
+#include <valhalla/thor/pathinfo.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * The weights of a contraction hierarchy overlay for one costing: the cost of each arc in both
+ * directions and what the cheapest way along it is, either one of its directed edges or a path
+ * through a lower vertex. Customizing a metric reads every edge once and then runs over the
+ * lower triangles of the overlay lowest vertex first, so it takes seconds rather than the rebuild
+ * fixed shortcuts would need, and picks up the current traffic and costing options.
+ *
+ * The metric only has the edge costs of the costing, not its turn costs or restrictions, which
+ * depend on the edge before. Paths found on it are checked and costed edge by edge afterwards.
+ */
+class CCHMetric {
+public:
+  static constexpr float kNoPath = std::numeric_limits<float>::max();
+  // Set on the via of an arc that is one of its directed edges (the index of the edge)
+  static constexpr uint32_t kEdgeVia = 1u << 31;
+  static constexpr uint32_t kNoVia = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Customize the overlay for a costing.
+   * @param  overlay      The contraction hierarchy overlay.
+   * @param  graphreader  Graph reader for the edges of the overlay.
+   * @param  costing      The costing, its access mode has to be the one of the overlay.
+   */
+  CCHMetric(const baldr::CCHOverlay& overlay,
+            baldr::GraphReader& graphreader,
+            const sif::DynamicCost& costing);
+
+  /**
+   * Can a path of this metric use an edge at all. Destination only edges are left out as they are
+   * on the first pass of the other route algorithms.
+   * @param  filter  Edge filter of the costing.
+   * @param  edge    The directed edge.
+   */
+  static bool Usable(const sif::EdgeFilter& filter, const baldr::DirectedEdge* edge) {
+    return filter(edge) > 0.0f && !edge->destonly() &&
+           edge->surface() != baldr::Surface::kImpassable;
+  }
+
+  /**
+   * @param  arc  An arc of the overlay.
+   * @return the cost from the lower vertex of the arc to the higher one, kNoPath if there is none
+   */
+  float up(const uint32_t arc) const {
+    return weights_[arc].up;
+  }
+
+  /**
+   * @param  arc  An arc of the overlay.
+   * @return the cost from the higher vertex of the arc to the lower one, kNoPath if there is none
+   */
+  float down(const uint32_t arc) const {
+    return weights_[arc].down;
+  }
+
+  /**
+   * @param  arc  An arc of the overlay.
+   * @param  up   True for the direction from the lower vertex to the higher one.
+   * @return kEdgeVia and the index of the directed edge if the arc is best taken along one of
+   *         its edges, the lower vertex to go through otherwise, kNoVia if there is no path.
+   */
+  uint32_t via(const uint32_t arc, const bool up) const {
+    return up ? weights_[arc].up_via : weights_[arc].down_via;
+  }
+
+  /**
+   * @return Returns how long the customization took in seconds.
+   */
+  float customization_secs() const {
+    return customization_secs_;
+  }
+
+protected:
+  struct Weight {
+    float up;
+    float down;
+    uint32_t up_via;
+    uint32_t down_via;
+  };
+  std::vector<Weight> weights_;
+  float customization_secs_;
+};
+
+/**
+ * Customizes metrics of an overlay on a thread of its own, one at a time, with one graph reader.
+ * The thor workers of a process routing on the same overlay file share it, so a set of costing
+ * options being customized for one of them is not customized again for the others. Only so many
+ * customizations are queued at once, more are turned down until some are done. The thread is
+ * joined when the last worker lets go of the customizer, customizations still queued then are
+ * given up and their metrics are nullptr.
+ */
+class CCHCustomizer {
+public:
+  using metric_future_t = std::shared_future<std::shared_ptr<const CCHMetric>>;
+
+  /**
+   * Constructor.
+   * @param  overlay      The overlay to customize metrics of.
+   * @param  mjolnir      Config of the graph reader the metrics are customized with.
+   * @param  max_pending  Largest number of customizations queued at once, the one running
+   *                      included.
+   */
+  CCHCustomizer(const std::shared_ptr<const baldr::CCHOverlay>& overlay,
+                const boost::property_tree::ptree& mjolnir,
+                const size_t max_pending);
+
+  /**
+   * Gives up the queued customizations and joins the thread.
+   */
+  ~CCHCustomizer();
+
+  /**
+   * Get the customizer shared by the workers routing on an overlay file, making it if there is
+   * none. The first one sets how many customizations are queued at once.
+   * @param  overlay      The overlay.
+   * @param  mjolnir      Config of the graph reader, its cch.file (or the overlay.cch of its
+   *                      tile_dir) is the file the overlay is from.
+   * @param  max_pending  Largest number of customizations queued at once.
+   */
+  static std::shared_ptr<CCHCustomizer> get(const std::shared_ptr<const baldr::CCHOverlay>& overlay,
+                                            const boost::property_tree::ptree& mjolnir,
+                                            const size_t max_pending);
+
+  /**
+   * Queue customizing a metric, or join the customization of the same costing options if it is
+   * already queued.
+   * @param  key      Costing and costing options of the metric.
+   * @param  options  Request options, their costing options are the ones of the metric.
+   * @return Returns the metric once it is customized, an invalid future if too many
+   *         customizations are queued already.
+   */
+  metric_future_t Customize(const std::string& key, const Options& options);
+
+protected:
+  struct Job {
+    std::string key;
+    Options options;
+    std::promise<std::shared_ptr<const CCHMetric>> promise;
+    metric_future_t metric;
+  };
+
+  /**
+   * Customize the queued metrics, oldest first, until stopped.
+   */
+  void Work();
+
+  std::shared_ptr<const baldr::CCHOverlay> overlay_;
+  boost::property_tree::ptree mjolnir_;
+  size_t max_pending_;
+
+  // Queued customizations, the first one is running
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::list<Job> jobs_;
+  bool stop_;
+  std::thread thread_;
+};
+
+/**
+ * Route algorithm on a contraction hierarchy overlay. A search upward from the ends of the
+ * origin edges and one from the starts of the destination edges only need the vertices on the
+ * paths to the root of the elimination tree, no priority queue, and where they meet is the
+ * best path. Its arcs are unpacked into the directed edges of the graph and the path is checked
+ * and costed with the costing, turn costs and restrictions included. Any path that breaks a turn
+ * restriction or isn't allowed by the costing is dropped so the caller can fall back to one of
+ * the other algorithms.
+ *
+ * The metric has no turn costs, so the path it finds is only sure to be the best one when the
+ * turns along it cost nothing. Its turn costs are a bound on how much worse than the best path
+ * it can be: a path whose turn costs are more than the max turn cost ratio of its edge costs is
+ * dropped as well, so the paths the overlay answers with cost at most that fraction more than the
+ * best one. The costings almost always have some cost at every node a path goes through, so with
+ * a ratio of 0 no path would be kept and the overlay isn't searched at all.
+ * Origins and destinations on the same edge are left to the other algorithms too.
+ *
+ * Metrics are customized for the costing options of the requests as they come in and kept for a
+ * few of them (most recently used first). Customizing takes seconds, so by default it is done by
+ * a customizer shared with the other workers and requests use the other algorithms until the
+ * metric is ready. Metrics being customized are not evicted. Metrics are customized again once
+ * older than the metric time to live so live traffic makes it into the routes, the old metric is
+ * used until the new one is ready.
+ */
+class CCHQuery : public PathAlgorithm {
+public:
+  /**
+   * Constructor.
+   * @param  max_cached_metrics   Number of metrics to keep for later requests.
+   * @param  metric_ttl           Seconds a metric is used for before it is customized again,
+   *                              0 to keep it until it is evicted.
+   * @param  max_turn_cost_ratio  Largest turn costs of a path, as a fraction of its edge costs,
+   *                              the overlay answers with, 0 to not use the overlay.
+   */
+  CCHQuery(const size_t max_cached_metrics = 4,
+           const float metric_ttl = 0.0f,
+           const float max_turn_cost_ratio = 0.1f);
+
+  /**
+   * Sets the overlay to route on and drops the metrics of any previous one.
+   * @param  overlay  The overlay, nullptr to not route on an overlay.
+   * @param  mjolnir  Config of the graph reader of the customizer metrics are customized by,
+   *                  none to customize them on the thread of the request instead.
+   */
+  void set_overlay(const std::shared_ptr<const baldr::CCHOverlay>& overlay,
+                   const boost::property_tree::ptree& mjolnir = {});
+
+  /**
+   * Can requests with this costing be routed on the overlay.
+   * @param  costing  The costing.
+   * @param  options  The request options.
+   */
+  bool Supports(const sif::DynamicCost& costing, const Options& options) const;
+
+  /**
+   * Form path between and origin and destination location using the supplied
+   * costing method.
+   * @param  origin       Origin location
+   * @param  dest         Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  mode_costing Costing methods.
+   * @param  mode         Travel mode to use.
+   * @param  options      Request options, their costing options select the metric.
+   * @return Returns the path edges (and elapsed time/modes at end of
+   *          each edge), empty if there is no path on the overlay or it had to be dropped.
+   */
+  std::vector<std::vector<PathInfo>>
+  GetBestPath(valhalla::Location& origin,
+              valhalla::Location& dest,
+              baldr::GraphReader& graphreader,
+              const std::shared_ptr<sif::DynamicCost>* mode_costing,
+              const sif::TravelMode mode,
+              const Options& options = Options::default_instance()) override;
+
+  /**
+   * Clear the temporary information generated during path construction.
+   */
+  void Clear() override;
+
+  /**
+   * Drops all cached metrics.
+   */
+  void ClearCache();
+
+protected:
+  struct CachedMetric {
+    std::string key;
+    std::chrono::steady_clock::time_point customized;
+    std::shared_ptr<const CCHMetric> metric;
+    // The metric being customized by the customizer, if any
+    CCHCustomizer::metric_future_t pending;
+  };
+
+  // One of the two searches: the best cost to each vertex reached, the vertex it came from
+  // (kNoVertex for the ones an origin or destination edge is at) and the vertices it may reach,
+  // the ancestors of where it starts in the elimination tree, lowest first
+  struct Search {
+    std::vector<float> costs;
+    std::vector<uint32_t> preds;
+    std::vector<uint32_t> ancestors;
+    std::vector<std::pair<uint32_t, uint32_t>> starts; // vertex, location edge index
+  };
+
+  std::shared_ptr<const baldr::CCHOverlay> overlay_;
+  std::shared_ptr<CCHCustomizer> customizer_;
+  size_t max_cached_metrics_;
+  float metric_ttl_;
+  float max_turn_cost_ratio_;
+
+  // Metrics, most recently used first
+  std::list<CachedMetric> metrics_;
+
+  Search forward_;
+  Search reverse_;
+  std::vector<uint8_t> marks_;
+
+  /**
+   * Get the metric for the costing options of a request, customizing it if there is none or it
+   * has outlived the metric time to live.
+   * @return Returns the metric, nullptr while it is being customized by the customizer.
+   */
+  std::shared_ptr<const CCHMetric> GetMetric(baldr::GraphReader& graphreader,
+                                             const sif::DynamicCost& costing,
+                                             const Options& options);
+
+  /**
+   * Start a search at the vertices of the edges of a location and mark their ancestors.
+   * @param  location     The origin or destination.
+   * @param  forward      True for the origin, whose edges are left at their ends.
+   * @param  search       The search to start.
+   */
+  void Start(baldr::GraphReader& graphreader,
+             const sif::DynamicCost& costing,
+             const valhalla::Location& location,
+             const bool forward,
+             Search& search);
+
+  /**
+   * Relax the arcs of the ancestors of a search, lowest first.
+   */
+  void Sweep(const CCHMetric& metric, const bool forward, Search& search);
+
+  /**
+   * Append the directed edges an arc stands for.
+   * @param  lower   The lower vertex of the arc.
+   * @param  higher  The higher vertex of the arc.
+   * @param  up      True for the direction from the lower vertex to the higher one.
+   * @param  edges   Indexes of the directed edges in the overlay.
+   */
+  void Unpack(const CCHMetric& metric,
+              const uint32_t lower,
+              const uint32_t higher,
+              const bool up,
+              std::vector<uint32_t>& edges) const;
+
+  /**
+   * Are any of the origin edges the same as a destination edge or its opposing edge.
+   */
+  bool SharesEdge(baldr::GraphReader& graphreader,
+                  const valhalla::Location& origin,
+                  const valhalla::Location& destination) const;
+
+  /**
+   * Cost the unpacked path edge by edge with the costing, turn costs included.
+   * @return Returns the path, empty if the costing doesn't allow it or its turn costs are more
+   *         than the max turn cost ratio of its edge costs.
+   */
+  std::vector<PathInfo> FormPath(baldr::GraphReader& graphreader,
+                                 const sif::DynamicCost& costing,
+                                 const sif::TravelMode mode,
+                                 const std::vector<baldr::GraphId>& edges,
+                                 const float origin_percent,
+                                 const float destination_percent);
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_CCH_H_
@@ -15,6 +15,7 @@
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
+#include <valhalla/sif/staticcost.h>
 #include <valhalla/thor/edgestatus.h>
 
 namespace valhalla {
@@ -94,6 +95,12 @@ public:
    */
   CostMatrix();
 
+  /**
+   * Destructor
+   */
+  virtual ~CostMatrix() {
+  }
+
   /**
    * Forms a time distance matrix from the set of source locations
    * to the set of target locations.
@@ -103,6 +110,9 @@ public:
    * @param  mode_costing          Costing methods.
    * @param  mode                  Travel mode to use.
    * @param  max_matrix_distance   Maximum arc-length distance for current mode.
+   * @param  helper_readers        Graph readers of extra threads to expand the per location
+   *                               searches with concurrently, one per thread. The result is
+   *                               the same as without them.
    * @return time/distance from origin index to all other locations
    */
   std::vector<TimeDistance>
@@ -111,7 +121,8 @@ public:
                  baldr::GraphReader& graphreader,
                  const std::shared_ptr<sif::DynamicCost>* mode_costing,
                  const sif::TravelMode mode,
-                 const float max_matrix_distance);
+                 const float max_matrix_distance,
+                 const std::vector<std::shared_ptr<baldr::GraphReader>>& helper_readers = {});
 
   /**
    * Clear the temporary information generated during time+distance
@@ -162,6 +173,30 @@ protected:
   // List of best connections found so far
   std::vector<BestCandidate> best_connection_;
 
+  // When the per location searches run concurrently, changes they would make
+  // to state shared with other locations are queued per location and applied
+  // in location order after each pass, so the result matches a serial run:
+  // per source the target status updates (target, source edge label count),
+  // per target the edges it reached and whether its search was exhausted
+  bool queue_updates_;
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> queued_target_updates_;
+  std::vector<std::vector<baldr::GraphId>> queued_target_edges_;
+  std::vector<uint8_t> exhausted_targets_;
+
+  /**
+   * Get the number of additional iterations to continue a search for once a
+   * connection (or all of them) has been found.
+   * @param  mode  Travel mode.
+   * @param  n     Combined number of edge labels of the searches involved.
+   */
+  static int GetThreshold(const sif::TravelMode mode, const int n);
+
+  /**
+   * Get the number of edge labels of the backward search of a target.
+   * @param  target  Target index.
+   */
+  virtual size_t TargetLabelCount(const uint32_t target) const;
+
   /**
    * Get the cost threshold based on the current mode and the max arc-length distance
    * for that mode.
@@ -180,11 +215,16 @@ protected:
 
   /**
    * Iterate the forward search from the source/origin location.
+   * @param  costing      Costing bound to its concrete type for the expansion.
    * @param  index        Index of the source location.
    * @param  n            Iteration counter.
    * @param  graphreader  Graph reader for accessing routing graph.
    */
-  void ForwardSearch(const uint32_t index, const uint32_t n, baldr::GraphReader& graphreader);
+  template <typename cost_t>
+  void ForwardSearch(const sif::StaticCost<cost_t> costing,
+                     const uint32_t index,
+                     const uint32_t n,
+                     baldr::GraphReader& graphreader);
 
   /**
    * Check if the edge on the forward search connects to a reached edge
@@ -193,7 +233,8 @@ protected:
    * @param  pred    Edge label of the predecessor.
    * @param  n       Iteration counter.
    */
-  void CheckForwardConnections(const uint32_t source, const sif::BDEdgeLabel& pred, const uint32_t n);
+  virtual void
+  CheckForwardConnections(const uint32_t source, const sif::BDEdgeLabel& pred, const uint32_t n);
 
   /**
    * Update status when a connection is found.
@@ -202,12 +243,34 @@ protected:
    */
   void UpdateStatus(const uint32_t source, const uint32_t target);
 
+  /**
+   * Update the status of the source when a connection is found.
+   * @param  source  Source index
+   * @param  target  Target index
+   */
+  void UpdateSourceStatus(const uint32_t source, const uint32_t target);
+
+  /**
+   * Update the status of the target when a connection is found.
+   * @param  source              Source index
+   * @param  target              Target index
+   * @param  source_label_count  Number of edge labels of the source search at
+   *                             the time the connection was found.
+   */
+  void UpdateTargetStatus(const uint32_t source,
+                          const uint32_t target,
+                          const uint32_t source_label_count);
+
   /**
    * Iterate the backward search from the target/destination location.
+   * @param  costing      Costing bound to its concrete type for the expansion.
    * @param  index        Index of the target location.
    * @param  graphreader  Graph reader for accessing routing graph.
    */
-  void BackwardSearch(const uint32_t index, baldr::GraphReader& graphreader);
+  template <typename cost_t>
+  void BackwardSearch(const sif::StaticCost<cost_t> costing,
+                      const uint32_t index,
+                      baldr::GraphReader& graphreader);
 
   /**
    * Sets the source/origin locations. Search expands forward from these
@@ -15,6 +15,7 @@
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
+#include <valhalla/sif/staticcost.h>
 #include <valhalla/thor/edgestatus.h>
 
 namespace valhalla {
@@ -151,6 +152,7 @@ protected:
 
   /**
    * Expand from the node along the forward search path.
+   * @param costing  Costing bound to its concrete type for the expansion.
    * @param graphreader  Graph reader.
    * @param node Graph Id of the node to expand.
    * @param pred Edge label of the predecessor edge leading to the node.
@@ -159,7 +161,9 @@ protected:
    * @param localtime Current local time.  Seconds since epoch.
    * @param seconds_of_week For time dependent Dijkstrass this allows lookup of predicted traffic.
    */
-  void ExpandForward(baldr::GraphReader& graphreader,
+  template <typename cost_t>
+  void ExpandForward(const sif::StaticCost<cost_t> costing,
+                     baldr::GraphReader& graphreader,
                      const baldr::GraphId& node,
                      const sif::EdgeLabel& pred,
                      const uint32_t pred_idx,
@@ -169,6 +173,7 @@ protected:
 
   /**
    * Expand from the node along the reverse search path.
+   * @param costing  Costing bound to its concrete type for the expansion.
    * @param graphreader  Graph reader.
    * @param node Graph Id of the node to expand.
    * @param pred Edge label of the predecessor edge leading to the node.
@@ -177,7 +182,9 @@ protected:
    * @param localtime Current local time.  Seconds since epoch.
    * @param seconds_of_week For time dependent Dijkstrass this allows lookup of predicted traffic.
    */
-  void ExpandReverse(baldr::GraphReader& graphreader,
+  template <typename cost_t>
+  void ExpandReverse(const sif::StaticCost<cost_t> costing,
+                     baldr::GraphReader& graphreader,
                      const baldr::GraphId& node,
                      const sif::BDEdgeLabel& pred,
                      const uint32_t pred_idx,
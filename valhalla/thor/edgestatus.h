@@ -1,7 +1,12 @@
 #ifndef VALHALLA_THOR_EDGESTATUS_H_
 #define VALHALLA_THOR_EDGESTATUS_H_
 
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 
@@ -47,25 +52,39 @@ struct EdgeStatusInfo {
  * edges within arrays for each tile. This allows the path algorithms to get
  * a pointer to the first edge status and iterate that pointer over sequential
  * edges. This reduces the number of map lookups.
+ *
+ * Tiles are found through a small open addressing table of tile slots rather
+ * than a node based hash map, and the per tile arrays are pooled so that they
+ * can be reused by the next search instead of being reallocated. Clearing only
+ * resets the slots that were used.
  */
 class EdgeStatus {
 public:
-  /**
-   * Destructor. Delete any allocated EdgeStatusInfo arrays.
-   */
-  ~EdgeStatus() {
-    clear();
+  EdgeStatus()
+      : last_tile_(kInvalidTile), last_array_(nullptr), tile_count_(0), slots_(kMinSlots) {
   }
 
   /**
-   * Clear the EdgeStatusInfo arrays and the edge status map.
+   * Clear the edge status of all tiles. The EdgeStatusInfo arrays are kept
+   * around (up to a limit) so the next search can reuse them.
    */
   void clear() {
-    // Delete any allocated arrays for tiles within the map.
-    for (auto& iter : edgestatus_) {
-      delete[] iter.second;
+    if (tile_count_ > 0) {
+      std::fill(slots_.begin(), slots_.end(), Slot{});
+    }
+    tile_count_ = 0;
+    last_tile_ = kInvalidTile;
+    last_array_ = nullptr;
+
+    // Keep the pool from holding on to the memory of one huge search forever
+    size_t pooled = 0;
+    for (size_t i = 0; i < arrays_.size(); ++i) {
+      pooled += arrays_[i].capacity();
+      if (pooled > kMaxPooledEdges) {
+        arrays_.resize(i);
+        break;
+      }
     }
-    edgestatus_.clear();
   }
 
   /**
@@ -79,16 +98,7 @@ public:
            const EdgeSet set,
            const uint32_t index,
            const baldr::GraphTile* tile) {
-    auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()] = {set, index};
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value(),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      inserted.first->second[edgeid.id()] = {set, index};
-    }
+    GetPtr(edgeid, tile)[0] = {set, index};
   }
 
   /**
@@ -98,22 +108,25 @@ public:
    * @param  set      Label set for this directed edge.
    */
   void Update(const baldr::GraphId& edgeid, const EdgeSet set) {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()].set_ = static_cast<uint32_t>(set);
+    EdgeStatusInfo* array = Find(edgeid.tile_value());
+    if (array) {
+      array[edgeid.id()].set_ = static_cast<uint32_t>(set);
     } else {
       throw std::runtime_error("EdgeStatus Update on edge not previously set");
     }
   }
 
   /**
-   * Get the status info of a directed edge given its GraphId.
+   * Get the status info of a directed edge given its GraphId. This does not
+   * modify the edge status (not even the last tile lookup) so it is safe to
+   * call from several threads as long as none of them changes the status.
    * @param   edgeid  GraphId of the directed edge.
    * @return  Returns edge status info.
    */
   EdgeStatusInfo Get(const baldr::GraphId& edgeid) const {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+    const uint32_t tile_value = edgeid.tile_value();
+    const EdgeStatusInfo* array = tile_value == last_tile_ ? last_array_ : Lookup(tile_value);
+    return array ? array[edgeid.id()] : EdgeStatusInfo();
   }
 
   /**
@@ -125,23 +138,104 @@ public:
    * @return  Returns a pointer to edge status info for this edge.
    */
   EdgeStatusInfo* GetPtr(const baldr::GraphId& edgeid, const baldr::GraphTile* tile) {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      return &p->second[edgeid.id()];
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value(),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      return &(inserted.first->second)[edgeid.id()];
+    const uint32_t tile_value = edgeid.tile_value();
+    EdgeStatusInfo* array = Find(tile_value);
+    if (!array) {
+      // Tile has not been seen yet. Hand it an array of EdgeStatusInfo, sized
+      // to the number of directed edges in the specified tile.
+      array = Insert(tile_value, tile->header()->directededgecount());
     }
+    return &array[edgeid.id()];
   }
 
 private:
-  // Edge status - keys are the tile Ids (level and tile Id) and the
-  // values are dynamically allocated arrays of EdgeStatusInfo (sized
-  // based on the directed edge count within the tile).
-  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+  static constexpr uint32_t kInvalidTile = std::numeric_limits<uint32_t>::max();
+  static constexpr size_t kMinSlots = 64;
+  // Most edge status entries the pool keeps between searches (8MB)
+  static constexpr size_t kMaxPooledEdges = 1 << 21;
+
+  struct Slot {
+    uint32_t tile = kInvalidTile;
+    uint32_t array = 0;
+  };
+
+  size_t SlotIndex(const uint32_t tile_value) const {
+    // tile ids are dense so scramble them a bit before masking
+    return (tile_value * 2654435761u) & (slots_.size() - 1);
+  }
+
+  EdgeStatusInfo* Lookup(const uint32_t tile_value) const {
+    for (size_t i = SlotIndex(tile_value);; i = (i + 1) & (slots_.size() - 1)) {
+      const Slot& slot = slots_[i];
+      if (slot.tile == tile_value) {
+        return const_cast<EdgeStatusInfo*>(arrays_[slot.array].data());
+      }
+      if (slot.tile == kInvalidTile) {
+        return nullptr;
+      }
+    }
+  }
+
+  EdgeStatusInfo* Find(const uint32_t tile_value) {
+    // Searches tend to stay within the same tile for a while
+    if (tile_value == last_tile_) {
+      return last_array_;
+    }
+    EdgeStatusInfo* array = Lookup(tile_value);
+    if (array) {
+      last_tile_ = tile_value;
+      last_array_ = array;
+    }
+    return array;
+  }
+
+  EdgeStatusInfo* Insert(const uint32_t tile_value, const uint32_t edge_count) {
+    // Keep the table at most half full
+    if ((tile_count_ + 1) * 2 > slots_.size()) {
+      std::vector<Slot> slots(slots_.size() * 2);
+      slots.swap(slots_);
+      for (const auto& slot : slots) {
+        if (slot.tile != kInvalidTile) {
+          size_t i = SlotIndex(slot.tile);
+          while (slots_[i].tile != kInvalidTile) {
+            i = (i + 1) & (slots_.size() - 1);
+          }
+          slots_[i] = slot;
+        }
+      }
+    }
+
+    // Take the next array from the pool, arrays past tile_count_ are unused
+    if (tile_count_ == arrays_.size()) {
+      arrays_.emplace_back();
+    }
+    auto& array = arrays_[tile_count_];
+    array.assign(edge_count, EdgeStatusInfo());
+
+    size_t i = SlotIndex(tile_value);
+    while (slots_[i].tile != kInvalidTile) {
+      i = (i + 1) & (slots_.size() - 1);
+    }
+    slots_[i] = {tile_value, tile_count_++};
+
+    last_tile_ = tile_value;
+    last_array_ = array.data();
+    return last_array_;
+  }
+
+  // The last tile looked up and its array
+  uint32_t last_tile_;
+  EdgeStatusInfo* last_array_;
+
+  // Number of tiles in use, they own the first tile_count_ arrays
+  uint32_t tile_count_;
+
+  // Open addressing table from tile Id (level and tile Id) to array index
+  std::vector<Slot> slots_;
+
+  // Pool of EdgeStatusInfo arrays (sized based on the directed edge count
+  // within the tile they are currently used for).
+  std::vector<std::vector<EdgeStatusInfo>> arrays_;
 };
 
 } // namespace thor
@@ -9,6 +9,7 @@
 
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/landmarks.h>
 #include <valhalla/proto/api.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/thor/edgestatus.h>
@@ -91,6 +92,15 @@ public:
     expansion_callback_ = expansion_callback;
   }
 
+  /**
+   * Sets the landmark tables used to tighten the A* heuristic of the algorithms that have one.
+   * Costings whose access mode has no table keep the straight line heuristic.
+   * @param  landmarks  Landmark tables, nullptr to not use landmarks.
+   */
+  void set_landmarks(const std::shared_ptr<const baldr::Landmarks>& landmarks) {
+    landmarks_ = landmarks;
+  }
+
 protected:
   const std::function<void()>* interrupt;
 
@@ -99,6 +109,47 @@ protected:
   // for tracking the expansion of the algorithm visually
   expansion_callback_t expansion_callback_;
 
+  // landmark tables for the A* heuristic
+  std::shared_ptr<const baldr::Landmarks> landmarks_;
+
+  /**
+   * Get the landmark table for an access mode.
+   * @param  access  Access mode of the costing.
+   * @return Returns the table, nullptr if there are no landmarks for the access mode.
+   */
+  const baldr::LandmarkTable* landmark_table(const uint32_t access) const {
+    return landmarks_ ? landmarks_->get(access) : nullptr;
+  }
+
+  /**
+   * Get the nodes a path has to go through to end at (or start from) a location: the start
+   * nodes of the edges of a destination or the end nodes of the edges of an origin.
+   * @param  graphreader  Graph reader.
+   * @param  location     The location.
+   * @param  destination  True if the path ends at the location.
+   * @return Returns the nodes, empty if one of them can't be found.
+   */
+  std::vector<baldr::GraphId> LandmarkTargets(baldr::GraphReader& graphreader,
+                                              const valhalla::Location& location,
+                                              const bool destination) const {
+    std::vector<baldr::GraphId> targets;
+    for (const auto& edge : location.path_edges()) {
+      baldr::GraphId edgeid(edge.graph_id());
+      baldr::GraphId node;
+      if (destination) {
+        node = graphreader.edge_startnode(edgeid);
+      } else {
+        const baldr::DirectedEdge* directededge = graphreader.directededge(edgeid);
+        node = directededge == nullptr ? baldr::GraphId() : directededge->endnode();
+      }
+      if (!node.Is_Valid()) {
+        return {};
+      }
+      targets.push_back(node);
+    }
+    return targets;
+  }
+
   /**
    * Check for path completion along the same edge. Edge ID in question
    * is along both an origin and destination and origin shows up at the
@@ -20,6 +20,8 @@
 #include <valhalla/thor/astar.h>
 #include <valhalla/thor/attributes_controller.h>
 #include <valhalla/thor/bidirectional_astar.h>
+#include <valhalla/thor/bucketmatrix.h>
+#include <valhalla/thor/cch.h>
 #include <valhalla/thor/isochrone.h>
 #include <valhalla/thor/match_result.h>
 #include <valhalla/thor/multimodal.h>
@@ -37,7 +39,12 @@ void run_service(const boost::property_tree::ptree& config);
 
 class thor_worker_t : public service_worker_t {
 public:
-  enum SOURCE_TO_TARGET_ALGORITHM { SELECT_OPTIMAL = 0, COST_MATRIX = 1, TIME_DISTANCE_MATRIX = 2 };
+  enum SOURCE_TO_TARGET_ALGORITHM {
+    SELECT_OPTIMAL = 0,
+    COST_MATRIX = 1,
+    TIME_DISTANCE_MATRIX = 2,
+    BUCKET_MATRIX = 3
+  };
   thor_worker_t(const boost::property_tree::ptree& config,
                 const std::shared_ptr<baldr::GraphReader>& graph_reader = {});
   virtual ~thor_worker_t();
@@ -56,6 +63,15 @@ public:
   std::string trace_attributes(Api& request);
   std::string expansion(Api& request);
 
+  /**
+   * Log a request that took longer than thor.logging.long_request milliseconds per unit of work
+   * (locations, sources and targets or trace points depending on the action).
+   * @param  request       The request.
+   * @param  id            Id of the request in the logs.
+   * @param  elapsed_time  Milliseconds thor spent on the request.
+   */
+  void log_long_request(const Api& request, const uint64_t id, const double elapsed_time) const;
+
 protected:
   std::vector<std::vector<thor::PathInfo>> get_path(PathAlgorithm* path_algorithm,
                                                     Location& origin,
@@ -96,14 +112,23 @@ protected:
   MultiModalPathAlgorithm multi_modal_astar;
   TimeDepForward timedep_forward;
   TimeDepReverse timedep_reverse;
+  // Tried before bidirectional A* when there is a contraction hierarchy overlay
+  CCHQuery cch_query;
   Isochrone isochrone_gen;
+  // Threads an isochrone request turns its grid into contours with
+  unsigned int isochrone_threads;
+  // Keeps its target selection phases between requests
+  BucketMatrix bucket_matrix;
   std::shared_ptr<meili::MapMatcher> matcher;
   float long_request;
+  // Whether costings keep the edge costs of the tiles they expand for later requests
+  bool edge_cost_tables;
   float max_timedep_distance;
   std::unordered_map<std::string, float> max_matrix_distance;
   SOURCE_TO_TARGET_ALGORITHM source_to_target_algorithm;
   meili::MapMatcherFactory matcher_factory;
   std::shared_ptr<baldr::GraphReader> reader;
+  std::vector<std::shared_ptr<baldr::GraphReader>> matrix_readers;
   AttributesController controller;
 };
 
@@ -2,12 +2,45 @@
 #define VALHALLA_TYR_ACTOR_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <functional>
+#include <iosfwd>
+#include <list>
 #include <memory>
 #include <unordered_map>
 
+#ifdef HAVE_HTTP
+#include <prime_server/prime_server.hpp>
+#endif
+
 namespace valhalla {
 namespace tyr {
 
+#ifdef HAVE_HTTP
+/**
+ * Runs a worker which answers the requests coming from the loki proxy by taking each of them
+ * through loki, thor and odin in the same thread (see actor_t::work)
+ * @param config  the service config
+ */
+void run_service(const boost::property_tree::ptree& config);
+#endif
+
+/**
+ * Map matches a stream of traces on a pool of threads, each with its own actor whose graph reader,
+ * matchers and labels are kept from one trace to the next. The workers share one tile cache and the
+ * candidate grids of their matchers. Traces are matched as they are read and their results are
+ * written as soon as every trace before them is done, so the output is in the order of the input.
+ *
+ * @param config       the service config
+ * @param input        newline delimited json trace_attributes requests, blank lines are skipped
+ * @param output       gets one line of json per request, the attributes or an error
+ * @param concurrency  the number of traces matched at once
+ * @return the number of requests read
+ */
+size_t trace_attributes_batch(const boost::property_tree::ptree& config,
+                              std::istream& input,
+                              std::ostream& output,
+                              size_t concurrency);
+
 class actor_t {
 public:
   actor_t(const boost::property_tree::ptree& config, bool auto_cleanup = false);
@@ -33,6 +66,23 @@ public:
   std::string expansion(const std::string& request_str,
                         const std::function<void()>& interrupt = []() -> void {});
 
+#ifdef HAVE_HTTP
+  /**
+   * Answers an http request by running all of the stages it needs on one request object. Unlike
+   * the separate loki, thor and odin workers the request is never serialized between stages.
+   *
+   * @param  job           the http request from the server
+   * @param  request_info  the http_request_info object used to communicate with the server about
+   * the state of the request
+   * @param  interrupt     a function that may be called periodically and will throw when processing
+   * should be interrupted
+   * @return the result, which always goes back to the server
+   */
+  prime_server::worker_t::result_t work(const std::list<zmq::message_t>& job,
+                                        void* request_info,
+                                        const std::function<void()>& interrupt);
+#endif
+
 protected:
   struct pimpl_t;
   std::shared_ptr<pimpl_t> pimpl;